@@ -8,23 +8,31 @@
 //
 
 #include "RasterDisplay.h"
+#include "raster-convert.h"
 #include <FL/Fl.H>
 #include <FL/Fl_Window.H>
 #include <FL/fl_ask.H>
 #include <FL/fl_draw.H>
 #include <FL/Fl_Preferences.H>
+#include <FL/filename.H>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #if _WIN32
 #  include <io.h>
+#  include <sys/utime.h>
 #else
 #  include <unistd.h>
+#  include <utime.h>
 #endif // _WIN32
 #include <fcntl.h>
 #include <errno.h>
 #include <math.h>
 #include <limits.h>
+#include <atomic>
+#include <thread>
 #include <FL/names.h>
 
 
@@ -36,19 +44,75 @@
 
 
 //
-// Constants...
+// Population count macro - use the hardware instruction (POPCNT on x86,
+// CNT on ARM) when the compiler is targeting it, otherwise a SWAR count...
 //
 
-#define D65_X	(0.412453 + 0.357580 + 0.180423)
-#define D65_Y	(0.212671 + 0.715160 + 0.072169)
-#define D65_Z	(0.019334 + 0.119193 + 0.950227)
+#if defined(__GNUC__) && (defined(__POPCNT__) || defined(__aarch64__) || defined(__ARM_NEON))
+#  define popcount64(v) ((unsigned)__builtin_popcountll(v))
+#else
+static inline unsigned
+popcount64(unsigned long long v)
+{
+  v = v - ((v >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+
+  return ((unsigned)((v * 0x0101010101010101ULL) >> 56));
+}
+#endif // __GNUC__ && (__POPCNT__ || __aarch64__ || __ARM_NEON)
+
+
+//
+// Local types...
+//
+
+typedef struct raster_band_s		// Band of rows decoded by a thread
+{
+  RasterDisplay		*display;	// Display widget
+  int			first,		// First row
+			last;		// Last row (exclusive)
+  z_off_t		offset;		// Offset of first row in file
+  int			status;		// 1 on success, 0 on failure
+  std::atomic<int>	*done;		// Number of finished bands
+} raster_band_t;
+
+
+typedef struct raster_bins_s		// Histogram bins counted by a thread
+{
+  RasterDisplay		*display;	// Display widget
+  int			first,		// First row
+			last;		// Last row (exclusive)
+  unsigned long		counts[15][256];// Number of pixels with each value
+  unsigned long long	totals[15];	// Total of values
+} raster_bins_t;
+
+
+typedef struct raster_cache_s		// Page index cache file header
+{
+  char			magic[8];	// "RVINDEX5"
+  int			offset_size,	// sizeof(z_off_t)
+			num_pages,	// Number of pages
+			num_index;	// Number of row index entries
+  unsigned long long	size,		// File size
+			mtime,		// File modification time
+			hash;		// Hash of the start of the file
+  char			path[1024];	// Absolute filename
+} raster_cache_t;
+
+
+typedef struct raster_cachefile_s	// Page index cache file
+{
+  char			filename[1024];	// Filename
+  unsigned long long	size;		// Size of file
+  time_t		mtime;		// Time of last use
+} raster_cachefile_t;
 
 
 //
 // Local globals...
 //
 
-static int		endian_offset = -1;
 static Fl_Preferences	*prefs = NULL;
 
 
@@ -57,36 +121,16 @@ static Fl_Preferences	*prefs = NULL;
 // Local functions...
 //
 
-static void	convert_cmy(cups_page_header_t *header, uchar *line,
-		            uchar *colors, uchar *pixels);
-static void	convert_cmyk(cups_page_header_t *header, uchar *line,
-		             uchar *colors, uchar *pixels);
-static void	convert_device(cups_page_header_t *header, uchar *line, uchar *colors, uchar *pixels, uchar device_colors[][3]);
-static void	convert_k(cups_page_header_t *header, uchar *line,
-		          uchar *colors, uchar *pixels);
-static void	convert_kcmy(cups_page_header_t *header, uchar *line,
-		             uchar *colors, uchar *pixels);
-static void	convert_kcmycm(cups_page_header_t *header, uchar *line,
-		               uchar *colors, uchar *pixels);
-static void	convert_lab(cups_page_header_t *header, uchar *line,
-		            uchar *colors, uchar *pixels);
-static void	convert_rgb(cups_page_header_t *header, uchar *line,
-		            uchar *colors, uchar *pixels);
-static void	convert_rgba(cups_page_header_t *header, int y, uchar *line,
-		             uchar *colors, uchar *pixels);
-static void	convert_rgbw(cups_page_header_t *header, uchar *line,
-		             uchar *colors, uchar *pixels);
-static void	convert_w(cups_page_header_t *header, uchar *line,
-		          uchar *colors, uchar *pixels);
-static void	convert_xyz(cups_page_header_t *header, uchar *line,
-		            uchar *colors, uchar *pixels);
-static void	convert_ymc(cups_page_header_t *header, uchar *line,
-		            uchar *colors, uchar *pixels);
-static void	convert_ymck(cups_page_header_t *header, uchar *line,
-		             uchar *colors, uchar *pixels);
+static unsigned	bits_count(const uchar *row, long first, long last, uchar mask, int fold);
+static int	bits_masks(cups_page_header_t *header, uchar masks[3], int *additive);
 static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static int	index_compare(raster_cachefile_t *a, raster_cachefile_t *b);
+static int	index_file(const char *filename, char *cachefile, size_t cachesize, raster_cache_t *cache);
+static void	index_prune(const char *cachefile);
+static unsigned	ink_total(cups_page_header_t *header, int bpc, const uchar *color);
 static size_t	rasterOffset(cups_raster_t *r);
 static void	rasterReset(cups_raster_t *r);
+static void	rasterSeek(cups_raster_t *r, unsigned row);
 
 
 //
@@ -116,11 +160,56 @@ RasterDisplay::RasterDisplay(
   alloc_pixels_ = 0;
   colors_       = NULL;
   alloc_colors_ = 0;
+  bits_         = NULL;
+  alloc_bits_   = 0;
+  bits_pixel_   = 0;
+  raw_          = NULL;
+  alloc_raw_    = 0;
+  index_        = NULL;
+  num_index_    = 0;
+  alloc_index_  = 0;
+  pending_      = NULL;
+  alloc_pending_ = 0;
+  pending_y_    = -1;
+  xmap_         = NULL;
+  alloc_xmap_   = 0;
+  xrep_         = 0;
+  screen_scale_ = 1.0f;
+  channels_     = 0;
+  ink_          = NULL;
+  alloc_ink_    = 0;
+  ink_rows_     = NULL;
+  alloc_ink_rows_ = 0;
+  show_ink_     = 0;
+  show_ink_box_ = 0;
+  histogram_state_  = RASTER_HISTOGRAM_NONE;
+  histogram_cancel_ = 0;
+  stats_sums_   = NULL;
+  stats_range_  = NULL;
+  stats_valid_  = 0;
+  region_       = 0;
+  compare_      = NULL;
+  show_diff_    = 0;
+  syncing_      = 0;
+  diff_         = NULL;
+  alloc_diff_   = 0;
+  dxsize_       = 0;
+  dysize_       = 0;
+  loading_      = 0;
+  scroll_x_     = -1;
+  scroll_y_     = -1;
+  num_tiles_    = 0;
+  tile_used_    = 0;
   factor_       = 0.0;
   mode_         = RASTER_MODE_ZOOM_IN;
   mouse_x_      = 0;
   mouse_y_      = 0;
 
+  if (!prefs)
+    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
+
+  prefs->get("inklimit", ink_limit_, 300);
+
   xscrollbar_.type(FL_HORIZONTAL);
   xscrollbar_.callback(scrollbar_cb, this);
 
@@ -137,7 +226,297 @@ RasterDisplay::RasterDisplay(
 
 RasterDisplay::~RasterDisplay()
 {
+  compare(NULL);
   close_file();
+
+  delete[] xmap_;
+  delete[] diff_;
+}
+
+
+//
+// 'RasterDisplay::average_bits()' - Provide a line of 1-bit data averaged over
+//                                   the area covered by each output pixel.
+//
+// Rather than picking one source pixel (which turns halftones into moire
+// patterns when zoomed out), each output pixel is the percentage of "on" bits
+// in its block of the packed raster data, counted 64 bits at a time...
+//
+
+void
+RasterDisplay::average_bits(int   X,	// I - X position in device pixels
+                            int   Y,	// I - Y position in device pixels
+                            int   W,	// I - Width of image row
+                            uchar *D)	// O - Image data
+{
+  int		c,			// Current channel
+		nchannels;		// Number of channels
+  long		x0, x1,			// Source columns for output pixel
+		y0, y1,			// Source rows for output line
+		y,			// Current source row
+		total;			// Number of source pixels in block
+  unsigned	hits;			// Number of "on" pixels in block
+  const uchar	*row;			// Current source row
+
+
+  y0 = (long)Y * header_.cupsHeight / dysize_;
+  y1 = (long)(Y + 1) * header_.cupsHeight / dysize_;
+
+  if (y1 <= y0)
+    y1 = y0 + 1;
+  if (y1 > (long)header_.cupsHeight)
+    y1 = header_.cupsHeight;
+
+  nchannels = bpp_;
+
+  for (x1 = (long)X * header_.cupsWidth / dxsize_; W > 0; W --, X ++)
+  {
+    x0 = x1;
+    x1 = (long)(X + 1) * header_.cupsWidth / dxsize_;
+
+    if (x1 <= x0)
+      x1 = x0 + 1;
+    if (x1 > (long)header_.cupsWidth)
+      x1 = header_.cupsWidth;
+
+    total = (x1 - x0) * (y1 - y0);
+
+    for (c = 0; c < nchannels; c ++)
+    {
+      for (y = y0, hits = 0, row = bits_ + y0 * header_.cupsBytesPerLine; y < y1; y ++, row += header_.cupsBytesPerLine)
+        hits += bits_count(row, x0 * bits_pixel_, x1 * bits_pixel_, bits_masks_[c], bits_pixel_ > 1);
+
+      if (bits_additive_)
+        *D++ = (uchar)(255 * hits / total);
+      else
+        *D++ = (uchar)(255 - 255 * hits / total);
+    }
+  }
+}
+
+
+//
+// 'RasterDisplay::band_cb()' - Decode and convert a band of the current page.
+//
+// Each band uses its own file and raster stream, seeking to the row index
+// entry at the start of the band...
+//
+
+void
+RasterDisplay::band_cb(void *b)		// I - Band
+{
+  raster_band_t		*band = (raster_band_t *)b;
+					// Band
+  RasterDisplay		*display = band->display;
+					// Display widget
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		bpl = display->header_.cupsBytesPerLine;
+					// Bytes per line
+  uchar			*line,		// Line buffer
+			*lptr;		// Current raster line
+  int			y;		// Current row
+
+
+  band->status = 0;
+
+  if ((fp = gzopen(display->filename_, "r")) != NULL)
+  {
+    if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) != NULL)
+    {
+      gzseek(fp, display->pages_[display->page_ - 1], SEEK_SET);
+      rasterReset(ras);
+
+      if (cupsRasterReadHeader(ras, &header) && (line = new uchar[bpl]) != NULL)
+      {
+	gzseek(fp, band->offset, SEEK_SET);
+	rasterSeek(ras, (unsigned)band->first);
+
+	for (y = band->first; y < band->last; y ++)
+	{
+	  if (display->bits_pixel_)
+	    lptr = display->bits_ + (long)y * bpl;
+	  else
+	    lptr = line;
+
+	  if (!cupsRasterReadPixels(ras, lptr, bpl))
+	    break;
+
+	  display->convert_line(y, lptr);
+	}
+
+	band->status = y >= band->last;
+
+	delete[] line;
+      }
+
+      cupsRasterClose(ras);
+    }
+
+    gzclose(fp);
+  }
+
+  (*band->done) ++;
+}
+
+
+//
+// 'RasterDisplay::build_stats()' - Build the summed-area tables for region
+//                                  statistics.
+//
+// The tables hold the sum and sum of squares of each channel for blocks of
+// RASTER_STATS_BLOCK pixels along with the minimum and maximum of each block,
+// so any region only needs its edges scanned...
+//
+
+int					// O - 1 on success, 0 on failure
+RasterDisplay::build_stats()
+{
+  int			x, y,		// Looping vars
+			c,		// Current channel
+			nchannels,	// Number of channels
+			bx, by,		// Current block
+			bw, bh,		// Number of blocks
+			yend;		// Last row in block row
+  unsigned		val;		// Channel value
+  const uchar		*color;		// Current color
+  unsigned long long	*sums,		// Current sums
+			*above;		// Sums above current block
+  unsigned short	*range;		// Current minimum and maximum
+
+
+  if (!colors_ || loading_)
+    return (0);
+
+  nchannels = (int)header_.cupsNumColors;
+  bw        = ((int)header_.cupsWidth + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
+  bh        = ((int)header_.cupsHeight + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
+
+  delete[] stats_sums_;
+  delete[] stats_range_;
+
+  stats_sums_  = new unsigned long long[(size_t)(bw + 1) * (bh + 1) * nchannels * 2];
+  stats_range_ = new unsigned short[(size_t)bw * bh * nchannels * 2];
+
+  if (!stats_sums_ || !stats_range_)
+  {
+    fl_alert("Unable to allocate memory for region statistics.");
+    return (0);
+  }
+
+  // Convert any deferred rows...
+  if (pending_y_ >= 0)
+  {
+    for (y = 0; y < (int)header_.cupsHeight; y ++)
+    {
+      if (pending_[y])
+        convert_row(y);
+    }
+  }
+
+  // The first row and column of the summed-area table are 0...
+  memset(stats_sums_, 0, (size_t)(bw + 1) * nchannels * 2 * sizeof(unsigned long long));
+
+  for (by = 0; by < bh; by ++)
+  {
+    sums  = stats_sums_ + (size_t)(by + 1) * (bw + 1) * nchannels * 2;
+    range = stats_range_ + (size_t)by * bw * nchannels * 2;
+
+    memset(sums, 0, (size_t)(bw + 1) * nchannels * 2 * sizeof(unsigned long long));
+
+    for (bx = 0; bx < bw; bx ++)
+    {
+      for (c = 0; c < nchannels; c ++)
+      {
+        range[(bx * nchannels + c) * 2]     = 65535;
+        range[(bx * nchannels + c) * 2 + 1] = 0;
+      }
+    }
+
+    // Add up the blocks in this row...
+    if ((yend = (by + 1) * RASTER_STATS_BLOCK) > (int)header_.cupsHeight)
+      yend = (int)header_.cupsHeight;
+
+    for (y = by * RASTER_STATS_BLOCK; y < yend; y ++)
+    {
+      color = colors_ + (long)y * header_.cupsWidth * bpc_;
+
+      for (x = 0; x < (int)header_.cupsWidth; x ++, color += bpc_)
+      {
+        bx = x / RASTER_STATS_BLOCK;
+
+        for (c = 0; c < nchannels; c ++)
+        {
+          val = rasterChannelValue(&header_, bpc_, color, c);
+
+          sums[((bx + 1) * nchannels + c) * 2]     += val;
+          sums[((bx + 1) * nchannels + c) * 2 + 1] += (unsigned long long)val * val;
+
+          if (val < range[(bx * nchannels + c) * 2])
+            range[(bx * nchannels + c) * 2] = (unsigned short)val;
+          if (val > range[(bx * nchannels + c) * 2 + 1])
+            range[(bx * nchannels + c) * 2 + 1] = (unsigned short)val;
+        }
+      }
+    }
+
+    // Then make them cumulative...
+    above = sums - (bw + 1) * nchannels * 2;
+
+    for (bx = 1; bx <= bw; bx ++)
+    {
+      for (c = 0; c < nchannels * 2; c ++)
+        sums[bx * nchannels * 2 + c] += sums[(bx - 1) * nchannels * 2 + c];
+    }
+
+    for (bx = 1; bx <= bw; bx ++)
+    {
+      for (c = 0; c < nchannels * 2; c ++)
+        sums[bx * nchannels * 2 + c] += above[bx * nchannels * 2 + c];
+    }
+  }
+
+  stats_valid_ = 1;
+
+  return (1);
+}
+
+
+//
+// 'RasterDisplay::can_diff()' - Can differences from the compared page be shown?
+//
+// Both pages must be loaded and have the same size and pixel format...
+//
+
+int					// O - 1 if differences can be shown, 0 otherwise
+RasterDisplay::can_diff()
+{
+  return (show_diff_ && compare_ && colors_ && compare_->colors_ && !loading_ && !compare_->loading_ &&
+          header_.cupsWidth == compare_->header_.cupsWidth &&
+          header_.cupsHeight == compare_->header_.cupsHeight &&
+          header_.cupsBitsPerColor == compare_->header_.cupsBitsPerColor &&
+          header_.cupsBitsPerPixel == compare_->header_.cupsBitsPerPixel &&
+          header_.cupsColorOrder == compare_->header_.cupsColorOrder &&
+          header_.cupsColorSpace == compare_->header_.cupsColorSpace &&
+          header_.cupsNumColors == compare_->header_.cupsNumColors);
+}
+
+
+//
+// 'RasterDisplay::channels()' - Show only some of the colorants (separations).
+//
+
+void
+RasterDisplay::channels(unsigned mask)	// I - Bitmask of channels to show (0 = all)
+{
+  if (mask == channels_)
+    return;
+
+  channels_ = mask;
+
+  flush_tiles();
+  redraw();
 }
 
 
@@ -148,6 +527,8 @@ RasterDisplay::~RasterDisplay()
 int					// O - 1 on success, 0 on failure
 RasterDisplay::close_file()
 {
+  stop_histogram();
+
   if (ras_)
   {
     cupsRasterClose(ras_);
@@ -180,118 +561,567 @@ RasterDisplay::close_file()
     alloc_colors_ = 0;
   }
 
-  memset(&header_, 0, sizeof(header_));
+  if (bits_)
+  {
+    delete[] bits_;
+    bits_       = NULL;
+    alloc_bits_ = 0;
+  }
 
-  return (1);
-}
+  if (index_)
+  {
+    free(index_);
+    index_       = NULL;
+    num_index_   = 0;
+    alloc_index_ = 0;
+  }
 
+  if (raw_)
+  {
+    delete[] raw_;
+    raw_       = NULL;
+    alloc_raw_ = 0;
+  }
 
-//
-// 'RasterDisplay::draw()' - Draw the raster display widget.
-//
+  if (pending_y_ >= 0)
+  {
+    Fl::remove_idle(convert_cb, this);
+    pending_y_ = -1;
+  }
 
-void
-RasterDisplay::draw()
-{
-  int	xoff, yoff;			// Offset of image
-  int	X, Y, W, H;			// Interior of widget
+  if (pending_)
+  {
+    delete[] pending_;
+    pending_       = NULL;
+    alloc_pending_ = 0;
+  }
 
+  if (ink_)
+  {
+    delete[] ink_;
+    delete[] ink_rows_;
+    ink_            = NULL;
+    alloc_ink_      = 0;
+    ink_rows_       = NULL;
+    alloc_ink_rows_ = 0;
+  }
 
-#ifdef DEBUG
-  puts("RasterDisplay::draw()");
-#endif // DEBUG
+  delete[] stats_sums_;
+  delete[] stats_range_;
+  stats_sums_  = NULL;
+  stats_range_ = NULL;
+  stats_valid_ = 0;
 
-  X = x() + Fl::box_dx(box());
-  Y = y() + Fl::box_dy(box());
-  W = visible_w();
-  H = visible_h();
+  bits_pixel_ = 0;
 
-  if (damage() & FL_DAMAGE_SCROLL)
-    fl_push_clip(X, Y, W, H);
+  flush_tiles();
 
-  if (factor_)
-    draw_box(box(), x(), y(), w() - SBWIDTH, h() - SBWIDTH, color());
-  else
-    draw_box();
+  memset(&header_, 0, sizeof(header_));
 
-  if (damage() & FL_DAMAGE_SCROLL)
+  if (compare_ && compare_->show_diff_)
   {
-    fl_pop_clip();
+    compare_->flush_tiles();
+    compare_->redraw();
   }
-  else if (factor_)
+
+  return (1);
+}
+
+
+//
+// 'RasterDisplay::compare()' - Set the display to compare with.
+//
+// The two displays refer to each other so that scrolling and zooming either
+// one updates the other...
+//
+
+void
+RasterDisplay::compare(RasterDisplay *d)// I - Display to compare with or NULL
+{
+  if (d == compare_)
+    return;
+
+  if (compare_)
   {
-    fl_color(FL_GRAY);
-    fl_rectf(x() + w() - SBWIDTH, y() + h() - SBWIDTH, SBWIDTH, SBWIDTH);
+    compare_->compare_ = NULL;
+    compare_->flush_tiles();
+    compare_->redraw();
   }
 
-  if (ras_ && pixels_ && header_.cupsWidth && header_.cupsHeight)
+  if ((compare_ = d) != NULL)
   {
-#ifdef DEBUG
-    printf("    pixels_=%p, cupsWidth=%d, cupsHeight=%d\n", pixels_,
-           header_.cupsWidth, header_.cupsHeight);
-#endif // DEBUG
-
-    fl_push_clip(X, Y, W, H);
+    if (d->compare_)
+      d->compare(NULL);
 
-    if (xsize_ <= W)
-      xoff = (W - xsize_) / 2;
-    else
-      xoff = 0;
+    d->compare_ = this;
+    d->flush_tiles();
+    d->redraw();
 
-    if (ysize_ <= H)
-      yoff = (H - ysize_) / 2;
-    else
-      yoff = 0;
+    sync_compare();
+  }
 
-    xoff += X;
-    yoff += Y;
+  flush_tiles();
+  redraw();
+}
 
-    xstep_ = header_.cupsWidth / xsize_;
-    xmod_  = header_.cupsWidth % xsize_;
 
-#ifdef DEBUG
-    printf("    xoff=%d, yoff=%d, xsize_=%d, ysize_=%d, xstep_=%d, xmod_=%d\n", xoff, yoff, xsize_, ysize_, xstep_, xmod_);
-#endif // DEBUG
+//
+// 'RasterDisplay::convert_cb()' - Convert deferred rows in the background.
+//
 
-    if (bpp_ == 1)
-      fl_draw_image_mono(image_cb, this, xoff, yoff, xsize_ > W ? W : xsize_, ysize_ > H ? H : ysize_, bpp_);
-    else
-      fl_draw_image(image_cb, this, xoff, yoff, xsize_ > W ? W : xsize_, ysize_ > H ? H : ysize_, bpp_);
+void
+RasterDisplay::convert_cb(void *d)	// I - Raster display widget
+{
+  RasterDisplay	*display = (RasterDisplay *)d;
+					// Display widget
+  int		count;			// Rows left to convert this time
 
-    fl_pop_clip();
-  }
 
-  draw_label(X, Y, W, H - 2 * labelsize());
+  count = RASTER_CONVERT_PIXELS / display->header_.cupsWidth + 1;
 
-  if (factor_)
+  for (; display->pending_y_ < (int)display->header_.cupsHeight && count > 0; display->pending_y_ ++)
   {
-    if (damage() & FL_DAMAGE_SCROLL)
-    {
-      update_child(xscrollbar_);
-      update_child(yscrollbar_);
-    }
-    else
+    if (display->pending_[display->pending_y_])
     {
-      draw_child(xscrollbar_);
-      draw_child(yscrollbar_);
+      display->convert_row(display->pending_y_);
+      count --;
     }
   }
+
+  if (display->pending_y_ >= (int)display->header_.cupsHeight)
+  {
+    // All done, redraw anything that was scaled from unconverted rows...
+    Fl::remove_idle(convert_cb, d);
+
+    display->pending_y_ = -1;
+    display->flush_tiles();
+    display->redraw();
+  }
 }
 
 
 //
-// 'RasterDisplay::get_color()' - Return the original color value for a coordinate.
+// 'RasterDisplay::convert_line()' - Convert a line of raster data for display.
 //
 
-uchar *					// O - Color values or NULL
-RasterDisplay::get_color(int X,		// I - X position in image
-                         int Y)		// I - Y position in image
+void
+RasterDisplay::convert_line(int   y,	// I - Row in page
+                            uchar *line)	// I - Raster data
+{
+  uchar	*cptr = colors_ + (long)y * header_.cupsWidth * bpc_,
+					// Pointer into colors_
+	*pptr = pixels_ + (long)y * header_.cupsWidth * bpp_;
+					// Pointer into pixels_
+
+
+  rasterConvertLine(&header_, y, line, cptr, pptr, device_colors_);
+}
+
+
+//
+// 'RasterDisplay::convert_row()' - Convert a deferred row.
+//
+
+void
+RasterDisplay::convert_row(int y)	// I - Row in page
+{
+  pending_[y] = 0;
+
+  if (bits_pixel_)
+    convert_line(y, bits_ + (long)y * header_.cupsBytesPerLine);
+  else
+    convert_line(y, raw_ + (long)y * header_.cupsBytesPerLine);
+}
+
+
+//
+// 'RasterDisplay::diff_row()' - Compute the differences of part of a row.
+//
+// Each column gets the largest difference of its channels, scaled to 0-255.
+// Identical rows are found with a single memcmp(), and 8-bit data uses a
+// simple byte loop that the compiler turns into SIMD instructions...
+//
+
+void
+RasterDisplay::diff_row(int   y,	// I - Row
+                        int   x0,	// I - First column
+                        int   x1,	// I - Last column (exclusive)
+                        uchar *d)	// O - Difference of each column
+{
+  int		i,			// Looping var
+		c,			// Current channel
+		nchannels,		// Number of channels
+		shift,			// Shift to get 8-bit value
+		delta,			// Difference of channel
+		maxdelta;		// Largest difference of column
+  unsigned	maxval;			// Maximum channel value
+  long		bytes;			// Bytes to compare
+  const uchar	*a,			// Colors in this page
+		*b;			// Colors in compared page
+  uchar		*t;			// Byte differences
+
+
+  if (pending_y_ >= 0 && pending_[y])
+    convert_row(y);
+
+  if (compare_->pending_y_ >= 0 && compare_->pending_[y])
+    compare_->convert_row(y);
+
+  bytes = (long)(x1 - x0) * bpc_;
+  a     = colors_ + ((long)y * header_.cupsWidth + x0) * bpc_;
+  b     = compare_->colors_ + ((long)y * header_.cupsWidth + x0) * bpc_;
+
+  if (!memcmp(a, b, (size_t)bytes))
+  {
+    memset(d, 0, (size_t)(x1 - x0));
+    return;
+  }
+
+  if (header_.cupsBitsPerColor == 8 && header_.cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Absolute difference of each byte, then the largest of each pixel...
+    t = bpc_ == 1 ? d : diff_ + 2 * header_.cupsWidth;
+
+    for (i = 0; i < bytes; i ++)
+      t[i] = (uchar)(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+
+    if (bpc_ > 1)
+    {
+      for (i = x0; i < x1; i ++, t += bpc_)
+      {
+        for (c = 1, maxdelta = t[0]; c < bpc_; c ++)
+        {
+          if (t[c] > maxdelta)
+            maxdelta = t[c];
+        }
+
+        *d++ = (uchar)maxdelta;
+      }
+    }
+    return;
+  }
+
+  // Other bit depths and color orders use the channel values...
+  nchannels = (int)header_.cupsNumColors;
+
+  if (header_.cupsBitsPerColor == 16)
+  {
+    maxval = 255;
+    shift  = 8;
+  }
+  else
+  {
+    maxval = (1U << header_.cupsBitsPerColor) - 1;
+    shift  = 0;
+  }
+
+  for (i = x0; i < x1; i ++, a += bpc_, b += bpc_)
+  {
+    maxdelta = 0;
+
+    if (memcmp(a, b, (size_t)bpc_))
+    {
+      for (c = 0; c < nchannels; c ++)
+      {
+        delta = (int)(rasterChannelValue(&header_, bpc_, a, c) >> shift) - (int)(rasterChannelValue(&header_, bpc_, b, c) >> shift);
+
+        if (delta < 0)
+          delta = -delta;
+        if (delta > maxdelta)
+          maxdelta = delta;
+      }
+
+      maxdelta = (int)((unsigned)maxdelta * 255 / maxval);
+
+      if (maxdelta == 0)
+        maxdelta = 1;			// Don't hide differences in the low bits
+    }
+
+    *d++ = (uchar)maxdelta;
+  }
+}
+
+
+//
+// 'RasterDisplay::draw()' - Draw the raster display widget.
+//
+
+void
+RasterDisplay::draw()
+{
+  int	xoff, yoff;			// Offset of image
+  int	X, Y, W, H;			// Interior of widget
+
+
+#ifdef DEBUG
+  puts("RasterDisplay::draw()");
+#endif // DEBUG
+
+  X = x() + Fl::box_dx(box());
+  Y = y() + Fl::box_dy(box());
+  W = visible_w();
+  H = visible_h();
+
+#if FL_API_VERSION >= 10400
+  // Scale the image for the screen's device pixels...
+  float sscale = window() ? Fl::screen_scale(window()->screen_num()) : 1.0f;
+					// Screen scaling factor
+
+  if (sscale != screen_scale_)
+  {
+    screen_scale_ = sscale;
+    scroll_x_     = -1;
+
+    update_xmap();
+  }
+#endif // FL_API_VERSION >= 10400
+
+  if ((damage() & ~FL_DAMAGE_CHILD) == FL_DAMAGE_SCROLL && scroll_x_ >= 0 && !loading_)
+  {
+    // Only the scroll position has changed, move what is already on the
+    // screen and just draw the newly exposed areas...
+    int dx = scroll_x_ - xscrollbar_.value(),
+	dy = scroll_y_ - yscrollbar_.value();
+
+    image_x_  += dx;
+    image_y_  += dy;
+    scroll_x_ = xscrollbar_.value();
+    scroll_y_ = yscrollbar_.value();
+
+    if (dx || dy)
+      fl_scroll(X, Y, W, H, dx, dy, scroll_cb, this);
+
+    update_child(xscrollbar_);
+    update_child(yscrollbar_);
+    return;
+  }
+
+  scroll_x_ = -1;
+  scroll_y_ = -1;
+
+  if (damage() & FL_DAMAGE_SCROLL)
+    fl_push_clip(X, Y, W, H);
+
+  if (factor_)
+    draw_box(box(), x(), y(), w() - SBWIDTH, h() - SBWIDTH, color());
+  else
+    draw_box();
+
+  if (damage() & FL_DAMAGE_SCROLL)
+  {
+    fl_pop_clip();
+  }
+  else if (factor_)
+  {
+    fl_color(FL_GRAY);
+    fl_rectf(x() + w() - SBWIDTH, y() + h() - SBWIDTH, SBWIDTH, SBWIDTH);
+  }
+
+  if (ras_ && pixels_ && header_.cupsWidth && header_.cupsHeight)
+  {
+#ifdef DEBUG
+    printf("    pixels_=%p, cupsWidth=%d, cupsHeight=%d\n", pixels_,
+           header_.cupsWidth, header_.cupsHeight);
+#endif // DEBUG
+
+    fl_push_clip(X, Y, W, H);
+
+    if (xsize_ <= W)
+      xoff = (W - xsize_) / 2;
+    else
+      xoff = 0;
+
+    if (ysize_ <= H)
+      yoff = (H - ysize_) / 2;
+    else
+      yoff = 0;
+
+    xoff += X;
+    yoff += Y;
+
+    image_x_ = xoff - xscrollbar_.value();
+    image_y_ = yoff - yscrollbar_.value();
+
+#ifdef DEBUG
+    printf("    xoff=%d, yoff=%d, xsize_=%d, ysize_=%d, dxsize_=%d, dysize_=%d, xrep_=%d\n", xoff, yoff, xsize_, ysize_, dxsize_, dysize_, xrep_);
+#endif // DEBUG
+
+    if (loading_ && screen_scale_ == 1.0f && (xsize_ != (int)header_.cupsWidth || ysize_ != (int)header_.cupsHeight || channels_ || show_ink_ || show_diff_))
+    {
+      // Page is still loading, draw directly...
+      if (bpp_ == 1)
+	fl_draw_image_mono(image_cb, this, xoff, yoff, xsize_ > W ? W : xsize_, ysize_ > H ? H : ysize_, bpp_);
+      else
+	fl_draw_image(image_cb, this, xoff, yoff, xsize_ > W ? W : xsize_, ysize_ > H ? H : ysize_, bpp_);
+    }
+    else
+    {
+      // Draw from the page buffer or tile cache...
+      if (loading_)
+        flush_tiles();
+
+      draw_tiles(xoff, yoff, xsize_ > W ? W : xsize_, ysize_ > H ? H : ysize_);
+
+      scroll_x_ = xscrollbar_.value();
+      scroll_y_ = yscrollbar_.value();
+    }
+
+    draw_ink_box();
+
+    fl_pop_clip();
+  }
+
+  draw_label(X, Y, W, H - 2 * labelsize());
+
+  if (factor_)
+  {
+    if (damage() & FL_DAMAGE_SCROLL)
+    {
+      update_child(xscrollbar_);
+      update_child(yscrollbar_);
+    }
+    else
+    {
+      draw_child(xscrollbar_);
+      draw_child(yscrollbar_);
+    }
+  }
+}
+
+
+//
+// 'RasterDisplay::draw_ink_box()' - Outline the ink bounding box of the page.
+//
+
+void
+RasterDisplay::draw_ink_box()
+{
+  const unsigned	*box;		// Ink bounding box
+  int			bx, by,		// Top-left corner on screen
+			bw, bh;		// Size on screen
+
+
+  if (!show_ink_box_ || (box = ink_box(page_)) == NULL || !header_.cupsWidth || !header_.cupsHeight)
+    return;
+
+  bx = image_x_ + (int)((double)box[0] * xsize_ / header_.cupsWidth);
+  by = image_y_ + (int)((double)box[1] * ysize_ / header_.cupsHeight);
+  bw = image_x_ + (int)((double)box[2] * xsize_ / header_.cupsWidth + 0.999) - bx;
+  bh = image_y_ + (int)((double)box[3] * ysize_ / header_.cupsHeight + 0.999) - by;
+
+  fl_color(FL_BLUE);
+  fl_line_style(FL_DASH);
+  fl_rect(bx, by, bw < 1 ? 1 : bw, bh < 1 ? 1 : bh);
+  fl_line_style(0);
+}
+
+
+//
+// 'RasterDisplay::draw_tiles()' - Draw the tiles covering part of the window.
+//
+// At 1:1 the page buffer is drawn directly without any tiles or copying.
+// Otherwise tiles are scaled at the screen's device resolution...
+//
+
+void
+RasterDisplay::draw_tiles(int X,	// I - X position on screen
+                          int Y,	// I - Y position on screen
+                          int W,	// I - Width on screen
+                          int H)	// I - Height on screen
+{
+  int		tx, ty,			// Current tile
+		tx0, ty0,		// First tile
+		tx1, ty1;		// Last tile
+  Fl_RGB_Image	*tile;			// Current tile image
+
+
+  // Convert the screen area to the range of tiles in the scaled image...
+  X -= image_x_;
+  Y -= image_y_;
+
+  if (X < 0)
+  {
+    W += X;
+    X = 0;
+  }
+
+  if (Y < 0)
+  {
+    H += Y;
+    Y = 0;
+  }
+
+  if ((X + W) > xsize_)
+    W = xsize_ - X;
+
+  if ((Y + H) > ysize_)
+    H = ysize_ - Y;
+
+  if (W <= 0 || H <= 0)
+    return;
+
+  if (xsize_ == (int)header_.cupsWidth && ysize_ == (int)header_.cupsHeight && !channels_ && !show_ink_ && !can_diff())
+  {
+    // 1:1, draw straight from the page buffer...
+    const uchar *ptr = pixels_ + ((long)Y * header_.cupsWidth + X) * bpp_;
+					// First pixel
+
+    if (bpp_ == 1)
+      fl_draw_image_mono(ptr, image_x_ + X, image_y_ + Y, W, H, 1, header_.cupsWidth);
+    else
+      fl_draw_image(ptr, image_x_ + X, image_y_ + Y, W, H, 3, header_.cupsWidth * 3);
+    return;
+  }
+
+  tx0 = X / RASTER_TILE_SIZE;
+  tx1 = (X + W - 1) / RASTER_TILE_SIZE;
+  ty0 = Y / RASTER_TILE_SIZE;
+  ty1 = (Y + H - 1) / RASTER_TILE_SIZE;
+
+  for (ty = ty0; ty <= ty1; ty ++)
+  {
+    for (tx = tx0; tx <= tx1; tx ++)
+    {
+      if ((tile = get_tile(tx, ty)) != NULL)
+        tile->draw(image_x_ + tx * RASTER_TILE_SIZE, image_y_ + ty * RASTER_TILE_SIZE);
+    }
+  }
+}
+
+
+//
+// 'RasterDisplay::flush_tiles()' - Free all cached tiles.
+//
+
+void
+RasterDisplay::flush_tiles()
+{
+  int	i;				// Looping var
+
+
+  for (i = 0; i < num_tiles_; i ++)
+    delete tiles_[i].image;
+
+  num_tiles_ = 0;
+}
+
+
+//
+// 'RasterDisplay::get_color()' - Return the original color value for a coordinate.
+//
+
+uchar *					// O - Color values or NULL
+RasterDisplay::get_color(int X,		// I - X position in image
+                         int Y)		// I - Y position in image
 {
   if (!colors_ || X < 0 || X >= (int)header_.cupsWidth ||
       Y < 0 || Y >= (int)header_.cupsHeight)
     return (NULL);
-  else
-    return (colors_ + (Y * header_.cupsWidth + X) * bpc_);
+
+  if (pending_y_ >= 0 && pending_[Y])
+    convert_row(Y);
+
+  return (colors_ + (Y * header_.cupsWidth + X) * bpc_);
 }
 
 
@@ -306,8 +1136,142 @@ RasterDisplay::get_pixel(int X,		// I - X position in image
   if (!pixels_ || X < 0 || X >= (int)header_.cupsWidth ||
       Y < 0 || Y >= (int)header_.cupsHeight)
     return (NULL);
+
+  if (pending_y_ >= 0 && pending_[Y])
+    convert_row(Y);
+
+  return (pixels_ + (Y * header_.cupsWidth + X) * bpp_);
+}
+
+
+//
+// 'RasterDisplay::get_tile()' - Get a tile of the scaled image, scaling it as
+//                               needed.
+//
+
+Fl_RGB_Image *				// O - Tile image or NULL
+RasterDisplay::get_tile(int tx,		// I - Tile column
+                        int ty)		// I - Tile row
+{
+  int		i,			// Looping var
+		X, Y,			// Position in scaled image
+		W, H,			// Size of tile
+		DX, DY,			// Position in device pixels
+		DW, DH,			// Size in device pixels
+		depth;			// Bytes per tile pixel
+  raster_tile_t	*tile;			// Current tile
+  uchar		*data,			// Tile pixels
+		*dptr,			// Pointer into tile pixels
+		*scaled = NULL;		// Scaled pixels for difference tiles
+
+
+  // See if the tile is already cached...
+  for (i = num_tiles_, tile = tiles_; i > 0; i --, tile ++)
+  {
+    if (tile->tx == tx && tile->ty == ty && tile->page == page_ && tile->xsize == dxsize_ && tile->ysize == dysize_)
+    {
+      tile->used = ++ tile_used_;
+      return (tile->image);
+    }
+  }
+
+  // Not cached, scale the pixels for this tile...
+  X = tx * RASTER_TILE_SIZE;
+  Y = ty * RASTER_TILE_SIZE;
+  W = xsize_ - X;
+  H = ysize_ - Y;
+
+  if (W <= 0 || H <= 0)
+    return (NULL);
+
+  if (W > RASTER_TILE_SIZE)
+    W = RASTER_TILE_SIZE;
+  if (H > RASTER_TILE_SIZE)
+    H = RASTER_TILE_SIZE;
+
+  DX = (int)(X * screen_scale_ + 0.5f);
+  DY = (int)(Y * screen_scale_ + 0.5f);
+  DW = (int)((X + W) * screen_scale_ + 0.5f);
+  DH = (int)((Y + H) * screen_scale_ + 0.5f);
+
+  if (DW > dxsize_)
+    DW = dxsize_;
+  if (DH > dysize_)
+    DH = dysize_;
+
+  DW -= DX;
+  DH -= DY;
+
+  if (DW <= 0 || DH <= 0)
+    return (NULL);
+
+  // Differences are drawn in color over a faded copy of the page...
+  if (can_diff())
+  {
+    depth  = 3;
+    scaled = new uchar[DW * bpp_];
+  }
   else
-    return (pixels_ + (Y * header_.cupsWidth + X) * bpp_);
+    depth = bpp_;
+
+  if ((data = new uchar[DW * DH * depth]) == NULL)
+  {
+    delete[] scaled;
+    return (NULL);
+  }
+
+  for (i = 0, dptr = data; i < DH; i ++, dptr += DW * depth)
+  {
+    if (scaled)
+    {
+      scale_line(DX, DY + i, DW, scaled);
+      overlay_diff(DX, DY + i, DW, scaled, dptr);
+    }
+    else
+    {
+      scale_line(DX, DY + i, DW, dptr);
+      overlay_ink(DX, DY + i, DW, dptr);
+    }
+  }
+
+  delete[] scaled;
+
+  // Add it to the cache, replacing the least recently used tile as needed...
+  if (num_tiles_ < RASTER_MAX_TILES)
+  {
+    tile = tiles_ + num_tiles_;
+    num_tiles_ ++;
+  }
+  else
+  {
+    raster_tile_t *oldest;		// Least recently used tile
+
+    for (i = num_tiles_, tile = tiles_, oldest = tiles_; i > 0; i --, tile ++)
+    {
+      if (tile->used < oldest->used)
+        oldest = tile;
+    }
+
+    tile = oldest;
+    delete tile->image;
+  }
+
+  tile->page  = page_;
+  tile->xsize = dxsize_;
+  tile->ysize = dysize_;
+  tile->tx    = tx;
+  tile->ty    = ty;
+  tile->used  = ++ tile_used_;
+  tile->image = new Fl_RGB_Image(data, DW, DH, depth);
+
+  tile->image->alloc_array = 1;
+
+#if FL_API_VERSION >= 10400
+  if (DW != W || DH != H)
+    tile->image->scale(W, H, 0, 1);
+#endif // FL_API_VERSION >= 10400
+
+  return (tile->image);
 }
 
 
@@ -406,6 +1370,9 @@ RasterDisplay::handle(int event)	// I - Event to handle
 	    start_ex_ = Fl::event_x();
 	    start_ey_ = Fl::event_y();
 
+            // Shift-drag to get the statistics of a region...
+	    region_ = mode_ == RASTER_MODE_CLICK && (Fl::event_state() & FL_SHIFT);
+
             if (mode_ == RASTER_MODE_CLICK)
 	      do_callback();
 
@@ -434,6 +1401,16 @@ RasterDisplay::handle(int event)	// I - Event to handle
 				Fl::event_y() - start_ey_);
 	        break;
 	    case RASTER_MODE_CLICK :
+	        if (region_)
+	        {
+		  window()->make_current();
+
+		  fl_overlay_rect(start_ex_, start_ey_,
+	                	  Fl::event_x() - start_ex_,
+				  Fl::event_y() - start_ey_);
+	        }
+
+		update_mouse_xy();
 		do_callback();
                 break;
           }
@@ -501,6 +1478,12 @@ RasterDisplay::handle(int event)	// I - Event to handle
 		break;
 
 	    case RASTER_MODE_CLICK :
+	        if (region_)
+	        {
+		  window()->make_current();
+		  fl_overlay_clear();
+	        }
+
 		do_callback();
 		break;
           }
@@ -532,5130 +1515,2843 @@ RasterDisplay::handle(int event)	// I - Event to handle
 
 	    position((int)(mouse_x_ * scale()) - W / 2, (int)(mouse_y_ * scale()) - H / 2);
           }
-          return (1);
-    }
-  }
-
-  return (Fl_Group::handle(event));
-}
-
-
-//
-// 'RasterDisplay::image_cb()' - Provide a single line of an image.
-//
-
-void
-RasterDisplay::image_cb(void  *p,	// I - Raster display widget
-                	int   X,	// I - X offset
-			int   Y,	// I - Y offset
-			int   W,	// I - Width of image row
-			uchar *D)	// O - Image data
-{
-  RasterDisplay		*display;	// Display widget
-  const uchar		*inptr;		// Pointer into image
-  int			bpp,		// Bytes per pixel value
-			xerr,		// Bresenheim values
-			xstep,		// ...
-			xmod,		// ...
-			xsize;		// ...
-
-
-//  printf("image_cb(p=%p, X=%d, Y=%d, W=%d, D=%p)\n", p, X, Y, W, D);
-
-  display = (RasterDisplay *)p;
-  bpp     = display->bpp_;
-  xstep   = display->xstep_ * bpp;
-  xmod    = display->xmod_;
-  xsize   = display->xsize_;
-  xerr    = ((X + display->xscrollbar_.value()) * xmod) % xsize;
-  X       = (X + display->xscrollbar_.value()) * display->header_.cupsWidth / xsize;
-  Y       = (Y + display->yscrollbar_.value()) * display->header_.cupsHeight / display->ysize_;
-  inptr   = display->pixels_ + (Y * display->header_.cupsWidth + X) * bpp;
-
-  if (xstep == bpp && xmod == 0)
-  {
-    memcpy(D, inptr, (size_t)W * bpp);
-  }
-  else if (bpp == 1)
-  {
-    for (; W > 0; W --)
-    {
-      *D++ = *inptr;
-
-      inptr += xstep;
-      xerr  += xmod;
-
-      if (xerr >= xsize)
-      {
-	xerr  -= xsize;
-	inptr += bpp;
-      }
-    }
-  }
-  else
-  {
-    for (; W > 0; W --)
-    {
-      *D++ = inptr[0];
-      *D++ = inptr[1];
-      *D++ = inptr[2];
-
-      inptr += xstep;
-      xerr  += xmod;
-
-      if (xerr >= xsize)
-      {
-	xerr  -= xsize;
-	inptr += bpp;
-      }
-    }
-  }
-}
-
-
-//
-// 'RasterDisplay::is_subtractive()' - Is the color space subtractive?
-//
-
-int
-RasterDisplay::is_subtractive()
-{
-  return ((header_.cupsColorSpace >= CUPS_CSPACE_K && header_.cupsColorSpace <= CUPS_CSPACE_SILVER) ||
-          (header_.cupsColorSpace >= CUPS_CSPACE_DEVICE1 && header_.cupsColorSpace <= CUPS_CSPACE_DEVICEF));
+          return (1);
+    }
+  }
+
+  return (Fl_Group::handle(event));
 }
 
 
 //
-// 'RasterDisplay::load_colors()' - Load device colors.
+// 'RasterDisplay::histogram()' - Get the histogram of the current page.
+//
+// The histogram is computed in the background once the page is loaded and
+// converted.  NULL is returned until it is ready...
 //
 
-void
-RasterDisplay::load_colors()
+const raster_histogram_t *		// O - Histogram or NULL if not ready
+RasterDisplay::histogram()
 {
-  int		i;			// Looping var
-  char		key[256],		// Key string
-		*value;			// Value
-  unsigned	c, m ,y;		// Colors
-
-
-  if (!is_subtractive() || header_.cupsBitsPerColor < 8)
-    return;
+  if (!colors_ || !header_.cupsWidth || !header_.cupsHeight || loading_ || pending_y_ >= 0)
+    return (NULL);
 
-  if (!prefs)
-    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
+  if (histogram_state_ == RASTER_HISTOGRAM_DONE)
+    return (&histogram_);
 
-  for (i = 0; i < header_.cupsNumColors; i ++)
+  if (histogram_state_ == RASTER_HISTOGRAM_NONE)
   {
-    snprintf(key, sizeof(key), "cs%dc%d", header_.cupsColorSpace, i);
+    if (histogram_thread_.joinable())
+      histogram_thread_.join();
 
-    if (prefs->get(key, value, "") && sscanf(value, "%u %u %u", &c, &m, &y) == 3)
-    {
-      device_colors_[i][0] = c;
-      device_colors_[i][1] = m;
-      device_colors_[i][2] = y;
-    }
+    histogram_state_  = RASTER_HISTOGRAM_RUNNING;
+    histogram_cancel_ = 0;
+    histogram_thread_ = std::thread(histogram_cb, this);
   }
+
+  return (NULL);
 }
 
 
 //
-// 'RasterDisplay::load_page()' - Load the next page from a raster stream.
+// 'RasterDisplay::histogram_band_cb()' - Count the channel values in a band.
 //
 
-int					// O - 1 on success, 0 on failure
-RasterDisplay::load_page()
+void
+RasterDisplay::histogram_band_cb(
+    void *b)				// I - Band
 {
-  union
+  raster_bins_t		*bins = (raster_bins_t *)b;
+					// Band and bins
+  RasterDisplay		*display = bins->display;
+					// Display widget
+  cups_page_header_t	*header = &display->header_;
+					// Page header
+  int			x, y,		// Looping vars
+			c,		// Current channel
+			nchannels = (int)header->cupsNumColors,
+					// Number of channels
+			width = (int)header->cupsWidth,
+					// Width of page
+			shift;		// Shift to get bin
+  unsigned		val;		// Channel value
+  const uchar		*color;		// Current color
+
+
+  memset(bins->counts, 0, sizeof(bins->counts));
+  memset(bins->totals, 0, sizeof(bins->totals));
+
+  shift = header->cupsBitsPerColor == 16 ? 8 : 0;
+
+  for (y = bins->first; y < bins->last && !display->histogram_cancel_; y ++)
   {
-    unsigned char	bytes[sizeof(int)];
-    int			integer;
-  }	endian_test;			// Endian test variable
-
+    color = display->colors_ + (long)y * width * display->bpc_;
 
-  if (!ras_ || page_ >= num_pages_)
-    return (0);
+    if (header->cupsColorOrder == CUPS_ORDER_CHUNKED && header->cupsBitsPerColor == 8)
+    {
+      // Common case, count the bytes...
+      for (x = 0; x < width; x ++, color += display->bpc_)
+      {
+        for (c = 0; c < nchannels; c ++)
+          bins->counts[c][color[c]] ++;
+      }
+    }
+    else
+    {
+      for (x = 0; x < width; x ++, color += display->bpc_)
+      {
+        for (c = 0; c < nchannels; c ++)
+        {
+          val = rasterChannelValue(header, display->bpc_, color, c);
 
-  if (!cupsRasterReadHeader(ras_, &header_))
-  {
-    int err;
-    fl_alert("Unable to read page header: %s", gzerror(fp_, &err));
-    return (0);
+          bins->counts[c][val >> shift] ++;
+          bins->totals[c] += val;
+        }
+      }
+    }
   }
 
-  page_ ++;
-
-  if (header_.cupsColorOrder == CUPS_ORDER_PLANAR)
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED && header->cupsBitsPerColor == 8)
   {
-    fl_alert("Sorry, RasterView doesn't support planar raster data at this time.");
-    return (0);
+    // Totals come from the bins...
+    for (c = 0; c < nchannels; c ++)
+    {
+      for (x = 1; x < 256; x ++)
+        bins->totals[c] += (unsigned long long)x * bins->counts[c][x];
+    }
   }
+}
 
-  // Allocate memory for the page data...
-#ifdef DEBUG
-  fprintf(stderr, "DEBUG: sizeof(cups_page_header_t) = %d\n", (int)sizeof(cups_page_header_t));
-  fprintf(stderr, "DEBUG: sizeof(cups_page_header_t) = %d\n", (int)sizeof(cups_page_header_t));
-  fprintf(stderr, "DEBUG: MediaClass = \"%s\"\n", header_.MediaClass);
-  fprintf(stderr, "DEBUG: MediaColor = \"%s\"\n", header_.MediaColor);
-  fprintf(stderr, "DEBUG: MediaType = \"%s\"\n", header_.MediaType);
-  fprintf(stderr, "DEBUG: OutputType = \"%s\"\n", header_.OutputType);
-
-  fprintf(stderr, "DEBUG: AdvanceDistance = %d(%x)\n", header_.AdvanceDistance,
-          header_.AdvanceDistance);
-  fprintf(stderr, "DEBUG: AdvanceMedia = %d(%x)\n", header_.AdvanceMedia,
-          header_.AdvanceMedia);
-  fprintf(stderr, "DEBUG: Collate = %d(%x)\n", header_.Collate,
-          header_.Collate);
-  fprintf(stderr, "DEBUG: CutMedia = %d(%x)\n", header_.CutMedia,
-          header_.CutMedia);
-  fprintf(stderr, "DEBUG: Duplex = %d(%x)\n", header_.Duplex, header_.Duplex);
-  fprintf(stderr, "DEBUG: HWResolution = [ %d(%x) %d(%x) ]\n",
-          header_.HWResolution[0], header_.HWResolution[0],
-          header_.HWResolution[1], header_.HWResolution[1]);
-  fprintf(stderr,
-          "DEBUG: ImagingBoundingBox = [ %d(%x) %d(%x) %d(%x) %d(%x) ]\n",
-          header_.ImagingBoundingBox[0], header_.ImagingBoundingBox[0],
-	  header_.ImagingBoundingBox[1], header_.ImagingBoundingBox[1],
-	  header_.ImagingBoundingBox[2], header_.ImagingBoundingBox[2],
-          header_.ImagingBoundingBox[3], header_.ImagingBoundingBox[3]);
-  fprintf(stderr, "DEBUG: InsertSheet = %d(%x)\n", header_.InsertSheet,
-          header_.InsertSheet);
-  fprintf(stderr, "DEBUG: Jog = %d(%x)\n", header_.Jog, header_.Jog);
-  fprintf(stderr, "DEBUG: LeadingEdge = %d(%x)\n", header_.LeadingEdge,
-          header_.LeadingEdge);
-  fprintf(stderr, "DEBUG: Margins = [ %d(%x) %d(%x) ]\n",
-          header_.Margins[0], header_.Margins[0],
-          header_.Margins[1], header_.Margins[1]);
-  fprintf(stderr, "DEBUG: ManualFeed = %d(%x)\n", header_.ManualFeed,
-          header_.ManualFeed);
-  fprintf(stderr, "DEBUG: MediaPosition = %d(%x)\n", header_.MediaPosition,
-          header_.MediaPosition);
-  fprintf(stderr, "DEBUG: MediaWeight = %d(%x)\n", header_.MediaWeight,
-          header_.MediaWeight);
-  fprintf(stderr, "DEBUG: MirrorPrint = %d(%x)\n", header_.MirrorPrint,
-          header_.MirrorPrint);
-  fprintf(stderr, "DEBUG: NegativePrint = %d(%x)\n", header_.NegativePrint,
-          header_.NegativePrint);
-  fprintf(stderr, "DEBUG: NumCopies = %d(%x)\n", header_.NumCopies,
-          header_.NumCopies);
-  fprintf(stderr, "DEBUG: Orientation = %d(%x)\n", header_.Orientation,
-          header_.Orientation);
-  fprintf(stderr, "DEBUG: OutputFaceUp = %d(%x)\n", header_.OutputFaceUp,
-          header_.OutputFaceUp);
-  fprintf(stderr, "DEBUG: PageSize = [ %d(%x) %d(%x) ]\n",
-          header_.PageSize[0], header_.PageSize[0],
-          header_.PageSize[1], header_.PageSize[1]);
-  fprintf(stderr, "DEBUG: Separations = %d(%x)\n", header_.Separations,
-          header_.Separations);
-  fprintf(stderr, "DEBUG: TraySwitch = %d(%x)\n", header_.TraySwitch,
-          header_.TraySwitch);
-  fprintf(stderr, "DEBUG: Tumble = %d(%x)\n", header_.Tumble, header_.Tumble);
-  fprintf(stderr, "DEBUG: cupsWidth = %d(%x)\n", header_.cupsWidth,
-          header_.cupsWidth);
-  fprintf(stderr, "DEBUG: cupsHeight = %d(%x)\n", header_.cupsHeight,
-          header_.cupsHeight);
-  fprintf(stderr, "DEBUG: cupsMediaType = %d(%x)\n", header_.cupsMediaType,
-          header_.cupsMediaType);
-  fprintf(stderr, "DEBUG: cupsBitsPerColor = %d(%x)\n",
-          header_.cupsBitsPerColor, header_.cupsBitsPerColor);
-  fprintf(stderr, "DEBUG: cupsBitsPerPixel = %d(%x)\n",
-          header_.cupsBitsPerPixel, header_.cupsBitsPerPixel);
-  fprintf(stderr, "DEBUG: cupsBytesPerLine = %d(%x)\n",
-          header_.cupsBytesPerLine, header_.cupsBytesPerLine);
-  fprintf(stderr, "DEBUG: cupsColorOrder = %d(%x)\n", header_.cupsColorOrder,
-          header_.cupsColorOrder);
-  fprintf(stderr, "DEBUG: cupsColorSpace = %d(%x)\n", header_.cupsColorSpace,
-          header_.cupsColorSpace);
-  fprintf(stderr, "DEBUG: cupsCompression = %d(%x)\n", header_.cupsCompression,
-          header_.cupsCompression);
-  fprintf(stderr, "DEBUG: cupsNumColors = %d(%x)\n", header_.cupsNumColors,
-          header_.cupsNumColors);
-#endif // DEBUG
 
-  bpp_ = header_.cupsNumColors == 1 ? 1 : 3;
+//
+// 'RasterDisplay::histogram_cb()' - Compute the histogram of the current page.
+//
+// Each thread counts a band of rows into its own bins, which are then
+// merged...
+//
 
-  if (header_.cupsWidth == 0 || header_.cupsWidth > 1000000 || header_.cupsHeight == 0 || header_.cupsHeight > 1000000)
+void
+RasterDisplay::histogram_cb(void *d)	// I - Raster display widget
+{
+  RasterDisplay		*display = (RasterDisplay *)d;
+					// Display widget
+  cups_page_header_t	*header = &display->header_;
+					// Page header
+  raster_histogram_t	*histogram = &display->histogram_;
+					// Histogram
+  int			i, c, v,	// Looping vars
+			nbands;		// Number of bands
+  raster_bins_t		*bins;		// Bins for each band
+  std::thread		threads[RASTER_MAX_THREADS];
+					// Threads
+
+
+  nbands = (int)std::thread::hardware_concurrency();
+
+  if (nbands < 1)
+    nbands = 1;
+  if (nbands > RASTER_MAX_THREADS)
+    nbands = RASTER_MAX_THREADS;
+  if (nbands > (int)header->cupsHeight)
+    nbands = (int)header->cupsHeight;
+
+  if ((bins = new raster_bins_t[nbands]) == NULL)
   {
-    fl_alert("Sorry, image dimensions are out of range (%ux%u).", header_.cupsWidth, header_.cupsHeight);
-    return (0);
+    display->histogram_state_ = RASTER_HISTOGRAM_NONE;
+    return;
   }
 
-  long	pixelsize = (long)header_.cupsWidth * bpp_;
-  long	bytes = pixelsize * header_.cupsHeight;
-
-  if (bytes >= INT_MAX)
+  for (i = 0; i < nbands; i ++)
   {
-    fl_alert("Sorry, image is too large to display (%ux%ux%u >= 2GB).", header_.cupsWidth, header_.cupsHeight, header_.cupsBitsPerPixel);
-    return (0);
+    bins[i].display = display;
+    bins[i].first   = (int)((long)i * header->cupsHeight / nbands);
+    bins[i].last    = (int)((long)(i + 1) * header->cupsHeight / nbands);
   }
 
-  if (bytes > alloc_pixels_)
-  {
-    if (pixels_)
-      delete[] pixels_;
-
-    pixels_       = new uchar[bytes];
-    alloc_pixels_ = bytes;
+  for (i = 1; i < nbands; i ++)
+    threads[i] = std::thread(histogram_band_cb, bins + i);
 
-    if (!pixels_)
-    {
-      fl_alert("Unable to allocate %ld bytes for page data.", bytes);
-      return (0);
-    }
-  }
+  histogram_band_cb(bins);
 
-  bpc_ = (header_.cupsBitsPerPixel + 7) / 8;
+  for (i = 1; i < nbands; i ++)
+    threads[i].join();
 
-  if (header_.cupsColorOrder != CUPS_ORDER_CHUNKED)
-    bpc_ *= header_.cupsNumColors;
+  // Merge the bins...
+  memset(histogram, 0, sizeof(raster_histogram_t));
 
-  long colorsize = (long)header_.cupsWidth * bpc_;
+  histogram->num_channels = (int)header->cupsNumColors;
 
-  bytes = colorsize * header_.cupsHeight;
+  if (header->cupsBitsPerColor == 16)
+    histogram->levels = 256;
+  else
+    histogram->levels = 1 << header->cupsBitsPerColor;
 
-  if (bytes > alloc_colors_)
+  for (c = 0; c < histogram->num_channels; c ++)
   {
-    if (colors_)
-      delete[] colors_;
-
-    colors_       = new uchar[bytes];
-    alloc_colors_ = bytes;
+    double total = 0.0;			// Total of channel values
 
-    if (!colors_)
+    for (i = 0; i < nbands; i ++)
     {
-      fl_alert("Unable to allocate %ld bytes for page data.", bytes);
-      return (0);
+      for (v = 0; v < histogram->levels; v ++)
+        histogram->counts[c][v] += bins[i].counts[c][v];
+
+      total += (double)bins[i].totals[c];
     }
+
+    histogram->coverage[c] = rasterInkCoverage(header, total);
   }
 
-  // Update the page dimensions/scaling...
-  resize(x(), y(), w(), h());
+  delete[] bins;
 
-  memset(colors_, 0, alloc_colors_);
-  memset(pixels_, 255, alloc_pixels_);
+  if (display->histogram_cancel_)
+    display->histogram_state_ = RASTER_HISTOGRAM_NONE;
+  else
+    display->histogram_state_ = RASTER_HISTOGRAM_DONE;
+}
 
-  uchar *line = new uchar[header_.cupsBytesPerLine];
 
-  if (!line)
-  {
-    fl_alert("Unable to allocate %d bytes for raster data.", header_.cupsBytesPerLine);
-    return (0);
-  }
+//
+// 'RasterDisplay::image_cb()' - Provide a single line of an image.
+//
 
-  // See what word order we need to use...
-  if (endian_offset < 0)
-  {
-    memset(&endian_test, 0, sizeof(endian_test));
-    endian_test.bytes[sizeof(endian_test.bytes) - 1] = 1;
-    if (endian_test.integer == 1)
-      endian_offset = 0;		// Big endian
-    else
-      endian_offset = 1;		// Little endian
-  }
+void
+RasterDisplay::image_cb(void  *p,	// I - Raster display widget
+                	int   X,	// I - X offset
+			int   Y,	// I - Y offset
+			int   W,	// I - Width of image row
+			uchar *D)	// O - Image data
+{
+  RasterDisplay	*display = (RasterDisplay *)p;
+					// Display widget
 
-  // Set device colors...
-  memset(device_colors_, 255, sizeof(device_colors_));
-
-  switch (header_.cupsColorSpace)
-  {
-    case CUPS_CSPACE_DEVICE3 :
-    case CUPS_CSPACE_DEVICE4 :
-    case CUPS_CSPACE_CMY :
-    case CUPS_CSPACE_CMYK :
-        device_colors_[0][1] = device_colors_[0][2] = 0;
-        device_colors_[1][0] = device_colors_[1][2] = 0;
-        device_colors_[2][0] = device_colors_[2][1] = 0;
-	break;
-
-    case CUPS_CSPACE_YMC :
-    case CUPS_CSPACE_YMCK :
-        device_colors_[0][0] = device_colors_[0][1] = 0;
-        device_colors_[1][0] = device_colors_[1][2] = 0;
-        device_colors_[2][1] = device_colors_[2][2] = 0;
-        break;
 
-    case CUPS_CSPACE_DEVICE6 :
-        device_colors_[0][1] = device_colors_[0][2] = 0;
-        device_colors_[1][0] = device_colors_[1][2] = 0;
-        device_colors_[2][0] = device_colors_[2][1] = 0;
-        device_colors_[4][0] = 127; device_colors_[4][1] = device_colors_[4][2] = 0;
-        device_colors_[5][1] = 127; device_colors_[5][0] = device_colors_[5][2] = 0;
-	break;
-
-    case CUPS_CSPACE_W :
-    case CUPS_CSPACE_SW :
-        device_colors_[0][0] = device_colors_[0][1] = device_colors_[0][2] = 0;
-        break;
+//  printf("image_cb(p=%p, X=%d, Y=%d, W=%d, D=%p)\n", p, X, Y, W, D);
 
-    case CUPS_CSPACE_RGB :
-    case CUPS_CSPACE_SRGB :
-    case CUPS_CSPACE_ADOBERGB :
-        device_colors_[0][0] = 0;
-        device_colors_[1][1] = 0;
-        device_colors_[2][2] = 0;
-        break;
+  display->scale_line(X + display->xscrollbar_.value(), Y + display->yscrollbar_.value(), W, D);
+  display->overlay_ink(X + display->xscrollbar_.value(), Y + display->yscrollbar_.value(), W, D);
+}
 
-    default :
-        break;
-  }
 
-  load_colors();
+//
+// 'RasterDisplay::ink_limit()' - Set the total ink limit.
+//
 
-  // Read the raster data...
-  uchar *pptr,				// Pointer into pixels_
-	*cptr;				// Pointer into colors_
-  int	py;				// Current position in page
+void
+RasterDisplay::ink_limit(int percent)	// I - Total ink limit in percent
+{
+  if (percent < 1)
+    percent = 1;
+  else if (percent > 1500)
+    percent = 1500;
 
-  for (py = header_.cupsHeight, cptr = colors_, pptr = pixels_;
-       py > 0;
-       py --, cptr += colorsize, pptr += pixelsize)
-  {
-    if ((py % header_.HWResolution[1]) == 0)
-    {
-      // Update the screen to show progress...
-      redraw();
-      Fl::check();
-    }
+  if (percent == ink_limit_)
+    return;
 
-    if (!cupsRasterReadPixels(ras_, line, header_.cupsBytesPerLine))
-    {
-      fl_alert("Unable to read page data: %s", strerror(errno));
-      delete[] line;
-      return (0);
-    }
+  ink_limit_ = percent;
 
-    switch (header_.cupsColorSpace)
-    {
-      case CUPS_CSPACE_DEVICE1 :
-      case CUPS_CSPACE_DEVICE2 :
-      case CUPS_CSPACE_DEVICE3 :
-      case CUPS_CSPACE_DEVICE4 :
-      case CUPS_CSPACE_DEVICE5 :
-      case CUPS_CSPACE_DEVICE6 :
-      case CUPS_CSPACE_DEVICE7 :
-      case CUPS_CSPACE_DEVICE8 :
-      case CUPS_CSPACE_DEVICE9 :
-      case CUPS_CSPACE_DEVICEA :
-      case CUPS_CSPACE_DEVICEB :
-      case CUPS_CSPACE_DEVICEC :
-      case CUPS_CSPACE_DEVICED :
-      case CUPS_CSPACE_DEVICEE :
-      case CUPS_CSPACE_DEVICEF :
-          convert_device(&header_, line, cptr, pptr, device_colors_);
-          break;
+  if (!prefs)
+    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
 
-      case CUPS_CSPACE_W :
-      case CUPS_CSPACE_SW :
-          convert_w(&header_, line, cptr, pptr);
-	  break;
+  prefs->set("inklimit", ink_limit_);
+  prefs->flush();
 
-      case CUPS_CSPACE_RGB :
-      case CUPS_CSPACE_SRGB :
-      case CUPS_CSPACE_ADOBERGB :
-          convert_rgb(&header_, line, cptr, pptr);
-	  break;
+  if (show_ink_)
+  {
+    flush_tiles();
+    redraw();
+  }
+}
 
-      case CUPS_CSPACE_RGBA :
-          convert_rgba(&header_, py, line, cptr, pptr);
-	  break;
 
-      case CUPS_CSPACE_RGBW :
-          convert_rgbw(&header_, line, cptr, pptr);
-	  break;
+//
+// 'RasterDisplay::ink_row()' - Compute the maximum total ink of a row of
+//                              blocks.
+//
 
-      case CUPS_CSPACE_K :
-      case CUPS_CSPACE_WHITE :
-      case CUPS_CSPACE_GOLD :
-      case CUPS_CSPACE_SILVER :
-	  convert_k(&header_, line, cptr, pptr);
-	  break;
+void
+RasterDisplay::ink_row(int by)		// I - Block row
+{
+  int		i, x, y,		// Looping vars
+		yend,			// Last row in block
+		c,			// Current channel
+		nchannels,		// Number of channels
+		width;			// Width of page
+  unsigned	total,			// Total ink for pixel
+		*totals;		// Total ink for each column
+  const uchar	*color;			// Current color
+  unsigned short *block;		// Current block
 
-      case CUPS_CSPACE_CMY :
-	  convert_cmy(&header_, line, cptr, pptr);
-	  break;
 
-      case CUPS_CSPACE_YMC :
-	  convert_ymc(&header_, line, cptr, pptr);
-	  break;
+  nchannels = (int)header_.cupsNumColors;
+  width     = (int)header_.cupsWidth;
+  block     = ink_ + (long)by * ((width + RASTER_INK_BLOCK - 1) / RASTER_INK_BLOCK);
 
-      case CUPS_CSPACE_KCMYcm :
-          if (header_.cupsBitsPerColor == 1)
-	  {
-	    convert_kcmycm(&header_, line, cptr, pptr);
-	    break;
-	  }
-      case CUPS_CSPACE_KCMY :
-	  convert_kcmy(&header_, line, cptr, pptr);
-	  break;
+  if ((yend = (by + 1) * RASTER_INK_BLOCK) > (int)header_.cupsHeight)
+    yend = (int)header_.cupsHeight;
 
-      case CUPS_CSPACE_CMYK :
-	  convert_cmyk(&header_, line, cptr, pptr);
-	  break;
+  if ((totals = new unsigned[width]) == NULL)
+    return;
 
-      case CUPS_CSPACE_YMCK :
-      case CUPS_CSPACE_GMCK :
-      case CUPS_CSPACE_GMCS :
-	  convert_ymck(&header_, line, cptr, pptr);
-	  break;
+  memset(totals, 0, (size_t)width * sizeof(unsigned));
 
-      case CUPS_CSPACE_CIEXYZ :
-          convert_xyz(&header_, line, cptr, pptr);
-	  break;
+  // Get the maximum total ink for each column in the block row...
+  for (y = by * RASTER_INK_BLOCK; y < yend; y ++)
+  {
+    if (pending_y_ >= 0 && pending_[y])
+      convert_row(y);
 
-      case CUPS_CSPACE_CIELab :
-      case CUPS_CSPACE_ICC1 :
-      case CUPS_CSPACE_ICC2 :
-      case CUPS_CSPACE_ICC3 :
-      case CUPS_CSPACE_ICC4 :
-      case CUPS_CSPACE_ICC5 :
-      case CUPS_CSPACE_ICC6 :
-      case CUPS_CSPACE_ICC7 :
-      case CUPS_CSPACE_ICC8 :
-      case CUPS_CSPACE_ICC9 :
-      case CUPS_CSPACE_ICCA :
-      case CUPS_CSPACE_ICCB :
-      case CUPS_CSPACE_ICCC :
-      case CUPS_CSPACE_ICCD :
-      case CUPS_CSPACE_ICCE :
-      case CUPS_CSPACE_ICCF :
-          convert_lab(&header_, line, cptr, pptr);
-	  break;
+    color = colors_ + (long)y * width * bpc_;
+
+    if (header_.cupsColorOrder == CUPS_ORDER_CHUNKED && header_.cupsBitsPerColor == 8)
+    {
+      // Common case, just add the bytes...
+      for (x = 0; x < width; x ++, color += bpc_)
+      {
+        for (c = 0, total = 0; c < nchannels; c ++)
+          total += color[c];
+
+        if (total > totals[x])
+          totals[x] = total;
+      }
+    }
+    else
+    {
+      for (x = 0; x < width; x ++, color += bpc_)
+      {
+        if ((total = ink_total(&header_, bpc_, color)) > totals[x])
+          totals[x] = total;
+      }
     }
   }
 
-  delete[] line;
+  // Then the maximum for each block...
+  for (x = 0; x < width; x += RASTER_INK_BLOCK, block ++)
+  {
+    for (i = x, total = 0; i < width && i < (x + RASTER_INK_BLOCK); i ++)
+    {
+      if (totals[i] > total)
+        total = totals[i];
+    }
 
-  // Mark the page for redisplay...
-  redraw();
+    *block = (unsigned short)total;
+  }
 
-  // Return successfully...
-  return (1);
+  delete[] totals;
+
+  ink_rows_[by] = 1;
 }
 
 
 //
-// 'RasterDisplay::open_file()' - Open a raster file for viewing.
+// 'RasterDisplay::is_subtractive()' - Is the color space subtractive?
 //
 
-int					// O - 1 on success, 0 on failure
-RasterDisplay::open_file(
-    const char *filename)		// I - File to open
+int
+RasterDisplay::is_subtractive()
 {
-  cups_page_header_t	header;		// Page header
-  uchar			*buffer = NULL;	// Line buffer
-  unsigned		bufsize = 0;	// Size of line buffer
-  unsigned		y;		// Current line
+  return ((header_.cupsColorSpace >= CUPS_CSPACE_K && header_.cupsColorSpace <= CUPS_CSPACE_SILVER) ||
+          (header_.cupsColorSpace >= CUPS_CSPACE_DEVICE1 && header_.cupsColorSpace <= CUPS_CSPACE_DEVICEF));
+}
 
 
-  close_file();
+//
+// 'RasterDisplay::load_bands()' - Decode and convert the current page using
+//                                 multiple threads.
+//
 
-  if ((fp_ = gzopen(filename, "r")) == NULL)
+int					// O - 1 on success, 0 on failure
+RasterDisplay::load_bands()
+{
+  int			i,		// Looping var
+			first,		// First index entry for page
+			count,		// Number of index entries for page
+			entry,		// Index entry for band
+			nbands,		// Number of bands
+			status = 1;	// Return status
+  raster_band_t		bands[RASTER_MAX_THREADS];
+					// Bands
+  std::thread		threads[RASTER_MAX_THREADS];
+					// Threads
+  std::atomic<int>	done(0);	// Number of finished bands
+
+
+  first  = page_index_[page_ - 1];
+  count  = page_index_[page_] - first;
+  nbands = (int)std::thread::hardware_concurrency();
+
+  if (nbands > count)
+    nbands = count;
+  if (nbands > RASTER_MAX_THREADS)
+    nbands = RASTER_MAX_THREADS;
+
+  for (i = 0; i < nbands; i ++)
   {
-    fl_alert("Unable to open file: %s", strerror(errno));
-    return (0);
+    entry = first + i * count / nbands;
+
+    bands[i].display = this;
+    bands[i].first   = (int)index_[entry].row;
+    bands[i].offset  = index_[entry].offset;
+    bands[i].done    = &done;
+
+    if (i > 0)
+      bands[i - 1].last = bands[i].first;
   }
 
-  if ((ras_ = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp_, CUPS_RASTER_READ)) == NULL)
+  bands[nbands - 1].last = (int)header_.cupsHeight;
+
+  for (i = 0; i < nbands; i ++)
+    threads[i] = std::thread(band_cb, bands + i);
+
+  // Update the screen to show progress until all of the bands are done...
+  while (done < nbands)
   {
-    fl_alert("Unable to read raster file header.");
-    gzclose(fp_);
-    fp_ = NULL;
-    return (0);
+    redraw();
+    Fl::wait(0.1);
   }
 
-  filename_ = strdup(filename);
+  for (i = 0; i < nbands; i ++)
+  {
+    threads[i].join();
 
-  // Figure out the number of pages and their offsets...
-  num_pages_ = 0;
-  pages_[0]  = gztell(fp_);
+    if (!bands[i].status)
+      status = 0;
+  }
 
-  while (cupsRasterReadHeader(ras_, &header))
-  {
-    num_pages_ ++;
+  return (status);
+}
 
-#ifdef DEBUG
-    fprintf(stderr, "PAGE %d: %ux%ux%u @ %ld\n", num_pages_, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, (long)pages_[num_pages_ - 1]);
-#endif // DEBUG
 
-    if (header.cupsBytesPerLine > bufsize)
-    {
-      bufsize = header.cupsBytesPerLine;
-      buffer  = (uchar *)realloc(buffer, bufsize);
-    }
+//
+// 'RasterDisplay::load_colors()' - Load device colors.
+//
 
-    for (y = header.cupsHeight; y > 0; y --)
-      cupsRasterReadPixels(ras_, buffer, header.cupsBytesPerLine);
+void
+RasterDisplay::load_colors()
+{
+  int		i;			// Looping var
+  char		key[256],		// Key string
+		*value;			// Value
+  unsigned	c, m ,y;		// Colors
 
-    if (num_pages_ >= RASTER_MAX_PAGES)
-      break;
 
-    pages_[num_pages_] = gztell(fp_) - rasterOffset(ras_);
-  }
+  if (!is_subtractive() || header_.cupsBitsPerColor < 8)
+    return;
 
-  gzseek(fp_, pages_[0], SEEK_SET);
-  rasterReset(ras_);
-  page_ = 0;
+  if (!prefs)
+    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
 
-  return (load_page());
+  for (i = 0; i < header_.cupsNumColors; i ++)
+  {
+    snprintf(key, sizeof(key), "cs%dc%d", header_.cupsColorSpace, i);
+
+    if (prefs->get(key, value, "") && sscanf(value, "%u %u %u", &c, &m, &y) == 3)
+    {
+      device_colors_[i][0] = c;
+      device_colors_[i][1] = m;
+      device_colors_[i][2] = y;
+    }
+  }
 }
 
 
 //
-// 'RasterDisplay::page()' - Return the current page number.
+// 'RasterDisplay::load_index()' - Load the cached page index for the file.
 //
 
-int					// O - Current page
-RasterDisplay::page(void)
+int					// O - 1 on success, 0 on failure
+RasterDisplay::load_index()
 {
-  return (page_);
-}
+  raster_cache_t	ident,		// Identity of current file
+			cache;		// Cache file header
+  char			cachefile[1024];// Cache filename
+  FILE			*fp;		// Cache file
+  raster_index_t	*temp;		// New index
+  int			i, j;		// Looping vars
+  int			status = 0;	// Return status
 
 
-/*
- * 'RasterDisplay::page()' - Set the current page number.
- */
+  if (!index_file(filename_, cachefile, sizeof(cachefile), &ident))
+    return (0);
 
-void
-RasterDisplay::page(int number)		// I - New page
-{
-  if (number < 1)
-    number = 1;
-  else if (number > num_pages_)
-    number = num_pages_;
+  if ((fp = fopen(cachefile, "rb")) == NULL)
+    return (0);
 
-  if (number == (page_ + 1))
-    this->load_page();
-  else if (number != page_)
+  if (fread(&cache, sizeof(cache), 1, fp) == 1 &&
+      !memcmp(cache.magic, ident.magic, sizeof(cache.magic)) &&
+      cache.offset_size == ident.offset_size &&
+      cache.size == ident.size && cache.mtime == ident.mtime &&
+      cache.hash == ident.hash && !strcmp(cache.path, ident.path) &&
+      cache.num_pages > 0 && cache.num_pages <= RASTER_MAX_PAGES &&
+      cache.num_index >= 0)
   {
-    gzseek(fp_, pages_[number - 1], SEEK_SET);
-    rasterReset(ras_);
+    if (cache.num_index > alloc_index_)
+    {
+      if ((temp = (raster_index_t *)realloc(index_, (size_t)cache.num_index * sizeof(raster_index_t))) != NULL)
+      {
+        index_       = temp;
+        alloc_index_ = cache.num_index;
+      }
+    }
 
-    page_ = number - 1;
-    this->load_page();
+    if (cache.num_index <= alloc_index_ &&
+        fread(pages_, sizeof(z_off_t), (size_t)cache.num_pages + 1, fp) == (size_t)cache.num_pages + 1 &&
+        fread(page_index_, sizeof(int), (size_t)cache.num_pages + 1, fp) == (size_t)cache.num_pages + 1 &&
+        fread(bbox_, sizeof(bbox_[0]), (size_t)cache.num_pages, fp) == (size_t)cache.num_pages &&
+        fread(hash_, sizeof(hash_[0]), (size_t)cache.num_pages, fp) == (size_t)cache.num_pages &&
+        fread(index_, sizeof(raster_index_t), (size_t)cache.num_index, fp) == (size_t)cache.num_index)
+    {
+      // Make sure the offsets and row index are consistent before using
+      // them, since a damaged cache would otherwise send us to the wrong
+      // place in the file or past the end of the index...
+      status = page_index_[0] >= 0 && page_index_[cache.num_pages] <= cache.num_index;
+
+      for (i = 0; status && i < cache.num_pages; i ++)
+      {
+        if (pages_[i + 1] <= pages_[i] || page_index_[i + 1] < page_index_[i])
+          status = 0;
+      }
+
+      for (i = 0; status && i < cache.num_pages; i ++)
+      {
+        for (j = page_index_[i] + 1; status && j < page_index_[i + 1]; j ++)
+        {
+          if (index_[j].row <= index_[j - 1].row)
+            status = 0;
+        }
+      }
+
+      if (status)
+      {
+        num_pages_ = cache.num_pages;
+        num_index_ = cache.num_index;
+      }
+    }
   }
+
+  fclose(fp);
+
+  // Mark the cache as recently used so it isn't pruned...
+  if (status)
+    utime(cachefile, NULL);
+
+  return (status);
 }
 
 
 //
-// 'RasterDisplay::position()' - Reposition the image on the screen.
+// 'RasterDisplay::load_page()' - Load the next page from a raster stream.
 //
 
-void
-RasterDisplay::position(int X,		// I - New X offset
-                        int Y)		// I - New Y offset
+int					// O - 1 on success, 0 on failure
+RasterDisplay::load_page()
 {
-  int	W, H;				// Interior size
 
+  if (!ras_ || page_ >= num_pages_)
+    return (0);
 
-  W = visible_w();
-  H = visible_h();
+  stop_histogram();
 
-  if (X < 0)
-    X = 0;
-  else if (X > (xsize_ - W))
-    X = xsize_ - W;
+  stats_valid_ = 0;
 
-  if (Y < 0)
-    Y = 0;
-  else if (Y > (ysize_ - H))
-    Y = ysize_ - H;
+  if (pending_y_ >= 0)
+  {
+    // Stop converting the previous page...
+    Fl::remove_idle(convert_cb, this);
+    pending_y_ = -1;
+  }
 
-  xscrollbar_.value(X, W, 0, xsize_);
-  yscrollbar_.value(Y, H, 0, ysize_);
+  if (!cupsRasterReadHeader(ras_, &header_))
+  {
+    int err;
+    fl_alert("Unable to read page header: %s", gzerror(fp_, &err));
+    return (0);
+  }
 
-  damage(FL_DAMAGE_SCROLL);
-}
+  page_ ++;
+
+  if (header_.cupsColorOrder == CUPS_ORDER_PLANAR)
+  {
+    fl_alert("Sorry, RasterView doesn't support planar raster data at this time.");
+    return (0);
+  }
 
+  // Allocate memory for the page data...
+#ifdef DEBUG
+  fprintf(stderr, "DEBUG: sizeof(cups_page_header_t) = %d\n", (int)sizeof(cups_page_header_t));
+  fprintf(stderr, "DEBUG: sizeof(cups_page_header_t) = %d\n", (int)sizeof(cups_page_header_t));
+  fprintf(stderr, "DEBUG: MediaClass = \"%s\"\n", header_.MediaClass);
+  fprintf(stderr, "DEBUG: MediaColor = \"%s\"\n", header_.MediaColor);
+  fprintf(stderr, "DEBUG: MediaType = \"%s\"\n", header_.MediaType);
+  fprintf(stderr, "DEBUG: OutputType = \"%s\"\n", header_.OutputType);
 
-//
-// 'RasterDisplay::resize()' - Resize the raster display widget.
-//
+  fprintf(stderr, "DEBUG: AdvanceDistance = %d(%x)\n", header_.AdvanceDistance,
+          header_.AdvanceDistance);
+  fprintf(stderr, "DEBUG: AdvanceMedia = %d(%x)\n", header_.AdvanceMedia,
+          header_.AdvanceMedia);
+  fprintf(stderr, "DEBUG: Collate = %d(%x)\n", header_.Collate,
+          header_.Collate);
+  fprintf(stderr, "DEBUG: CutMedia = %d(%x)\n", header_.CutMedia,
+          header_.CutMedia);
+  fprintf(stderr, "DEBUG: Duplex = %d(%x)\n", header_.Duplex, header_.Duplex);
+  fprintf(stderr, "DEBUG: HWResolution = [ %d(%x) %d(%x) ]\n",
+          header_.HWResolution[0], header_.HWResolution[0],
+          header_.HWResolution[1], header_.HWResolution[1]);
+  fprintf(stderr,
+          "DEBUG: ImagingBoundingBox = [ %d(%x) %d(%x) %d(%x) %d(%x) ]\n",
+          header_.ImagingBoundingBox[0], header_.ImagingBoundingBox[0],
+	  header_.ImagingBoundingBox[1], header_.ImagingBoundingBox[1],
+	  header_.ImagingBoundingBox[2], header_.ImagingBoundingBox[2],
+          header_.ImagingBoundingBox[3], header_.ImagingBoundingBox[3]);
+  fprintf(stderr, "DEBUG: InsertSheet = %d(%x)\n", header_.InsertSheet,
+          header_.InsertSheet);
+  fprintf(stderr, "DEBUG: Jog = %d(%x)\n", header_.Jog, header_.Jog);
+  fprintf(stderr, "DEBUG: LeadingEdge = %d(%x)\n", header_.LeadingEdge,
+          header_.LeadingEdge);
+  fprintf(stderr, "DEBUG: Margins = [ %d(%x) %d(%x) ]\n",
+          header_.Margins[0], header_.Margins[0],
+          header_.Margins[1], header_.Margins[1]);
+  fprintf(stderr, "DEBUG: ManualFeed = %d(%x)\n", header_.ManualFeed,
+          header_.ManualFeed);
+  fprintf(stderr, "DEBUG: MediaPosition = %d(%x)\n", header_.MediaPosition,
+          header_.MediaPosition);
+  fprintf(stderr, "DEBUG: MediaWeight = %d(%x)\n", header_.MediaWeight,
+          header_.MediaWeight);
+  fprintf(stderr, "DEBUG: MirrorPrint = %d(%x)\n", header_.MirrorPrint,
+          header_.MirrorPrint);
+  fprintf(stderr, "DEBUG: NegativePrint = %d(%x)\n", header_.NegativePrint,
+          header_.NegativePrint);
+  fprintf(stderr, "DEBUG: NumCopies = %d(%x)\n", header_.NumCopies,
+          header_.NumCopies);
+  fprintf(stderr, "DEBUG: Orientation = %d(%x)\n", header_.Orientation,
+          header_.Orientation);
+  fprintf(stderr, "DEBUG: OutputFaceUp = %d(%x)\n", header_.OutputFaceUp,
+          header_.OutputFaceUp);
+  fprintf(stderr, "DEBUG: PageSize = [ %d(%x) %d(%x) ]\n",
+          header_.PageSize[0], header_.PageSize[0],
+          header_.PageSize[1], header_.PageSize[1]);
+  fprintf(stderr, "DEBUG: Separations = %d(%x)\n", header_.Separations,
+          header_.Separations);
+  fprintf(stderr, "DEBUG: TraySwitch = %d(%x)\n", header_.TraySwitch,
+          header_.TraySwitch);
+  fprintf(stderr, "DEBUG: Tumble = %d(%x)\n", header_.Tumble, header_.Tumble);
+  fprintf(stderr, "DEBUG: cupsWidth = %d(%x)\n", header_.cupsWidth,
+          header_.cupsWidth);
+  fprintf(stderr, "DEBUG: cupsHeight = %d(%x)\n", header_.cupsHeight,
+          header_.cupsHeight);
+  fprintf(stderr, "DEBUG: cupsMediaType = %d(%x)\n", header_.cupsMediaType,
+          header_.cupsMediaType);
+  fprintf(stderr, "DEBUG: cupsBitsPerColor = %d(%x)\n",
+          header_.cupsBitsPerColor, header_.cupsBitsPerColor);
+  fprintf(stderr, "DEBUG: cupsBitsPerPixel = %d(%x)\n",
+          header_.cupsBitsPerPixel, header_.cupsBitsPerPixel);
+  fprintf(stderr, "DEBUG: cupsBytesPerLine = %d(%x)\n",
+          header_.cupsBytesPerLine, header_.cupsBytesPerLine);
+  fprintf(stderr, "DEBUG: cupsColorOrder = %d(%x)\n", header_.cupsColorOrder,
+          header_.cupsColorOrder);
+  fprintf(stderr, "DEBUG: cupsColorSpace = %d(%x)\n", header_.cupsColorSpace,
+          header_.cupsColorSpace);
+  fprintf(stderr, "DEBUG: cupsCompression = %d(%x)\n", header_.cupsCompression,
+          header_.cupsCompression);
+  fprintf(stderr, "DEBUG: cupsNumColors = %d(%x)\n", header_.cupsNumColors,
+          header_.cupsNumColors);
+#endif // DEBUG
 
-void
-RasterDisplay::resize(int X,		// I - New X position
-                      int Y,		// I - New Y position
-		      int W,		// I - New width
-		      int H)		// I - New height
-{
-  Fl_Widget::resize(X, Y, W, H);
+  bpp_ = header_.cupsNumColors == 1 ? 1 : 3;
 
-  xscrollbar_.resize(X, Y + H - SBWIDTH, W - SBWIDTH, SBWIDTH);
-  yscrollbar_.resize(X + W - SBWIDTH, Y, SBWIDTH, H - SBWIDTH);
+  if (header_.cupsWidth == 0 || header_.cupsWidth > 1000000 || header_.cupsHeight == 0 || header_.cupsHeight > 1000000)
+  {
+    fl_alert("Sorry, image dimensions are out of range (%ux%u).", header_.cupsWidth, header_.cupsHeight);
+    return (0);
+  }
 
-  W -= Fl::box_dw(box()) + SBWIDTH;
-  H -= Fl::box_dh(box()) + SBWIDTH;
+  long	pixelsize = (long)header_.cupsWidth * bpp_;
+  long	bytes = pixelsize * header_.cupsHeight;
 
-  if (factor_ == 0.0f && header_.cupsWidth && header_.cupsHeight)
+  if (bytes >= INT_MAX)
   {
-    xsize_ = W;
+    fl_alert("Sorry, image is too large to display (%ux%ux%u >= 2GB).", header_.cupsWidth, header_.cupsHeight, header_.cupsBitsPerPixel);
+    return (0);
+  }
 
-    if (xsize_ > (int)(header_.cupsWidth * 4))
-      xsize_ = header_.cupsWidth * 4;
+  if (bytes > alloc_pixels_)
+  {
+    if (pixels_)
+      delete[] pixels_;
 
-    ysize_ = xsize_ * header_.cupsHeight / header_.cupsWidth;
+    pixels_       = new uchar[bytes];
+    alloc_pixels_ = bytes;
 
-    if (ysize_ > H)
+    if (!pixels_)
     {
-      ysize_ = H;
-
-      if (ysize_ > (int)(header_.cupsHeight * 4))
-	ysize_ = header_.cupsHeight * 4;
-
-      xsize_ = ysize_ * header_.cupsWidth / header_.cupsHeight;
+      fl_alert("Unable to allocate %ld bytes for page data.", bytes);
+      return (0);
     }
   }
 
-  update_scrollbars();
-
-  redraw();
-}
-
-
-//
-// 'RasterDisplay::save_colors()' - Save device colors.
-//
-
-void
-RasterDisplay::save_colors()
-{
-  int		i;			// Looping var
-  char		key[256],		// Key string
-		value[256];		// Value
+  bpc_ = (header_.cupsBitsPerPixel + 7) / 8;
 
+  if (header_.cupsColorOrder != CUPS_ORDER_CHUNKED)
+    bpc_ *= header_.cupsNumColors;
 
-  if (!is_subtractive() || header_.cupsBitsPerColor < 8)
-    return;
+  long colorsize = (long)header_.cupsWidth * bpc_;
 
-  if (!prefs)
-    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
+  bytes = colorsize * header_.cupsHeight;
 
-  for (i = 0; i < header_.cupsNumColors; i ++)
+  if (bytes > alloc_colors_)
   {
-    snprintf(key, sizeof(key), "cs%dc%d", header_.cupsColorSpace, i);
-    snprintf(value, sizeof(value), "%d %d %d", device_colors_[i][0], device_colors_[i][1], device_colors_[i][2]);
+    if (colors_)
+      delete[] colors_;
 
-    prefs->set(key, value);
+    colors_       = new uchar[bytes];
+    alloc_colors_ = bytes;
+
+    if (!colors_)
+    {
+      fl_alert("Unable to allocate %ld bytes for page data.", bytes);
+      return (0);
+    }
   }
 
-  prefs->flush();
-}
+  // Keep the packed rows of 1-bit data for area averaging...
+  if ((bits_pixel_ = bits_masks(&header_, bits_masks_, &bits_additive_)) > 0)
+  {
+    bytes = (long)header_.cupsBytesPerLine * header_.cupsHeight;
 
+    if (bytes > alloc_bits_)
+    {
+      if (bits_)
+        delete[] bits_;
 
-//
-// 'RasterDisplay::scale()' - Scale the image.
-//
+      bits_       = new uchar[bytes];
+      alloc_bits_ = bytes;
 
-void
-RasterDisplay::scale(float factor)	// I - Scaling factor (0 = auto)
-{
-  int	X, Y, W, H;			// Interior of widget
-  float	ratio;				// Scaling ratio
+      if (!bits_)
+      {
+        fl_alert("Unable to allocate %ld bytes for page data.", bytes);
+        return (0);
+      }
+    }
+  }
 
+  // Update the page dimensions/scaling...
+  resize(x(), y(), w(), h());
 
-  if (factor)
-  {
-    xscrollbar_.show();
-    yscrollbar_.show();
-  }
-  else
-  {
-    xscrollbar_.hide();
-    yscrollbar_.hide();
-  }
+  memset(colors_, 0, alloc_colors_);
+  memset(pixels_, 255, alloc_pixels_);
 
-  if (factor > 20.0f)
-    factor = 20.0f;
+  uchar *line = new uchar[header_.cupsBytesPerLine];
 
-  // Make sure that the image doesn't get scaled to nothin'...
-  if (header_.cupsWidth && header_.cupsHeight)
+  if (!line)
   {
-    if (factor > 0.0f && (header_.cupsWidth * factor) < 32.0f && header_.cupsWidth > 32)
-      factor = 32.0f / header_.cupsWidth;
-
-    if (factor > 0.0f && (header_.cupsHeight * factor) < 32.0f && header_.cupsHeight > 32)
-      factor = 32.0f / header_.cupsHeight;
+    fl_alert("Unable to allocate %d bytes for raster data.", header_.cupsBytesPerLine);
+    return (0);
   }
 
-  if (factor_ == 0.0f)
-    ratio = 0.0f;
-  else
-    ratio = factor / factor_;
-
-  factor_ = factor;
+  // Set device colors...
+  rasterConvertColors(&header_, device_colors_);
 
-  redraw();
+  load_colors();
 
-  if (!header_.cupsWidth || !header_.cupsHeight)
-    return;
+  if (!is_subtractive())
+    channels_ = 0;
 
-  W = visible_w();
-  H = visible_h();
+  // When the whole page is shown in the window, only convert the rows that
+  // are displayed (none when 1-bit data is area averaged) and convert the
+  // rest in the background...
+  int	defer = 0,			// Defer conversion of rows?
+	coarse = 0;			// Defer conversion of all rows?
 
-  if (factor_ == 0.0f)
+  if (factor_ == 0.0f && dysize_ > 0 && (2 * dysize_) <= (int)header_.cupsHeight)
   {
-    xsize_ = W;
-
-    if (xsize_ > (int)(header_.cupsWidth * 4))
-      xsize_ = header_.cupsWidth * 4;
-
-    ysize_ = xsize_ * header_.cupsHeight / header_.cupsWidth;
+    coarse = bits_pixel_ && dxsize_ < (int)header_.cupsWidth;
 
-    if (ysize_ > H)
+    if (!bits_pixel_)
     {
-      ysize_ = H;
+      bytes = (long)header_.cupsBytesPerLine * header_.cupsHeight;
 
-      if (ysize_ > (int)(header_.cupsHeight * 4))
-	ysize_ = header_.cupsHeight * 4;
+      if (bytes > alloc_raw_)
+      {
+        if (raw_)
+          delete[] raw_;
 
-      xsize_ = ysize_ * header_.cupsWidth / header_.cupsHeight;
+        raw_       = new uchar[bytes];
+        alloc_raw_ = bytes;
+      }
     }
 
-    X = 0;
-    Y = 0;
-  }
-  else
-  {
-    xsize_ = (int)((float)header_.cupsWidth * factor_ + 0.5f);
-    ysize_ = (int)((float)header_.cupsHeight * factor_ + 0.5f);
-
-    if (xsize_ <= W)
-    {
-      // The image will be centered...
-      X = 0;
-    }
-    else if (ratio == 0.0)
+    if ((bits_pixel_ || raw_) && (int)header_.cupsHeight > alloc_pending_)
     {
-      // Previous zoom was auto-fit, center it...
-      X = (xsize_ - W) / 2;
+      if (pending_)
+        delete[] pending_;
+
+      pending_       = new uchar[header_.cupsHeight];
+      alloc_pending_ = header_.cupsHeight;
     }
-    else
+
+    if ((bits_pixel_ || raw_) && pending_)
     {
-      // Try to center on the previous location...
-      X = (int)((xscrollbar_.value() + W / 2) * ratio) - W / 2;
+      defer = 1;
+      memset(pending_, 0, header_.cupsHeight);
     }
+  }
 
-    if (ysize_ <= H)
+  // Large pages in plain files are decoded in parallel bands, starting at
+  // the row index entries...
+  int	bands = !defer && index_ && gzdirect(fp_) &&
+	        (page_index_[page_] - page_index_[page_ - 1]) > 1 &&
+	        std::thread::hardware_concurrency() > 1;
+					// Decode bands in parallel?
+
+  // When zoomed in, start reading at the last index entry before the visible
+  // rows, then go back for the rows above them...
+  int	i,				// Looping var
+	first,				// First index entry for page
+	start = 0,			// First row to read
+	last_y = -1;			// Last visible row
+
+  if (!bands && !defer && factor_ != 0.0f && ysize_ > visible_h() && index_)
+  {
+    first = page_index_[page_ - 1];
+    start  = (int)((long)yscrollbar_.value() * header_.cupsHeight / ysize_);
+    last_y = (int)((long)(yscrollbar_.value() + visible_h()) * header_.cupsHeight / ysize_);
+
+    for (i = page_index_[page_] - 1; i > first; i --)
     {
-      // The image will be centered...
-      Y = 0;
+      if (index_[i].row <= (unsigned)start)
+        break;
     }
-    else if (ratio == 0.0)
+
+    if (i > first)
     {
-      // Previous zoom was auto-fit, center it...
-      Y = (ysize_ - H) / 2;
+      start = (int)index_[i].row;
+
+      gzseek(fp_, index_[i].offset, SEEK_SET);
+      rasterSeek(ras_, index_[i].row);
     }
     else
-    {
-      // Try to center on the previous location...
-      Y = (int)((yscrollbar_.value() + H / 2) * ratio) - H / 2;
-    }
+      start = 0;
   }
 
-  // Update the scrollbars...
-  if (X < 0)
-    X = 0;
-  else if (X > (xsize_ - W))
-    X = xsize_ - W;
+  // Read the raster data...
+  loading_ = 1;
 
-  if (xsize_ <= W)
+  if (bands)
   {
-    xscrollbar_.deactivate();
-    xscrollbar_.value(0, 1, 0, 1);
+    if (!load_bands())
+    {
+      fl_alert("Unable to read page data: %s", strerror(errno));
+      delete[] line;
+      loading_ = 0;
+      flush_tiles();
+      return (0);
+    }
   }
   else
   {
-    xscrollbar_.activate();
-    xscrollbar_.value(X, W, 0, xsize_);
-  }
+    uchar *lptr;				// Current raster line
+    int	y,				// Current position in page
+	  yend,				// End of current pass
+	  sy,				// Current scaled row
+	  sample_y;			// Next row to show
 
-  if (Y < 0)
-    Y = 0;
-  else if (Y > (ysize_ - H))
-    Y = ysize_ - H;
+    for (y = start, yend = header_.cupsHeight, sy = 0, sample_y = 0;; y ++)
+    {
+      if (y >= yend)
+      {
+        if (!start || yend == start)
+          break;
 
-  if (ysize_ <= H)
-  {
-    yscrollbar_.deactivate();
-    yscrollbar_.value(0, 1, 0, 1);
+        // Go back for the rows above the visible area...
+        y    = 0;
+        yend = start;
+
+        gzseek(fp_, index_[page_index_[page_ - 1]].offset, SEEK_SET);
+        rasterSeek(ras_, 0);
+      }
+
+      if (((header_.cupsHeight - y) % header_.HWResolution[1]) == 0 || y == last_y)
+      {
+        // Update the screen to show progress...
+        redraw();
+        Fl::check();
+      }
+
+      if (bits_pixel_)
+      {
+        // Read 1-bit data directly into the packed buffer...
+        lptr = bits_ + (long)y * header_.cupsBytesPerLine;
+      }
+      else if (defer)
+      {
+        // Keep the raw data for converting later...
+        lptr = raw_ + (long)y * header_.cupsBytesPerLine;
+      }
+      else
+        lptr = line;
+
+      if (!cupsRasterReadPixels(ras_, lptr, header_.cupsBytesPerLine))
+      {
+        fl_alert("Unable to read page data: %s", strerror(errno));
+        delete[] line;
+        loading_ = 0;
+        flush_tiles();
+        return (0);
+      }
+
+      if (defer)
+      {
+        // Convert this row later if it isn't displayed right now...
+        if (coarse || y != sample_y)
+        {
+          pending_[y] = 1;
+
+          if (pending_y_ < 0)
+            pending_y_ = y;
+          continue;
+        }
+
+        while (sample_y <= y && sample_y < (int)header_.cupsHeight)
+        {
+          sy ++;
+          sample_y = (int)((long)sy * header_.cupsHeight / dysize_);
+        }
+      }
+
+      convert_line(y, lptr);
+    }
   }
-  else
-  {
-    yscrollbar_.activate();
-    yscrollbar_.value(Y, H, 0, ysize_);
+
+  delete[] line;
+
+  loading_ = 0;
+
+  // Total ink needs to be computed again for the new page...
+  if (ink_rows_)
+    memset(ink_rows_, 0, (size_t)alloc_ink_rows_);
+
+  if ((start || bands) && page_ < num_pages_)
+  {
+    // Position the stream at the start of the next page...
+    gzseek(fp_, pages_[page_], SEEK_SET);
+    rasterReset(ras_);
   }
-}
 
+  // Convert any remaining rows in the background...
+  if (pending_y_ >= 0)
+    Fl::add_idle(convert_cb, this);
 
-//
-// 'RasterDisplay::scrollbar_cb()' - Update the display based on the scrollbar position.
-//
+  // Mark the page for redisplay, along with the differences shown by the
+  // compared display...
+  if (show_diff_)
+    flush_tiles();
 
-void
-RasterDisplay::scrollbar_cb(
-    Fl_Widget *w,			// I - Widget
-    void      *d)			// I - Raster display widget
-{
-  RasterDisplay	*img = (RasterDisplay *)d;
+  redraw();
 
+  if (compare_ && compare_->show_diff_)
+  {
+    compare_->flush_tiles();
+    compare_->redraw();
+  }
 
-  img->damage(FL_DAMAGE_SCROLL);
+  // Return successfully...
+  return (1);
 }
 
 
 //
-// 'RasterDisplay::update_mouse_xy()' - Update the mouse X and Y values.
+// 'RasterDisplay::open_file()' - Open a raster file for viewing.
 //
 
-void
-RasterDisplay::update_mouse_xy()
+int					// O - 1 on success, 0 on failure
+RasterDisplay::open_file(
+    const char *filename)		// I - File to open
 {
-  int	X, Y;				// X,Y position
-  int	W, H;				// Width and height
+  cups_page_header_t	header;		// Page header
+  unsigned		y,		// Current line
+			next,		// Next line to index
+			*bbox;		// Ink bounding box of page
+  unsigned long long	*hash;		// Content hash of page
 
 
-  X = Fl::event_x() - x() - Fl::box_dx(box()) + xscrollbar_.value();
-  Y = Fl::event_y() - y() - Fl::box_dy(box()) + yscrollbar_.value();
-  W = visible_w();
-  H = visible_h();
+  close_file();
 
-  if (!ras_ || xsize_ <= 0 || ysize_ <= 0)
+  if ((fp_ = gzopen(filename, "r")) == NULL)
   {
-    mouse_x_ = -1;
-    mouse_y_ = -1;
-    return;
+    fl_alert("Unable to open file: %s", strerror(errno));
+    return (0);
   }
 
-  if (xsize_ < W)
-    X -= (W - xsize_) / 2;
+  if ((ras_ = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp_, CUPS_RASTER_READ)) == NULL)
+  {
+    fl_alert("Unable to read raster file header.");
+    gzclose(fp_);
+    fp_ = NULL;
+    return (0);
+  }
 
-  if (X < 0)
-    mouse_x_ = 0;
-  else if (X >= xsize_)
-    mouse_x_ = header_.cupsWidth;
-  else
-    mouse_x_ = X * header_.cupsWidth / xsize_;
+  filename_ = strdup(filename);
 
-  if (ysize_ < H)
-    Y -= (H - ysize_) / 2;
+  // Use the cached page index if the file hasn't changed, otherwise figure
+  // out the number of pages and their offsets, indexing the rows of each page
+  // and finding its ink bounding box and content hash as we go.  The rows are
+  // skipped without expanding them...
+  if (!load_index())
+  {
+    num_pages_ = 0;
+    pages_[0]  = gztell(fp_);
 
-  if (Y < 0)
-    mouse_y_ = 0;
-  else if (Y >= ysize_)
-    mouse_y_ = header_.cupsHeight;
-  else
-    mouse_y_ = Y * header_.cupsHeight / ysize_;
+    while (cupsRasterReadHeader(ras_, &header))
+    {
+      page_index_[num_pages_] = num_index_;
 
-//  printf("EXY:%4d,%4d  BXY:%4d,%4d  SC=%4d,%4d  XY:%4d,%4d  WH:%4d,%4d  SZ:%4d,%4d  MXY:%4d,%4d\n", Fl::event_x(), Fl::event_y(), Fl::box_dx(box()), Fl::box_dy(box()), xscrollbar_.value(), yscrollbar_.value(), X, Y, W, H, xsize_, ysize_, mouse_x_, mouse_y_);
+      num_pages_ ++;
 
-  if (mouse_x_ < 0)
-    mouse_x_ = 0;
-  else if (mouse_x_ > (int)header_.cupsWidth)
-    mouse_x_ = (int)header_.cupsWidth;
+#ifdef DEBUG
+      fprintf(stderr, "PAGE %d: %ux%ux%u @ %ld\n", num_pages_, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, (long)pages_[num_pages_ - 1]);
+#endif // DEBUG
 
-  if (mouse_y_ < 0)
-    mouse_y_ = 0;
-  else if (mouse_y_ > (int)header_.cupsHeight)
-    mouse_y_ = (int)header_.cupsHeight;
-}
+      bbox = bbox_[num_pages_ - 1];
+      hash = hash_ + num_pages_ - 1;
+      memset(bbox, 0, sizeof(bbox_[0]));
+      *hash = 0;
 
+      for (y = 0, next = 0; y < header.cupsHeight; y ++)
+      {
+        if (y >= next && ras_->count == 0)
+        {
+          // Start of a new row record, add an index entry...
+          if (num_index_ >= alloc_index_)
+          {
+            raster_index_t *temp;		// New index
 
-//
-// 'RasterDisplay::update_scrollbars()' - Update the scrollbars.
-//
+            if ((temp = (raster_index_t *)realloc(index_, (size_t)(alloc_index_ + 1024) * sizeof(raster_index_t))) == NULL)
+              break;
 
-void
-RasterDisplay::update_scrollbars()
-{
-  int	X, Y;				// X/Y offsets
-  int	W, H;				// Interior size
+            index_       = temp;
+            alloc_index_ += 1024;
+          }
 
+          index_[num_index_].row    = y;
+          index_[num_index_].offset = gztell(fp_) - rasterOffset(ras_);
+          num_index_ ++;
 
-  if (header_.cupsWidth && header_.cupsHeight)
-  {
-    W = visible_w();
-    H = visible_h();
+          next = y + RASTER_INDEX_ROWS;
+        }
 
-    X = xscrollbar_.value();
-    if (X > (xsize_ - W))
-      X = xsize_ - W;
-    else if (X < 0)
-      X = 0;
+        _cupsRasterScanLines(ras_, 1, bbox, hash);
+      }
 
-    if (xsize_ <= W)
-    {
-      xscrollbar_.deactivate();
-      xscrollbar_.value(0, 1, 0, 1);
-    }
-    else
-    {
-      xscrollbar_.activate();
-      xscrollbar_.value(X, W, 0, xsize_);
-    }
+      if (y < header.cupsHeight)
+        _cupsRasterScanLines(ras_, header.cupsHeight - y, bbox, hash);
 
-    Y = yscrollbar_.value();
-    if (Y > (ysize_ - H))
-      Y = ysize_ - H;
-    else if (Y < 0)
-      Y = 0;
+      pages_[num_pages_] = gztell(fp_) - rasterOffset(ras_);
 
-    if (ysize_ <= H)
-    {
-      yscrollbar_.deactivate();
-      yscrollbar_.value(0, 1, 0, 1);
-    }
-    else
-    {
-      yscrollbar_.activate();
-      yscrollbar_.value(Y, H, 0, ysize_);
+      if (num_pages_ >= RASTER_MAX_PAGES)
+        break;
     }
+
+    page_index_[num_pages_] = num_index_;
+
+    save_index();
   }
-  else
-  {
-    xscrollbar_.value(0, 1, 0, 1);
-    yscrollbar_.value(0, 1, 0, 1);
-  }
+
+  gzseek(fp_, pages_[0], SEEK_SET);
+  rasterReset(ras_);
+  page_ = 0;
+
+  return (load_page());
 }
 
 
 //
-// 'convert_cmy()' - Convert CMY or YMC raster data.
+// 'RasterDisplay::overlay_diff()' - Draw the differences from the compared
+//                                   page over a line of the image.
+//
+// Changed pixels are drawn in red through yellow by the size of the largest
+// difference covered by each device pixel, and unchanged pixels are faded...
 //
 
-static void
-convert_cmy(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+void
+RasterDisplay::overlay_diff(int         X,	// I - X position in device pixels
+                            int         Y,	// I - Y position in device pixels
+                            int         W,	// I - Width of image row
+                            const uchar *S,	// I - Scaled image data
+                            uchar       *D)	// O - RGB image data
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	bit;				// Current bit
+  int		x, y,			// Looping vars
+		c0, c1,			// Columns covered by image row
+		x0, x1,			// Columns covered by device pixel
+		y0, y1,			// Rows covered by device pixel
+		maxdelta;		// Largest difference
+  uchar		*cmax,			// Largest difference of each column
+		*row;			// Differences of current row
+  long		bytes;			// Bytes to allocate
 
 
-  w = header->cupsWidth;
+  bytes = (long)header_.cupsWidth * (bpc_ + 2);
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (bytes > alloc_diff_)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit       = *line++;
-	    *colors++ = bit >> 4;
+    delete[] diff_;
 
-	    if (bit & 0x40)
-	      pixels[0] = 0;
-	    if (bit & 0x20)
-	      pixels[1] = 0;
-	    if (bit & 0x10)
-	      pixels[2] = 0;
+    diff_       = new uchar[bytes];
+    alloc_diff_ = bytes;
+  }
 
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 15;
-
-	      if (bit & 0x04)
-	        pixels[3] = 0;
-	      if (bit & 0x02)
-	        pixels[4] = 0;
-	      if (bit & 0x01)
-	        pixels[5] = 0;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    bit = *line++;
-	    *colors++ = bit;
+  cmax = diff_;
+  row  = diff_ + header_.cupsWidth;
 
-	    *pixels++ = 255 - 85 * ((bit & 0x30) >> 4);
-	    *pixels++ = 255 - 85 * ((bit & 0x0c) >> 2);
-	    *pixels++ = 255 - 85 * (bit & 0x03);
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-	    *pixels++ = 255 - 17 * (bit & 0x0f);
+  // Find the rows and columns covered by this line...
+  y0 = (int)((long)Y * header_.cupsHeight / dysize_);
+  y1 = (int)((long)(Y + 1) * header_.cupsHeight / dysize_);
 
-	    *colors++ = bit = *line++;
-	    *pixels++ = 255 - 17 * ((bit & 0xf0) >> 4);
-	    *pixels++ = 255 - 17 * (bit & 0x0f);
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = val = *line++;
-	    *pixels++ = 255 - val;
+  if (y1 <= y0)
+    y1 = y0 + 1;
+  if (y1 > (int)header_.cupsHeight)
+    y1 = (int)header_.cupsHeight;
 
-	    *colors++ = val = *line++;
-	    *pixels++ = 255 - val;
+  c0 = xmap_[X] / bpp_;
 
-	    *colors++ = val = *line++;
-	    *pixels++ = 255 - val;
-          }
-          break;
-      case 16 :
-	  if (endian_offset)
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
+  if ((X + W) < dxsize_)
+    c1 = xmap_[X + W] / bpp_;
+  else
+    c1 = (int)header_.cupsWidth;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
+  if (c1 <= xmap_[X + W - 1] / bpp_)
+    c1 = xmap_[X + W - 1] / bpp_ + 1;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
-            }
-	  }
-	  else
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *line++;
+  // Get the largest difference of each column...
+  diff_row(y0, c0, c1, cmax + c0);
 
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *line++;
+  for (y = y0 + 1; y < y1; y ++)
+  {
+    diff_row(y, c0, c1, row + c0);
 
-	      *colors++ = val = *line++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *line++;
-            }
-	  }
-          break;
+    for (x = c0; x < c1; x ++)
+    {
+      if (row[x] > cmax[x])
+        cmax[x] = row[x];
     }
   }
-  else
+
+  // Then draw each device pixel...
+  for (x = X; x < (X + W); x ++, D += 3)
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+    x0 = xmap_[x] / bpp_;
 
+    if ((x + 1) < dxsize_)
+      x1 = xmap_[x + 1] / bpp_;
+    else
+      x1 = (int)header_.cupsWidth;
 
-    cptr = line;
-    mptr = line + bytespercolor;
-    yptr = line + 2 * bytespercolor;
+    if (x1 <= x0)
+      x1 = x0 + 1;
 
-    switch (header->cupsBitsPerColor)
+    for (maxdelta = 0; x0 < x1; x0 ++)
     {
-      case 1 :
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*cptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[0] = 0;
-	    }
-	    else
-	      colors ++;
-
-	    if (*mptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[1] = 0;
-	    }
-	    else
-	      colors ++;
-
-	    if (*yptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[2] = 0;
-	    }
-	    else
-	      colors ++;
-
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      cptr ++;
-	      mptr ++;
-	      yptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      case 0 :
-	          *colors++ = val = (*cptr & 0xc0) >> 6;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0xc0) >> 6;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*yptr & 0xc0) >> 6;
-		  *pixels++ = 255 - 85 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*cptr & 0x30) >> 4;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0x30) >> 4;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*yptr & 0x30) >> 4;
-		  *pixels++ = 255 - 85 * val;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*cptr & 0x0c) >> 2;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0x0c) >> 2;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = (*yptr & 0x0c) >> 2;
-		  *pixels++ = 255 - 85 * val;
-                  break;
-	      case 3 :
-	          *colors++ = val = *cptr & 0x03;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = *mptr & 0x03;
-		  *pixels++ = 255 - 85 * val;
-	          *colors++ = val = *yptr & 0x03;
-		  *pixels++ = 255 - 85 * val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      case 0 :
-	          *colors++ = val = (*cptr & 0xf0) >> 4;
-		  *pixels++ = 255 - 17 * val;
-	          *colors++ = val = (*mptr & 0xf0) >> 4;
-		  *pixels++ = 255 - 17 * val;
-	          *colors++ = val = (*yptr & 0xf0) >> 4;
-		  *pixels++ = 255 - 17 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = *cptr & 0x0f;
-		  *pixels++ = 255 - 17 * val;
-	          *colors++ = val = *mptr & 0x0f;
-		  *pixels++ = 255 - 17 * val;
-	          *colors++ = val = *yptr & 0x0f;
-		  *pixels++ = 255 - 17 * val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = val = *cptr++;
-	    *pixels++ = 255 - val;
-
-	    *colors++ = val = *mptr++;
-	    *pixels++ = 255 - val;
-
-	    *colors++ = val = *yptr++;
-	    *pixels++ = 255 - val;
-          }
-          break;
-      case 16 :
-          if (endian_offset)
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = *cptr++;
-	      *colors++ = val = *cptr++;
-	      *pixels++ = 255 - val;
-
-	      *colors++ = *mptr++;
-	      *colors++ = val = *mptr++;
-	      *pixels++ = 255 - val;
-
-	      *colors++ = *yptr++;
-	      *colors++ = val = *yptr++;
-	      *pixels++ = 255 - val;
-            }
-          }
-	  else
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = val = *cptr++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *cptr++;
-
-	      *colors++ = val = *mptr++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *mptr++;
+      if (cmax[x0] > maxdelta)
+        maxdelta = cmax[x0];
+    }
 
-	      *colors++ = val = *yptr++;
-	      *pixels++ = 255 - val;
-	      *colors++ = *yptr++;
-            }
-          }
-	  break;
+    if (maxdelta)
+    {
+      D[0] = 255;
+      D[1] = (uchar)(255 - maxdelta);
+      D[2] = 0;
+    }
+    else if (bpp_ == 1)
+    {
+      D[0] = D[1] = D[2] = (uchar)(192 + *S / 4);
     }
+    else
+    {
+      D[0] = (uchar)(192 + S[0] / 4);
+      D[1] = (uchar)(192 + S[1] / 4);
+      D[2] = (uchar)(192 + S[2] / 4);
+    }
+
+    S += bpp_;
   }
 }
 
 
 //
-// 'convert_cmyk()' - Convert CMYK raster data.
+// 'RasterDisplay::overlay_ink()' - Highlight pixels over the total ink limit in
+//                                  a scaled line.
+//
+// When zoomed out each device pixel covers several page pixels, so the
+// maximum total ink of the blocks it covers is used instead.  Blocks are
+// computed when first drawn and kept until the next page is loaded...
 //
 
-static void
-convert_cmyk(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+void
+RasterDisplay::overlay_ink(int   X,	// I - X position in device pixels
+                           int   Y,	// I - Y position in device pixels
+                           int   W,	// I - Width of image row
+                           uchar *D)	// IO - Image data
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	*kptr,				// Black pointer
-	bit;				// Current bit
-  int	r, g, b, k;			// Current RGB color + K
-
+  int		x, y,			// Looping vars
+		x0, x1,			// Columns covered by device pixel
+		y0, y1,			// Rows covered by device pixel
+		bw, bh;			// Size of block array
+  unsigned	limit,			// Total ink limit
+		total;			// Total ink
+  const uchar	*row;			// Current row of colors
+  const unsigned short *block;		// Current block
+  long		bytes;			// Bytes to allocate
+
+
+  if (!show_ink_ || bpp_ != 3 || header_.cupsNumColors < 2 || !is_subtractive() || !xmap_)
+    return;
 
-  w = header->cupsWidth;
+  limit = (unsigned)ink_limit_ * 255 / 100;
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (dxsize_ >= (int)header_.cupsWidth)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
+    // Zoomed in, check each page pixel...
+    y = (int)((long)Y * header_.cupsHeight / dysize_);
+
+    if (pending_y_ >= 0 && pending_[y])
+      convert_row(y);
+
+    row = colors_ + (long)y * header_.cupsWidth * bpc_;
+
+    for (x = X; x < (X + W); x ++, D += 3)
     {
-      case 1 :
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit       = *line++;
-	    *colors++ = bit >> 4;
+      if (ink_total(&header_, bpc_, row + (long)(xmap_[x] / 3) * bpc_) > limit)
+      {
+        D[0] = 255;
+        D[1] /= 4;
+        D[2] /= 4;
+      }
+    }
 
-            if (bit & 0x10)
-	    {
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      if (bit & 0x80)
-		pixels[0] = 0;
-	      if (bit & 0x40)
-		pixels[1] = 0;
-	      if (bit & 0x20)
-		pixels[2] = 0;
-	    }
-
-	    if (x > 1)
-	    {
- 	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x01)
-	      {
-		pixels[3] = 0;
-		pixels[4] = 0;
-		pixels[5] = 0;
-	      }
-	      else
-	      {
-		if (bit & 0x08)
-	          pixels[3] = 0;
-		if (bit & 0x04)
-	          pixels[4] = 0;
-		if (bit & 0x02)
-	          pixels[5] = 0;
-	      }
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
+    return;
+  }
 
-	    k = 85 * (bit & 0x03);
-	    r = 255 - 85 * ((bit & 0xc0) >> 6) - k;
-	    g = 255 - 85 * ((bit & 0x30) >> 4) - k;
-	    b = 255 - 85 * ((bit & 0x0c) >> 2) - k;
+  // Zoomed out, make sure we have the blocks for this line...
+  bw    = ((int)header_.cupsWidth + RASTER_INK_BLOCK - 1) / RASTER_INK_BLOCK;
+  bh    = ((int)header_.cupsHeight + RASTER_INK_BLOCK - 1) / RASTER_INK_BLOCK;
+  bytes = (long)bw * bh;
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (bytes > alloc_ink_ || bh > alloc_ink_rows_)
+  {
+    delete[] ink_;
+    delete[] ink_rows_;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    ink_           = new unsigned short[bytes];
+    alloc_ink_     = bytes;
+    ink_rows_      = new uchar[bh];
+    alloc_ink_rows_ = bh;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
+    memset(ink_rows_, 0, (size_t)bh);
+  }
+
+  y0 = (int)((long)Y * header_.cupsHeight / dysize_) / RASTER_INK_BLOCK;
+  y1 = (int)(((long)(Y + 1) * header_.cupsHeight - 1) / dysize_) / RASTER_INK_BLOCK;
+
+  if (y1 >= bh)
+    y1 = bh - 1;
+
+  for (y = y0; y <= y1; y ++)
+  {
+    if (!ink_rows_[y])
+      ink_row(y);
+  }
+
+  for (x = X; x < (X + W); x ++, D += 3)
+  {
+    x0 = (int)((long)x * header_.cupsWidth / dxsize_) / RASTER_INK_BLOCK;
+    x1 = (int)(((long)(x + 1) * header_.cupsWidth - 1) / dxsize_) / RASTER_INK_BLOCK;
 
-	    r = 255 - 17 * ((bit & 0xf0) >> 4);
-	    g = 255 - 17 * (bit & 0x0f);
+    if (x1 >= bw)
+      x1 = bw - 1;
 
-	    *colors++ = bit = *line++;
+    for (y = y0, total = 0; y <= y1 && total <= limit; y ++)
+    {
+      for (block = ink_ + (long)y * bw + x0; block <= (ink_ + (long)y * bw + x1); block ++)
+      {
+        if (*block > total)
+          total = *block;
+      }
+    }
 
-	    b = 255 - 17 * ((bit & 0xf0) >> 4);
-	    k = 17 * (bit & 0x0f);
-	    r -= k;
-	    g -= k;
-	    b -= k;
+    if (total > limit)
+    {
+      D[0] = 255;
+      D[1] /= 4;
+      D[2] /= 4;
+    }
+  }
+}
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+//
+// 'RasterDisplay::page()' - Return the current page number.
+//
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = val = *line++;
-	    r         = 255 - val;
-	    *colors++ = val = *line++;
-	    g         = 255 - val;
-	    *colors++ = val = *line++;
-	    b         = 255 - val;
-	    *colors++ = k = *line++;
-
-	    r -= k;
-	    g -= k;
-	    b -= k;
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+int					// O - Current page
+RasterDisplay::page(void)
+{
+  return (page_);
+}
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-	    if (endian_offset)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      r         = 255 - val;
+/*
+ * 'RasterDisplay::page()' - Set the current page number.
+ */
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      g         = 255 - val;
+void
+RasterDisplay::page(int number)		// I - New page
+{
+  if (number < 1)
+    number = 1;
+  else if (number > num_pages_)
+    number = num_pages_;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      b         = 255 - val;
+  if (number == page_ || reuse_page(number))
+    return;
 
-	      *colors++ = *line++;
-	      *colors++ = k = *line++;
-	    }
-	    else
-	    {
-	      *colors++ = val = *line++;
-	      r         = 255 - val;
-	      *colors++ = *line++;
+  if (number == (page_ + 1))
+    this->load_page();
+  else
+  {
+    gzseek(fp_, pages_[number - 1], SEEK_SET);
+    rasterReset(ras_);
 
-	      *colors++ = val = *line++;
-	      g         = 255 - val;
-	      *colors++ = *line++;
+    page_ = number - 1;
+    this->load_page();
+  }
+}
 
-	      *colors++ = val = *line++;
-	      b         = 255 - val;
-	      *colors++ = *line++;
 
-	      *colors++ = k = *line++;
-	      *colors++ = *line++;
-	    }
+//
+// 'RasterDisplay::position()' - Reposition the image on the screen.
+//
 
-	    r -= k;
-	    g -= k;
-	    b -= k;
+void
+RasterDisplay::position(int X,		// I - New X offset
+                        int Y)		// I - New Y offset
+{
+  int	W, H;				// Interior size
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  W = visible_w();
+  H = visible_h();
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-    }
-  }
-  else
-  {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+  if (X < 0)
+    X = 0;
+  else if (X > (xsize_ - W))
+    X = xsize_ - W;
 
+  if (Y < 0)
+    Y = 0;
+  else if (Y > (ysize_ - H))
+    Y = ysize_ - H;
 
-    cptr = line;
-    mptr = line + bytespercolor;
-    yptr = line + 2 * bytespercolor;
-    kptr = line + 3 * bytespercolor;
+  xscrollbar_.value(X, W, 0, xsize_);
+  yscrollbar_.value(Y, H, 0, ysize_);
 
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*cptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  damage(FL_DAMAGE_SCROLL);
 
-	    if (*mptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  sync_compare();
+}
 
-	    if (*yptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
 
-	    if (*kptr & bit)
-	    {
-	      *colors++ = 1;
+//
+// 'RasterDisplay::recolor()' - Regenerate the displayed pixels after a device
+//                              color change.
+//
+// Device-N pixels are recomputed from the original color values using
+// multiple threads, without reading the page again...
+//
 
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      colors ++;
-
-	      if (*cptr & bit)
-		pixels[0] = 0;
-	      if (*mptr & bit)
-		pixels[1] = 0;
-	      if (*yptr & bit)
-		pixels[2] = 0;
-            }
+void
+RasterDisplay::recolor()
+{
+  int			i,		// Looping var
+			nbands;		// Number of bands
+  raster_band_t		bands[RASTER_MAX_THREADS];
+					// Bands
+  std::thread		threads[RASTER_MAX_THREADS];
+					// Threads
+  std::atomic<int>	done(0);	// Number of finished bands
+
+
+  if (!colors_ || !pixels_ || !header_.cupsHeight ||
+      header_.cupsColorSpace < CUPS_CSPACE_DEVICE1 ||
+      header_.cupsColorSpace > CUPS_CSPACE_DEVICEF)
+    return;
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      cptr ++;
-	      mptr ++;
-	      yptr ++;
-	      kptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      default :
-	      case 0 :
-	          val       = (*kptr & 0xc0) >> 6;
-		  k         = 85 * val;
+  nbands = (int)std::thread::hardware_concurrency();
 
-	          *colors++ = val = (*cptr & 0xc0) >> 6;
-		  r         = 255 - 85 * val - k;
+  if (nbands < 1)
+    nbands = 1;
+  if (nbands > RASTER_MAX_THREADS)
+    nbands = RASTER_MAX_THREADS;
+  if (nbands > (int)header_.cupsHeight)
+    nbands = (int)header_.cupsHeight;
 
-	          *colors++ = val = (*mptr & 0xc0) >> 6;
-		  g         = 255 - 85 * val - k;
+  for (i = 0; i < nbands; i ++)
+  {
+    bands[i].display = this;
+    bands[i].first   = (int)((long)i * header_.cupsHeight / nbands);
+    bands[i].last    = (int)((long)(i + 1) * header_.cupsHeight / nbands);
+    bands[i].offset  = 0;
+    bands[i].done    = &done;
+  }
 
-	          *colors++ = val = (*yptr & 0xc0) >> 6;
-		  b         = 255 - 85 * val - k;
+  for (i = 1; i < nbands; i ++)
+    threads[i] = std::thread(recolor_cb, bands + i);
 
-	          *colors++ = val;
-                  break;
-	      case 1 :
-	          val       = (*kptr & 0x30) >> 4;
-		  k         = 85 * val;
+  recolor_cb(bands);
 
-	          *colors++ = val = (*cptr & 0x30) >> 4;
-		  r         = 255 - 85 * val - k;
+  for (i = 1; i < nbands; i ++)
+    threads[i].join();
 
-	          *colors++ = val = (*mptr & 0x30) >> 4;
-		  g         = 255 - 85 * val - k;
+  flush_tiles();
+  redraw();
+}
 
-	          *colors++ = val = (*yptr & 0x30) >> 4;
-		  b         = 255 - 85 * val - k;
 
-	          *colors++ = val;
-                  break;
-	      case 2 :
-	          val       = (*kptr & 0x0c) >> 2;
-		  k         = 85 * val;
+//
+// 'RasterDisplay::recolor_cb()' - Regenerate the displayed pixels for a band.
+//
 
-	          *colors++ = val = (*cptr & 0x0c) >> 2;
-		  r         = 255 - 85 * val - k;
+void
+RasterDisplay::recolor_cb(void *b)	// I - Band
+{
+  raster_band_t		*band = (raster_band_t *)b;
+					// Band
+  RasterDisplay		*display = band->display;
+					// Display widget
+  int			y;		// Current row
 
-	          *colors++ = val = (*mptr & 0x0c) >> 2;
-		  g         = 255 - 85 * val - k;
 
-	          *colors++ = val = (*yptr & 0x0c) >> 2;
-		  b         = 255 - 85 * val - k;
+  for (y = band->first; y < band->last; y ++)
+  {
+    // Rows that haven't been converted yet will use the new colors...
+    if (display->pending_y_ >= 0 && display->pending_[y])
+      continue;
 
-	          *colors++ = val;
-                  break;
-	      case 3 :
-	          val       = *kptr & 0x03;
-		  k         = 85 * val;
+    rasterRecolorLine(&display->header_, display->colors_ + (long)y * display->header_.cupsWidth * display->bpc_, display->pixels_ + (long)y * display->header_.cupsWidth * display->bpp_, display->device_colors_);
+  }
 
-	          *colors++ = val = *cptr & 0x03;
-		  r         = 255 - 85 * val - k;
+  band->status = 1;
 
-	          *colors++ = val = *mptr & 0x03;
-		  g         = 255 - 85 * val - k;
+  (*band->done) ++;
+}
 
-	          *colors++ = val = *yptr & 0x03;
-		  b         = 255 - 85 * val - k;
 
-	          *colors++ = val;
+//
+// 'RasterDisplay::region_stats()' - Get the statistics of a region of the page.
+//
+// Whole blocks come from the summed-area tables, and only the partial blocks
+// along the edges of the region are read from the page...
+//
 
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
+long					// O - Number of pixels in region
+RasterDisplay::region_stats(
+    int            X1,			// I - First corner
+    int            Y1,
+    int            X2,			// I - Second corner
+    int            Y2,
+    raster_stats_t *stats)		// O - Statistics for each channel
+{
+  int			c,		// Current channel
+			nchannels,	// Number of channels
+			bx, by,		// Current block
+			bw,		// Number of blocks in a row
+			bx0, by0,	// First whole block
+			bx1, by1;	// Last whole block (exclusive)
+  long			count;		// Number of pixels
+  unsigned long long	sums[15],	// Sums of channel values
+			squares[15];	// Sums of squares
+  const unsigned long long *s00, *s01, *s10, *s11;
+					// Corners in summed-area table
+  const unsigned short	*range;		// Minimum and maximum of block
+  double		variance;	// Variance of channel
+
+
+  memset(stats, 0, sizeof(raster_stats_t));
+
+  if (!colors_)
+    return (0);
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  // Get the region as [X1,X2) by [Y1,Y2) within the page...
+  if (X1 > X2)
+  {
+    c  = X1;
+    X1 = X2;
+    X2 = c;
+  }
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  if (Y1 > Y2)
+  {
+    c  = Y1;
+    Y1 = Y2;
+    Y2 = c;
+  }
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      default :
-	      case 0 :
-	          val       = (*kptr & 0xf0) >> 4;
-		  k         = 17 * val;
-	          *colors++ = val = (*cptr & 0xf0) >> 4;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val = (*mptr & 0xf0) >> 4;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = (*yptr & 0xf0) >> 4;
-		  b         = 255 - 17 * val - k;
-	          *colors++ = val;
-                  break;
-	      case 1 :
-	          val       = *kptr & 0x0f;
-		  k         = 17 * val;
-	          *colors++ = val = *cptr & 0x0f;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val = *mptr & 0x0f;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = *yptr & 0x0f;
-		  b         = 255 - 17 * val - k;
-	          *colors++ = val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (X1 < 0)
+    X1 = 0;
+  if (Y1 < 0)
+    Y1 = 0;
+  if (++ X2 > (int)header_.cupsWidth)
+    X2 = (int)header_.cupsWidth;
+  if (++ Y2 > (int)header_.cupsHeight)
+    Y2 = (int)header_.cupsHeight;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  if (X1 >= X2 || Y1 >= Y2)
+    return (0);
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    k         = *kptr++;
-	    *colors++ = val = *cptr++;
-	    r         = 255 - val - k;
-	    *colors++ = val = *mptr++;
-	    g         = 255 - val - k;
-	    *colors++ = val = *yptr++;
-	    b         = 255 - val - k;
-	    *colors++ = k;
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (!stats_valid_ && !build_stats())
+    return (0);
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  nchannels = (int)header_.cupsNumColors;
+  count     = (long)(X2 - X1) * (Y2 - Y1);
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-            if (endian_offset)
-	    {
-	      *colors++ = *cptr++;
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val;
+  memset(sums, 0, sizeof(sums));
+  memset(squares, 0, sizeof(squares));
 
-	      *colors++ = *mptr++;
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val;
+  stats->num_channels = nchannels;
+  stats->count        = count;
 
-	      *colors++ = *yptr++;
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val;
+  for (c = 0; c < nchannels; c ++)
+  {
+    stats->min[c] = 65535;
+    stats->max[c] = 0;
+  }
 
-	      *colors++ = *kptr++;
-	      *colors++ = k = *kptr++;
-            }
-	    else
-            {
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val;
-	      *colors++ = *cptr++;
+  bw  = ((int)header_.cupsWidth + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
+  bx0 = (X1 + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
+  by0 = (Y1 + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
+  bx1 = X2 / RASTER_STATS_BLOCK;
+  by1 = Y2 / RASTER_STATS_BLOCK;
 
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val;
-	      *colors++ = *mptr++;
+  if (X2 == (int)header_.cupsWidth)
+    bx1 = bw;
+  if (Y2 == (int)header_.cupsHeight)
+    by1 = ((int)header_.cupsHeight + RASTER_STATS_BLOCK - 1) / RASTER_STATS_BLOCK;
 
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val;
-	      *colors++ = *yptr++;
+  if (bx0 < bx1 && by0 < by1)
+  {
+    // Add the whole blocks...
+    s00 = stats_sums_ + ((size_t)by0 * (bw + 1) + bx0) * nchannels * 2;
+    s01 = stats_sums_ + ((size_t)by0 * (bw + 1) + bx1) * nchannels * 2;
+    s10 = stats_sums_ + ((size_t)by1 * (bw + 1) + bx0) * nchannels * 2;
+    s11 = stats_sums_ + ((size_t)by1 * (bw + 1) + bx1) * nchannels * 2;
 
-	      *colors++ = k = *kptr++;
-	      *colors++ = *kptr++;
-	    }
+    for (c = 0; c < nchannels; c ++)
+    {
+      sums[c]    = s11[2 * c] - s01[2 * c] - s10[2 * c] + s00[2 * c];
+      squares[c] = s11[2 * c + 1] - s01[2 * c + 1] - s10[2 * c + 1] + s00[2 * c + 1];
+    }
 
-            r -= k;
-	    g -= k;
-	    b -= k;
+    for (by = by0; by < by1; by ++)
+    {
+      range = stats_range_ + ((size_t)by * bw + bx0) * nchannels * 2;
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+      for (bx = bx0; bx < bx1; bx ++)
+      {
+        for (c = 0; c < nchannels; c ++, range += 2)
+        {
+          if (range[0] < stats->min[c])
+            stats->min[c] = range[0];
+          if (range[1] > stats->max[c])
+            stats->max[c] = range[1];
+        }
+      }
+    }
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    // Then the partial blocks around them...
+    int XB0 = bx0 * RASTER_STATS_BLOCK,	// Left of whole blocks
+	YB0 = by0 * RASTER_STATS_BLOCK,	// Top of whole blocks
+	XB1 = bx1 * RASTER_STATS_BLOCK,	// Right of whole blocks
+	YB1 = by1 * RASTER_STATS_BLOCK;	// Bottom of whole blocks
+
+    if (XB1 > X2)
+      XB1 = X2;
+    if (YB1 > Y2)
+      YB1 = Y2;
+
+    scan_region(X1, Y1, X2, YB0, sums, squares, stats);
+    scan_region(X1, YB1, X2, Y2, sums, squares, stats);
+    scan_region(X1, YB0, XB0, YB1, sums, squares, stats);
+    scan_region(XB1, YB0, X2, YB1, sums, squares, stats);
+  }
+  else
+  {
+    // Small region, just read the pixels...
+    scan_region(X1, Y1, X2, Y2, sums, squares, stats);
+  }
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-	  }
-          break;
-    }
+  for (c = 0; c < nchannels; c ++)
+  {
+    stats->mean[c] = (double)sums[c] / count;
+    variance       = (double)squares[c] / count - stats->mean[c] * stats->mean[c];
+    stats->stddev[c] = variance > 0.0 ? sqrt(variance) : 0.0;
   }
+
+  return (count);
 }
 
 
 //
-// 'convert_device()' - Convert Device-N raster data.
+// 'RasterDisplay::resize()' - Resize the raster display widget.
 //
 
-static void
-convert_device(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels,	// O - RGB pixels
-    uchar               device_colors[][3])
-    					// I - RGB values for each device color
+void
+RasterDisplay::resize(int X,		// I - New X position
+                      int Y,		// I - New Y position
+		      int W,		// I - New width
+		      int H)		// I - New height
 {
-  int	x,				// X position in line
-	z,				// Color
-	w,				// Width of line
-	val;				// Pixel value
-  int	r, g, b;			// Current RGB color
-
-
-  w = header->cupsWidth;
+  Fl_Widget::resize(X, Y, W, H);
 
-  if (header->cupsColorOrder != CUPS_ORDER_CHUNKED)
-  {
-    fputs("Error: Unsupported color order for Device-N...\n", stderr);
-    return;
-  }
+  xscrollbar_.resize(X, Y + H - SBWIDTH, W - SBWIDTH, SBWIDTH);
+  yscrollbar_.resize(X + W - SBWIDTH, Y, SBWIDTH, H - SBWIDTH);
 
-  if (header->cupsBitsPerColor != 8 && header->cupsBitsPerColor != 16)
-  {
-    fputs("Error: Unsupported bit depth for Device-N...\n", stderr);
-    return;
-  }
+  W -= Fl::box_dw(box()) + SBWIDTH;
+  H -= Fl::box_dh(box()) + SBWIDTH;
 
-  switch (header->cupsBitsPerColor)
+  if (factor_ == 0.0f && header_.cupsWidth && header_.cupsHeight)
   {
-    case 8 :
-	for (x = w; x > 0; x --)
-	{
-	  r = g = b = 255;
-	  for (z = 0; z < header->cupsNumColors; z ++)
-	  {
-	    *colors++ = val = *line++;
-
-	    r -= val * device_colors[z][0] / 255;
-	    g -= val * device_colors[z][1] / 255;
-	    b -= val * device_colors[z][2] / 255;
-	  }
+    xsize_ = W;
 
-	  if (r <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = r;
+    if (xsize_ > (int)(header_.cupsWidth * 4))
+      xsize_ = header_.cupsWidth * 4;
 
-	  if (g <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = g;
+    ysize_ = xsize_ * header_.cupsHeight / header_.cupsWidth;
 
-	  if (b <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = b;
-	}
-	break;
-    case 16 :
-	for (x = w; x > 0; x --)
-	{
-	  r = g = b = 255;
-	  for (z = 0; z < header->cupsNumColors; z ++)
-	  {
-	    if (endian_offset)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	    }
-	    else
-	    {
-	      *colors++ = val = *line++;
-	      *colors++ = *line++;
-	    }
+    if (ysize_ > H)
+    {
+      ysize_ = H;
 
-	    r -= val * device_colors[z][0] / 255;
-	    g -= val * device_colors[z][1] / 255;
-	    b -= val * device_colors[z][2] / 255;
-	  }
+      if (ysize_ > (int)(header_.cupsHeight * 4))
+	ysize_ = header_.cupsHeight * 4;
 
-	  if (r <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = r;
+      xsize_ = ysize_ * header_.cupsWidth / header_.cupsHeight;
+    }
+  }
 
-	  if (g <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = g;
+  update_xmap();
+  update_scrollbars();
 
-	  if (b <= 0)
-	    *pixels++ = 0;
-	  else
-	    *pixels++ = b;
-	}
-	break;
-  }
+  redraw();
 }
 
 
-
 //
-// 'convert_k()' - Convert black raster data.
+// 'RasterDisplay::reuse_page()' - Show a page with the same contents as the
+//                                 current page without decoding it again.
+//
+// Pages with the same hash keep the decoded pixels, cached tiles, and
+// statistics of the current page - only the page header is read...
 //
 
-static void
-convert_k(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - Grayscale pixels
+int					// O - 1 if reused, 0 otherwise
+RasterDisplay::reuse_page(int number)	// I - Page number
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	bit,				// Current bit
-	byte;				// Current byte
+  int			i;		// Looping var
+  cups_page_header_t	header;		// Page header
 
 
-  w = header->cupsWidth;
+  if (!ras_ || loading_ || page_ < 1 || number < 1 || number > num_pages_ || hash_[number - 1] != hash_[page_ - 1])
+    return (0);
+
+  gzseek(fp_, pages_[number - 1], SEEK_SET);
+  rasterReset(ras_);
 
-  switch (header->cupsBitsPerColor)
+  if (!cupsRasterReadHeader(ras_, &header) || header.cupsWidth != header_.cupsWidth || header.cupsHeight != header_.cupsHeight || header.cupsBytesPerLine != header_.cupsBytesPerLine || header.cupsColorSpace != header_.cupsColorSpace)
   {
-    case 1 :
-        for (x = w, bit = 0x80, byte = *line++; x > 0; x --)
-	{
-	  if (byte & bit)
-	  {
-	    *colors++ = 1;
-	    *pixels++ = 0;
-	  }
-	  else
-	  {
-	    colors ++;
-	    pixels ++;
-          }
+    // Not the same after all, go back to the start of the next page...
+    if (page_ < num_pages_)
+    {
+      gzseek(fp_, pages_[page_], SEEK_SET);
+      rasterReset(ras_);
+    }
 
-          if (bit > 1)
-	    bit >>= 1;
-	  else
-	  {
-	    bit  = 0x80;
-	    byte = *line++;
-	  }
-        }
-        break;
-    case 2 :
-        for (x = w; x > 0; x -= 4)
-	{
-	  byte = *line++;
+    return (0);
+  }
 
-	  *colors++ = val = (byte & 0xc0) >> 6;
-	  *pixels++ = ~(85 * val);
+  header_ = header;
 
-	  if (x > 1)
-	  {
-	    *colors++ = val = (byte & 0x30) >> 4;
-	    *pixels++ = ~(85 * val);
-	  }
+  for (i = 0; i < num_tiles_; i ++)
+  {
+    if (tiles_[i].page == page_)
+      tiles_[i].page = number;
+  }
 
-	  if (x > 2)
-	  {
-	    *colors++ = val = (byte & 0x0c) >> 2;
-	    *pixels++ = ~(85 * val);
-	  }
+  page_ = number;
+
+  if (page_ < num_pages_)
+  {
+    // Position the stream at the start of the next page...
+    gzseek(fp_, pages_[page_], SEEK_SET);
+    rasterReset(ras_);
+  }
 
-	  if (x > 3)
-	  {
-	    *colors++ = val = byte & 0x03;
-	    *pixels++ = ~(85 * val);
-	  }
-        }
-        break;
-    case 4 :
-        for (x = w; x > 0; x -= 2)
-	{
-	  byte = *line++;
+  if (show_diff_)
+    flush_tiles();
 
-	  *colors++ = val = (byte & 0xf0) >> 4;
-	  *pixels++ = ~(17 * val);
+  redraw();
 
-	  *colors++ = val = byte & 0x0f;
-	  *pixels++ = ~(17 * val);
-        }
-        break;
-    case 8 :
-        for (x = w; x > 0; x --)
-	{
-	  *colors++ = val = *line++;
-	  *pixels++ = ~val;
-	}
-        break;
-    case 16 :
-	if (endian_offset)
-	{
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *line++;
-	    *colors++ = val = *line++;
-	    *pixels++ = ~val;
-          }
-	}
-	else
-	{
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = val = *line++;
-	    *pixels++ = ~val;
-	    *colors++ = *line++;
-          }
-	}
-        break;
+  if (compare_ && compare_->show_diff_)
+  {
+    compare_->flush_tiles();
+    compare_->redraw();
   }
+
+  return (1);
 }
 
 
 //
-// 'convert_kcmy()' - Convert KCMY or KCMYcm (8-bit) raster data.
+// 'RasterDisplay::same_page()' - Return the first earlier page with the same
+//                                contents.
 //
 
-static void
-convert_kcmy(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+int					// O - Page number or 0 if none
+RasterDisplay::same_page(
+    int number) const			// I - Page number
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	*kptr,				// Black pointer
-	bit;				// Current bit
-  int	r, g, b, k;			// Current RGB color + K
+  int	i;				// Looping var
 
 
-  w = header->cupsWidth;
+  if (number < 1 || number > num_pages_)
+    return (0);
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  for (i = 0; i < (number - 1); i ++)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit       = *line++;
-	    *colors++ = bit >> 4;
+    if (hash_[i] == hash_[number - 1])
+      return (i + 1);
+  }
 
-            if (bit & 0x80)
-	    {
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      if (bit & 0x40)
-		pixels[0] = 0;
-	      if (bit & 0x20)
-		pixels[1] = 0;
-	      if (bit & 0x10)
-		pixels[2] = 0;
-	    }
-
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x08)
-	      {
-		pixels[3] = 0;
-		pixels[4] = 0;
-		pixels[5] = 0;
-	      }
-	      else
-	      {
-		if (bit & 0x04)
-	          pixels[3] = 0;
-		if (bit & 0x02)
-	          pixels[4] = 0;
-		if (bit & 0x01)
-	          pixels[5] = 0;
-	      }
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
+  return (0);
+}
 
-	    k = 85 * ((bit & 0xc0) >> 6);
-	    r = 255 - 85 * ((bit & 0x30) >> 4) - k;
-	    g = 255 - 85 * ((bit & 0x0c) >> 2) - k;
-	    b = 255 - 85 * (bit & 0x03) - k;
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+//
+// 'RasterDisplay::save_colors()' - Save device colors.
+//
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+void
+RasterDisplay::save_colors()
+{
+  int		i;			// Looping var
+  char		key[256],		// Key string
+		value[256];		// Value
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
 
-	    k = 17 * ((bit & 0xf0) >> 4);
-	    r = 255 - 17 * (bit & 0x0f) - k;
+  if (!is_subtractive() || header_.cupsBitsPerColor < 8)
+    return;
 
-	    *colors++ = bit = *line++;
+  if (!prefs)
+    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
 
-	    g = 255 - 17 * ((bit & 0xf0) >> 4) - k;
-	    b = 255 - 17 * (bit & 0x0f) - k;
+  for (i = 0; i < header_.cupsNumColors; i ++)
+  {
+    snprintf(key, sizeof(key), "cs%dc%d", header_.cupsColorSpace, i);
+    snprintf(value, sizeof(value), "%d %d %d", device_colors_[i][0], device_colors_[i][1], device_colors_[i][2]);
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+    prefs->set(key, value);
+  }
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  prefs->flush();
+}
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *line;
-	    k         = *line++;
-	    *colors++ = *line;
-	    r         = 255 - *line++ - k;
-	    *colors++ = *line;
-	    g         = 255 - *line++ - k;
-	    *colors++ = *line;
-	    b         = 255 - *line++ - k;
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+//
+// 'RasterDisplay::save_index()' - Save the page index for the file.
+//
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-	    if (endian_offset)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = k = *line++;
+void
+RasterDisplay::save_index()
+{
+  raster_cache_t	cache;		// Cache file header
+  char			cachefile[1024];// Cache filename
+  FILE			*fp;		// Cache file
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      r         = 255 - val - k;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      g         = 255 - val - k;
+  if (num_pages_ < 1 || !index_file(filename_, cachefile, sizeof(cachefile), &cache))
+    return;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      b         = 255 - val - k;
-            }
-	    else
-	    {
-	      *colors++ = k = *line++;
-	      *colors++ = *line++;
+  cache.num_pages = num_pages_;
+  cache.num_index = num_index_;
 
-	      *colors++ = val = *line++;
-	      r         = 255 - val - k;
-	      *colors++ = *line++;
+  if ((fp = fopen(cachefile, "wb")) == NULL)
+    return;
 
-	      *colors++ = val = *line++;
-	      g         = 255 - val - k;
-	      *colors++ = *line++;
+  if (fwrite(&cache, sizeof(cache), 1, fp) != 1 ||
+      fwrite(pages_, sizeof(z_off_t), (size_t)num_pages_ + 1, fp) != (size_t)num_pages_ + 1 ||
+      fwrite(page_index_, sizeof(int), (size_t)num_pages_ + 1, fp) != (size_t)num_pages_ + 1 ||
+      fwrite(bbox_, sizeof(bbox_[0]), (size_t)num_pages_, fp) != (size_t)num_pages_ ||
+      fwrite(hash_, sizeof(hash_[0]), (size_t)num_pages_, fp) != (size_t)num_pages_ ||
+      fwrite(index_, sizeof(raster_index_t), (size_t)num_index_, fp) != (size_t)num_index_)
+  {
+    // Don't leave a partial cache file...
+    fclose(fp);
+    remove(cachefile);
+    return;
+  }
 
-	      *colors++ = val = *line++;
-	      b         = 255 - val - k;
-	      *colors++ = *line++;
-            }
+  fclose(fp);
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  index_prune(cachefile);
+}
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-    }
+//
+// 'RasterDisplay::scale()' - Scale the image.
+//
+
+void
+RasterDisplay::scale(float factor)	// I - Scaling factor (0 = auto)
+{
+  int	X, Y, W, H;			// Interior of widget
+  float	ratio;				// Scaling ratio
+
+
+  if (factor)
+  {
+    xscrollbar_.show();
+    yscrollbar_.show();
   }
   else
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
-
+    xscrollbar_.hide();
+    yscrollbar_.hide();
+  }
 
-    kptr = line;
-    cptr = line + bytespercolor;
-    mptr = line + 2 * bytespercolor;
-    yptr = line + 3 * bytespercolor;
+  if (factor > 20.0f)
+    factor = 20.0f;
 
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*kptr & bit)
-	    {
-	      *colors++ = 1;
+  // Make sure that the image doesn't get scaled to nothin'...
+  if (header_.cupsWidth && header_.cupsHeight)
+  {
+    if (factor > 0.0f && (header_.cupsWidth * factor) < 32.0f && header_.cupsWidth > 32)
+      factor = 32.0f / header_.cupsWidth;
 
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      colors ++;
-
-	      if (*cptr & bit)
-		pixels[0] = 0;
-	      if (*mptr & bit)
-		pixels[1] = 0;
-	      if (*yptr & bit)
-		pixels[2] = 0;
-            }
+    if (factor > 0.0f && (header_.cupsHeight * factor) < 32.0f && header_.cupsHeight > 32)
+      factor = 32.0f / header_.cupsHeight;
+  }
 
-	    if (*cptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  if (factor_ == 0.0f)
+    ratio = 0.0f;
+  else
+    ratio = factor / factor_;
 
-	    if (*mptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  factor_ = factor;
 
-	    if (*yptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  redraw();
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      cptr ++;
-	      mptr ++;
-	      yptr ++;
-	      kptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*kptr & 0xc0) >> 6;
-		  k         = 85 * val;
-
-	          *colors++ = val = (*cptr & 0xc0) >> 6;
-		  r         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*mptr & 0xc0) >> 6;
-		  g         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*yptr & 0xc0) >> 6;
-		  b         = 255 - 85 * val - k;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*kptr & 0x30) >> 4;
-		  k         = 85 * val;
-
-	          *colors++ = val = (*cptr & 0x30) >> 4;
-		  r         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*mptr & 0x30) >> 4;
-		  g         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*yptr & 0x30) >> 4;
-		  b         = 255 - 85 * val - k;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*kptr & 0x0c) >> 2;
-		  k         = 85 * val;
-
-	          *colors++ = val = (*cptr & 0x0c) >> 2;
-		  r         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*mptr & 0x0c) >> 2;
-		  g         = 255 - 85 * val - k;
-
-	          *colors++ = val = (*yptr & 0x0c) >> 2;
-		  b         = 255 - 85 * val - k;
-                  break;
-	      case 3 :
-	          *colors++ = val = *kptr & 0x03;
-		  k         = 85 * val;
-
-	          *colors++ = val = *cptr & 0x03;
-		  r         = 255 - 85 * val - k;
-
-	          *colors++ = val = *mptr & 0x03;
-		  g         = 255 - 85 * val - k;
-
-	          *colors++ = val = *yptr & 0x03;
-		  b         = 255 - 85 * val - k;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (!header_.cupsWidth || !header_.cupsHeight)
+    return;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  W = visible_w();
+  H = visible_h();
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*kptr & 0xf0) >> 4;
-		  k         = 17 * val;
-	          *colors++ = val = (*cptr & 0xf0) >> 4;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val = (*mptr & 0xf0) >> 4;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = (*yptr & 0xf0) >> 4;
-		  b         = 255 - 17 * val - k;
-                  break;
-	      case 1 :
-	          *colors++ = val = *kptr & 0x0f;
-		  k         = 17 * val;
-	          *colors++ = val = *cptr & 0x0f;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val = *mptr & 0x0f;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = *yptr & 0x0f;
-		  b         = 255 - 17 * val - k;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (factor_ == 0.0f)
+  {
+    xsize_ = W;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    if (xsize_ > (int)(header_.cupsWidth * 4))
+      xsize_ = header_.cupsWidth * 4;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = k = *kptr++;
-	    *colors++ = val = *cptr++;
-	    r         = 255 - val - k;
-	    *colors++ = val = *mptr++;
-	    g         = 255 - val - k;
-	    *colors++ = val = *yptr++;
-	    b         = 255 - val - k;
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+    ysize_ = xsize_ * header_.cupsHeight / header_.cupsWidth;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    if (ysize_ > H)
+    {
+      ysize_ = H;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-            if (endian_offset)
-	    {
-	      *colors++ = *kptr++;
-	      *colors++ = k = *kptr++;
+      if (ysize_ > (int)(header_.cupsHeight * 4))
+	ysize_ = header_.cupsHeight * 4;
 
-	      *colors++ = *cptr++;
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val - k;
+      xsize_ = ysize_ * header_.cupsWidth / header_.cupsHeight;
+    }
 
-	      *colors++ = *mptr++;
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val - k;
+    X = 0;
+    Y = 0;
+  }
+  else
+  {
+    xsize_ = (int)((float)header_.cupsWidth * factor_ + 0.5f);
+    ysize_ = (int)((float)header_.cupsHeight * factor_ + 0.5f);
 
-	      *colors++ = *yptr++;
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val - k;
-            }
-	    else
-            {
-	      *colors++ = k = *kptr++;
-	      *colors++ = *kptr++;
+    if (xsize_ <= W)
+    {
+      // The image will be centered...
+      X = 0;
+    }
+    else if (ratio == 0.0)
+    {
+      // Previous zoom was auto-fit, center it...
+      X = (xsize_ - W) / 2;
+    }
+    else
+    {
+      // Try to center on the previous location...
+      X = (int)((xscrollbar_.value() + W / 2) * ratio) - W / 2;
+    }
 
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val - k;
-	      *colors++ = *cptr++;
+    if (ysize_ <= H)
+    {
+      // The image will be centered...
+      Y = 0;
+    }
+    else if (ratio == 0.0)
+    {
+      // Previous zoom was auto-fit, center it...
+      Y = (ysize_ - H) / 2;
+    }
+    else
+    {
+      // Try to center on the previous location...
+      Y = (int)((yscrollbar_.value() + H / 2) * ratio) - H / 2;
+    }
+  }
 
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val - k;
-	      *colors++ = *mptr++;
+  update_xmap();
 
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val - k;
-	      *colors++ = *yptr++;
-	    }
+  // Update the scrollbars...
+  if (X < 0)
+    X = 0;
+  else if (X > (xsize_ - W))
+    X = xsize_ - W;
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (xsize_ <= W)
+  {
+    xscrollbar_.deactivate();
+    xscrollbar_.value(0, 1, 0, 1);
+  }
+  else
+  {
+    xscrollbar_.activate();
+    xscrollbar_.value(X, W, 0, xsize_);
+  }
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  if (Y < 0)
+    Y = 0;
+  else if (Y > (ysize_ - H))
+    Y = ysize_ - H;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-	  }
-          break;
-    }
+  if (ysize_ <= H)
+  {
+    yscrollbar_.deactivate();
+    yscrollbar_.value(0, 1, 0, 1);
+  }
+  else
+  {
+    yscrollbar_.activate();
+    yscrollbar_.value(Y, H, 0, ysize_);
   }
+
+  sync_compare();
 }
 
 
 //
-// 'convert_kcmycm()' - Convert KCMYcm (1-bit) raster data.
+// 'RasterDisplay::scale_channels()' - Scale a single line of the selected
+//                                     separations.
+//
+// One separation is shown as a grayscale image and several are mixed using
+// the device colors.  Only the displayed pixels are extracted from the original
+// color values, so changing separations doesn't need to reconvert the page...
 //
 
-static void
-convert_kcmycm(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+void
+RasterDisplay::scale_channels(int   X,	// I - X position in device pixels
+                              int   Y,	// I - Y position in device pixels
+                              int   W,	// I - Width of image row
+                              uchar *D)	// O - Image data
 {
-  int	x,				// X position in line
-	w;				// Width of line
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	*kptr,				// Black pointer
-	*lcptr,				// Light cyan pointer
-	*lmptr,				// Light magenta pointer
-	bit;				// Current bit
-  int	r, g, b;			// Current RGB color
+  int		c,			// Current channel
+		y,			// Source row
+		nchannels,		// Number of channels
+		shift,			// Shift to get 8-bit value
+		r, g, b,		// Current RGB color
+		val;			// Channel value
+  unsigned	mask,			// Channels to show
+		maxval;			// Maximum channel value
+  const uchar	*row,			// Current row of colors
+		*color;			// Current color
+  const int	*xmap;			// Pointer into column map
+
+
+  if (!xmap_)
+    return;
 
+  y         = (int)((long)Y * header_.cupsHeight / dysize_);
+  nchannels = (int)header_.cupsNumColors;
+  mask      = channels_ & ((1U << nchannels) - 1);
+  row       = colors_ + (long)y * header_.cupsWidth * bpc_;
 
-  w = header->cupsWidth;
+  if (pending_y_ >= 0 && pending_[y])
+    convert_row(y);
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (header_.cupsBitsPerColor == 16)
   {
-    // Chunky
-    for (x = w; x > 0; x --)
-    {
-      bit       = *line++;
-      *colors++ = bit;
-
-      if (bit & 0x20)
-      {
-        *pixels++ = 0;
-        *pixels++ = 0;
-        *pixels++ = 0;
-	continue;
-      }
-
-      r = g = 255;
-
-      if (bit & 0x10)
-	r -= 255;
-      if (bit & 0x08)
-	g -= 255;
-      if (bit & 0x02)
-	r -= 127;
-      if (bit & 0x01)
-	g -= 127;
-      if (bit & 0x04)
-	b = 0;
-      else
-        b = 255;
-
-      if (r < 0)
-	*pixels++ = 0;
-      else
-	*pixels++ = r;
-
-      if (g < 0)
-	*pixels++ = 0;
-      else
-	*pixels++ = g;
-
-      // Blue is always in range...
-      *pixels++ = b;
-    }
+    maxval = 255;
+    shift  = 8;
   }
   else
   {
-    // Banded
-    int bytespercolor = header->cupsBytesPerLine / 6;
-
+    maxval = (1U << header_.cupsBitsPerColor) - 1;
+    shift  = 0;
+  }
 
-    kptr  = line;
-    cptr  = line + bytespercolor;
-    mptr  = line + 2 * bytespercolor;
-    yptr  = line + 3 * bytespercolor;
-    lcptr = line + 4 * bytespercolor;
-    lmptr = line + 5 * bytespercolor;
+  for (xmap = xmap_ + X; W > 0; W --, xmap ++)
+  {
+    color = row + (long)(*xmap / bpp_) * bpc_;
 
-    for (x = w, bit = 0x80; x > 0; x --)
+    if (!(mask & (mask - 1)))
     {
-      if (*kptr & bit)
-      {
-        *colors++ = 1;
-	*pixels++ = 0;
-	*pixels++ = 0;
-	*pixels++ = 0;
-      }
-      else
-      {
-        colors ++;
-        r = g = 255;
-
-	if (*cptr & bit)
-	  r -= 255;
-	if (*mptr & bit)
-	  g -= 255;
-	if (*lcptr & bit)
-	  r -= 127;
-	if (*lmptr & bit)
-	  g -= 127;
-	if (*yptr & bit)
-	  b = 0;
-	else
-	  b = 255;
-
-	if (r < 0)
-	  *pixels++ = 0;
-	else
-	  *pixels++ = r;
-
-	if (g < 0)
-	  *pixels++ = 0;
-	else
-	  *pixels++ = g;
-
-	// Blue is always in range...
-	*pixels++ = b;
-      }
-
-      if (*cptr & bit)
-        *colors++ = 1;
-      else
-        colors ++;
-
-      if (*mptr & bit)
-        *colors++ = 1;
-      else
-        colors ++;
-
-      if (*yptr & bit)
-        *colors++ = 1;
-      else
-        colors ++;
-
-      if (*lcptr & bit)
-        *colors++ = 1;
-      else
-        colors ++;
+      // One separation, show as grayscale...
+      for (c = 0; c < nchannels && !(mask & (1U << c)); c ++);
 
-      if (*lmptr & bit)
-        *colors++ = 1;
+      if (c < nchannels)
+        r = 255 - (int)((rasterChannelValue(&header_, bpc_, color, c) >> shift) * 255 / maxval);
       else
-        colors ++;
+        r = 255;
 
-      if (bit > 1)
-	bit >>= 1;
-      else
-      {
-	bit = 0x80;
-	cptr ++;
-	mptr ++;
-	yptr ++;
-	kptr ++;
-	lcptr ++;
-	lmptr ++;
-      }
+      g = b = r;
     }
-  }
-}
-
+    else
+    {
+      // Mix the selected separations...
+      for (c = 0, r = g = b = 255; c < nchannels; c ++)
+      {
+        if (!(mask & (1U << c)))
+          continue;
 
-//
-// 'convert_lab()' - Convert CIE Lab or ICCn raster data.
-//
+        val = (int)((rasterChannelValue(&header_, bpc_, color, c) >> shift) * 255 / maxval);
 
-static void
-convert_lab(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
-{
-  int			x,		// X position in line
-			w,		// Width of line
-			val;		// Pixel value
-  unsigned short	*sline;		// 16-bit pixels
-  float			lab[3],		// Lab color
-			p,		//
-			xyz[3],		// XYZ color
-			rgb[3];		// RGB color
+	r -= val * device_colors_[c][0] / 255;
+	g -= val * device_colors_[c][1] / 255;
+	b -= val * device_colors_[c][2] / 255;
+      }
 
+      if (r < 0)
+        r = 0;
+      if (g < 0)
+        g = 0;
+      if (b < 0)
+        b = 0;
+    }
 
-  w = header->cupsWidth;
+    *D++ = (uchar)r;
 
-  for (x = w, sline = (unsigned short *)line; x > 0; x --)
-  {
-    // Extract the Lab color value...
-    if (header->cupsBitsPerColor == 8)
-    {
-      // 8-bit color values...
-      *colors++ = val = *line++;
-      lab[0]    = val / 2.55f;
-      *colors++ = val = *line++;
-      lab[1]    = val - 128.0f;
-      *colors++ = val = *line++;
-      lab[2]    = val - 128.0f;
-    }
-    else
+    if (bpp_ == 3)
     {
-      // 16-bit color values...
-      *colors++ = *line++;
-      *colors++ = *line++;
-      lab[0]    = *sline++ / 655.35f;
-      *colors++ = *line++;
-      *colors++ = *line++;
-      lab[1]    = *sline++ / 256.0f - 128.0f;
-      *colors++ = *line++;
-      *colors++ = *line++;
-      lab[2]    = *sline++ / 256.0f - 128.0f;
+      *D++ = (uchar)g;
+      *D++ = (uchar)b;
     }
-
-    // Convert Lab to XYZ...
-    if (lab[0] < 8)
-      p = lab[0] / 903.3;
-    else
-      p = (lab[0] + 16.0f) / 116.0f;
-
-    xyz[0] = D65_X * pow(p + lab[1] * 0.002, 3.0);
-    xyz[1] = D65_Y * pow((double)p, 3.0);
-    xyz[2] = D65_Z * pow(p - lab[2] * 0.005, 3.0);
-
-    // Convert XYZ to sRGB...
-    rgb[0] =  3.240479f * xyz[0] - 1.537150f * xyz[1] - 0.498535f * xyz[2];
-    rgb[1] = -0.969256f * xyz[0] + 1.875992f * xyz[1] + 0.041556f * xyz[2];
-    rgb[2] =  0.055648f * xyz[0] - 0.204043f * xyz[1] + 1.057311f * xyz[2];
-
-    rgb[0] = rgb[0] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[0], 0.41666) - 0.055f;
-    rgb[1] = rgb[1] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[1], 0.41666) - 0.055f;
-    rgb[2] = rgb[2] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[2], 0.41666) - 0.055f;
-
-    // Save it...
-    if (rgb[0] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[0] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[0] + 0.5);
-    else
-      *pixels++ = 255;
-
-    if (rgb[1] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[1] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[1] + 0.5);
-    else
-      *pixels++ = 255;
-
-    if (rgb[2] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[2] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[2] + 0.5);
-    else
-      *pixels++ = 255;
   }
 }
 
 
 //
-// 'convert_rgb()' - Convert RGB raster data.
+// 'RasterDisplay::scale_line()' - Scale a single line of the image.
 //
 
-static void
-convert_rgb(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+void
+RasterDisplay::scale_line(int   X,	// I - X position in device pixels
+                          int   Y,	// I - Y position in device pixels
+                          int   W,	// I - Width of image row
+                          uchar *D)	// O - Image data
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*rptr,				// Red pointer
-	*gptr,				// Green pointer
-	*bptr,				// Blue pointer
-	bit;				// Current bit
-
+  const uchar	*inptr;			// Pointer into image
+  const int	*xmap;			// Pointer into column map
+  int		bpp,			// Bytes per pixel value
+		count;			// Pixels left in current source pixel
 
-  w = header->cupsWidth;
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (channels_)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-	  memset(pixels, 0, w * 3);
-
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit = *line++;
-	    *colors++ = bit >> 4;
-
-	    if (bit & 0x40)
-	      pixels[0] = 255;
-	    if (bit & 0x20)
-	      pixels[1] = 255;
-	    if (bit & 0x10)
-	      pixels[2] = 255;
-
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x04)
-	        pixels[3] = 255;
-	      if (bit & 0x02)
-	        pixels[4] = 255;
-	      if (bit & 0x01)
-	        pixels[5] = 255;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-
-	    *pixels++ = 85 * ((bit & 0x30) >> 4);
-	    *pixels++ = 85 * ((bit & 0x0c) >> 2);
-	    *pixels++ = 85 * (bit & 0x03);
-          }
-          break;
-      case 4 :
-	  memset(pixels, 0, w * 3);
-
-          for (x = w; x > 0; x --, pixels += 3)
-	  {
-	    bit = *line++;
-	    *colors++ = bit;
-
-	    if (bit & 0x0f)
-	      pixels[0] += 17 * (bit & 0x0f);
-
-	    bit = *line++;
-	    *colors++ = bit;
+    // Show only the selected separations...
+    scale_channels(X, Y, W, D);
+    return;
+  }
 
-	    if (bit & 0xf0)
-	      pixels[1] += 17 * ((bit & 0xf0) >> 4);
-	    if (bit & 0x0f)
-	      pixels[2] += 17 * (bit & 0x0f);
-          }
-          break;
-      case 8 :
-	  memcpy(colors, line, w * 3);
-          memcpy(pixels, line, w * 3);
-          break;
-      case 16 :
-	  if (endian_offset)
-	    *colors++ = *line++;
+  if (bits_pixel_ && dxsize_ < (int)header_.cupsWidth)
+  {
+    // Area-average 1-bit data when zoomed out...
+    average_bits(X, Y, W, D);
+    return;
+  }
 
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *pixels++ = *line++;
-	    *colors++ = *line++;
+  if (!xmap_)
+    return;
 
-	    *colors++ = *pixels++ = *line++;
-	    *colors++ = *line++;
+  bpp   = bpp_;
+  Y     = Y * header_.cupsHeight / dysize_;
+  inptr = pixels_ + Y * header_.cupsWidth * bpp;
 
-	    *colors++ = *pixels++ = *line++;
-	    if (!endian_offset || x > 1)
-	      *colors++ = *line++;
-          }
-          break;
-    }
+  if (xrep_ == 1)
+  {
+    // 1:1, copy the row...
+    memcpy(D, inptr + X * bpp, (size_t)W * bpp);
   }
-  else
+  else if (xrep_ > 1)
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
-
+    // Integer zoom, replicate each source pixel...
+    inptr += (X / xrep_) * bpp;
+    count = xrep_ - X % xrep_;
 
-    rptr = line;
-    gptr = line + bytespercolor;
-    bptr = line + 2 * bytespercolor;
-
-    switch (header->cupsBitsPerColor)
+    if (bpp == 1)
     {
-      case 1 :
-	  memset(pixels, 0, w * 3);
-
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*rptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[0] = 255;
-	    }
-	    else
-	      colors ++;
-
-	    if (*gptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[1] = 255;
-	    }
-	    else
-	      colors ++;
+      while (W > 0)
+      {
+        if (count > W)
+          count = W;
 
-	    if (*bptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[2] = 255;
-	    }
-	    else
-	      colors ++;
+        memset(D, *inptr++, (size_t)count);
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      rptr ++;
-	      gptr ++;
-	      bptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xc0) >> 6;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*gptr & 0xc0) >> 6;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*bptr & 0xc0) >> 6;
-		  *pixels++ = 85 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*rptr & 0x30) >> 4;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*gptr & 0x30) >> 4;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*bptr & 0x30) >> 4;
-		  *pixels++ = 85 * val;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*rptr & 0x0c) >> 2;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*gptr & 0x0c) >> 2;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = (*bptr & 0x0c) >> 2;
-		  *pixels++ = 85 * val;
-                  break;
-	      case 3 :
-	          *colors++ = val = *rptr & 0x03;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = *gptr & 0x03;
-		  *pixels++ = 85 * val;
-	          *colors++ = val = *bptr & 0x03;
-		  *pixels++ = 85 * val;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xf0) >> 4;
-		  *pixels++ = 17 * val;
-	          *colors++ = val = (*gptr & 0xf0) >> 4;
-		  *pixels++ = 17 * val;
-	          *colors++ = val = (*bptr & 0xf0) >> 4;
-		  *pixels++ = 17 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = *rptr & 0x0f;
-		  *pixels++ = 17 * val;
-	          *colors++ = val = *gptr & 0x0f;
-		  *pixels++ = 17 * val;
-	          *colors++ = val = *bptr & 0x0f;
-		  *pixels++ = 17 * val;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *pixels++ = *rptr++;
-	    *colors++ = *pixels++ = *gptr++;
-	    *colors++ = *pixels++ = *bptr++;
-          }
-          break;
-      case 16 :
-          if (endian_offset)
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = *rptr++;
-	      *colors++ = *pixels++ = *rptr++;
-	      *colors++ = *gptr++;
-	      *colors++ = *pixels++ = *gptr++;
-	      *colors++ = *bptr++;
-	      *colors++ = *pixels++ = *bptr++;
-            }
-	  }
-	  else
-	  {
-            for (x = w; x > 0; x --)
-	    {
-	      *colors++ = *pixels++ = *rptr++;
-	      *colors++ = *rptr++;
-	      *colors++ = *pixels++ = *gptr++;
-	      *colors++ = *gptr++;
-	      *colors++ = *pixels++ = *bptr++;
-	      *colors++ = *bptr++;
-            }
-	  }
-          break;
+        D     += count;
+        W     -= count;
+        count = xrep_;
+      }
+    }
+    else
+    {
+      for (; W > 0; W --, D += 3)
+      {
+        D[0] = inptr[0];
+        D[1] = inptr[1];
+        D[2] = inptr[2];
+
+        if (-- count == 0)
+        {
+          inptr += 3;
+          count = xrep_;
+        }
+      }
     }
   }
-}
-
-
-//
-// 'convert_rgba()' - Convert RGBA raster data.
-//
-
-static void
-convert_rgba(
-    cups_page_header_t *header,	// I - Raster header */
-    int                 y,		// I - Raster Y position
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
-{
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*rptr,				// Red pointer
-	*gptr,				// Green pointer
-	*bptr,				// Blue pointer
-	*aptr,				// Alpha pointer
-	bit;				// Current bit
-  int	r, g, b, a;			// Current color
-  int	bg;				// Background to blend
-
-
-  w = header->cupsWidth;
-  y &= 128;
-
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  else if (bpp == 1)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
+    // Arbitrary zoom, gather pixels using the column map...
+    for (xmap = xmap_ + X; W >= 4; W -= 4, D += 4, xmap += 4)
     {
-      case 1 :
-	  memset(pixels, 0, w * 3);
-
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit = *line++;
-	    *colors++ = bit >> 4;
-
-            if (bit & 0x10)
-	    {
-	      if (bit & 0x80)
-		pixels[0] = 255;
-	      if (bit & 0x40)
-		pixels[1] = 255;
-	      if (bit & 0x20)
-		pixels[2] = 255;
-            }
-	    else if ((x & 128) ^ y)
-	    {
-	      pixels[0] = 128;
-	      pixels[1] = 128;
-	      pixels[2] = 128;
-	    }
-	    else
-	    {
-	      pixels[0] = 192;
-	      pixels[1] = 192;
-	      pixels[2] = 192;
-	    }
-
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-              if (bit & 0x01)
-	      {
-		if (bit & 0x08)
-	          pixels[3] = 255;
-		if (bit & 0x04)
-	          pixels[4] = 255;
-		if (bit & 0x02)
-	          pixels[5] = 255;
-	      }
-	      else if (((x - 1) & 128) ^ y)
-	      {
-		pixels[3] = 128;
-		pixels[4] = 128;
-		pixels[5] = 128;
-	      }
-	      else
-	      {
-		pixels[3] = 192;
-		pixels[4] = 192;
-		pixels[5] = 192;
-	      }
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-
-	    r = 85 * ((bit & 0xc0) >> 6);
-	    g = 85 * ((bit & 0x30) >> 4);
-	    b = 85 * ((bit & 0x0c) >> 2);
-	    a = 85 * (bit & 0x03);
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-
-	    r = 17 * ((bit & 0xf0) >> 4);
-	    g = 17 * (bit & 0x0f);
-
-	    *colors++ = bit = *line++;
-
-	    b = 17 * ((bit & 0xf0) >> 4);
-	    a = 17 * (bit & 0x0f);
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *line++;
-	    *colors++ = g = *line++;
-	    *colors++ = b = *line++;
-	    *colors++ = a = *line++;
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 16 :
-	  if (endian_offset)
-	    *colors++ = *line++;
-
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *line++;
-	    *colors++ = *line++;
-	    *colors++ = g = *line++;
-	    *colors++ = *line++;
-	    *colors++ = b = *line++;
-	    *colors++ = *line++;
-	    *colors++ = a = *line++;
-	    if (!endian_offset || x > 1)
-	      *colors++ = *line++;
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
+      D[0] = inptr[xmap[0]];
+      D[1] = inptr[xmap[1]];
+      D[2] = inptr[xmap[2]];
+      D[3] = inptr[xmap[3]];
     }
+
+    for (; W > 0; W --)
+      *D++ = inptr[*xmap++];
   }
   else
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
-
+    const uchar	*ptr;			// Pointer to source pixel
 
-    rptr = line;
-    gptr = line + bytespercolor;
-    bptr = line + 2 * bytespercolor;
-    aptr = line + 3 * bytespercolor;
-
-    switch (header->cupsBitsPerColor)
+    for (xmap = xmap_ + X; W > 0; W --, D += 3)
     {
-      case 1 :
-	  memset(pixels, 0, w * 3);
-
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*rptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[0] = 255;
-	    }
-	    else
-	      colors ++;
-
-	    if (*gptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[1] = 255;
-	    }
-	    else
-	      colors ++;
-
-	    if (*bptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[2] = 255;
-	    }
-	    else
-	      colors ++;
-
-	    if (*aptr & bit)
-	      *colors++ = 1;
-	    else
-	    {
-	      colors ++;
-
-	      if ((x & 128) ^ y)
-	      {
-		pixels[0] = 128;
-		pixels[1] = 128;
-		pixels[2] = 128;
-	      }
-	      else
-	      {
-		pixels[0] = 192;
-		pixels[1] = 192;
-		pixels[2] = 192;
-	      }
-            }
-
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      rptr ++;
-	      gptr ++;
-	      bptr ++;
-	      aptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xc0) >> 6;
-		  r         = 85 * val;
-
-	          *colors++ = val = (*gptr & 0xc0) >> 6;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0xc0) >> 6;
-		  b         = 85 * val;
-
-	          *colors++ = val = (*aptr & 0xc0) >> 6;
-		  a         = 85 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*rptr & 0x30) >> 4;
-		  r         = 85 * val;
-
-	          *colors++ = val = (*gptr & 0x30) >> 4;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0x30) >> 4;
-		  b         = 85 * val;
-
-	          *colors++ = val = (*aptr & 0x30) >> 4;
-		  a         = 85 * val;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*rptr & 0x0c) >> 2;
-		  r         = 85 * val;
-
-	          *colors++ = val = (*gptr & 0x0c) >> 2;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0x0c) >> 2;
-		  b         = 85 * val;
-
-	          *colors++ = val = (*aptr & 0x0c) >> 2;
-		  a         = 85 * val;
-                  break;
-	      case 3 :
-	          *colors++ = val = *rptr & 0x03;
-		  r         = 85 * val;
-
-	          *colors++ = val = *gptr & 0x03;
-		  g         = 85 * val;
-
-	          *colors++ = val = *bptr & 0x03;
-		  b         = 85 * val;
-
-	          *colors++ = val = *aptr & 0x03;
-		  a         = 85 * val;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-		  aptr ++;
-                  break;
-	    }
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xf0) >> 4;
-		  r         = 17 * val;
-
-	          *colors++ = val = (*gptr & 0xf0) >> 4;
-		  g         = 17 * val;
-
-	          *colors++ = val = (*bptr & 0xf0) >> 4;
-		  b         = 17 * val;
-
-	          *colors++ = val = (*aptr & 0xf0) >> 4;
-		  a         = 17 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = *rptr & 0x0f;
-		  r         = 17 * val;
-
-	          *colors++ = val = *gptr & 0x0f;
-		  g         = 17 * val;
-
-	          *colors++ = val = *bptr & 0x0f;
-		  b         = 17 * val;
-
-	          *colors++ = val = *aptr & 0x0f;
-		  a         = 17 * val;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-		  aptr ++;
-                  break;
-	    }
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *rptr++;
-	    *colors++ = g = *gptr++;
-	    *colors++ = b = *bptr++;
-	    *colors++ = a = *aptr++;
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-            if (endian_offset)
-	    {
-	      *colors++ = *rptr++;
-	      *colors++ = r = *rptr++;
-	      *colors++ = *gptr++;
-	      *colors++ = g = *gptr++;
-	      *colors++ = *bptr++;
-	      *colors++ = b = *bptr++;
-	      *colors++ = *aptr++;
-	      *colors++ = a = *aptr++;
-            }
-	    else
-	    {
-	      *colors++ = r = *rptr++;
-	      *colors++ = *rptr++;
-	      *colors++ = g = *gptr++;
-	      *colors++ = *gptr++;
-	      *colors++ = b = *bptr++;
-	      *colors++ = *bptr++;
-	      *colors++ = a = *aptr++;
-	      *colors++ = *aptr++;
-            }
-
-	    if (a < 255)
-	    {
-	      if ((x & 128) ^ y)
-	        bg = 128;
-	      else
-	        bg = 192;
-
-              if (a == 0)
-	        r = g = b = bg;
-	      else
-	      {
-        	r = (a * r + (255 - a) * bg) / 255;
-        	g = (a * g + (255 - a) * bg) / 255;
-        	b = (a * b + (255 - a) * bg) / 255;
-	      }
-	    }
-
-	    *pixels++ = r;
-	    *pixels++ = g;
-	    *pixels++ = b;
-	  }
-          break;
+      ptr  = inptr + *xmap++;
+      D[0] = ptr[0];
+      D[1] = ptr[1];
+      D[2] = ptr[2];
     }
   }
 }
 
 
 //
-// 'convert_rgbw()' - Convert RGBW raster data.
+// 'RasterDisplay::scan_region()' - Add the pixels in a region to the region
+//                                  statistics.
 //
 
-static void
-convert_rgbw(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
-{
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*rptr,				// Red pointer
-	*gptr,				// Green pointer
-	*bptr,				// Blue pointer
-	*wptr,				// White pointer
-	bit;				// Current bit
-  int	r, g, b, white;			// Current RGBW color
-
+void
+RasterDisplay::scan_region(
+    int                X1,		// I - Left column
+    int                Y1,		// I - Top row
+    int                X2,		// I - Right column (exclusive)
+    int                Y2,		// I - Bottom row (exclusive)
+    unsigned long long *sums,		// IO - Sums of channel values
+    unsigned long long *squares,	// IO - Sums of squares
+    raster_stats_t     *stats)		// IO - Minimum and maximum values
+{
+  int		x, y,			// Looping vars
+		c;			// Current channel
+  unsigned	val;			// Channel value
+  const uchar	*color;			// Current color
 
-  w = header->cupsWidth;
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  for (y = Y1; y < Y2; y ++)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-	  memset(pixels, 0, w * 3);
+    color = colors_ + ((long)y * header_.cupsWidth + X1) * bpc_;
 
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit = *line++;
-	    *colors++ = bit >> 4;
+    for (x = X1; x < X2; x ++, color += bpc_)
+    {
+      for (c = 0; c < stats->num_channels; c ++)
+      {
+        val = rasterChannelValue(&header_, bpc_, color, c);
 
-            if (bit & 0x10)
-	    {
-	      if (bit & 0x80)
-		pixels[0] = 255;
-	      if (bit & 0x40)
-		pixels[1] = 255;
-	      if (bit & 0x20)
-		pixels[2] = 255;
-            }
+        sums[c]    += val;
+        squares[c] += (unsigned long long)val * val;
 
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x01)
-	      {
-		if (bit & 0x08)
-	          pixels[3] = 255;
-		if (bit & 0x04)
-	          pixels[4] = 255;
-		if (bit & 0x02)
-	          pixels[5] = 255;
-	      }
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
+        if (val < stats->min[c])
+          stats->min[c] = val;
+        if (val > stats->max[c])
+          stats->max[c] = val;
+      }
+    }
+  }
+}
 
-	    white = 85 * (bit & 0x03) - 255;
-            r     = 85 * ((bit & 0xc0) >> 6) + white;
-	    g     = 85 * ((bit & 0x30) >> 4) + white;
-	    b     = 85 * ((bit & 0x0c) >> 2) + white;
 
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
+//
+// 'RasterDisplay::scroll_cb()' - Draw an area exposed by scrolling.
+//
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+void
+RasterDisplay::scroll_cb(void *d,	// I - Raster display widget
+                         int  X,	// I - X position
+                         int  Y,	// I - Y position
+                         int  W,	// I - Width
+                         int  H)	// I - Height
+{
+  RasterDisplay	*display = (RasterDisplay *)d;
+					// Display widget
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
 
-	    r = 17 * ((bit & 0xf0) >> 4);
-	    g = 17 * (bit & 0x0f);
+  fl_push_clip(X, Y, W, H);
 
-	    *colors++ = bit = *line++;
+  fl_color(display->color());
+  fl_rectf(X, Y, W, H);
 
-	    b     = 17 * ((bit & 0xf0) >> 4);
-	    white = 17 * (bit & 0x0f) - 255;
+  display->draw_tiles(X, Y, W, H);
+  display->draw_ink_box();
 
-	    r += white;
-	    g += white;
-	    b += white;
+  fl_pop_clip();
+}
 
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+//
+// 'RasterDisplay::scrollbar_cb()' - Update the display based on the scrollbar position.
+//
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *line++;
-	    *colors++ = g = *line++;
-	    *colors++ = b = *line++;
-	    *colors++ = val = *line++;
-	    white     = val - 255;
-
-	    r += white;
-	    g += white;
-	    b += white;
-
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
+void
+RasterDisplay::scrollbar_cb(
+    Fl_Widget *w,			// I - Widget
+    void      *d)			// I - Raster display widget
+{
+  RasterDisplay	*img = (RasterDisplay *)d;
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 16 :
-	  if (endian_offset)
-	    *colors++ = *line++;
+  img->damage(FL_DAMAGE_SCROLL);
+  img->sync_compare();
+}
 
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *line++;
-	    *colors++ = *line++;
-	    *colors++ = g = *line++;
-	    *colors++ = *line++;
-	    *colors++ = b = *line++;
-	    *colors++ = *line++;
-	    *colors++ = val = *line++;
-	    white     = val - 255;
-	    if (!endian_offset || x > 1)
-	      *colors++ = *line++;
-
-	    r += white;
-	    g += white;
-	    b += white;
-
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+//
+// 'RasterDisplay::stop_histogram()' - Stop computing the histogram.
+//
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-    }
-  }
-  else
+void
+RasterDisplay::stop_histogram()
+{
+  if (histogram_thread_.joinable())
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
-
-
-    rptr = line;
-    gptr = line + bytespercolor;
-    bptr = line + 2 * bytespercolor;
-    wptr = line + 3 * bytespercolor;
-
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-	  memset(pixels, 0, w * 3);
+    histogram_cancel_ = 1;
+    histogram_thread_.join();
+  }
 
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*rptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  histogram_state_ = RASTER_HISTOGRAM_NONE;
+}
 
-	    if (*gptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
 
-	    if (*bptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+//
+// 'RasterDisplay::sync_compare()' - Scroll and zoom the compared display to
+//                                   match this one.
+//
 
-	    if (*wptr & bit)
-	    {
-	      *colors++ = 1;
-
-	      if (*rptr & bit)
-		pixels[0] = 255;
-	      if (*gptr & bit)
-		pixels[1] = 255;
-	      if (*bptr & bit)
-		pixels[2] = 255;
-            }
-	    else
-	      colors ++;
+void
+RasterDisplay::sync_compare()
+{
+  if (!compare_ || compare_->syncing_)
+    return;
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      rptr ++;
-	      gptr ++;
-	      bptr ++;
-	      wptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xc0) >> 6;
-		  r         = 85 * val;
-
-		  *colors++ = val = (*gptr & 0xc0) >> 6;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0xc0) >> 6;
-		  b         = 85 * val;
-
-		  *colors++ = val = (*wptr & 0xc0) >> 6;
-		  white     = 85 * val - 255;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*rptr & 0x30) >> 4;
-		  r         = 85 * val;
-
-		  *colors++ = val = (*gptr & 0x30) >> 4;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0x30) >> 4;
-		  b         = 85 * val;
-
-		  *colors++ = val = (*wptr & 0x30) >> 4;
-		  white     = 85 * val - 255;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*rptr & 0x0c) >> 2;
-		  r         = 85 * val;
-
-		  *colors++ = val = (*gptr & 0x0c) >> 2;
-		  g         = 85 * val;
-
-	          *colors++ = val = (*bptr & 0x0c) >> 2;
-		  b         = 85 * val;
-
-		  *colors++ = val = (*wptr & 0x0c) >> 2;
-		  white     = 85 * val - 255;
-                  break;
-	      case 3 :
-	          *colors++ = val = *rptr & 0x03;
-		  r         = 85 * val;
-
-		  *colors++ = val = *gptr & 0x03;
-		  g         = 85 * val;
-
-	          *colors++ = val = *bptr & 0x03;
-		  b         = 85 * val;
-
-		  *colors++ = val = *wptr & 0x03;
-		  white     = 85 * val - 255;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-		  wptr ++;
-                  break;
-	    }
-
-	    r += white;
-	    g += white;
-	    b += white;
-
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
+  syncing_ = 1;
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+  if (compare_->factor_ != factor_)
+    compare_->scale(factor_);
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      default :
-	      case 0 :
-	          *colors++ = val = (*rptr & 0xf0) >> 4;
-		  r         = 17 * val;
-
-	          *colors++ = val = (*gptr & 0xf0) >> 4;
-		  g         = 17 * val;
-
-	          *colors++ = val = (*bptr & 0xf0) >> 4;
-		  b         = 17 * val;
-
-		  *colors++ = val = (*wptr & 0xf0) >> 4;
-		  white     = 17 * val - 255;
-                  break;
-	      case 1 :
-	          *colors++ = val = *rptr & 0x0f;
-		  r         = 17 * val;
-
-	          *colors++ = val = *gptr & 0x0f;
-		  g         = 17 * val;
-
-	          *colors++ = val = *bptr & 0x0f;
-		  b         = 17 * val;
-
-		  *colors++ = val = *wptr & 0x0f;
-		  white     = 17 * val - 255;
-
-		  rptr ++;
-		  gptr ++;
-		  bptr ++;
-		  wptr ++;
-                  break;
-	    }
-
-	    r += white;
-	    g += white;
-	    b += white;
-
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
+  compare_->position(xscrollbar_.value(), yscrollbar_.value());
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+  syncing_ = 0;
+}
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = r = *rptr++;
-	    *colors++ = g = *gptr++;
-	    *colors++ = b = *bptr++;
-	    *colors++ = val = *wptr++;
-	    white     = val - 255;
-
-            r += white;
-            g += white;
-            b += white;
-
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+//
+// 'RasterDisplay::update_mouse_xy()' - Update the mouse X and Y values.
+//
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-            if (endian_offset)
-	    {
-	      *colors++ = *rptr++;
-	      *colors++ = r = *rptr++;
+void
+RasterDisplay::update_mouse_xy()
+{
+  int	X, Y;				// X,Y position
+  int	W, H;				// Width and height
 
-	      *colors++ = *gptr++;
-	      *colors++ = g = *gptr++;
 
-	      *colors++ = *bptr++;
-	      *colors++ = b = *bptr++;
+  X = Fl::event_x() - x() - Fl::box_dx(box()) + xscrollbar_.value();
+  Y = Fl::event_y() - y() - Fl::box_dy(box()) + yscrollbar_.value();
+  W = visible_w();
+  H = visible_h();
 
-	      *colors++ = *wptr++;
-	      *colors++ = val = *wptr++;
-	      white     = val - 255;
-	    }
-	    else
-	    {
-	      *colors++ = r = *rptr++;
-	      *colors++ = *rptr++;
+  if (!ras_ || xsize_ <= 0 || ysize_ <= 0)
+  {
+    mouse_x_ = -1;
+    mouse_y_ = -1;
+    return;
+  }
 
-	      *colors++ = g = *gptr++;
-	      *colors++ = *gptr++;
+  if (xsize_ < W)
+    X -= (W - xsize_) / 2;
 
-	      *colors++ = b = *bptr++;
-	      *colors++ = *bptr++;
+  if (X < 0)
+    mouse_x_ = 0;
+  else if (X >= xsize_)
+    mouse_x_ = header_.cupsWidth;
+  else
+    mouse_x_ = X * header_.cupsWidth / xsize_;
 
-	      *colors++ = val = *wptr++;
-	      white     = val - 255;
-	      *colors++ = *wptr++;
-	    }
+  if (ysize_ < H)
+    Y -= (H - ysize_) / 2;
 
-            r += white;
-            g += white;
-            b += white;
+  if (Y < 0)
+    mouse_y_ = 0;
+  else if (Y >= ysize_)
+    mouse_y_ = header_.cupsHeight;
+  else
+    mouse_y_ = Y * header_.cupsHeight / ysize_;
 
-            if (r <= 0)
-	      *pixels++ = 0;
-	    else if (r < 255)
-	      *pixels++ = r;
-	    else
-	      *pixels++ = 255;
+//  printf("EXY:%4d,%4d  BXY:%4d,%4d  SC=%4d,%4d  XY:%4d,%4d  WH:%4d,%4d  SZ:%4d,%4d  MXY:%4d,%4d\n", Fl::event_x(), Fl::event_y(), Fl::box_dx(box()), Fl::box_dy(box()), xscrollbar_.value(), yscrollbar_.value(), X, Y, W, H, xsize_, ysize_, mouse_x_, mouse_y_);
 
-            if (g <= 0)
-	      *pixels++ = 0;
-	    else if (g < 255)
-	      *pixels++ = g;
-	    else
-	      *pixels++ = 255;
+  if (mouse_x_ < 0)
+    mouse_x_ = 0;
+  else if (mouse_x_ > (int)header_.cupsWidth)
+    mouse_x_ = (int)header_.cupsWidth;
 
-            if (b <= 0)
-	      *pixels++ = 0;
-	    else if (b < 255)
-	      *pixels++ = b;
-	    else
-	      *pixels++ = 255;
-          }
-          break;
-    }
-  }
+  if (mouse_y_ < 0)
+    mouse_y_ = 0;
+  else if (mouse_y_ > (int)header_.cupsHeight)
+    mouse_y_ = (int)header_.cupsHeight;
 }
 
 
 //
-// 'convert_w()' - Convert grayscale raster data.
+// 'RasterDisplay::update_scrollbars()' - Update the scrollbars.
 //
 
-static void
-convert_w(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - Grayscale pixels
+void
+RasterDisplay::update_scrollbars()
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	bit,				// Current bit
-	byte;				// Current byte
-
+  int	X, Y;				// X/Y offsets
+  int	W, H;				// Interior size
 
-  w = header->cupsWidth;
 
-  switch (header->cupsBitsPerColor)
+  if (header_.cupsWidth && header_.cupsHeight)
   {
-    case 1 :
-        for (x = w, bit = 0x80, byte = *line++; x > 0; x --)
-	{
-	  if (byte & bit)
-	  {
-	    *colors++ = 1;
-	    pixels ++;
-	  }
-	  else
-	  {
-	    colors ++;
-	    *pixels++ = 0;
-	  }
-
-          if (bit > 1)
-	    bit >>= 1;
-	  else
-	  {
-	    bit  = 0x80;
-	    byte = *line++;
-	  }
-        }
-        break;
-    case 2 :
-        for (x = w; x > 0; x -= 4)
-	{
-	  byte = *line++;
-
-	  *colors++ = val = (byte & 0xc0) >> 6;
-	  *pixels++ = 85 * val;
-
-	  if (x > 1)
-	  {
-	    *colors++ = val = (byte & 0x30) >> 4;
-	    *pixels++ = 85 * val;
-	  }
+    W = visible_w();
+    H = visible_h();
 
-	  if (x > 2)
-	  {
-	    *colors++ = val = (byte & 0x0c) >> 2;
-	    *pixels++ = 85 * val;
-	  }
+    X = xscrollbar_.value();
+    if (X > (xsize_ - W))
+      X = xsize_ - W;
+    else if (X < 0)
+      X = 0;
 
-	  if (x > 3)
-	  {
-	    *colors++ = val = byte & 0x03;
-	    *pixels++ = 85 * val;
-	  }
-        }
-        break;
-    case 4 :
-        for (x = w; x > 0; x -= 2)
-	{
-	  byte = *line++;
+    if (xsize_ <= W)
+    {
+      xscrollbar_.deactivate();
+      xscrollbar_.value(0, 1, 0, 1);
+    }
+    else
+    {
+      xscrollbar_.activate();
+      xscrollbar_.value(X, W, 0, xsize_);
+    }
 
-          *colors++ = val = (byte & 0xf0) >> 4;
-	  *pixels++ = 17 * val;
+    Y = yscrollbar_.value();
+    if (Y > (ysize_ - H))
+      Y = ysize_ - H;
+    else if (Y < 0)
+      Y = 0;
 
-	  if (x > 1)
-	  {
-            *colors++ = val = byte & 0x0f;
-	    *pixels++ = 17 * val;
-	  }
-        }
-        break;
-    case 8 :
-        memcpy(colors, line, w);
-        memcpy(pixels, line, w);
-        break;
-    case 16 :
-	if (endian_offset)
-	{
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *line++;
-	    *colors++ = *pixels++ = *line++;
-          }
-	}
-	else
-	{
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = *pixels++ = *line++;
-	    *colors++ = *line++;
-          }
-	}
-        break;
+    if (ysize_ <= H)
+    {
+      yscrollbar_.deactivate();
+      yscrollbar_.value(0, 1, 0, 1);
+    }
+    else
+    {
+      yscrollbar_.activate();
+      yscrollbar_.value(Y, H, 0, ysize_);
+    }
+  }
+  else
+  {
+    xscrollbar_.value(0, 1, 0, 1);
+    yscrollbar_.value(0, 1, 0, 1);
   }
 }
 
 
 //
-// 'convert_xyz()' - Convert CIE XYZ raster data.
+// 'RasterDisplay::update_xmap()' - Update the column map for the current zoom.
+//
+// The map holds the byte offset of the source pixel for each column of the
+// scaled image (in device pixels) so that scale_line() doesn't need to step
+// through the scaling for every pixel of every row...
 //
 
-static void
-convert_xyz(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+void
+RasterDisplay::update_xmap()
 {
-  int			x,		// X position in line
-			w,		// Width of line
-			val;		// Pixel value
-  unsigned short	*sline;		// 16-bit pixels
-  float			xyz[3],		// XYZ color
-			rgb[3];		// RGB color
+  int	x,				// Scaled column
+	offset,				// Source offset
+	xerr,				// Bresenheim values
+	xstep,				// ...
+	xmod;				// ...
 
 
-  w = header->cupsWidth;
+  xrep_   = 0;
+  dxsize_ = (int)(xsize_ * screen_scale_ + 0.5f);
+  dysize_ = (int)(ysize_ * screen_scale_ + 0.5f);
 
-  for (x = w, sline = (unsigned short *)line; x > 0; x --)
-  {
-    // Extract the Lab color value...
-    if (header->cupsBitsPerColor == 8)
-    {
-      // 8-bit color values...
-      *colors++ = val = *line++;
-      xyz[0]    = val / 231.8181f;
-      *colors++ = val = *line++;
-      xyz[1]    = val / 231.8181f;
-      *colors++ = val = *line++;
-      xyz[2]    = val / 231.8181f;
-    }
-    else
-    {
-      // 16-bit color values...
-      *colors++ = *line++;
-      *colors++ = *line++;
-      *colors++ = *line++;
-      *colors++ = *line++;
-      *colors++ = *line++;
-      *colors++ = *line++;
-
-      xyz[0] = *sline++ / 59577.2727f;
-      xyz[1] = *sline++ / 59577.2727f;
-      xyz[2] = *sline++ / 59577.2727f;
-    }
+  if (!header_.cupsWidth || dxsize_ <= 0 || dysize_ <= 0)
+    return;
+
+  if ((dxsize_ % header_.cupsWidth) == 0)
+    xrep_ = dxsize_ / header_.cupsWidth;
+
+  if (dxsize_ > alloc_xmap_)
+  {
+    delete[] xmap_;
 
-    // Convert XYZ to sRGB...
-    rgb[0] =  3.240479f * xyz[0] - 1.537150f * xyz[1] - 0.498535f * xyz[2];
-    rgb[1] = -0.969256f * xyz[0] + 1.875992f * xyz[1] + 0.041556f * xyz[2];
-    rgb[2] =  0.055648f * xyz[0] - 0.204043f * xyz[1] + 1.057311f * xyz[2];
+    alloc_xmap_ = dxsize_;
+    xmap_       = new int[alloc_xmap_];
+  }
 
-    rgb[0] = rgb[0] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[0], 0.41666) - 0.055f;
-    rgb[1] = rgb[1] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[1], 0.41666) - 0.055f;
-    rgb[2] = rgb[2] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[2], 0.41666) - 0.055f;
+  xstep = (int)header_.cupsWidth / dxsize_ * bpp_;
+  xmod  = (int)header_.cupsWidth % dxsize_;
 
-    // Save it...
-    if (rgb[0] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[0] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[0] + 0.5);
-    else
-      *pixels++ = 255;
+  for (x = 0, offset = 0, xerr = 0; x < dxsize_; x ++)
+  {
+    xmap_[x] = offset;
 
-    if (rgb[1] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[1] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[1] + 0.5);
-    else
-      *pixels++ = 255;
+    offset += xstep;
+    xerr   += xmod;
 
-    if (rgb[2] <= 0.0f)
-      *pixels++ = 0;
-    else if (rgb[2] < 1.0f)
-      *pixels++ = (int)(255.0f * rgb[2] + 0.5);
-    else
-      *pixels++ = 255;
+    if (xerr >= dxsize_)
+    {
+      xerr   -= dxsize_;
+      offset += bpp_;
+    }
   }
 }
 
 
 //
-// 'convert_ymc()' - Convert YMC raster data.
+// 'bits_count()' - Count the pixels with any masked bit set in a packed row.
+//
+// "first" and "last" are bit offsets on pixel boundaries.  For 4-bit chunked
+// pixels ("fold" is non-zero) each nibble counts once if any of its masked
+// bits are set.
 //
 
-static void
-convert_ymc(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+static unsigned				// O - Number of matching pixels
+bits_count(const uchar *row,		// I - Packed raster row
+           long        first,		// I - First bit
+           long        last,		// I - Last bit (exclusive)
+           uchar       mask,		// I - Bit mask for each byte
+           int         fold)		// I - Fold nibbles?
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	bit;				// Current bit
+  unsigned		count = 0;	// Count
+  const uchar		*ptr,		// Pointer into row
+			*end;		// End of whole bytes
+  unsigned long long	mask64,		// 64-bit mask
+			word;		// Current 64 bits
+  uchar			byte;		// Current byte
 
 
-  w = header->cupsWidth;
+  ptr = row + first / 8;
+  end = row + last / 8;
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (first & 7)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit       = *line++;
-	    *colors++ = bit >> 4;
-
-	    if (bit & 0x40)
-	      pixels[2] = 0;
-	    if (bit & 0x20)
-	      pixels[1] = 0;
-	    if (bit & 0x10)
-	      pixels[0] = 0;
-
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x04)
-		pixels[5] = 0;
-	      if (bit & 0x02)
-		pixels[4] = 0;
-	      if (bit & 0x01)
-		pixels[3] = 0;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --, pixels += 3)
-	  {
-	    *colors++ = bit = *line++;
+    // Partial first byte...
+    byte = *ptr++ & mask & (0xff >> (first & 7));
 
-	    pixels[2] = 255 - 85 * ((bit & 0x30) >> 4);
-	    pixels[1] = 255 - 85 * ((bit & 0x0c) >> 2);
-	    pixels[0] = 255 - 85 * (bit & 0x03);
-          }
-          break;
-      case 4 :
-          for (x = w; x > 0; x --, pixels += 3)
-	  {
-	    *colors++ = bit = *line++;
+    if (ptr > end)
+      byte &= 0xff << (8 - (last & 7));
 
-	    pixels[2] = 255 - 17 * (bit & 0x0f);
+    if (fold)
+      byte = (byte | (byte >> 2) | (byte >> 1) | (byte >> 3)) & 0x11;
 
-	    *colors++ = bit = *line++;
+    count += popcount64(byte);
 
-	    pixels[1] = 255 - 17 * ((bit & 0xf0) >> 4);
-	    pixels[0] = 255 - 17 * (bit & 0x0f);
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --, pixels += 3)
-	  {
-	    *colors++ = val = *line++;
-	    pixels[2] = 255 - val;
+    if (ptr > end)
+      return (count);
+  }
 
-	    *colors++ = val = *line++;
-	    pixels[1] = 255 - val;
+  // Whole 64-bit words...
+  mask64 = mask * 0x0101010101010101ULL;
 
-	    *colors++ = val = *line++;
-	    pixels[0] = 255 - val;
-          }
-          break;
-      case 16 :
-	  if (endian_offset)
-	  {
-            for (x = w; x > 0; x --, pixels += 3)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      pixels[2] = 255 - val;
-
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      pixels[1] = 255 - val;
-
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      pixels[0] = 255 - val;
-	    }
-          }
-	  else
-	  {
-            for (x = w; x > 0; x --, pixels += 3)
-	    {
-	      *colors++ = val = *line++;
-	      pixels[2] = 255 - val;
-	      *colors++ = *line++;
-
-	      *colors++ = val = *line++;
-	      pixels[1] = 255 - val;
-	      *colors++ = *line++;
-
-	      *colors++ = val = *line++;
-	      pixels[0] = 255 - val;
-	      *colors++ = *line++;
-	    }
-	  }
-          break;
-    }
-  }
-  else
+  for (; (end - ptr) >= 8; ptr += 8)
   {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+    memcpy(&word, ptr, sizeof(word));
 
+    word &= mask64;
 
-    yptr = line;
-    mptr = line + bytespercolor;
-    cptr = line + 2 * bytespercolor;
-
-    switch (header->cupsBitsPerColor)
+    if (fold)
     {
-      case 1 :
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*yptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[2] = 0;
-	    }
-	    else
-	      colors ++;
-
-	    if (*mptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[1] = 0;
-	    }
-	    else
-	      colors ++;
-
-	    if (*cptr & bit)
-	    {
-	      *colors++ = 1;
-	      pixels[0] = 0;
-	    }
-	    else
-	      colors ++;
+      word |= word >> 2;
+      word |= word >> 1;
+      word &= 0x1111111111111111ULL;
+    }
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      cptr ++;
-	      mptr ++;
-	      yptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++, pixels += 3)
-	  {
-	    switch (x & 3)
-	    {
-	      case 0 :
-	          *colors++ = val = (*yptr & 0xc0) >> 6;
-		  pixels[2] = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0xc0) >> 6;
-		  pixels[1] = 255 - 85 * val;
-	          *colors++ = val = (*cptr & 0xc0) >> 6;
-		  pixels[0] = 255 - 85 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = (*yptr & 0x30) >> 4;
-		  pixels[2] = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0x30) >> 4;
-		  pixels[1] = 255 - 85 * val;
-	          *colors++ = val = (*cptr & 0x30) >> 4;
-		  pixels[0] = 255 - 85 * val;
-                  break;
-	      case 2 :
-	          *colors++ = val = (*yptr & 0x0c) >> 2;
-		  pixels[2] = 255 - 85 * val;
-	          *colors++ = val = (*mptr & 0x0c) >> 2;
-		  pixels[1] = 255 - 85 * val;
-	          *colors++ = val = (*cptr & 0x0c) >> 2;
-		  pixels[0] = 255 - 85 * val;
-                  break;
-	      case 3 :
-	          *colors++ = val = *yptr & 0x03;
-		  pixels[2] = 255 - 85 * val;
-	          *colors++ = val = *mptr & 0x03;
-		  pixels[1] = 255 - 85 * val;
-	          *colors++ = val = *cptr & 0x03;
-		  pixels[0] = 255 - 85 * val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++, pixels += 3)
-	  {
-	    switch (x & 1)
-	    {
-	      case 0 :
-	          *colors++ = val = (*yptr & 0xf0) >> 4;
-		  pixels[2] = 255 - 17 * val;
-	          *colors++ = val = (*mptr & 0xf0) >> 4;
-		  pixels[1] = 255 - 17 * val;
-	          *colors++ = val = (*cptr & 0xf0) >> 4;
-		  pixels[0] = 255 - 17 * val;
-                  break;
-	      case 1 :
-	          *colors++ = val = *yptr & 0x0f;
-		  pixels[2] = 255 - 17 * val;
-	          *colors++ = val = *mptr & 0x0f;
-		  pixels[1] = 255 - 17 * val;
-	          *colors++ = val = *cptr & 0x0f;
-		  pixels[0] = 255 - 17 * val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-                  break;
-	    }
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --, pixels += 3)
-	  {
-	    *colors++ = val = *yptr++;
-	    pixels[2] = 255 - val;
+    count += popcount64(word);
+  }
 
-	    *colors++ = val = *mptr++;
-	    pixels[1] = 255 - val;
+  // Remaining bytes...
+  for (; ptr < end; ptr ++)
+  {
+    byte = *ptr & mask;
 
-	    *colors++ = val = *cptr++;
-	    pixels[0] = 255 - val;
-          }
-          break;
-      case 16 :
-          if (endian_offset)
-	  {
-            for (x = w; x > 0; x --, pixels += 3)
-	    {
-	      *colors++ = *yptr++;
-	      *colors++ = val = *yptr++;
-	      pixels[2] = 255 - val;
+    if (fold)
+      byte = (byte | (byte >> 2) | (byte >> 1) | (byte >> 3)) & 0x11;
 
-	      *colors++ = *mptr++;
-	      *colors++ = val = *mptr++;
-	      pixels[1] = 255 - val;
+    count += popcount64(byte);
+  }
 
-	      *colors++ = *cptr++;
-	      *colors++ = val = *cptr++;
-	      pixels[0] = 255 - val;
-            }
-          }
-	  else
-	  {
-            for (x = w; x > 0; x --, pixels += 3)
-	    {
-	      *colors++ = val = *yptr++;
-	      pixels[2] = 255 - val;
-	      *colors++ = *yptr++;
+  if (last & 7)
+  {
+    // Partial last byte...
+    byte = *ptr & mask & (0xff << (8 - (last & 7)));
 
-	      *colors++ = val = *mptr++;
-	      pixels[1] = 255 - val;
-	      *colors++ = *mptr++;
+    if (fold)
+      byte = (byte | (byte >> 2) | (byte >> 1) | (byte >> 3)) & 0x11;
 
-	      *colors++ = val = *cptr++;
-	      pixels[0] = 255 - val;
-	      *colors++ = *cptr++;
-            }
-          }
-	  break;
-    }
+    count += popcount64(byte);
   }
+
+  return (count);
 }
 
 
 //
-// 'convert_ymck()' - Convert YMCK, GMCK, or GMCS raster data.
+// 'bits_masks()' - Get the bit masks used to area-average 1-bit raster data.
+//
+// Each displayed channel (gray or R, G, and B) gets a mask of the bits in a
+// byte that turn it off (subtractive) or on (additive), matching what the
+// convert_*() functions do for a single pixel.
 //
 
-static void
-convert_ymck(
-    cups_page_header_t *header,	// I - Raster header */
-    uchar               *line,		// I - Raster line
-    uchar               *colors,	// O - Original pixels
-    uchar               *pixels)	// O - RGB pixels
+static int				// O - Bits per pixel or 0 if not supported
+bits_masks(cups_page_header_t *header,	// I - Page header
+           uchar              masks[3],	// O - Masks for gray or R, G, and B
+           int                *additive)// O - 1 if additive, 0 if subtractive
 {
-  int	x,				// X position in line
-	w,				// Width of line
-	val;				// Pixel value
-  uchar	*cptr,				// Cyan pointer
-	*mptr,				// Magenta pointer
-	*yptr,				// Yellow pointer
-	*kptr,				// Black pointer
-	bit;				// Current bit
-  int	r, g, b, k;			// Current RGB color + K
-
-
-  w = header->cupsWidth;
+  static const struct
+  {
+    cups_cspace_t	cspace;		// Color space
+    int			additive;	// Additive color?
+    uchar		masks[3];	// Nibble masks for R, G, and B
+  }			nibbles[] =	// 4-bit pixel masks
+  {
+    { CUPS_CSPACE_RGB,      1, { 0x4, 0x2, 0x1 } },
+    { CUPS_CSPACE_SRGB,     1, { 0x4, 0x2, 0x1 } },
+    { CUPS_CSPACE_ADOBERGB, 1, { 0x4, 0x2, 0x1 } },
+    { CUPS_CSPACE_CMY,      0, { 0x4, 0x2, 0x1 } },
+    { CUPS_CSPACE_YMC,      0, { 0x1, 0x2, 0x4 } },
+    { CUPS_CSPACE_CMYK,     0, { 0x9, 0x5, 0x3 } },
+    { CUPS_CSPACE_KCMY,     0, { 0xc, 0xa, 0x9 } },
+    { CUPS_CSPACE_YMCK,     0, { 0x3, 0x5, 0x9 } },
+    { CUPS_CSPACE_GMCK,     0, { 0x3, 0x5, 0x9 } },
+    { CUPS_CSPACE_GMCS,     0, { 0x3, 0x5, 0x9 } }
+  };
+  size_t		i;		// Looping var
+
+
+  if (header->cupsBitsPerColor != 1 || header->cupsColorOrder != CUPS_ORDER_CHUNKED)
+    return (0);
 
-  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  if (header->cupsBitsPerPixel == 1)
   {
-    // Chunky
-    switch (header->cupsBitsPerColor)
+    switch (header->cupsColorSpace)
     {
-      case 1 :
-          for (x = w; x > 0; x -= 2, pixels += 6)
-	  {
-	    bit       = *line++;
-	    *colors++ = bit >> 4;
-
-            if (bit & 0x10)
-	    {
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      if (bit & 0x80)
-		pixels[2] = 0;
-	      if (bit & 0x40)
-		pixels[1] = 0;
-	      if (bit & 0x20)
-		pixels[0] = 0;
-	    }
-
-	    if (x > 1)
-	    {
-	      *colors++ = bit & 0x0f;
-
-	      if (bit & 0x01)
-	      {
-		pixels[3] = 0;
-		pixels[4] = 0;
-		pixels[5] = 0;
-	      }
-	      else
-	      {
-		if (bit & 0x08)
-	          pixels[5] = 0;
-		if (bit & 0x04)
-	          pixels[4] = 0;
-		if (bit & 0x02)
-	          pixels[3] = 0;
-	      }
-	    }
-          }
-          break;
-      case 2 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-
-	    k = 85 * (bit & 0x03);
-	    b = 255 - 85 * ((bit & 0xc0) >> 6) - k;
-	    g = 255 - 85 * ((bit & 0x30) >> 4) - k;
-	    r = 255 - 85 * ((bit & 0x0c) >> 2) - k;
-
-	    if (r < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
-
-	    if (g < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
-
-	    if (b < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
+      case CUPS_CSPACE_W :
+      case CUPS_CSPACE_SW :
+          *additive = 1;
           break;
-      case 4 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = bit = *line++;
-
-	    b = 255 - 17 * ((bit & 0xf0) >> 4);
-	    g = 255 - 17 * (bit & 0x0f);
-
-	    *colors++ = bit = *line++;
-
-	    r = 255 - 17 * ((bit & 0xf0) >> 4);
-	    k = 17 * (bit & 0x0f);
-
-	    r -= k;
-	    g -= k;
-	    b -= k;
-
-	    if (r < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
-
-	    if (g < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
 
-	    if (b < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
+      case CUPS_CSPACE_K :
+      case CUPS_CSPACE_WHITE :
+      case CUPS_CSPACE_GOLD :
+      case CUPS_CSPACE_SILVER :
+          *additive = 0;
           break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    *colors++ = val = *line++;
-	    b         = 255 - val;
-
-	    *colors++ = val = *line++;
-	    g         = 255 - val;
-
-	    *colors++ = val = *line++;
-	    r         = 255 - val;
 
-	    *colors++ = k = *line++;
+      default :
+          return (0);
+    }
 
-	    r -= k;
-	    g -= k;
-	    b -= k;
+    masks[0] = masks[1] = masks[2] = 0xff;
 
-	    if (r < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+    return (1);
+  }
+  else if (header->cupsBitsPerPixel == 4)
+  {
+    for (i = 0; i < (sizeof(nibbles) / sizeof(nibbles[0])); i ++)
+    {
+      if (nibbles[i].cspace == header->cupsColorSpace)
+      {
+        *additive = nibbles[i].additive;
+        masks[0]  = (uchar)(nibbles[i].masks[0] * 0x11);
+        masks[1]  = (uchar)(nibbles[i].masks[1] * 0x11);
+        masks[2]  = (uchar)(nibbles[i].masks[2] * 0x11);
 
-	    if (g < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+        return (4);
+      }
+    }
+  }
 
-	    if (b < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-	    if (endian_offset)
-	    {
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      b         = 255 - val;
+  return (0);
+}
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      g         = 255 - val;
 
-	      *colors++ = *line++;
-	      *colors++ = val = *line++;
-	      r         = 255 - val;
+//
+// 'index_compare()' - Compare the last use of two page index cache files.
+//
 
-	      *colors++ = *line++;
-	      *colors++ = k = *line++;
-	    }
-	    else
-	    {
-	      *colors++ = val = *line++;
-	      b         = 255 - val;
-	      *colors++ = *line++;
+static int				// O - Result of comparison
+index_compare(raster_cachefile_t *a,	// I - First file
+              raster_cachefile_t *b)	// I - Second file
+{
+  // Sort the most recently used files first...
+  if (a->mtime > b->mtime)
+    return (-1);
+  else if (a->mtime < b->mtime)
+    return (1);
+  else
+    return (0);
+}
 
-	      *colors++ = val = *line++;
-	      g         = 255 - val;
-	      *colors++ = *line++;
 
-	      *colors++ = val = *line++;
-	      r         = 255 - val;
-	      *colors++ = *line++;
+//
+// 'index_file()' - Get the page index cache file and identity for a file.
+//
+// The cache file is named using a hash of the absolute filename and lives in
+// the per-user data directory.  The identity is the file's size, modification
+// time, and a hash of the start of the file (the sync word and first page
+// header)...
+//
 
-	      *colors++ = k = *line++;
-	      *colors++ = *line++;
-	    }
+static int				// O - 1 on success, 0 on failure
+index_file(const char     *filename,	// I - Raster file
+           char           *cachefile,	// O - Cache filename
+           size_t         cachesize,	// I - Size of cache filename buffer
+           raster_cache_t *cache)	// O - File identity
+{
+  char			dir[1024];	// User data directory
+  struct stat		fileinfo;	// File information
+  FILE			*fp;		// File
+  uchar			buffer[4096];	// Start of file
+  size_t		i,		// Looping var
+			bytes;		// Bytes read
+  unsigned long long	hash;		// FNV-1a hash
 
-	    r -= k;
-	    g -= k;
-	    b -= k;
 
-	    if (r < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+  if (!filename)
+    return (0);
 
-	    if (g < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  if (!prefs)
+    prefs = new Fl_Preferences(Fl_Preferences::USER, "msweet.org", "rasterview");
 
-	    if (b < 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-    }
-  }
-  else
-  {
-    // Banded
-    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+  if (!prefs->getUserdataPath(dir, sizeof(dir)))
+    return (0);
 
+  memset(cache, 0, sizeof(raster_cache_t));
+  memcpy(cache->magic, "RVINDEX5", sizeof(cache->magic));
 
-    yptr = line;
-    mptr = line + bytespercolor;
-    cptr = line + 2 * bytespercolor;
-    kptr = line + 3 * bytespercolor;
+  cache->offset_size = (int)sizeof(z_off_t);
 
-    switch (header->cupsBitsPerColor)
-    {
-      case 1 :
-          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
-	  {
-	    if (*yptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+#if _WIN32
+  if (!_fullpath(cache->path, filename, sizeof(cache->path)))
+    return (0);
+#else
+  char *path;				// Absolute filename
 
-	    if (*mptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  if ((path = realpath(filename, NULL)) == NULL)
+    return (0);
 
-	    if (*cptr & bit)
-	      *colors++ = 1;
-	    else
-	      colors ++;
+  snprintf(cache->path, sizeof(cache->path), "%s", path);
+  free(path);
+#endif // _WIN32
 
-	    if (*kptr & bit)
-	    {
-	      *colors++ = 1;
+  if (stat(cache->path, &fileinfo))
+    return (0);
 
-	      pixels[0] = 0;
-	      pixels[1] = 0;
-	      pixels[2] = 0;
-	    }
-	    else
-	    {
-	      colors ++;
-
-	      if (*cptr & bit)
-		pixels[0] = 0;
-	      if (*mptr & bit)
-		pixels[1] = 0;
-	      if (*yptr & bit)
-		pixels[2] = 0;
-            }
+  cache->size  = (unsigned long long)fileinfo.st_size;
+  cache->mtime = (unsigned long long)fileinfo.st_mtime;
 
-            if (bit > 1)
-	      bit >>= 1;
-	    else
-	    {
-	      bit = 0x80;
-	      cptr ++;
-	      mptr ++;
-	      yptr ++;
-	      kptr ++;
-	    }
-          }
-          break;
-      case 2 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 3)
-	    {
-	      default :
-	      case 0 :
-	          val       = (*kptr & 0xc0) >> 6;
-		  k         = 85 * val;
+  if ((fp = fopen(cache->path, "rb")) == NULL)
+    return (0);
 
-	          *colors++ = val = (*yptr & 0xc0) >> 6;
-		  b         = 255 - 85 * val - k;
+  bytes = fread(buffer, 1, sizeof(buffer), fp);
 
-	          *colors++ = val = (*mptr & 0xc0) >> 6;
-		  g         = 255 - 85 * val - k;
+  fclose(fp);
 
-	          *colors++ = val = (*cptr & 0xc0) >> 6;
-		  r         = 255 - 85 * val - k;
+  for (i = 0, hash = 0xcbf29ce484222325ULL; i < bytes; i ++)
+    hash = (hash ^ buffer[i]) * 0x100000001b3ULL;
 
-	          *colors++ = val;
-                  break;
-	      case 1 :
-	          val       = (*kptr & 0x30) >> 4;
-		  k         = 85 * val;
+  cache->hash = hash;
 
-	          *colors++ = val = (*yptr & 0x30) >> 4;
-		  b         = 255 - 85 * val - k;
+  // Name the cache file using a hash of the absolute filename...
+  for (i = 0, hash = 0xcbf29ce484222325ULL; cache->path[i]; i ++)
+    hash = (hash ^ (uchar)cache->path[i]) * 0x100000001b3ULL;
 
-	          *colors++ = val = (*mptr & 0x30) >> 4;
-		  g         = 255 - 85 * val - k;
+  snprintf(cachefile, cachesize, "%sindex-%016llx.dat", dir, hash);
 
-	          *colors++ = val = (*cptr & 0x30) >> 4;
-		  r         = 255 - 85 * val - k;
+  return (1);
+}
 
-	          *colors++ = val;
-                  break;
-	      case 2 :
-	          val       = (*kptr & 0x0c) >> 2;
-		  k         = 85 * val;
 
-	          *colors++ = val = (*yptr & 0x0c) >> 2;
-		  b         = 255 - 85 * val - k;
+//
+// 'index_prune()' - Remove stale and least recently used page index caches.
+//
+// Caches for raster files that have changed or been removed are removed
+// first, then the least recently used caches until there are at most
+// RASTER_MAX_INDEXES caches using at most RASTER_MAX_INDEX_SIZE bytes.  The
+// modification time of a cache is updated whenever it is used.  The named
+// cache file is always kept...
+//
 
-	          *colors++ = val = (*mptr & 0x0c) >> 2;
-		  g         = 255 - 85 * val - k;
+static void
+index_prune(const char *cachefile)	// I - Cache file to keep
+{
+  char			dir[1024],	// Cache directory
+			*ptr;		// Pointer into directory
+  struct dirent		**names;	// Files in directory
+  int			i,		// Looping var
+			num_names,	// Number of files
+			num_files = 0,	// Number of cache files
+			stale;		// Is the cache stale?
+  raster_cachefile_t	*files,		// Cache files
+			*f;		// Current cache file
+  raster_cache_t	cache;		// Cache file header
+  struct stat		fileinfo;	// Cache or raster file information
+  unsigned long long	total = 0;	// Total size of cache files
+  FILE			*fp;		// Cache file
+
+
+  snprintf(dir, sizeof(dir), "%s", cachefile);
+
+  if ((ptr = strrchr(dir, '/')) == NULL)
+    return;
 
-	          *colors++ = val = (*cptr & 0x0c) >> 2;
-		  r         = 255 - 85 * val - k;
+  ptr[1] = '\0';
 
-	          *colors++ = val;
-                  break;
-	      case 3 :
-	          val       = *kptr & 0x03;
-		  k         = 85 * val;
+  if ((num_names = fl_filename_list(dir, &names)) <= 0)
+    return;
 
-	          *colors++ = val = *yptr & 0x03;
-		  b         = 255 - 85 * val - k;
+  files = new raster_cachefile_t[num_names];
 
-	          *colors++ = val = *mptr & 0x03;
-		  g         = 255 - 85 * val - k;
+  for (i = 0; i < num_names; i ++)
+  {
+    f = files + num_files;
 
-	          *colors++ = val = *cptr & 0x03;
-		  r         = 255 - 85 * val - k;
+    if (!fl_filename_match(names[i]->d_name, "index-*.dat"))
+      continue;
 
-	          *colors++ = val;
+    snprintf(f->filename, sizeof(f->filename), "%s%s", dir, names[i]->d_name);
 
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
+    if (stat(f->filename, &fileinfo))
+      continue;
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+    f->size  = (unsigned long long)fileinfo.st_size;
+    f->mtime = fileinfo.st_mtime;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    // See if the raster file is still there and unchanged...
+    stale = 1;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 4 :
-          for (x = 0; x < w; x ++)
-	  {
-	    switch (x & 1)
-	    {
-	      default :
-	      case 0 :
-	          val       = (*kptr & 0xf0) >> 4;
-		  k         = 17 * val;
-	          *colors++ = val = (*yptr & 0xf0) >> 4;
-		  b         = 255 - 17 * val - k;
-	          *colors++ = val = (*mptr & 0xf0) >> 4;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = (*cptr & 0xf0) >> 4;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val;
-                  break;
-	      case 1 :
-	          val       = *kptr & 0x0f;
-		  k         = 17 * val;
-	          *colors++ = val = *yptr & 0x0f;
-		  b         = 255 - 17 * val - k;
-	          *colors++ = val = *mptr & 0x0f;
-		  g         = 255 - 17 * val - k;
-	          *colors++ = val = *cptr & 0x0f;
-		  r         = 255 - 17 * val - k;
-	          *colors++ = val;
-
-		  cptr ++;
-		  mptr ++;
-		  yptr ++;
-		  kptr ++;
-                  break;
-	    }
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+    if ((fp = fopen(f->filename, "rb")) != NULL)
+    {
+      if (fread(&cache, sizeof(cache), 1, fp) == 1 && !memcmp(cache.magic, "RVINDEX5", sizeof(cache.magic)))
+      {
+        cache.path[sizeof(cache.path) - 1] = '\0';
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+        stale = stat(cache.path, &fileinfo) || (unsigned long long)fileinfo.st_size != cache.size || (unsigned long long)fileinfo.st_mtime != cache.mtime;
+      }
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 8 :
-          for (x = w; x > 0; x --)
-	  {
-	    k         = *kptr++;
-	    *colors++ = val = *yptr++;
-	    b         = 255 - val - k;
-	    *colors++ = val = *mptr++;
-	    g         = 255 - val - k;
-	    *colors++ = val = *cptr++;
-	    r         = 255 - val - k;
-	    *colors++ = k;
-
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
+      fclose(fp);
+    }
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+    if (stale && strcmp(f->filename, cachefile))
+      remove(f->filename);
+    else
+      num_files ++;
+  }
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-          }
-          break;
-      case 16 :
-          for (x = w; x > 0; x --)
-	  {
-            if (endian_offset)
-	    {
-	      *colors++ = *cptr++;
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val;
+  fl_filename_free_list(&names, num_names);
 
-	      *colors++ = *mptr++;
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val;
+  // Then remove the least recently used caches over the limits...
+  qsort(files, (size_t)num_files, sizeof(raster_cachefile_t), (int (*)(const void *, const void *))index_compare);
 
-	      *colors++ = *yptr++;
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val;
+  for (i = 0; i < num_files; i ++)
+  {
+    total += files[i].size;
 
-	      *colors++ = *kptr++;
-	      *colors++ = k = *kptr++;
-            }
-	    else
-            {
-	      *colors++ = val = *cptr++;
-	      r         = 255 - val;
-	      *colors++ = *cptr++;
+    if ((i >= RASTER_MAX_INDEXES || total > RASTER_MAX_INDEX_SIZE) && strcmp(files[i].filename, cachefile))
+      remove(files[i].filename);
+  }
 
-	      *colors++ = val = *mptr++;
-	      g         = 255 - val;
-	      *colors++ = *mptr++;
+  delete[] files;
+}
 
-	      *colors++ = val = *yptr++;
-	      b         = 255 - val;
-	      *colors++ = *yptr++;
 
-	      *colors++ = k = *kptr++;
-	      *colors++ = *kptr++;
-	    }
+//
+// 'ink_total()' - Get the total ink of an original color.
+//
+// The total is the sum of the channel values scaled to 0-255, so 255 is 100%
+// coverage...
+//
 
-            r -= k;
-	    g -= k;
-	    b -= k;
+static unsigned				// O - Total ink
+ink_total(cups_page_header_t *header,	// I - Raster header
+          int                bpc,	// I - Bytes per color
+          const uchar        *color)	// I - Original color
+{
+  int		c,			// Current channel
+		nchannels = (int)header->cupsNumColors;
+					// Number of channels
+  unsigned	total = 0,		// Total ink
+		maxval;			// Maximum channel value
 
-	    if (r <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = r;
 
-	    if (g <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = g;
+  if (header->cupsBitsPerColor == 16)
+  {
+    for (c = 0; c < nchannels; c ++)
+      total += rasterChannelValue(header, bpc, color, c) >> 8;
+  }
+  else if (header->cupsBitsPerColor == 8)
+  {
+    for (c = 0; c < nchannels; c ++)
+      total += rasterChannelValue(header, bpc, color, c);
+  }
+  else
+  {
+    maxval = (1U << header->cupsBitsPerColor) - 1;
 
-	    if (b <= 0)
-	      *pixels++ = 0;
-	    else
-	      *pixels++ = b;
-	  }
-          break;
-    }
+    for (c = 0; c < nchannels; c ++)
+      total += rasterChannelValue(header, bpc, color, c) * 255 / maxval;
   }
+
+  return (total);
 }
 
 
@@ -5693,3 +4389,19 @@ rasterReset(cups_raster_t *r)		// I - Stream to reset
   r->bufptr = r->buffer;
   r->bufend = r->buffer;
 }
+
+
+//
+// 'rasterSeek()' - Reset the stream after seeking to a row in the page.
+//
+
+void
+rasterSeek(cups_raster_t *r,		// I - Stream
+           unsigned      row)		// I - Row in page
+{
+  rasterReset(r);
+
+  r->remaining = r->header.cupsHeight - row;
+  r->count     = 0;
+  r->pcurrent  = r->pixels;
+}
@@ -18,15 +18,27 @@
 #  include "raster-private.h"
 #  include <FL/Fl.H>
 #  include <FL/Fl_Group.H>
+#  include <FL/Fl_RGB_Image.H>
 #  include <FL/Fl_Scrollbar.H>
 #  include <zlib.h>
+#  include <atomic>
+#  include <thread>
 
 
 //
 // Constants...
 //
 
+#  define RASTER_CONVERT_PIXELS	1000000	// Pixels to convert per idle callback
+#  define RASTER_INDEX_ROWS	256	// Rows between index entries
+#  define RASTER_INK_BLOCK	8	// Width and height of total ink blocks
+#  define RASTER_MAX_INDEXES	100	// Maximum cached page indexes
+#  define RASTER_MAX_INDEX_SIZE	67108864// Maximum size of cached page indexes
 #  define RASTER_MAX_PAGES	1000	// Maximum pages
+#  define RASTER_MAX_THREADS	16	// Maximum decoding threads
+#  define RASTER_MAX_TILES	256	// Maximum cached tiles
+#  define RASTER_STATS_BLOCK	16	// Width and height of region statistics blocks
+#  define RASTER_TILE_SIZE	256	// Width and height of cached tiles
 #  define SBWIDTH		17	// Scrollbar width
 
 
@@ -43,6 +55,73 @@ enum
 };
 
 
+//
+// Histogram states...
+//
+
+enum
+{
+  RASTER_HISTOGRAM_NONE,
+  RASTER_HISTOGRAM_RUNNING,
+  RASTER_HISTOGRAM_DONE
+};
+
+
+//
+// Histogram of each channel in a page...
+//
+
+typedef struct raster_histogram_s
+{
+  int			num_channels,	// Number of channels
+			levels;		// Number of levels per channel
+  unsigned long		counts[15][256];// Number of pixels with each level
+  double		coverage[15];	// Average coverage in percent
+} raster_histogram_t;
+
+
+//
+// Statistics for a region of a page...
+//
+
+typedef struct raster_stats_s
+{
+  int			num_channels;	// Number of channels
+  long			count;		// Number of pixels
+  double		mean[15],	// Mean of each channel
+			stddev[15];	// Standard deviation of each channel
+  unsigned		min[15],	// Minimum of each channel
+			max[15];	// Maximum of each channel
+} raster_stats_t;
+
+
+//
+// Row index entry for seeking within a page...
+//
+
+typedef struct raster_index_s
+{
+  unsigned		row;		// Row number
+  z_off_t		offset;		// Offset of row data in file
+} raster_index_t;
+
+
+//
+// Cached tile of the scaled image...
+//
+
+typedef struct raster_tile_s
+{
+  int			page,		// Page number
+			xsize,		// Scaled image width
+			ysize,		// Scaled image height
+			tx,		// Tile column
+			ty;		// Tile row
+  unsigned long		used;		// Last use
+  Fl_RGB_Image		*image;		// Scaled pixels
+} raster_tile_t;
+
+
 //
 // RasterDisplay widget...
 //
@@ -54,8 +133,17 @@ class RasterDisplay : public Fl_Group
   gzFile		fp_;		// File pointer
   int			page_,		// Current page number
 			num_pages_;	// Number of pages
-  z_off_t		pages_[RASTER_MAX_PAGES];
-					// Page offsets
+  z_off_t		pages_[RASTER_MAX_PAGES + 1];
+					// Page offsets and end of last page
+  raster_index_t	*index_;	// Row index for all pages
+  int			num_index_,	// Number of index entries
+			alloc_index_;	// Number of index entries allocated
+  int			page_index_[RASTER_MAX_PAGES + 1];
+					// First index entry for each page
+  unsigned		bbox_[RASTER_MAX_PAGES][4];
+					// Ink bounding box of each page
+  unsigned long long	hash_[RASTER_MAX_PAGES];
+					// Content hash of each page
   cups_page_header_t	header_;	// Page header for current page
   int			bpc_,		// Bytes per color
 			bpp_;		// Bytes per pixel
@@ -63,11 +151,34 @@ class RasterDisplay : public Fl_Group
   long			alloc_pixels_;	// Number of bytes allocated
   uchar			*colors_;	// Color data buffer
   long			alloc_colors_;	// Numebr of colors allocated
+  uchar			*bits_;		// Packed 1-bit raster data
+  long			alloc_bits_;	// Number of bytes allocated
+  int			bits_pixel_;	// Bits per pixel for area averaging (0 = none)
+  int			bits_additive_;	// Non-zero if set bits add light
+  uchar			bits_masks_[3];	// Bit masks for each displayed channel
+  uchar			*raw_;		// Raw rows awaiting conversion
+  long			alloc_raw_;	// Number of bytes allocated
+  uchar			*pending_;	// Rows awaiting conversion
+  int			alloc_pending_;	// Number of rows allocated
+  int			pending_y_;	// Next row to convert (-1 = none)
   float			factor_;	// Zoom factor
-  int			xsize_;		// Bresenheim variables
-  int			xstep_;		// ...
-  int			xmod_;		// ...
-  int			ysize_;		// ...
+  int			xsize_,		// Size of scaled image
+			ysize_;
+  float			screen_scale_;	// Screen scaling factor
+  int			dxsize_,	// Size of scaled image in device pixels
+			dysize_;
+  int			*xmap_;		// Source offset for each scaled column
+  int			alloc_xmap_;	// Number of columns allocated
+  int			xrep_;		// Integer zoom factor (0 = none)
+  int			loading_;	// Non-zero while a page is loading
+  int			image_x_,	// Screen position of scaled image
+			image_y_;
+  int			scroll_x_,	// Scroll position of last draw (-1 = none)
+			scroll_y_;
+  raster_tile_t		tiles_[RASTER_MAX_TILES];
+					// Tile cache
+  int			num_tiles_;	// Number of cached tiles
+  unsigned long		tile_used_;	// Tile use counter
 
   Fl_Scrollbar		xscrollbar_;	// Horizontal scrollbar
   Fl_Scrollbar		yscrollbar_;	// Vertical scrollbar
@@ -84,13 +195,66 @@ class RasterDisplay : public Fl_Group
 
   uchar			device_colors_[15][3];
 					// CMY device colors
+  unsigned		channels_;	// Separations to show (0 = all)
+  unsigned short	*ink_;		// Maximum total ink of each block
+  long			alloc_ink_;	// Number of blocks allocated
+  uchar			*ink_rows_;	// Non-zero for block rows in ink_
+  int			alloc_ink_rows_;// Number of block rows allocated
+  int			ink_limit_;	// Total ink limit in percent
+  int			show_ink_;	// Show pixels over the ink limit?
+  int			show_ink_box_;	// Outline the ink bounding box?
+  raster_histogram_t	histogram_;	// Histogram of current page
+  std::thread		histogram_thread_;
+					// Histogram thread
+  std::atomic<int>	histogram_state_,
+					// State of histogram
+			histogram_cancel_;
+					// Stop computing the histogram?
+  unsigned long long	*stats_sums_;	// Summed-area tables of blocks
+  unsigned short	*stats_range_;	// Minimum and maximum of blocks
+  int			stats_valid_;	// Non-zero if tables are for this page
+  int			region_;	// Non-zero when dragging a region
+  RasterDisplay		*compare_;	// Display to compare with
+  int			show_diff_,	// Show differences from compare_?
+			syncing_;	// Non-zero while updating compare_
+  uchar			*diff_;		// Differences of each column
+  long			alloc_diff_;	// Number of bytes allocated
 
+  void		average_bits(int X, int Y, int W, uchar *D);
+  static void	band_cb(void *b);
+  int		build_stats();
+  int		can_diff();
+  static void	convert_cb(void *d);
+  void		convert_line(int y, uchar *line);
+  void		convert_row(int y);
+  void		diff_row(int y, int x0, int x1, uchar *d);
+  void		draw_ink_box();
+  void		draw_tiles(int X, int Y, int W, int H);
+  void		flush_tiles();
+  Fl_RGB_Image	*get_tile(int tx, int ty);
+  static void	histogram_band_cb(void *b);
+  static void	histogram_cb(void *d);
   static void	image_cb(void *p, int X, int Y, int W, uchar *D);
+  void		ink_row(int by);
+  int		load_bands();
   void		load_colors();
+  int		load_index();
+  void		overlay_diff(int X, int Y, int W, const uchar *S, uchar *D);
+  void		overlay_ink(int X, int Y, int W, uchar *D);
+  static void	recolor_cb(void *b);
+  int		reuse_page(int number);
   void		save_colors();
+  void		save_index();
+  void		scale_channels(int X, int Y, int W, uchar *D);
+  void		scale_line(int X, int Y, int W, uchar *D);
+  void		scan_region(int X1, int Y1, int X2, int Y2, unsigned long long *sums, unsigned long long *squares, raster_stats_t *stats);
+  static void	scroll_cb(void *d, int X, int Y, int W, int H);
   static void	scrollbar_cb(Fl_Widget *w, void *d);
+  void		stop_histogram();
+  void		sync_compare();
   void		update_mouse_xy();
   void		update_scrollbars();
+  void		update_xmap();
   int		visible_h() { return (h() - Fl::box_dh(box()) - (yscrollbar_.visible() ? SBWIDTH : 0)); }
   int		visible_w() { return (w() - Fl::box_dw(box()) - (xscrollbar_.visible() ? SBWIDTH : 0)); }
 
@@ -105,13 +269,22 @@ class RasterDisplay : public Fl_Group
 
   int			bytes_per_color() const { return bpc_; }
   int			bytes_per_pixel() const { return bpp_; }
+  void			channels(unsigned mask);
+  unsigned		channels() const { return channels_; }
   int			close_file();
+  void			compare(RasterDisplay *d);
+  RasterDisplay		*compare() const { return compare_; }
   void			device_color(int n, Fl_Color c) { uchar r,g,b; Fl::get_color(c, r, g, b); device_colors_[n][0] = 255-r; device_colors_[n][1] = 255-g; device_colors_[n][2] = 255-b; save_colors();}
   Fl_Color		device_color(int n) { return (fl_rgb_color(255-device_colors_[n][0], 255-device_colors_[n][1], 255-device_colors_[n][2])); }
   uchar			*get_color(int X, int Y);
   uchar			*get_pixel(int X, int Y);
   int			handle(int event);
   cups_page_header_t	*header() { return &header_; }
+  const raster_histogram_t *histogram();
+  void			ink_limit(int percent);
+  int			ink_limit() const { return ink_limit_; }
+  const unsigned	*ink_box(int number) const { return (number >= 1 && number <= num_pages_ && bbox_[number - 1][2] ? bbox_[number - 1] : NULL); }
+  int			is_blank(int number) const { return (number >= 1 && number <= num_pages_ && !bbox_[number - 1][2]); }
   int			is_subtractive();
   int			load_page();
   void			mode(int m) { mode_ = m; }
@@ -121,10 +294,21 @@ class RasterDisplay : public Fl_Group
   int			num_pages() const { return num_pages_; }
   int			page(void);
   void			page(int number);
+  z_off_t		page_offset(int number) const { return (number >= 1 && number <= num_pages_ + 1 ? pages_[number - 1] : -1); }
   void			position(int X, int Y);
+  void			recolor();
+  int			region() const { return region_; }
+  long			region_stats(int X1, int Y1, int X2, int Y2, raster_stats_t *stats);
   void			resize(int X, int Y, int W, int H);
+  int			same_page(int number) const;
   void			scale(float factor);
   float			scale() const { return factor_; }
+  void			show_diff(int s) { if (s != show_diff_) { show_diff_ = s; flush_tiles(); redraw(); } }
+  int			show_diff() const { return show_diff_; }
+  void			show_ink(int s) { if (s != show_ink_) { show_ink_ = s; flush_tiles(); redraw(); } }
+  int			show_ink() const { return show_ink_; }
+  void			show_ink_box(int s) { if (s != show_ink_box_) { show_ink_box_ = s; redraw(); } }
+  int			show_ink_box() const { return show_ink_box_; }
   int			start_x() const { return start_x_; }
   int			start_y() const { return start_y_; }
   int			open_file(const char *filename);
@@ -0,0 +1,174 @@
+//
+// CUPS raster histogram widget code.
+//
+// Copyright 2002-2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "RasterHistogram.h"
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#include <stdio.h>
+
+
+//
+// Constants...
+//
+
+#define LABEL_WIDTH	80		// Width of channel labels
+
+
+//
+// 'RasterHistogram::RasterHistogram()' - Create a new histogram widget.
+//
+
+RasterHistogram::RasterHistogram(
+    int        X,			// I - X position
+    int        Y,			// I - Y position
+    int        W,			// I - Width
+    int        H,			// I - Height
+    const char *L)			// I - Label string
+  : Fl_Widget(X, Y, W, H, L)
+{
+  box(FL_DOWN_BOX);
+  color(FL_WHITE);
+
+  display_ = NULL;
+}
+
+
+//
+// 'RasterHistogram::~RasterHistogram()' - Destroy a histogram widget.
+//
+
+RasterHistogram::~RasterHistogram()
+{
+  Fl::remove_timeout(timeout_cb, this);
+}
+
+
+//
+// 'RasterHistogram::draw()' - Draw the histogram widget.
+//
+
+void
+RasterHistogram::draw()
+{
+  const raster_histogram_t *histogram;	// Histogram of page
+  int			c,		// Current channel
+			X, Y, W, H,	// Interior of widget
+			bx, bw,		// Position and width of bars
+			ry, rh,		// Position and height of channel row
+			i, v, vend,	// Looping vars
+			bh;		// Height of bar
+  unsigned long		count,		// Count for bar
+			maxcount;	// Maximum count
+  char			s[255];		// Label string
+
+
+  draw_box();
+
+  X = x() + Fl::box_dx(box());
+  Y = y() + Fl::box_dy(box());
+  W = w() - Fl::box_dw(box());
+  H = h() - Fl::box_dh(box());
+
+  fl_font(FL_HELVETICA, 12);
+
+  if (!display_ || !display_->header()->cupsWidth)
+    return;
+
+  if ((histogram = display_->histogram()) == NULL)
+  {
+    fl_color(FL_DARK3);
+    fl_draw("Computing histogram...", X, Y, W, H, FL_ALIGN_CENTER);
+    return;
+  }
+
+  fl_push_clip(X, Y, W, H);
+
+  bx = X + LABEL_WIDTH;
+  bw = W - LABEL_WIDTH - 5;
+  rh = H / histogram->num_channels;
+
+  for (c = 0, ry = Y; c < histogram->num_channels; c ++, ry += rh)
+  {
+    // Label each channel with its average coverage...
+    snprintf(s, sizeof(s), "%d: %.1f%%", c + 1, histogram->coverage[c]);
+    fl_color(FL_BLACK);
+    fl_draw(s, X + 5, ry, LABEL_WIDTH - 10, rh, FL_ALIGN_LEFT);
+
+    // Scale to the largest count other than 0, which is usually the paper...
+    for (v = 1, maxcount = 1; v < histogram->levels; v ++)
+    {
+      if (histogram->counts[c][v] > maxcount)
+        maxcount = histogram->counts[c][v];
+    }
+
+    fl_color(display_->device_color(c));
+
+    for (i = 0; i < bw; i ++)
+    {
+      v    = i * histogram->levels / bw;
+      vend = (i + 1) * histogram->levels / bw;
+
+      for (count = histogram->counts[c][v ++]; v < vend; v ++)
+      {
+        if (histogram->counts[c][v] > count)
+          count = histogram->counts[c][v];
+      }
+
+      if (count > maxcount)
+        count = maxcount;
+
+      if ((bh = (int)((rh - 2) * count / maxcount)) > 0)
+        fl_yxline(bx + i, ry + rh - 1, ry + rh - bh - 1);
+    }
+
+    fl_color(FL_GRAY);
+    fl_xyline(bx, ry + rh - 1, bx + bw - 1);
+  }
+
+  fl_pop_clip();
+}
+
+
+//
+// 'RasterHistogram::timeout_cb()' - Check whether the histogram is ready.
+//
+
+void
+RasterHistogram::timeout_cb(void *d)	// I - Histogram widget
+{
+  RasterHistogram	*histogram = (RasterHistogram *)d;
+					// Histogram widget
+
+
+  if (!histogram->display_ || !histogram->display_->header()->cupsWidth)
+    return;
+
+  if (histogram->display_->histogram())
+    histogram->redraw();
+  else
+    Fl::repeat_timeout(0.25, timeout_cb, d);
+}
+
+
+//
+// 'RasterHistogram::update()' - Show the histogram of a new page.
+//
+
+void
+RasterHistogram::update()
+{
+  Fl::remove_timeout(timeout_cb, this);
+  Fl::add_timeout(0.25, timeout_cb, this);
+
+  redraw();
+}
@@ -0,0 +1,47 @@
+//
+// CUPS raster histogram widget header file.
+//
+// Copyright 2002-2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef RasterHistogram_h
+#  define RasterHistogram_h
+
+
+//
+// Include necessary headers...
+//
+
+#  include "RasterDisplay.h"
+#  include <FL/Fl_Widget.H>
+
+
+//
+// RasterHistogram widget...
+//
+
+class RasterHistogram : public Fl_Widget
+{
+  RasterDisplay		*display_;	// Display widget
+
+  static void	timeout_cb(void *d);
+
+  protected:
+
+  void		draw();
+
+  public:
+
+  RasterHistogram(int X, int Y, int W, int H, const char *L = 0);
+  ~RasterHistogram();
+
+  void			display(RasterDisplay *d) { display_ = d; }
+  RasterDisplay		*display() const { return display_; }
+  void			update();
+};
+
+
+#endif // !RasterHistogram_h
@@ -14,11 +14,15 @@
 #define __OPENTRANSPORTPROVIDERS__	// For macOS...
 #define FL_INTERNAL
 #include "RasterView.h"
+#include "raster-pages.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <FL/Fl.H>
 #include <FL/Fl_Color_Chooser.H>
 #include <FL/Fl_Native_File_Chooser.H>
+#include <FL/fl_ask.H>
 #include <FL/x.H>
 
 #include "eyedropper.xbm"
@@ -40,7 +44,8 @@
 #  define MENU_OFFSET	25
 #endif // __APPLE__
 #define ATTRS_WIDTH	310
-#define DEVICEN_HEIGHT	30
+#define DEVICEN_HEIGHT	55
+#define HISTOGRAM_HEIGHT 150
 
 #define HELP_HTML \
 "<HTML>\n" \
@@ -56,7 +61,10 @@
 "(<CODE>P</CODE>) to drag/pan the page in the window, <var>zoom " \
 "out</var> mode (<CODE>SHIFT + Z</CODE>) to click on the page to " \
 "zoom out, or <var>color viewing</var> mode (<CODE>C</CODE>) to " \
-"click or drag the mouse and view the raw colors on the page.</P>\n" \
+"click or drag the mouse and view the raw colors on the page. " \
+"Hold <CODE>SHIFT</CODE> while dragging in color viewing mode to " \
+"view the mean, standard deviation, and range of each channel in " \
+"the selected region.</P>\n" \
 "<H2>Keyboard Shortcuts</H2>\n" \
 "<UL>\n" \
 "<LI><CODE>Spacebar</CODE>: Show next page</LI>\n" \
@@ -71,10 +79,23 @@
 "<LI><CODE>Z</CODE>: Click or drag mouse to zoom in</LI>\n" \
 "<LI><CODE>SHIFT + Z</CODE>: Click to zoom out</LI>\n" \
 "<LI><CODE>CTRL/CMD + A</CODE>: Show/hide the page attributes</LI>\n" \
+"<LI><CODE>CTRL/CMD + B</CODE>: Show the compared files side by side</LI>\n" \
+"<LI><CODE>CTRL/CMD + D</CODE>: Show/hide differences from the compared file</LI>\n" \
+"<LI><CODE>CTRL/CMD + I</CODE>: Show/hide pixels over the total ink limit</LI>\n" \
+"<LI><CODE>CTRL/CMD + K</CODE>: Show/hide the ink bounding box</LI>\n" \
 "<LI><CODE>CTRL/CMD + O</CODE>: Open a raster file</LI>\n" \
 "<LI><CODE>CTRL/CMD + Q</CODE>: Quit RasterView</LI>\n" \
 "<LI><CODE>CTRL/CMD + R</CODE>: Reload the raster file</LI>\n" \
+"<LI><CODE>CTRL/CMD + S</CODE>: Save pages to a new raster file</LI>\n" \
+"<LI><CODE>CTRL/CMD + T</CODE>: Flip between the compared files</LI>\n" \
 "</UL>\n" \
+"<H2>Comparing Files</H2>\n" \
+"<P>Choose <var>Compare With...</var> from the <var>View</var> menu " \
+"to open a second raster file against the current one. Both files " \
+"show the same page and scroll and zoom together, either side by " \
+"side or one at a time. Show the differences to see the changed " \
+"pixels in red (small changes) through yellow (large changes) over " \
+"a faded copy of the page.</P>\n" \
 "</BODY>\n" \
 "</HTML>\n"
 
@@ -129,6 +150,35 @@ RasterView::attrs_cb(Fl_Widget *widget)	// I - Button
 }
 
 
+//
+// 'RasterView::channel_cb()' - Show the selected separations.
+//
+
+void
+RasterView::channel_cb(
+    Fl_Widget *widget)			// I - Widget
+{
+  RasterView		*view;		// I - Window
+  int			i,		// Looping var
+			count;		// Number of channels
+  unsigned		mask;		// Selected channels
+
+
+  view  = (RasterView *)(widget->window());
+  count = (int)view->display_->header()->cupsNumColors;
+
+  for (i = 0, mask = 0; i < count && i < 15; i ++)
+    if (view->channels_[i]->value())
+      mask |= 1U << i;
+
+  // Selecting all of the channels is the same as selecting none...
+  if (mask == (1U << count) - 1)
+    mask = 0;
+
+  view->display_->channels(mask);
+}
+
+
 //
 // 'RasterView::close_cb()' - Close this window.
 //
@@ -153,6 +203,7 @@ RasterView::close_cb(Fl_Widget  *widget)// I - Menu or window
     return;
 
   view->hide();
+  compare_close_cb(view);
   view->display_->close_file();
   view->set_filename(NULL);
 }
@@ -183,6 +234,24 @@ RasterView::color_cb(
 
   if (!ccolor || !cpixel)
     strncpy(view->pixel_, "        -/=/0-9 to zoom", sizeof(view->pixel_) - 1);
+  else if (display->region())
+  {
+    // Show the statistics of the region...
+    raster_stats_t	stats;		// Region statistics
+
+    if (display->region_stats(display->start_x(), display->start_y(), display->mouse_x(), display->mouse_y(), &stats) > 0)
+    {
+      snprintf(view->pixel_, sizeof(view->pixel_), "%ldpx", stats.count);
+
+      for (i = 0, ptr = view->pixel_ + strlen(view->pixel_); i < stats.num_channels; i ++)
+      {
+        snprintf(ptr, sizeof(view->pixel_) - (size_t)(ptr - view->pixel_), " %.1f\302\261%.1f [%u-%u]", stats.mean[i], stats.stddev[i], stats.min[i], stats.max[i]);
+        ptr += strlen(ptr);
+      }
+
+      Fl::copy(view->pixel_, strlen(view->pixel_), 1);
+    }
+  }
   else
   {
     strncpy(view->pixel_, "       ", sizeof(view->pixel_) - 1);
@@ -266,6 +335,96 @@ RasterView::color_cb(
 }
 
 
+//
+// 'RasterView::compare_cb()' - Compare with another file.
+//
+
+void
+RasterView::compare_cb(Fl_Widget *widget)// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+  Fl_Native_File_Chooser fc;		// File chooser
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  if (view->loading_ || !view->filename_)
+    return;
+
+  fc.title("Compare With?");
+  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
+  fc.filter("Raster Files\t*.{apple,pwg,ras}{,.gz}\n");
+
+  if (fc.show())
+    return;
+
+  view->loading_ = 1;
+  if (view->compare_->open_file(fc.filename()))
+  {
+    if (view->compare_filename_)
+      free(view->compare_filename_);
+
+    view->compare_filename_ = strdup(fc.filename());
+    view->display_->compare(view->compare_);
+
+    if (!view->flip_)
+      view->side_by_side_ = 1;
+  }
+  else
+    compare_close_cb(view);
+
+  view->set_filename(view->filename_);
+  view->update_compare();
+  view->loading_ = 0;
+}
+
+
+//
+// 'RasterView::compare_close_cb()' - Stop comparing with another file.
+//
+
+void
+RasterView::compare_close_cb(
+    Fl_Widget *widget)			// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  if (view->loading_ || !view->compare_filename_)
+    return;
+
+  view->display_->compare(NULL);
+  view->compare_->close_file();
+
+  free(view->compare_filename_);
+  view->compare_filename_ = NULL;
+  view->side_by_side_     = 0;
+  view->flip_             = 0;
+
+  if (view->filename_)
+    view->set_filename(view->filename_);
+  view->update_compare();
+}
+
+
 //
 // 'RasterView::device_cb()' - Handle device color changes.
 //
@@ -279,6 +438,12 @@ RasterView::device_cb(
 
 
   view = (RasterView *)(widget->window());
+
+  // The page's band threads use the device colors while it loads, so don't
+  // change them until the load is done...
+  if (view->loading_)
+    return;
+
   for (i = 0; i < 15; i ++)
     if (widget == view->colors_[i])
     {
@@ -286,16 +451,83 @@ RasterView::device_cb(
 
       Fl::get_color(view->display_->device_color(i), r, g, b);
 
-      if (fl_color_chooser(widget->label(), r, g, b))
+      if (fl_color_chooser(widget->label(), r, g, b) && !view->loading_)
       {
-        view->display_->device_color(i, fl_rgb_color(r, g, b));
-        reopen_cb(widget);
+        Fl_Color c = fl_rgb_color(r, g, b);
+
+        view->display_->device_color(i, c);
+        view->display_->recolor();
+
+        widget->color(c);
+        widget->labelcolor(fl_contrast(FL_BLACK, c));
+        widget->redraw();
       }
       break;
     }
 }
 
 
+//
+// 'RasterView::diff_cb()' - Show or hide differences from the compared file.
+//
+
+void
+RasterView::diff_cb(Fl_Widget *widget)	// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+  int		show;			// Show differences?
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  if (view->loading_ || !view->compare_filename_)
+    return;
+
+  show = !view->display_->show_diff();
+
+  view->display_->show_diff(show);
+  view->compare_->show_diff(show);
+}
+
+
+//
+// 'RasterView::flip_cb()' - Flip between the current and compared files.
+//
+
+void
+RasterView::flip_cb(Fl_Widget *widget)	// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  if (view->loading_ || !view->compare_filename_)
+    return;
+
+  view->side_by_side_ = 0;
+  view->flip_         = !view->flip_;
+
+  view->update_compare();
+}
+
+
 //
 // 'RasterView::goto_cb()' - Show the specified page.
 //
@@ -357,6 +589,88 @@ RasterView::help_cb()
 }
 
 
+//
+// 'RasterView::ink_box_cb()' - Show or hide the ink bounding box.
+//
+
+void
+RasterView::ink_box_cb(Fl_Widget *widget)	// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  view->display_->show_ink_box(!view->display_->show_ink_box());
+  view->compare_->show_ink_box(view->display_->show_ink_box());
+}
+
+
+//
+// 'RasterView::ink_cb()' - Show or hide pixels over the total ink limit.
+//
+
+void
+RasterView::ink_cb(Fl_Widget *widget)	// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  view->display_->show_ink(!view->display_->show_ink());
+}
+
+
+//
+// 'RasterView::ink_limit_cb()' - Set the total ink limit.
+//
+
+void
+RasterView::ink_limit_cb(
+    Fl_Widget *widget)			// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+  const char	*value;			// New limit
+  char		current[32];		// Current limit
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  snprintf(current, sizeof(current), "%d", view->display_->ink_limit());
+
+  if ((value = fl_input("Total ink limit (%%):", current)) != NULL && atoi(value) > 0)
+  {
+    view->display_->ink_limit(atoi(value));
+    view->display_->show_ink(1);
+  }
+}
+
+
 //
 // 'RasterView::init()' - Initialize the window.
 //
@@ -370,11 +684,22 @@ RasterView::init()
     {"&File", 0, 0, 0, FL_SUBMENU },
       {"&Open...", FL_COMMAND + 'o', (Fl_Callback *)open_cb },
       {"&Re-open", FL_COMMAND + 'r', (Fl_Callback *)reopen_cb, },
+      {"&Save Pages...", FL_COMMAND + 's', (Fl_Callback *)save_cb },
       {"&Close", FL_COMMAND + 'w', (Fl_Callback *)close_cb },
 #ifndef __APPLE__
       {"&Quit", FL_COMMAND + 'q', (Fl_Callback *)quit_cb },
 #endif // !__APPLE__
       {0},
+    {"&View", 0, 0, 0, FL_SUBMENU },
+      {"Show/Hide &Ink Limit", FL_COMMAND + 'i', (Fl_Callback *)ink_cb },
+      {"Show/Hide Ink &Box", FL_COMMAND + 'k', (Fl_Callback *)ink_box_cb },
+      {"Set Ink &Limit...", 0, (Fl_Callback *)ink_limit_cb, 0, FL_MENU_DIVIDER },
+      {"&Compare With...", 0, (Fl_Callback *)compare_cb },
+      {"Show/Hide &Differences", FL_COMMAND + 'd', (Fl_Callback *)diff_cb },
+      {"Side &by Side", FL_COMMAND + 'b', (Fl_Callback *)side_by_side_cb },
+      {"Flip &A/B", FL_COMMAND + 't', (Fl_Callback *)flip_cb },
+      {"Close Comparison", 0, (Fl_Callback *)compare_close_cb },
+      {0},
     {"&Help", 0, 0, 0, FL_SUBMENU },
       {"&About RasterView...", 0, (Fl_Callback *)help_cb },
       {0},
@@ -406,6 +731,10 @@ RasterView::init()
   display_ = new RasterDisplay(0, MENU_OFFSET, w(), h() - MENU_OFFSET - 30);
   display_->callback((Fl_Callback *)color_cb);
 
+  compare_ = new RasterDisplay(0, MENU_OFFSET, w(), h() - MENU_OFFSET - 30);
+  compare_->callback((Fl_Callback *)color_cb);
+  compare_->hide();
+
   buttons_ = new Fl_Group(0, h() - 30, w(), 30);
     sub_group = new Fl_Group(0, h() - 30, 80, 30);
       prev_button_ = new Fl_Button(0, h() - 30, 25, 30);
@@ -431,7 +760,24 @@ RasterView::init()
     sub_group->resizable(page_input_);
     sub_group->end();
 
-    status_ = new Fl_Box(80, h() - 30, w() - 250, 30, "-/=/0-9 to zoom");
+    blank_ = new Fl_Box(80, h() - 25, 45, 20, "Blank");
+    blank_->box(FL_ROUNDED_BOX);
+    blank_->color(FL_DARK_RED);
+    blank_->labelcolor(FL_WHITE);
+    blank_->labelsize(12);
+    blank_->tooltip("This page is blank.");
+    blank_->hide();
+
+    same_tip_[0] = '\0';
+    same_ = new Fl_Box(80, h() - 25, 45, 20, "Same");
+    same_->box(FL_ROUNDED_BOX);
+    same_->color(FL_DARK_BLUE);
+    same_->labelcolor(FL_WHITE);
+    same_->labelsize(12);
+    same_->tooltip(same_tip_);
+    same_->hide();
+
+    status_ = new Fl_Box(125, h() - 30, w() - 295, 30, "-/=/0-9 to zoom");
     status_->align((Fl_Align)(FL_ALIGN_CENTER | FL_ALIGN_INSIDE));
 
     sub_group = new Fl_Group(w() - 170, h() - 30, 120, 30);
@@ -491,17 +837,25 @@ RasterView::init()
   buttons_->end();
 
   attributes_ = new Fl_Group(w(), 0, ATTRS_WIDTH, h());
-    header_ = new Fl_Text_Display(w(), 0, ATTRS_WIDTH, h() - DEVICEN_HEIGHT);
+    header_ = new Fl_Text_Display(w(), 0, ATTRS_WIDTH, h() - DEVICEN_HEIGHT - HISTOGRAM_HEIGHT);
     header_buffer_ = new Fl_Text_Buffer(65536);
     header_->buffer(header_buffer_);
     header_->textfont(FL_COURIER);
     header_->textsize(12);
     header_->box(FL_DOWN_BOX);
 
+    histogram_ = new RasterHistogram(w(), h() - DEVICEN_HEIGHT - HISTOGRAM_HEIGHT, ATTRS_WIDTH, HISTOGRAM_HEIGHT);
+    histogram_->display(display_);
+
     for (int i = 0; i < 15; i ++)
     {
       colors_[i] = new Fl_Button(w() + 5 + 20 * i, h() - DEVICEN_HEIGHT + 5, 20, 20, color_labels[i]);
       colors_[i]->callback(device_cb);
+
+      channels_[i] = new Fl_Button(w() + 5 + 20 * i, h() - DEVICEN_HEIGHT + 30, 20, 20, color_labels[i]);
+      channels_[i]->type(FL_TOGGLE_BUTTON);
+      channels_[i]->tooltip("Show only the selected separations.");
+      channels_[i]->callback(channel_cb);
     }
   attributes_->resizable(header_);
   attributes_->end();
@@ -512,8 +866,11 @@ RasterView::init()
   callback((Fl_Callback *)close_cb, this);
 
   // Initialize the titlebar...
-  filename_ = NULL;
-  title_    = NULL;
+  filename_         = NULL;
+  title_            = NULL;
+  compare_filename_ = NULL;
+  side_by_side_     = 0;
+  flip_             = 0;
 
   set_filename(NULL);
 
@@ -541,6 +898,7 @@ RasterView::load_attrs()
   int			i;		// Looping var
   char			s[1024];	// Line buffer
   cups_page_header_t	*header;	// Header data
+  const unsigned	*bbox;		// Ink bounding box
 
 
   header = display_->header();
@@ -834,6 +1192,19 @@ RasterView::load_attrs()
     header_buffer_->append(s);
   }
 
+  // Show the ink bounding box found when the page was indexed...
+  if ((bbox = display_->ink_box(display_->page())) != NULL)
+    snprintf(s, sizeof(s), "\nInkBoundingBox = [ %u %u %u %u ]\n", bbox[0], bbox[1], bbox[2], bbox[3]);
+  else
+    snprintf(s, sizeof(s), "\nInkBoundingBox = none\n");
+  header_buffer_->append(s);
+
+  if ((i = display_->same_page(display_->page())) > 0)
+  {
+    snprintf(s, sizeof(s), "SameAsPage = %d\n", i);
+    header_buffer_->append(s);
+  }
+
  /*
   * Set device colors for the given color space...
   */
@@ -860,8 +1231,25 @@ RasterView::load_attrs()
     for (i = 0; i < 15; i ++)
       colors_[i]->deactivate();
   }
+
+ /*
+  * Show separation toggles for the colorants...
+  */
+
+  for (i = 0; i < 15; i ++)
+  {
+    if (i < (int)header->cupsNumColors && display_->is_subtractive())
+    {
+      channels_[i]->show();
+      channels_[i]->value((display_->channels() >> i) & 1);
+    }
+    else
+      channels_[i]->hide();
+  }
   header_->redraw();
 
+  histogram_->update();
+
   // Update navigation controls...
   char val[255];
 
@@ -877,6 +1265,30 @@ RasterView::load_attrs()
     next_button_->deactivate();
   else
     next_button_->activate();
+
+  int same = display_->same_page(display_->page());
+					// Earlier page with the same contents
+
+  if (display_->is_blank(display_->page()))
+  {
+    blank_->show();
+    same_->hide();
+  }
+  else if (same)
+  {
+    snprintf(same_tip_, sizeof(same_tip_), "This page is the same as page %d.", same);
+    blank_->hide();
+    same_->show();
+  }
+  else
+  {
+    blank_->hide();
+    same_->hide();
+  }
+
+  buttons_->redraw();
+
+  update_compare();
 }
 
 
@@ -890,14 +1302,20 @@ RasterView::mode_cb(Fl_Widget *widget)
   RasterView *view = (RasterView *)widget->window();
 
 
+  int mode;				// New mode
+
+
   if (widget == view->zoom_in_button_)
-    view->display_->mode(RASTER_MODE_ZOOM_IN);
+    mode = RASTER_MODE_ZOOM_IN;
   else if (widget == view->zoom_out_button_)
-    view->display_->mode(RASTER_MODE_ZOOM_OUT);
+    mode = RASTER_MODE_ZOOM_OUT;
   else if (widget == view->pan_button_)
-    view->display_->mode(RASTER_MODE_PAN);
+    mode = RASTER_MODE_PAN;
   else
-    view->display_->mode(RASTER_MODE_CLICK);
+    mode = RASTER_MODE_CLICK;
+
+  view->display_->mode(mode);
+  view->compare_->mode(mode);
 }
 
 
@@ -1037,6 +1455,10 @@ RasterView::reopen_cb(Fl_Widget *widget)// I - Menu or window
   view->loading_ = 1;
     view->header_buffer_->text("Loading...");
     view->display_->open_file(view->filename_);
+
+    if (view->compare_filename_ && !view->compare_->open_file(view->compare_filename_))
+      compare_close_cb(view);
+
     view->load_attrs();
   view->loading_ = 0;
 }
@@ -1069,11 +1491,120 @@ RasterView::resize(int X,		// I - New X position
   menubar_->resize(0, 0, base_W, 25);
 #endif /* !__APPLE__ */
 
-  display_->resize(0, MENU_OFFSET, base_W, H - MENU_OFFSET - 30);
+  if (side_by_side_)
+  {
+    // Show the compared file in the right half...
+    display_->resize(0, MENU_OFFSET, base_W / 2, H - MENU_OFFSET - 30);
+    compare_->resize(base_W / 2, MENU_OFFSET, base_W - base_W / 2, H - MENU_OFFSET - 30);
+  }
+  else
+  {
+    display_->resize(0, MENU_OFFSET, base_W, H - MENU_OFFSET - 30);
+    compare_->resize(0, MENU_OFFSET, base_W, H - MENU_OFFSET - 30);
+  }
+
   buttons_->resize(0, H - 30, base_W, 30);
 }
 
 
+//
+// 'RasterView::save_cb()' - Save pages to a new raster file.
+//
+// The pages are copied from the current file without decoding them.  Only
+// the pages that were indexed when the file was opened can be saved.
+//
+
+void
+RasterView::save_cb(Fl_Widget *widget)	// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+  RasterDisplay	*display;		// Display widget
+  Fl_Native_File_Chooser fc;		// File chooser
+  const char	*value;			// Page list
+  char		current[32];		// Default page list
+  int		ranges[2 * RASTER_MAX_RANGES],
+					// Page ranges
+		num_ranges,		// Number of page ranges
+		num_pages,		// Number of pages in file
+		num_save = 0,		// Number of pages to save
+		i,			// Looping var
+		page;			// Current page
+  raster_extent_t *pages;		// Byte ranges of pages to save
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  display   = view->display_;
+  num_pages = display->num_pages();
+
+  if (view->loading_ || !view->filename_ || num_pages < 1)
+    return;
+
+  snprintf(current, sizeof(current), "1-%d", num_pages);
+
+  if ((value = fl_input("Pages to save:", current)) == NULL)
+    return;
+
+  if ((num_ranges = rasterPageRanges(value, ranges, RASTER_MAX_RANGES)) < 0)
+  {
+    fl_alert("Bad page list \"%s\".", value);
+    return;
+  }
+
+  for (i = 0; i < num_ranges; i ++)
+  {
+    if (ranges[2 * i] > num_pages)
+    {
+      fl_alert("Page %d is out of range, the file has %d pages.", ranges[2 * i], num_pages);
+      return;
+    }
+
+    if (ranges[2 * i + 1] > num_pages)
+      ranges[2 * i + 1] = num_pages;
+
+    num_save += ranges[2 * i + 1] - ranges[2 * i] + 1;
+  }
+
+  fc.title("Save Pages?");
+  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+  fc.options(Fl_Native_File_Chooser::SAVEAS_CONFIRM);
+  fc.filter("Raster Files\t*.{apple,pwg,ras}\n");
+
+  if (fc.show())
+    return;
+
+  if (!strcmp(fc.filename(), view->filename_))
+  {
+    fl_alert("Unable to save pages over the current file.");
+    return;
+  }
+
+  pages = new raster_extent_t[num_save];
+
+  for (i = 0, num_save = 0; i < num_ranges; i ++)
+  {
+    for (page = ranges[2 * i]; page <= ranges[2 * i + 1]; page ++, num_save ++)
+    {
+      pages[num_save].start = display->page_offset(page);
+      pages[num_save].end   = display->page_offset(page + 1);
+    }
+  }
+
+  if (!rasterCopyPages(fc.filename(), view->filename_, display->page_offset(1), pages, num_save))
+    fl_alert("Unable to save pages to \"%s\": %s", fc.filename(), strerror(errno));
+
+  delete[] pages;
+}
+
+
 //
 // 'RasterView::set_filename()' - Set the filename and window title.
 //
@@ -1085,13 +1616,16 @@ RasterView::set_filename(const char *f)	// I - New filename
   const char	*base;			// Basename
 
 
-  if (filename_)
-    free(filename_);
+  if (f != filename_)
+  {
+    if (filename_)
+      free(filename_);
 
-  if (f)
-    filename_ = strdup(f);
-  else
-    filename_ = NULL;
+    if (f)
+      filename_ = strdup(f);
+    else
+      filename_ = NULL;
+  }
 
   if (title_)
     free(title_);
@@ -1103,7 +1637,20 @@ RasterView::set_filename(const char *f)	// I - New filename
     else
       base = f;
 
-    snprintf(s, sizeof(s), "%s - " VERSION, base);
+    if (compare_filename_)
+    {
+      const char *cbase;		// Basename of compared file
+
+      if ((cbase = strrchr(compare_filename_, '/')) != NULL)
+        cbase ++;
+      else
+        cbase = compare_filename_;
+
+      snprintf(s, sizeof(s), "%s vs %s - " VERSION, base, cbase);
+    }
+    else
+      snprintf(s, sizeof(s), "%s - " VERSION, base);
+
     title_ = strdup(s);
   }
   else
@@ -1113,6 +1660,75 @@ RasterView::set_filename(const char *f)	// I - New filename
 }
 
 
+//
+// 'RasterView::side_by_side_cb()' - Show the compared files side by side.
+//
+
+void
+RasterView::side_by_side_cb(
+    Fl_Widget *widget)			// I - Menu or window
+{
+  RasterView	*view;			// I - Window
+
+
+#ifdef __APPLE__
+  view = (RasterView *)Fl::first_window();
+
+#else
+  if (widget->window())
+    view = (RasterView *)(widget->window());
+  else
+    view = (RasterView *)widget;
+#endif // __APPLE__
+
+  if (view->loading_ || !view->compare_filename_)
+    return;
+
+  view->side_by_side_ = !view->side_by_side_;
+  view->flip_         = 0;
+
+  view->update_compare();
+}
+
+
+//
+// 'RasterView::update_compare()' - Show the compared file.
+//
+// The compared file follows the current page and is shown next to, or
+// instead of, the current file...
+//
+
+void
+RasterView::update_compare()
+{
+  if (compare_filename_ && compare_->page() != display_->page())
+  {
+    // Loading the page runs the event loop, so block the other callbacks
+    // until it is done...
+    int loading = loading_;		// Previous loading state
+
+    loading_ = 1;
+    compare_->page(display_->page());
+    loading_ = loading;
+  }
+
+  if (compare_filename_ && (side_by_side_ || flip_))
+    compare_->show();
+  else
+    compare_->hide();
+
+  if (compare_filename_ && flip_ && !side_by_side_)
+    display_->hide();
+  else
+    display_->show();
+
+  resize(x(), y(), w(), h());
+  redraw();
+
+  Fl::focus(display_->visible() ? display_ : compare_);
+}
+
+
 //
 // 'RasterView::RasterView()' - Create a new window.
 //
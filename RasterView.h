@@ -16,6 +16,7 @@
 //
 
 #  include "RasterDisplay.h"
+#  include "RasterHistogram.h"
 #  include <FL/Fl_Double_Window.H>
 #  include <FL/Fl_Box.H>
 #  include <FL/Fl_Button.H>
@@ -34,11 +35,19 @@ class RasterView : public Fl_Double_Window
   RasterView		*next_;		// Next window in list
   char			*filename_;	// Filename
   char			*title_;	// Window title
+  char			*compare_filename_;
+					// File being compared with
+  int			side_by_side_,	// Show both files side by side?
+			flip_;		// Show the compared file instead?
   int			loading_;	// Non-zero if we are loading a page
   char			pixel_[1024];	// Current pixel value
   Fl_Sys_Menu_Bar	*menubar_;	// Menubar
   RasterDisplay		*display_;	// Display widget
+  RasterDisplay		*compare_;	// Compared file display widget
   Fl_Group		*buttons_;	// Button bar
+  Fl_Box		*blank_;	// Blank page badge
+  Fl_Box		*same_;		// Duplicate page badge
+  char			same_tip_[64];	// Duplicate page badge tooltip
   Fl_Box		*status_;	// Status box
   Fl_Button		*prev_button_,	// Previous page button
 			*next_button_,	// Next page button
@@ -50,8 +59,10 @@ class RasterView : public Fl_Double_Window
   Fl_Int_Input		*page_input_;	// Page number control
   Fl_Group		*attributes_;	// Attributes pane
   Fl_Button		*colors_[15];	// Color buttons
+  Fl_Button		*channels_[15];	// Separation buttons
   Fl_Text_Display	*header_;	// Page header
   Fl_Text_Buffer	*header_buffer_;// Attribute buffer
+  RasterHistogram	*histogram_;	// Histogram of page
 
   static RasterView	*first_;	// First window in list
   static Fl_Help_Dialog	*help_;		// Help dialog
@@ -61,11 +72,19 @@ class RasterView : public Fl_Double_Window
   static void	apple_open_cb(const char *f);
 #  endif // __APPLE__
   static void	attrs_cb(Fl_Widget *widget);
+  static void	channel_cb(Fl_Widget *widget);
   static void	close_cb(Fl_Widget *widget);
   static void	color_cb(RasterDisplay *display);
+  static void	compare_cb(Fl_Widget *widget);
+  static void	compare_close_cb(Fl_Widget *widget);
   static void	device_cb(Fl_Widget *widget);
+  static void	diff_cb(Fl_Widget *widget);
+  static void	flip_cb(Fl_Widget *widget);
   static void	goto_cb(Fl_Widget *widget);
   static void	help_cb();
+  static void	ink_box_cb(Fl_Widget *widget);
+  static void	ink_cb(Fl_Widget *widget);
+  static void	ink_limit_cb(Fl_Widget *widget);
   void		init();
   void		load_attrs();
   static void	mode_cb(Fl_Widget *widget);
@@ -74,7 +93,10 @@ class RasterView : public Fl_Double_Window
   static void	prev_cb(Fl_Widget *widget);
   static void	quit_cb();
   static void	reopen_cb(Fl_Widget *widget);
+  static void	save_cb(Fl_Widget *widget);
   void		set_filename(const char *f);
+  static void	side_by_side_cb(Fl_Widget *widget);
+  void		update_compare();
 
   public:
 
@@ -0,0 +1,4485 @@
+//
+// Raster data conversion functions for RasterView.
+//
+// These functions convert a line of raster data to the original color values
+// (the "colors" buffer) and 8-bit grayscale or RGB values for display (the
+// "pixels" buffer).  They are shared by the RasterView widget and the
+// command-line tools.
+//
+// Copyright 2002-2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-convert.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+//
+// Constants...
+//
+
+#define D65_X	(0.412453 + 0.357580 + 0.180423)
+#define D65_Y	(0.212671 + 0.715160 + 0.072169)
+#define D65_Z	(0.019334 + 0.119193 + 0.950227)
+
+
+//
+// Local types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+
+//
+// Local globals...
+//
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) || defined(__BIG_ENDIAN__)
+static const int	endian_offset = 0;	// Big endian
+#else
+static const int	endian_offset = 1;	// Little endian
+#endif // __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ || __BIG_ENDIAN__
+
+
+//
+// Local functions...
+//
+
+static void	convert_cmy(cups_page_header_t *header, uchar *line,
+		            uchar *colors, uchar *pixels);
+static void	convert_cmyk(cups_page_header_t *header, uchar *line,
+		             uchar *colors, uchar *pixels);
+static void	convert_device(cups_page_header_t *header, uchar *line, uchar *colors, uchar *pixels, uchar device_colors[][3]);
+static void	convert_k(cups_page_header_t *header, uchar *line,
+		          uchar *colors, uchar *pixels);
+static void	convert_kcmy(cups_page_header_t *header, uchar *line,
+		             uchar *colors, uchar *pixels);
+static void	convert_kcmycm(cups_page_header_t *header, uchar *line,
+		               uchar *colors, uchar *pixels);
+static void	convert_lab(cups_page_header_t *header, uchar *line,
+		            uchar *colors, uchar *pixels);
+static void	convert_rgb(cups_page_header_t *header, uchar *line,
+		            uchar *colors, uchar *pixels);
+static void	convert_rgba(cups_page_header_t *header, int y, uchar *line,
+		             uchar *colors, uchar *pixels);
+static void	convert_rgbw(cups_page_header_t *header, uchar *line,
+		             uchar *colors, uchar *pixels);
+static void	convert_w(cups_page_header_t *header, uchar *line,
+		          uchar *colors, uchar *pixels);
+static void	convert_xyz(cups_page_header_t *header, uchar *line,
+		            uchar *colors, uchar *pixels);
+static void	convert_ymc(cups_page_header_t *header, uchar *line,
+		            uchar *colors, uchar *pixels);
+static void	convert_ymck(cups_page_header_t *header, uchar *line,
+		             uchar *colors, uchar *pixels);
+
+
+//
+// 'rasterConvertColors()' - Set the default device colors for a page.
+//
+// Each device color is the amount of red, green, and blue that a full value
+// of the corresponding colorant removes from white.
+//
+
+void
+rasterConvertColors(
+    cups_page_header_t *header,		// I - Page header
+    unsigned char      device_colors[15][3])
+					// O - RGB values for each device color
+{
+  memset(device_colors, 255, 15 * 3);
+
+  switch (header->cupsColorSpace)
+  {
+    case CUPS_CSPACE_DEVICE3 :
+    case CUPS_CSPACE_DEVICE4 :
+    case CUPS_CSPACE_CMY :
+    case CUPS_CSPACE_CMYK :
+        device_colors[0][1] = device_colors[0][2] = 0;
+        device_colors[1][0] = device_colors[1][2] = 0;
+        device_colors[2][0] = device_colors[2][1] = 0;
+	break;
+
+    case CUPS_CSPACE_YMC :
+    case CUPS_CSPACE_YMCK :
+        device_colors[0][0] = device_colors[0][1] = 0;
+        device_colors[1][0] = device_colors[1][2] = 0;
+        device_colors[2][1] = device_colors[2][2] = 0;
+        break;
+
+    case CUPS_CSPACE_DEVICE6 :
+        device_colors[0][1] = device_colors[0][2] = 0;
+        device_colors[1][0] = device_colors[1][2] = 0;
+        device_colors[2][0] = device_colors[2][1] = 0;
+        device_colors[4][0] = 127; device_colors[4][1] = device_colors[4][2] = 0;
+        device_colors[5][1] = 127; device_colors[5][0] = device_colors[5][2] = 0;
+	break;
+
+    case CUPS_CSPACE_W :
+    case CUPS_CSPACE_SW :
+        device_colors[0][0] = device_colors[0][1] = device_colors[0][2] = 0;
+        break;
+
+    case CUPS_CSPACE_RGB :
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_ADOBERGB :
+        device_colors[0][0] = 0;
+        device_colors[1][1] = 0;
+        device_colors[2][2] = 0;
+        break;
+
+    default :
+        break;
+  }
+}
+
+
+//
+// 'rasterConvertLine()' - Convert a line of raster data.
+//
+// The "pixels" buffer must be initialized to white (255) since the 1-bit
+// conversions only clear the pixels that are marked.
+//
+
+void
+rasterConvertLine(
+    cups_page_header_t *header,		// I - Page header
+    int                y,		// I - Row in page
+    unsigned char      *line,		// I - Raster data
+    unsigned char      *colors,		// O - Original pixels
+    unsigned char      *pixels,		// O - Grayscale or RGB pixels
+    unsigned char      device_colors[15][3])
+					// I - RGB values for each device color
+{
+  switch (header->cupsColorSpace)
+  {
+    case CUPS_CSPACE_DEVICE1 :
+    case CUPS_CSPACE_DEVICE2 :
+    case CUPS_CSPACE_DEVICE3 :
+    case CUPS_CSPACE_DEVICE4 :
+    case CUPS_CSPACE_DEVICE5 :
+    case CUPS_CSPACE_DEVICE6 :
+    case CUPS_CSPACE_DEVICE7 :
+    case CUPS_CSPACE_DEVICE8 :
+    case CUPS_CSPACE_DEVICE9 :
+    case CUPS_CSPACE_DEVICEA :
+    case CUPS_CSPACE_DEVICEB :
+    case CUPS_CSPACE_DEVICEC :
+    case CUPS_CSPACE_DEVICED :
+    case CUPS_CSPACE_DEVICEE :
+    case CUPS_CSPACE_DEVICEF :
+        convert_device(header, line, colors, pixels, device_colors);
+        break;
+
+    case CUPS_CSPACE_W :
+    case CUPS_CSPACE_SW :
+        convert_w(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_RGB :
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_ADOBERGB :
+        convert_rgb(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_RGBA :
+        convert_rgba(header, (int)header->cupsHeight - y, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_RGBW :
+        convert_rgbw(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_K :
+    case CUPS_CSPACE_WHITE :
+    case CUPS_CSPACE_GOLD :
+    case CUPS_CSPACE_SILVER :
+        convert_k(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_CMY :
+        convert_cmy(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_YMC :
+        convert_ymc(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_KCMYcm :
+        if (header->cupsBitsPerColor == 1)
+        {
+          convert_kcmycm(header, line, colors, pixels);
+          break;
+        }
+    case CUPS_CSPACE_KCMY :
+        convert_kcmy(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_CMYK :
+        convert_cmyk(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_YMCK :
+    case CUPS_CSPACE_GMCK :
+    case CUPS_CSPACE_GMCS :
+        convert_ymck(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_CIEXYZ :
+        convert_xyz(header, line, colors, pixels);
+        break;
+
+    case CUPS_CSPACE_CIELab :
+    case CUPS_CSPACE_ICC1 :
+    case CUPS_CSPACE_ICC2 :
+    case CUPS_CSPACE_ICC3 :
+    case CUPS_CSPACE_ICC4 :
+    case CUPS_CSPACE_ICC5 :
+    case CUPS_CSPACE_ICC6 :
+    case CUPS_CSPACE_ICC7 :
+    case CUPS_CSPACE_ICC8 :
+    case CUPS_CSPACE_ICC9 :
+    case CUPS_CSPACE_ICCA :
+    case CUPS_CSPACE_ICCB :
+    case CUPS_CSPACE_ICCC :
+    case CUPS_CSPACE_ICCD :
+    case CUPS_CSPACE_ICCE :
+    case CUPS_CSPACE_ICCF :
+        convert_lab(header, line, colors, pixels);
+        break;
+  }
+}
+
+
+//
+// 'rasterInkCoverage()' - Get the ink coverage of one channel of a page.
+//
+// The absence of light in additive color spaces such as W and RGB counts as
+// ink, so a blank page has no coverage in every color space...
+//
+
+double					// O - Coverage in percent
+rasterInkCoverage(
+    cups_page_header_t *header,		// I - Raster header
+    double             total)		// I - Sum of the channel's values
+{
+  double	maxval,			// Sum of a solid channel
+		coverage;		// Coverage in percent
+
+
+  if (header->cupsBitsPerColor == 16)
+    maxval = 65535.0;
+  else
+    maxval = (double)((1 << header->cupsBitsPerColor) - 1);
+
+  maxval   *= (double)header->cupsWidth * (double)header->cupsHeight;
+  coverage = maxval > 0.0 ? 100.0 * total / maxval : 0.0;
+
+  if (!((header->cupsColorSpace >= CUPS_CSPACE_K && header->cupsColorSpace <= CUPS_CSPACE_SILVER) || (header->cupsColorSpace >= CUPS_CSPACE_DEVICE1 && header->cupsColorSpace <= CUPS_CSPACE_DEVICEF)))
+    coverage = 100.0 - coverage;
+
+  return (coverage);
+}
+
+
+//
+// 'rasterRecolorLine()' - Regenerate Device-N pixels from the original colors.
+//
+
+void
+rasterRecolorLine(
+    cups_page_header_t *header,		// I - Raster header
+    unsigned char      *colors,		// I - Original pixels
+    unsigned char      *pixels,		// O - RGB pixels
+    unsigned char      device_colors[15][3])
+					// I - RGB values for each device color
+{
+  int	x,				// X position in line
+	z,				// Color
+	w,				// Width of line
+	bpc,				// Bytes per color
+	val;				// Pixel value
+  int	r, g, b;			// Current RGB color
+
+
+  if (header->cupsColorOrder != CUPS_ORDER_CHUNKED ||
+      (header->cupsBitsPerColor != 8 && header->cupsBitsPerColor != 16))
+    return;
+
+  w = header->cupsWidth;
+
+  // Use the most significant byte of 16-bit values, just like
+  // convert_device()...
+  if (header->cupsBitsPerColor == 16)
+  {
+    bpc    = 2;
+    colors += endian_offset;
+  }
+  else
+    bpc = 1;
+
+  for (x = w; x > 0; x --)
+  {
+    r = g = b = 255;
+
+    for (z = 0; z < (int)header->cupsNumColors; z ++, colors += bpc)
+    {
+      val = *colors;
+
+      r -= val * device_colors[z][0] / 255;
+      g -= val * device_colors[z][1] / 255;
+      b -= val * device_colors[z][2] / 255;
+    }
+
+    *pixels++ = r <= 0 ? 0 : r;
+    *pixels++ = g <= 0 ? 0 : g;
+    *pixels++ = b <= 0 ? 0 : b;
+  }
+}
+
+
+//
+// 'convert_cmy()' - Convert CMY or YMC raster data.
+//
+
+static void
+convert_cmy(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	bit;				// Current bit
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit       = *line++;
+	    *colors++ = bit >> 4;
+
+	    if (bit & 0x40)
+	      pixels[0] = 0;
+	    if (bit & 0x20)
+	      pixels[1] = 0;
+	    if (bit & 0x10)
+	      pixels[2] = 0;
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 15;
+
+	      if (bit & 0x04)
+	        pixels[3] = 0;
+	      if (bit & 0x02)
+	        pixels[4] = 0;
+	      if (bit & 0x01)
+	        pixels[5] = 0;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    bit = *line++;
+	    *colors++ = bit;
+
+	    *pixels++ = 255 - 85 * ((bit & 0x30) >> 4);
+	    *pixels++ = 255 - 85 * ((bit & 0x0c) >> 2);
+	    *pixels++ = 255 - 85 * (bit & 0x03);
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+	    *pixels++ = 255 - 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+	    *pixels++ = 255 - 17 * ((bit & 0xf0) >> 4);
+	    *pixels++ = 255 - 17 * (bit & 0x0f);
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = val = *line++;
+	    *pixels++ = 255 - val;
+
+	    *colors++ = val = *line++;
+	    *pixels++ = 255 - val;
+
+	    *colors++ = val = *line++;
+	    *pixels++ = 255 - val;
+          }
+          break;
+      case 16 :
+	  if (endian_offset)
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+            }
+	  }
+	  else
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *line++;
+            }
+	  }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    cptr = line;
+    mptr = line + bytespercolor;
+    yptr = line + 2 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*cptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[0] = 0;
+	    }
+	    else
+	      colors ++;
+
+	    if (*mptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[1] = 0;
+	    }
+	    else
+	      colors ++;
+
+	    if (*yptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[2] = 0;
+	    }
+	    else
+	      colors ++;
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      cptr ++;
+	      mptr ++;
+	      yptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      case 0 :
+	          *colors++ = val = (*cptr & 0xc0) >> 6;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0xc0) >> 6;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*yptr & 0xc0) >> 6;
+		  *pixels++ = 255 - 85 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*cptr & 0x30) >> 4;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0x30) >> 4;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*yptr & 0x30) >> 4;
+		  *pixels++ = 255 - 85 * val;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*cptr & 0x0c) >> 2;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0x0c) >> 2;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = (*yptr & 0x0c) >> 2;
+		  *pixels++ = 255 - 85 * val;
+                  break;
+	      case 3 :
+	          *colors++ = val = *cptr & 0x03;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = *mptr & 0x03;
+		  *pixels++ = 255 - 85 * val;
+	          *colors++ = val = *yptr & 0x03;
+		  *pixels++ = 255 - 85 * val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      case 0 :
+	          *colors++ = val = (*cptr & 0xf0) >> 4;
+		  *pixels++ = 255 - 17 * val;
+	          *colors++ = val = (*mptr & 0xf0) >> 4;
+		  *pixels++ = 255 - 17 * val;
+	          *colors++ = val = (*yptr & 0xf0) >> 4;
+		  *pixels++ = 255 - 17 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = *cptr & 0x0f;
+		  *pixels++ = 255 - 17 * val;
+	          *colors++ = val = *mptr & 0x0f;
+		  *pixels++ = 255 - 17 * val;
+	          *colors++ = val = *yptr & 0x0f;
+		  *pixels++ = 255 - 17 * val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = val = *cptr++;
+	    *pixels++ = 255 - val;
+
+	    *colors++ = val = *mptr++;
+	    *pixels++ = 255 - val;
+
+	    *colors++ = val = *yptr++;
+	    *pixels++ = 255 - val;
+          }
+          break;
+      case 16 :
+          if (endian_offset)
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = *cptr++;
+	      *colors++ = val = *cptr++;
+	      *pixels++ = 255 - val;
+
+	      *colors++ = *mptr++;
+	      *colors++ = val = *mptr++;
+	      *pixels++ = 255 - val;
+
+	      *colors++ = *yptr++;
+	      *colors++ = val = *yptr++;
+	      *pixels++ = 255 - val;
+            }
+          }
+	  else
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = val = *cptr++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *cptr++;
+
+	      *colors++ = val = *mptr++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *mptr++;
+
+	      *colors++ = val = *yptr++;
+	      *pixels++ = 255 - val;
+	      *colors++ = *yptr++;
+            }
+          }
+	  break;
+    }
+  }
+}
+
+
+//
+// 'convert_cmyk()' - Convert CMYK raster data.
+//
+
+static void
+convert_cmyk(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	*kptr,				// Black pointer
+	bit;				// Current bit
+  int	r, g, b, k;			// Current RGB color + K
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit       = *line++;
+	    *colors++ = bit >> 4;
+
+            if (bit & 0x10)
+	    {
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      if (bit & 0x80)
+		pixels[0] = 0;
+	      if (bit & 0x40)
+		pixels[1] = 0;
+	      if (bit & 0x20)
+		pixels[2] = 0;
+	    }
+
+	    if (x > 1)
+	    {
+ 	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x01)
+	      {
+		pixels[3] = 0;
+		pixels[4] = 0;
+		pixels[5] = 0;
+	      }
+	      else
+	      {
+		if (bit & 0x08)
+	          pixels[3] = 0;
+		if (bit & 0x04)
+	          pixels[4] = 0;
+		if (bit & 0x02)
+	          pixels[5] = 0;
+	      }
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    k = 85 * (bit & 0x03);
+	    r = 255 - 85 * ((bit & 0xc0) >> 6) - k;
+	    g = 255 - 85 * ((bit & 0x30) >> 4) - k;
+	    b = 255 - 85 * ((bit & 0x0c) >> 2) - k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    r = 255 - 17 * ((bit & 0xf0) >> 4);
+	    g = 255 - 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+
+	    b = 255 - 17 * ((bit & 0xf0) >> 4);
+	    k = 17 * (bit & 0x0f);
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = val = *line++;
+	    r         = 255 - val;
+	    *colors++ = val = *line++;
+	    g         = 255 - val;
+	    *colors++ = val = *line++;
+	    b         = 255 - val;
+	    *colors++ = k = *line++;
+
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+	    if (endian_offset)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      r         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      g         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      b         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = k = *line++;
+	    }
+	    else
+	    {
+	      *colors++ = val = *line++;
+	      r         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      g         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      b         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = k = *line++;
+	      *colors++ = *line++;
+	    }
+
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    cptr = line;
+    mptr = line + bytespercolor;
+    yptr = line + 2 * bytespercolor;
+    kptr = line + 3 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*cptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*mptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*yptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*kptr & bit)
+	    {
+	      *colors++ = 1;
+
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      colors ++;
+
+	      if (*cptr & bit)
+		pixels[0] = 0;
+	      if (*mptr & bit)
+		pixels[1] = 0;
+	      if (*yptr & bit)
+		pixels[2] = 0;
+            }
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      cptr ++;
+	      mptr ++;
+	      yptr ++;
+	      kptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      default :
+	      case 0 :
+	          val       = (*kptr & 0xc0) >> 6;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0xc0) >> 6;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0xc0) >> 6;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0xc0) >> 6;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 1 :
+	          val       = (*kptr & 0x30) >> 4;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0x30) >> 4;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x30) >> 4;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0x30) >> 4;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 2 :
+	          val       = (*kptr & 0x0c) >> 2;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0x0c) >> 2;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x0c) >> 2;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0x0c) >> 2;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 3 :
+	          val       = *kptr & 0x03;
+		  k         = 85 * val;
+
+	          *colors++ = val = *cptr & 0x03;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = *mptr & 0x03;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = *yptr & 0x03;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      default :
+	      case 0 :
+	          val       = (*kptr & 0xf0) >> 4;
+		  k         = 17 * val;
+	          *colors++ = val = (*cptr & 0xf0) >> 4;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val = (*mptr & 0xf0) >> 4;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = (*yptr & 0xf0) >> 4;
+		  b         = 255 - 17 * val - k;
+	          *colors++ = val;
+                  break;
+	      case 1 :
+	          val       = *kptr & 0x0f;
+		  k         = 17 * val;
+	          *colors++ = val = *cptr & 0x0f;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val = *mptr & 0x0f;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = *yptr & 0x0f;
+		  b         = 255 - 17 * val - k;
+	          *colors++ = val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    k         = *kptr++;
+	    *colors++ = val = *cptr++;
+	    r         = 255 - val - k;
+	    *colors++ = val = *mptr++;
+	    g         = 255 - val - k;
+	    *colors++ = val = *yptr++;
+	    b         = 255 - val - k;
+	    *colors++ = k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+            if (endian_offset)
+	    {
+	      *colors++ = *cptr++;
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val;
+
+	      *colors++ = *mptr++;
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val;
+
+	      *colors++ = *yptr++;
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val;
+
+	      *colors++ = *kptr++;
+	      *colors++ = k = *kptr++;
+            }
+	    else
+            {
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val;
+	      *colors++ = *cptr++;
+
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val;
+	      *colors++ = *mptr++;
+
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val;
+	      *colors++ = *yptr++;
+
+	      *colors++ = k = *kptr++;
+	      *colors++ = *kptr++;
+	    }
+
+            r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+	  }
+          break;
+    }
+  }
+}
+
+
+//
+// 'convert_device()' - Convert Device-N raster data.
+//
+
+static void
+convert_device(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels,	// O - RGB pixels
+    uchar               device_colors[][3])
+    					// I - RGB values for each device color
+{
+  int	x,				// X position in line
+	z,				// Color
+	w,				// Width of line
+	val;				// Pixel value
+  int	r, g, b;			// Current RGB color
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder != CUPS_ORDER_CHUNKED)
+  {
+    fputs("Error: Unsupported color order for Device-N...\n", stderr);
+    return;
+  }
+
+  if (header->cupsBitsPerColor != 8 && header->cupsBitsPerColor != 16)
+  {
+    fputs("Error: Unsupported bit depth for Device-N...\n", stderr);
+    return;
+  }
+
+  switch (header->cupsBitsPerColor)
+  {
+    case 8 :
+	for (x = w; x > 0; x --)
+	{
+	  r = g = b = 255;
+	  for (z = 0; z < header->cupsNumColors; z ++)
+	  {
+	    *colors++ = val = *line++;
+
+	    r -= val * device_colors[z][0] / 255;
+	    g -= val * device_colors[z][1] / 255;
+	    b -= val * device_colors[z][2] / 255;
+	  }
+
+	  if (r <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = r;
+
+	  if (g <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = g;
+
+	  if (b <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = b;
+	}
+	break;
+    case 16 :
+	for (x = w; x > 0; x --)
+	{
+	  r = g = b = 255;
+	  for (z = 0; z < header->cupsNumColors; z ++)
+	  {
+	    if (endian_offset)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	    }
+	    else
+	    {
+	      *colors++ = val = *line++;
+	      *colors++ = *line++;
+	    }
+
+	    r -= val * device_colors[z][0] / 255;
+	    g -= val * device_colors[z][1] / 255;
+	    b -= val * device_colors[z][2] / 255;
+	  }
+
+	  if (r <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = r;
+
+	  if (g <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = g;
+
+	  if (b <= 0)
+	    *pixels++ = 0;
+	  else
+	    *pixels++ = b;
+	}
+	break;
+  }
+}
+
+
+
+//
+// 'convert_k()' - Convert black raster data.
+//
+
+static void
+convert_k(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - Grayscale pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	bit,				// Current bit
+	byte;				// Current byte
+
+
+  w = header->cupsWidth;
+
+  switch (header->cupsBitsPerColor)
+  {
+    case 1 :
+        for (x = w, bit = 0x80, byte = *line++; x > 0; x --)
+	{
+	  if (byte & bit)
+	  {
+	    *colors++ = 1;
+	    *pixels++ = 0;
+	  }
+	  else
+	  {
+	    colors ++;
+	    pixels ++;
+          }
+
+          if (bit > 1)
+	    bit >>= 1;
+	  else
+	  {
+	    bit  = 0x80;
+	    byte = *line++;
+	  }
+        }
+        break;
+    case 2 :
+        for (x = w; x > 0; x -= 4)
+	{
+	  byte = *line++;
+
+	  *colors++ = val = (byte & 0xc0) >> 6;
+	  *pixels++ = ~(85 * val);
+
+	  if (x > 1)
+	  {
+	    *colors++ = val = (byte & 0x30) >> 4;
+	    *pixels++ = ~(85 * val);
+	  }
+
+	  if (x > 2)
+	  {
+	    *colors++ = val = (byte & 0x0c) >> 2;
+	    *pixels++ = ~(85 * val);
+	  }
+
+	  if (x > 3)
+	  {
+	    *colors++ = val = byte & 0x03;
+	    *pixels++ = ~(85 * val);
+	  }
+        }
+        break;
+    case 4 :
+        for (x = w; x > 0; x -= 2)
+	{
+	  byte = *line++;
+
+	  *colors++ = val = (byte & 0xf0) >> 4;
+	  *pixels++ = ~(17 * val);
+
+	  *colors++ = val = byte & 0x0f;
+	  *pixels++ = ~(17 * val);
+        }
+        break;
+    case 8 :
+        for (x = w; x > 0; x --)
+	{
+	  *colors++ = val = *line++;
+	  *pixels++ = ~val;
+	}
+        break;
+    case 16 :
+	if (endian_offset)
+	{
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *line++;
+	    *colors++ = val = *line++;
+	    *pixels++ = ~val;
+          }
+	}
+	else
+	{
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = val = *line++;
+	    *pixels++ = ~val;
+	    *colors++ = *line++;
+          }
+	}
+        break;
+  }
+}
+
+
+//
+// 'convert_kcmy()' - Convert KCMY or KCMYcm (8-bit) raster data.
+//
+
+static void
+convert_kcmy(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	*kptr,				// Black pointer
+	bit;				// Current bit
+  int	r, g, b, k;			// Current RGB color + K
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit       = *line++;
+	    *colors++ = bit >> 4;
+
+            if (bit & 0x80)
+	    {
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      if (bit & 0x40)
+		pixels[0] = 0;
+	      if (bit & 0x20)
+		pixels[1] = 0;
+	      if (bit & 0x10)
+		pixels[2] = 0;
+	    }
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x08)
+	      {
+		pixels[3] = 0;
+		pixels[4] = 0;
+		pixels[5] = 0;
+	      }
+	      else
+	      {
+		if (bit & 0x04)
+	          pixels[3] = 0;
+		if (bit & 0x02)
+	          pixels[4] = 0;
+		if (bit & 0x01)
+	          pixels[5] = 0;
+	      }
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    k = 85 * ((bit & 0xc0) >> 6);
+	    r = 255 - 85 * ((bit & 0x30) >> 4) - k;
+	    g = 255 - 85 * ((bit & 0x0c) >> 2) - k;
+	    b = 255 - 85 * (bit & 0x03) - k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    k = 17 * ((bit & 0xf0) >> 4);
+	    r = 255 - 17 * (bit & 0x0f) - k;
+
+	    *colors++ = bit = *line++;
+
+	    g = 255 - 17 * ((bit & 0xf0) >> 4) - k;
+	    b = 255 - 17 * (bit & 0x0f) - k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *line;
+	    k         = *line++;
+	    *colors++ = *line;
+	    r         = 255 - *line++ - k;
+	    *colors++ = *line;
+	    g         = 255 - *line++ - k;
+	    *colors++ = *line;
+	    b         = 255 - *line++ - k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+	    if (endian_offset)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = k = *line++;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      r         = 255 - val - k;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      g         = 255 - val - k;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      b         = 255 - val - k;
+            }
+	    else
+	    {
+	      *colors++ = k = *line++;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      r         = 255 - val - k;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      g         = 255 - val - k;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      b         = 255 - val - k;
+	      *colors++ = *line++;
+            }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    kptr = line;
+    cptr = line + bytespercolor;
+    mptr = line + 2 * bytespercolor;
+    yptr = line + 3 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*kptr & bit)
+	    {
+	      *colors++ = 1;
+
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      colors ++;
+
+	      if (*cptr & bit)
+		pixels[0] = 0;
+	      if (*mptr & bit)
+		pixels[1] = 0;
+	      if (*yptr & bit)
+		pixels[2] = 0;
+            }
+
+	    if (*cptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*mptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*yptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      cptr ++;
+	      mptr ++;
+	      yptr ++;
+	      kptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*kptr & 0xc0) >> 6;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0xc0) >> 6;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0xc0) >> 6;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0xc0) >> 6;
+		  b         = 255 - 85 * val - k;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*kptr & 0x30) >> 4;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0x30) >> 4;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x30) >> 4;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0x30) >> 4;
+		  b         = 255 - 85 * val - k;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*kptr & 0x0c) >> 2;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*cptr & 0x0c) >> 2;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x0c) >> 2;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*yptr & 0x0c) >> 2;
+		  b         = 255 - 85 * val - k;
+                  break;
+	      case 3 :
+	          *colors++ = val = *kptr & 0x03;
+		  k         = 85 * val;
+
+	          *colors++ = val = *cptr & 0x03;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val = *mptr & 0x03;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = *yptr & 0x03;
+		  b         = 255 - 85 * val - k;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*kptr & 0xf0) >> 4;
+		  k         = 17 * val;
+	          *colors++ = val = (*cptr & 0xf0) >> 4;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val = (*mptr & 0xf0) >> 4;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = (*yptr & 0xf0) >> 4;
+		  b         = 255 - 17 * val - k;
+                  break;
+	      case 1 :
+	          *colors++ = val = *kptr & 0x0f;
+		  k         = 17 * val;
+	          *colors++ = val = *cptr & 0x0f;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val = *mptr & 0x0f;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = *yptr & 0x0f;
+		  b         = 255 - 17 * val - k;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = k = *kptr++;
+	    *colors++ = val = *cptr++;
+	    r         = 255 - val - k;
+	    *colors++ = val = *mptr++;
+	    g         = 255 - val - k;
+	    *colors++ = val = *yptr++;
+	    b         = 255 - val - k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+            if (endian_offset)
+	    {
+	      *colors++ = *kptr++;
+	      *colors++ = k = *kptr++;
+
+	      *colors++ = *cptr++;
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val - k;
+
+	      *colors++ = *mptr++;
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val - k;
+
+	      *colors++ = *yptr++;
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val - k;
+            }
+	    else
+            {
+	      *colors++ = k = *kptr++;
+	      *colors++ = *kptr++;
+
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val - k;
+	      *colors++ = *cptr++;
+
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val - k;
+	      *colors++ = *mptr++;
+
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val - k;
+	      *colors++ = *yptr++;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+	  }
+          break;
+    }
+  }
+}
+
+
+//
+// 'convert_kcmycm()' - Convert KCMYcm (1-bit) raster data.
+//
+
+static void
+convert_kcmycm(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w;				// Width of line
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	*kptr,				// Black pointer
+	*lcptr,				// Light cyan pointer
+	*lmptr,				// Light magenta pointer
+	bit;				// Current bit
+  int	r, g, b;			// Current RGB color
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    for (x = w; x > 0; x --)
+    {
+      bit       = *line++;
+      *colors++ = bit;
+
+      if (bit & 0x20)
+      {
+        *pixels++ = 0;
+        *pixels++ = 0;
+        *pixels++ = 0;
+	continue;
+      }
+
+      r = g = 255;
+
+      if (bit & 0x10)
+	r -= 255;
+      if (bit & 0x08)
+	g -= 255;
+      if (bit & 0x02)
+	r -= 127;
+      if (bit & 0x01)
+	g -= 127;
+      if (bit & 0x04)
+	b = 0;
+      else
+        b = 255;
+
+      if (r < 0)
+	*pixels++ = 0;
+      else
+	*pixels++ = r;
+
+      if (g < 0)
+	*pixels++ = 0;
+      else
+	*pixels++ = g;
+
+      // Blue is always in range...
+      *pixels++ = b;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = header->cupsBytesPerLine / 6;
+
+
+    kptr  = line;
+    cptr  = line + bytespercolor;
+    mptr  = line + 2 * bytespercolor;
+    yptr  = line + 3 * bytespercolor;
+    lcptr = line + 4 * bytespercolor;
+    lmptr = line + 5 * bytespercolor;
+
+    for (x = w, bit = 0x80; x > 0; x --)
+    {
+      if (*kptr & bit)
+      {
+        *colors++ = 1;
+	*pixels++ = 0;
+	*pixels++ = 0;
+	*pixels++ = 0;
+      }
+      else
+      {
+        colors ++;
+        r = g = 255;
+
+	if (*cptr & bit)
+	  r -= 255;
+	if (*mptr & bit)
+	  g -= 255;
+	if (*lcptr & bit)
+	  r -= 127;
+	if (*lmptr & bit)
+	  g -= 127;
+	if (*yptr & bit)
+	  b = 0;
+	else
+	  b = 255;
+
+	if (r < 0)
+	  *pixels++ = 0;
+	else
+	  *pixels++ = r;
+
+	if (g < 0)
+	  *pixels++ = 0;
+	else
+	  *pixels++ = g;
+
+	// Blue is always in range...
+	*pixels++ = b;
+      }
+
+      if (*cptr & bit)
+        *colors++ = 1;
+      else
+        colors ++;
+
+      if (*mptr & bit)
+        *colors++ = 1;
+      else
+        colors ++;
+
+      if (*yptr & bit)
+        *colors++ = 1;
+      else
+        colors ++;
+
+      if (*lcptr & bit)
+        *colors++ = 1;
+      else
+        colors ++;
+
+      if (*lmptr & bit)
+        *colors++ = 1;
+      else
+        colors ++;
+
+      if (bit > 1)
+	bit >>= 1;
+      else
+      {
+	bit = 0x80;
+	cptr ++;
+	mptr ++;
+	yptr ++;
+	kptr ++;
+	lcptr ++;
+	lmptr ++;
+      }
+    }
+  }
+}
+
+
+//
+// 'convert_lab()' - Convert CIE Lab or ICCn raster data.
+//
+
+static void
+convert_lab(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int			x,		// X position in line
+			w,		// Width of line
+			val;		// Pixel value
+  unsigned short	*sline;		// 16-bit pixels
+  float			lab[3],		// Lab color
+			p,		//
+			xyz[3],		// XYZ color
+			rgb[3];		// RGB color
+
+
+  w = header->cupsWidth;
+
+  for (x = w, sline = (unsigned short *)line; x > 0; x --)
+  {
+    // Extract the Lab color value...
+    if (header->cupsBitsPerColor == 8)
+    {
+      // 8-bit color values...
+      *colors++ = val = *line++;
+      lab[0]    = val / 2.55f;
+      *colors++ = val = *line++;
+      lab[1]    = val - 128.0f;
+      *colors++ = val = *line++;
+      lab[2]    = val - 128.0f;
+    }
+    else
+    {
+      // 16-bit color values...
+      *colors++ = *line++;
+      *colors++ = *line++;
+      lab[0]    = *sline++ / 655.35f;
+      *colors++ = *line++;
+      *colors++ = *line++;
+      lab[1]    = *sline++ / 256.0f - 128.0f;
+      *colors++ = *line++;
+      *colors++ = *line++;
+      lab[2]    = *sline++ / 256.0f - 128.0f;
+    }
+
+    // Convert Lab to XYZ...
+    if (lab[0] < 8)
+      p = lab[0] / 903.3;
+    else
+      p = (lab[0] + 16.0f) / 116.0f;
+
+    xyz[0] = D65_X * pow(p + lab[1] * 0.002, 3.0);
+    xyz[1] = D65_Y * pow((double)p, 3.0);
+    xyz[2] = D65_Z * pow(p - lab[2] * 0.005, 3.0);
+
+    // Convert XYZ to sRGB...
+    rgb[0] =  3.240479f * xyz[0] - 1.537150f * xyz[1] - 0.498535f * xyz[2];
+    rgb[1] = -0.969256f * xyz[0] + 1.875992f * xyz[1] + 0.041556f * xyz[2];
+    rgb[2] =  0.055648f * xyz[0] - 0.204043f * xyz[1] + 1.057311f * xyz[2];
+
+    rgb[0] = rgb[0] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[0], 0.41666) - 0.055f;
+    rgb[1] = rgb[1] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[1], 0.41666) - 0.055f;
+    rgb[2] = rgb[2] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[2], 0.41666) - 0.055f;
+
+    // Save it...
+    if (rgb[0] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[0] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[0] + 0.5);
+    else
+      *pixels++ = 255;
+
+    if (rgb[1] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[1] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[1] + 0.5);
+    else
+      *pixels++ = 255;
+
+    if (rgb[2] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[2] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[2] + 0.5);
+    else
+      *pixels++ = 255;
+  }
+}
+
+
+//
+// 'convert_rgb()' - Convert RGB raster data.
+//
+
+static void
+convert_rgb(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*rptr,				// Red pointer
+	*gptr,				// Green pointer
+	*bptr,				// Blue pointer
+	bit;				// Current bit
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit = *line++;
+	    *colors++ = bit >> 4;
+
+	    if (bit & 0x40)
+	      pixels[0] = 255;
+	    if (bit & 0x20)
+	      pixels[1] = 255;
+	    if (bit & 0x10)
+	      pixels[2] = 255;
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x04)
+	        pixels[3] = 255;
+	      if (bit & 0x02)
+	        pixels[4] = 255;
+	      if (bit & 0x01)
+	        pixels[5] = 255;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    *pixels++ = 85 * ((bit & 0x30) >> 4);
+	    *pixels++ = 85 * ((bit & 0x0c) >> 2);
+	    *pixels++ = 85 * (bit & 0x03);
+          }
+          break;
+      case 4 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w; x > 0; x --, pixels += 3)
+	  {
+	    bit = *line++;
+	    *colors++ = bit;
+
+	    if (bit & 0x0f)
+	      pixels[0] += 17 * (bit & 0x0f);
+
+	    bit = *line++;
+	    *colors++ = bit;
+
+	    if (bit & 0xf0)
+	      pixels[1] += 17 * ((bit & 0xf0) >> 4);
+	    if (bit & 0x0f)
+	      pixels[2] += 17 * (bit & 0x0f);
+          }
+          break;
+      case 8 :
+	  memcpy(colors, line, w * 3);
+          memcpy(pixels, line, w * 3);
+          break;
+      case 16 :
+	  if (endian_offset)
+	    *colors++ = *line++;
+
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *pixels++ = *line++;
+	    *colors++ = *line++;
+
+	    *colors++ = *pixels++ = *line++;
+	    *colors++ = *line++;
+
+	    *colors++ = *pixels++ = *line++;
+	    if (!endian_offset || x > 1)
+	      *colors++ = *line++;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    rptr = line;
+    gptr = line + bytespercolor;
+    bptr = line + 2 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*rptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[0] = 255;
+	    }
+	    else
+	      colors ++;
+
+	    if (*gptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[1] = 255;
+	    }
+	    else
+	      colors ++;
+
+	    if (*bptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[2] = 255;
+	    }
+	    else
+	      colors ++;
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      rptr ++;
+	      gptr ++;
+	      bptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xc0) >> 6;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*gptr & 0xc0) >> 6;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*bptr & 0xc0) >> 6;
+		  *pixels++ = 85 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*rptr & 0x30) >> 4;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*gptr & 0x30) >> 4;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*bptr & 0x30) >> 4;
+		  *pixels++ = 85 * val;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*rptr & 0x0c) >> 2;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*gptr & 0x0c) >> 2;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = (*bptr & 0x0c) >> 2;
+		  *pixels++ = 85 * val;
+                  break;
+	      case 3 :
+	          *colors++ = val = *rptr & 0x03;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = *gptr & 0x03;
+		  *pixels++ = 85 * val;
+	          *colors++ = val = *bptr & 0x03;
+		  *pixels++ = 85 * val;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xf0) >> 4;
+		  *pixels++ = 17 * val;
+	          *colors++ = val = (*gptr & 0xf0) >> 4;
+		  *pixels++ = 17 * val;
+	          *colors++ = val = (*bptr & 0xf0) >> 4;
+		  *pixels++ = 17 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = *rptr & 0x0f;
+		  *pixels++ = 17 * val;
+	          *colors++ = val = *gptr & 0x0f;
+		  *pixels++ = 17 * val;
+	          *colors++ = val = *bptr & 0x0f;
+		  *pixels++ = 17 * val;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *pixels++ = *rptr++;
+	    *colors++ = *pixels++ = *gptr++;
+	    *colors++ = *pixels++ = *bptr++;
+          }
+          break;
+      case 16 :
+          if (endian_offset)
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = *rptr++;
+	      *colors++ = *pixels++ = *rptr++;
+	      *colors++ = *gptr++;
+	      *colors++ = *pixels++ = *gptr++;
+	      *colors++ = *bptr++;
+	      *colors++ = *pixels++ = *bptr++;
+            }
+	  }
+	  else
+	  {
+            for (x = w; x > 0; x --)
+	    {
+	      *colors++ = *pixels++ = *rptr++;
+	      *colors++ = *rptr++;
+	      *colors++ = *pixels++ = *gptr++;
+	      *colors++ = *gptr++;
+	      *colors++ = *pixels++ = *bptr++;
+	      *colors++ = *bptr++;
+            }
+	  }
+          break;
+    }
+  }
+}
+
+
+//
+// 'convert_rgba()' - Convert RGBA raster data.
+//
+
+static void
+convert_rgba(
+    cups_page_header_t *header,	// I - Raster header */
+    int                 y,		// I - Raster Y position
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*rptr,				// Red pointer
+	*gptr,				// Green pointer
+	*bptr,				// Blue pointer
+	*aptr,				// Alpha pointer
+	bit;				// Current bit
+  int	r, g, b, a;			// Current color
+  int	bg;				// Background to blend
+
+
+  w = header->cupsWidth;
+  y &= 128;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit = *line++;
+	    *colors++ = bit >> 4;
+
+            if (bit & 0x10)
+	    {
+	      if (bit & 0x80)
+		pixels[0] = 255;
+	      if (bit & 0x40)
+		pixels[1] = 255;
+	      if (bit & 0x20)
+		pixels[2] = 255;
+            }
+	    else if ((x & 128) ^ y)
+	    {
+	      pixels[0] = 128;
+	      pixels[1] = 128;
+	      pixels[2] = 128;
+	    }
+	    else
+	    {
+	      pixels[0] = 192;
+	      pixels[1] = 192;
+	      pixels[2] = 192;
+	    }
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+              if (bit & 0x01)
+	      {
+		if (bit & 0x08)
+	          pixels[3] = 255;
+		if (bit & 0x04)
+	          pixels[4] = 255;
+		if (bit & 0x02)
+	          pixels[5] = 255;
+	      }
+	      else if (((x - 1) & 128) ^ y)
+	      {
+		pixels[3] = 128;
+		pixels[4] = 128;
+		pixels[5] = 128;
+	      }
+	      else
+	      {
+		pixels[3] = 192;
+		pixels[4] = 192;
+		pixels[5] = 192;
+	      }
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    r = 85 * ((bit & 0xc0) >> 6);
+	    g = 85 * ((bit & 0x30) >> 4);
+	    b = 85 * ((bit & 0x0c) >> 2);
+	    a = 85 * (bit & 0x03);
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    r = 17 * ((bit & 0xf0) >> 4);
+	    g = 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+
+	    b = 17 * ((bit & 0xf0) >> 4);
+	    a = 17 * (bit & 0x0f);
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *line++;
+	    *colors++ = g = *line++;
+	    *colors++ = b = *line++;
+	    *colors++ = a = *line++;
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 16 :
+	  if (endian_offset)
+	    *colors++ = *line++;
+
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *line++;
+	    *colors++ = *line++;
+	    *colors++ = g = *line++;
+	    *colors++ = *line++;
+	    *colors++ = b = *line++;
+	    *colors++ = *line++;
+	    *colors++ = a = *line++;
+	    if (!endian_offset || x > 1)
+	      *colors++ = *line++;
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    rptr = line;
+    gptr = line + bytespercolor;
+    bptr = line + 2 * bytespercolor;
+    aptr = line + 3 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*rptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[0] = 255;
+	    }
+	    else
+	      colors ++;
+
+	    if (*gptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[1] = 255;
+	    }
+	    else
+	      colors ++;
+
+	    if (*bptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[2] = 255;
+	    }
+	    else
+	      colors ++;
+
+	    if (*aptr & bit)
+	      *colors++ = 1;
+	    else
+	    {
+	      colors ++;
+
+	      if ((x & 128) ^ y)
+	      {
+		pixels[0] = 128;
+		pixels[1] = 128;
+		pixels[2] = 128;
+	      }
+	      else
+	      {
+		pixels[0] = 192;
+		pixels[1] = 192;
+		pixels[2] = 192;
+	      }
+            }
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      rptr ++;
+	      gptr ++;
+	      bptr ++;
+	      aptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xc0) >> 6;
+		  r         = 85 * val;
+
+	          *colors++ = val = (*gptr & 0xc0) >> 6;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0xc0) >> 6;
+		  b         = 85 * val;
+
+	          *colors++ = val = (*aptr & 0xc0) >> 6;
+		  a         = 85 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*rptr & 0x30) >> 4;
+		  r         = 85 * val;
+
+	          *colors++ = val = (*gptr & 0x30) >> 4;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0x30) >> 4;
+		  b         = 85 * val;
+
+	          *colors++ = val = (*aptr & 0x30) >> 4;
+		  a         = 85 * val;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*rptr & 0x0c) >> 2;
+		  r         = 85 * val;
+
+	          *colors++ = val = (*gptr & 0x0c) >> 2;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0x0c) >> 2;
+		  b         = 85 * val;
+
+	          *colors++ = val = (*aptr & 0x0c) >> 2;
+		  a         = 85 * val;
+                  break;
+	      case 3 :
+	          *colors++ = val = *rptr & 0x03;
+		  r         = 85 * val;
+
+	          *colors++ = val = *gptr & 0x03;
+		  g         = 85 * val;
+
+	          *colors++ = val = *bptr & 0x03;
+		  b         = 85 * val;
+
+	          *colors++ = val = *aptr & 0x03;
+		  a         = 85 * val;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+		  aptr ++;
+                  break;
+	    }
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xf0) >> 4;
+		  r         = 17 * val;
+
+	          *colors++ = val = (*gptr & 0xf0) >> 4;
+		  g         = 17 * val;
+
+	          *colors++ = val = (*bptr & 0xf0) >> 4;
+		  b         = 17 * val;
+
+	          *colors++ = val = (*aptr & 0xf0) >> 4;
+		  a         = 17 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = *rptr & 0x0f;
+		  r         = 17 * val;
+
+	          *colors++ = val = *gptr & 0x0f;
+		  g         = 17 * val;
+
+	          *colors++ = val = *bptr & 0x0f;
+		  b         = 17 * val;
+
+	          *colors++ = val = *aptr & 0x0f;
+		  a         = 17 * val;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+		  aptr ++;
+                  break;
+	    }
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *rptr++;
+	    *colors++ = g = *gptr++;
+	    *colors++ = b = *bptr++;
+	    *colors++ = a = *aptr++;
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+            if (endian_offset)
+	    {
+	      *colors++ = *rptr++;
+	      *colors++ = r = *rptr++;
+	      *colors++ = *gptr++;
+	      *colors++ = g = *gptr++;
+	      *colors++ = *bptr++;
+	      *colors++ = b = *bptr++;
+	      *colors++ = *aptr++;
+	      *colors++ = a = *aptr++;
+            }
+	    else
+	    {
+	      *colors++ = r = *rptr++;
+	      *colors++ = *rptr++;
+	      *colors++ = g = *gptr++;
+	      *colors++ = *gptr++;
+	      *colors++ = b = *bptr++;
+	      *colors++ = *bptr++;
+	      *colors++ = a = *aptr++;
+	      *colors++ = *aptr++;
+            }
+
+	    if (a < 255)
+	    {
+	      if ((x & 128) ^ y)
+	        bg = 128;
+	      else
+	        bg = 192;
+
+              if (a == 0)
+	        r = g = b = bg;
+	      else
+	      {
+        	r = (a * r + (255 - a) * bg) / 255;
+        	g = (a * g + (255 - a) * bg) / 255;
+        	b = (a * b + (255 - a) * bg) / 255;
+	      }
+	    }
+
+	    *pixels++ = r;
+	    *pixels++ = g;
+	    *pixels++ = b;
+	  }
+          break;
+    }
+  }
+}
+
+
+//
+// 'convert_rgbw()' - Convert RGBW raster data.
+//
+
+static void
+convert_rgbw(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*rptr,				// Red pointer
+	*gptr,				// Green pointer
+	*bptr,				// Blue pointer
+	*wptr,				// White pointer
+	bit;				// Current bit
+  int	r, g, b, white;			// Current RGBW color
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit = *line++;
+	    *colors++ = bit >> 4;
+
+            if (bit & 0x10)
+	    {
+	      if (bit & 0x80)
+		pixels[0] = 255;
+	      if (bit & 0x40)
+		pixels[1] = 255;
+	      if (bit & 0x20)
+		pixels[2] = 255;
+            }
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x01)
+	      {
+		if (bit & 0x08)
+	          pixels[3] = 255;
+		if (bit & 0x04)
+	          pixels[4] = 255;
+		if (bit & 0x02)
+	          pixels[5] = 255;
+	      }
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    white = 85 * (bit & 0x03) - 255;
+            r     = 85 * ((bit & 0xc0) >> 6) + white;
+	    g     = 85 * ((bit & 0x30) >> 4) + white;
+	    b     = 85 * ((bit & 0x0c) >> 2) + white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    r = 17 * ((bit & 0xf0) >> 4);
+	    g = 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+
+	    b     = 17 * ((bit & 0xf0) >> 4);
+	    white = 17 * (bit & 0x0f) - 255;
+
+	    r += white;
+	    g += white;
+	    b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *line++;
+	    *colors++ = g = *line++;
+	    *colors++ = b = *line++;
+	    *colors++ = val = *line++;
+	    white     = val - 255;
+
+	    r += white;
+	    g += white;
+	    b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 16 :
+	  if (endian_offset)
+	    *colors++ = *line++;
+
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *line++;
+	    *colors++ = *line++;
+	    *colors++ = g = *line++;
+	    *colors++ = *line++;
+	    *colors++ = b = *line++;
+	    *colors++ = *line++;
+	    *colors++ = val = *line++;
+	    white     = val - 255;
+	    if (!endian_offset || x > 1)
+	      *colors++ = *line++;
+
+	    r += white;
+	    g += white;
+	    b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    rptr = line;
+    gptr = line + bytespercolor;
+    bptr = line + 2 * bytespercolor;
+    wptr = line + 3 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+	  memset(pixels, 0, w * 3);
+
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*rptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*gptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*bptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*wptr & bit)
+	    {
+	      *colors++ = 1;
+
+	      if (*rptr & bit)
+		pixels[0] = 255;
+	      if (*gptr & bit)
+		pixels[1] = 255;
+	      if (*bptr & bit)
+		pixels[2] = 255;
+            }
+	    else
+	      colors ++;
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      rptr ++;
+	      gptr ++;
+	      bptr ++;
+	      wptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xc0) >> 6;
+		  r         = 85 * val;
+
+		  *colors++ = val = (*gptr & 0xc0) >> 6;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0xc0) >> 6;
+		  b         = 85 * val;
+
+		  *colors++ = val = (*wptr & 0xc0) >> 6;
+		  white     = 85 * val - 255;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*rptr & 0x30) >> 4;
+		  r         = 85 * val;
+
+		  *colors++ = val = (*gptr & 0x30) >> 4;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0x30) >> 4;
+		  b         = 85 * val;
+
+		  *colors++ = val = (*wptr & 0x30) >> 4;
+		  white     = 85 * val - 255;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*rptr & 0x0c) >> 2;
+		  r         = 85 * val;
+
+		  *colors++ = val = (*gptr & 0x0c) >> 2;
+		  g         = 85 * val;
+
+	          *colors++ = val = (*bptr & 0x0c) >> 2;
+		  b         = 85 * val;
+
+		  *colors++ = val = (*wptr & 0x0c) >> 2;
+		  white     = 85 * val - 255;
+                  break;
+	      case 3 :
+	          *colors++ = val = *rptr & 0x03;
+		  r         = 85 * val;
+
+		  *colors++ = val = *gptr & 0x03;
+		  g         = 85 * val;
+
+	          *colors++ = val = *bptr & 0x03;
+		  b         = 85 * val;
+
+		  *colors++ = val = *wptr & 0x03;
+		  white     = 85 * val - 255;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+		  wptr ++;
+                  break;
+	    }
+
+	    r += white;
+	    g += white;
+	    b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      default :
+	      case 0 :
+	          *colors++ = val = (*rptr & 0xf0) >> 4;
+		  r         = 17 * val;
+
+	          *colors++ = val = (*gptr & 0xf0) >> 4;
+		  g         = 17 * val;
+
+	          *colors++ = val = (*bptr & 0xf0) >> 4;
+		  b         = 17 * val;
+
+		  *colors++ = val = (*wptr & 0xf0) >> 4;
+		  white     = 17 * val - 255;
+                  break;
+	      case 1 :
+	          *colors++ = val = *rptr & 0x0f;
+		  r         = 17 * val;
+
+	          *colors++ = val = *gptr & 0x0f;
+		  g         = 17 * val;
+
+	          *colors++ = val = *bptr & 0x0f;
+		  b         = 17 * val;
+
+		  *colors++ = val = *wptr & 0x0f;
+		  white     = 17 * val - 255;
+
+		  rptr ++;
+		  gptr ++;
+		  bptr ++;
+		  wptr ++;
+                  break;
+	    }
+
+	    r += white;
+	    g += white;
+	    b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = r = *rptr++;
+	    *colors++ = g = *gptr++;
+	    *colors++ = b = *bptr++;
+	    *colors++ = val = *wptr++;
+	    white     = val - 255;
+
+            r += white;
+            g += white;
+            b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+            if (endian_offset)
+	    {
+	      *colors++ = *rptr++;
+	      *colors++ = r = *rptr++;
+
+	      *colors++ = *gptr++;
+	      *colors++ = g = *gptr++;
+
+	      *colors++ = *bptr++;
+	      *colors++ = b = *bptr++;
+
+	      *colors++ = *wptr++;
+	      *colors++ = val = *wptr++;
+	      white     = val - 255;
+	    }
+	    else
+	    {
+	      *colors++ = r = *rptr++;
+	      *colors++ = *rptr++;
+
+	      *colors++ = g = *gptr++;
+	      *colors++ = *gptr++;
+
+	      *colors++ = b = *bptr++;
+	      *colors++ = *bptr++;
+
+	      *colors++ = val = *wptr++;
+	      white     = val - 255;
+	      *colors++ = *wptr++;
+	    }
+
+            r += white;
+            g += white;
+            b += white;
+
+            if (r <= 0)
+	      *pixels++ = 0;
+	    else if (r < 255)
+	      *pixels++ = r;
+	    else
+	      *pixels++ = 255;
+
+            if (g <= 0)
+	      *pixels++ = 0;
+	    else if (g < 255)
+	      *pixels++ = g;
+	    else
+	      *pixels++ = 255;
+
+            if (b <= 0)
+	      *pixels++ = 0;
+	    else if (b < 255)
+	      *pixels++ = b;
+	    else
+	      *pixels++ = 255;
+          }
+          break;
+    }
+  }
+}
+
+
+//
+// 'convert_w()' - Convert grayscale raster data.
+//
+
+static void
+convert_w(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - Grayscale pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	bit,				// Current bit
+	byte;				// Current byte
+
+
+  w = header->cupsWidth;
+
+  switch (header->cupsBitsPerColor)
+  {
+    case 1 :
+        for (x = w, bit = 0x80, byte = *line++; x > 0; x --)
+	{
+	  if (byte & bit)
+	  {
+	    *colors++ = 1;
+	    pixels ++;
+	  }
+	  else
+	  {
+	    colors ++;
+	    *pixels++ = 0;
+	  }
+
+          if (bit > 1)
+	    bit >>= 1;
+	  else
+	  {
+	    bit  = 0x80;
+	    byte = *line++;
+	  }
+        }
+        break;
+    case 2 :
+        for (x = w; x > 0; x -= 4)
+	{
+	  byte = *line++;
+
+	  *colors++ = val = (byte & 0xc0) >> 6;
+	  *pixels++ = 85 * val;
+
+	  if (x > 1)
+	  {
+	    *colors++ = val = (byte & 0x30) >> 4;
+	    *pixels++ = 85 * val;
+	  }
+
+	  if (x > 2)
+	  {
+	    *colors++ = val = (byte & 0x0c) >> 2;
+	    *pixels++ = 85 * val;
+	  }
+
+	  if (x > 3)
+	  {
+	    *colors++ = val = byte & 0x03;
+	    *pixels++ = 85 * val;
+	  }
+        }
+        break;
+    case 4 :
+        for (x = w; x > 0; x -= 2)
+	{
+	  byte = *line++;
+
+          *colors++ = val = (byte & 0xf0) >> 4;
+	  *pixels++ = 17 * val;
+
+	  if (x > 1)
+	  {
+            *colors++ = val = byte & 0x0f;
+	    *pixels++ = 17 * val;
+	  }
+        }
+        break;
+    case 8 :
+        memcpy(colors, line, w);
+        memcpy(pixels, line, w);
+        break;
+    case 16 :
+	if (endian_offset)
+	{
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *line++;
+	    *colors++ = *pixels++ = *line++;
+          }
+	}
+	else
+	{
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = *pixels++ = *line++;
+	    *colors++ = *line++;
+          }
+	}
+        break;
+  }
+}
+
+
+//
+// 'convert_xyz()' - Convert CIE XYZ raster data.
+//
+
+static void
+convert_xyz(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int			x,		// X position in line
+			w,		// Width of line
+			val;		// Pixel value
+  unsigned short	*sline;		// 16-bit pixels
+  float			xyz[3],		// XYZ color
+			rgb[3];		// RGB color
+
+
+  w = header->cupsWidth;
+
+  for (x = w, sline = (unsigned short *)line; x > 0; x --)
+  {
+    // Extract the Lab color value...
+    if (header->cupsBitsPerColor == 8)
+    {
+      // 8-bit color values...
+      *colors++ = val = *line++;
+      xyz[0]    = val / 231.8181f;
+      *colors++ = val = *line++;
+      xyz[1]    = val / 231.8181f;
+      *colors++ = val = *line++;
+      xyz[2]    = val / 231.8181f;
+    }
+    else
+    {
+      // 16-bit color values...
+      *colors++ = *line++;
+      *colors++ = *line++;
+      *colors++ = *line++;
+      *colors++ = *line++;
+      *colors++ = *line++;
+      *colors++ = *line++;
+
+      xyz[0] = *sline++ / 59577.2727f;
+      xyz[1] = *sline++ / 59577.2727f;
+      xyz[2] = *sline++ / 59577.2727f;
+    }
+
+    // Convert XYZ to sRGB...
+    rgb[0] =  3.240479f * xyz[0] - 1.537150f * xyz[1] - 0.498535f * xyz[2];
+    rgb[1] = -0.969256f * xyz[0] + 1.875992f * xyz[1] + 0.041556f * xyz[2];
+    rgb[2] =  0.055648f * xyz[0] - 0.204043f * xyz[1] + 1.057311f * xyz[2];
+
+    rgb[0] = rgb[0] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[0], 0.41666) - 0.055f;
+    rgb[1] = rgb[1] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[1], 0.41666) - 0.055f;
+    rgb[2] = rgb[2] <= 0.0 ? 0.0 : 1.055f * pow((double)rgb[2], 0.41666) - 0.055f;
+
+    // Save it...
+    if (rgb[0] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[0] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[0] + 0.5);
+    else
+      *pixels++ = 255;
+
+    if (rgb[1] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[1] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[1] + 0.5);
+    else
+      *pixels++ = 255;
+
+    if (rgb[2] <= 0.0f)
+      *pixels++ = 0;
+    else if (rgb[2] < 1.0f)
+      *pixels++ = (int)(255.0f * rgb[2] + 0.5);
+    else
+      *pixels++ = 255;
+  }
+}
+
+
+//
+// 'convert_ymc()' - Convert YMC raster data.
+//
+
+static void
+convert_ymc(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	bit;				// Current bit
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit       = *line++;
+	    *colors++ = bit >> 4;
+
+	    if (bit & 0x40)
+	      pixels[2] = 0;
+	    if (bit & 0x20)
+	      pixels[1] = 0;
+	    if (bit & 0x10)
+	      pixels[0] = 0;
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x04)
+		pixels[5] = 0;
+	      if (bit & 0x02)
+		pixels[4] = 0;
+	      if (bit & 0x01)
+		pixels[3] = 0;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --, pixels += 3)
+	  {
+	    *colors++ = bit = *line++;
+
+	    pixels[2] = 255 - 85 * ((bit & 0x30) >> 4);
+	    pixels[1] = 255 - 85 * ((bit & 0x0c) >> 2);
+	    pixels[0] = 255 - 85 * (bit & 0x03);
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --, pixels += 3)
+	  {
+	    *colors++ = bit = *line++;
+
+	    pixels[2] = 255 - 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+
+	    pixels[1] = 255 - 17 * ((bit & 0xf0) >> 4);
+	    pixels[0] = 255 - 17 * (bit & 0x0f);
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --, pixels += 3)
+	  {
+	    *colors++ = val = *line++;
+	    pixels[2] = 255 - val;
+
+	    *colors++ = val = *line++;
+	    pixels[1] = 255 - val;
+
+	    *colors++ = val = *line++;
+	    pixels[0] = 255 - val;
+          }
+          break;
+      case 16 :
+	  if (endian_offset)
+	  {
+            for (x = w; x > 0; x --, pixels += 3)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      pixels[2] = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      pixels[1] = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      pixels[0] = 255 - val;
+	    }
+          }
+	  else
+	  {
+            for (x = w; x > 0; x --, pixels += 3)
+	    {
+	      *colors++ = val = *line++;
+	      pixels[2] = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      pixels[1] = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      pixels[0] = 255 - val;
+	      *colors++ = *line++;
+	    }
+	  }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    yptr = line;
+    mptr = line + bytespercolor;
+    cptr = line + 2 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*yptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[2] = 0;
+	    }
+	    else
+	      colors ++;
+
+	    if (*mptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[1] = 0;
+	    }
+	    else
+	      colors ++;
+
+	    if (*cptr & bit)
+	    {
+	      *colors++ = 1;
+	      pixels[0] = 0;
+	    }
+	    else
+	      colors ++;
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      cptr ++;
+	      mptr ++;
+	      yptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++, pixels += 3)
+	  {
+	    switch (x & 3)
+	    {
+	      case 0 :
+	          *colors++ = val = (*yptr & 0xc0) >> 6;
+		  pixels[2] = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0xc0) >> 6;
+		  pixels[1] = 255 - 85 * val;
+	          *colors++ = val = (*cptr & 0xc0) >> 6;
+		  pixels[0] = 255 - 85 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = (*yptr & 0x30) >> 4;
+		  pixels[2] = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0x30) >> 4;
+		  pixels[1] = 255 - 85 * val;
+	          *colors++ = val = (*cptr & 0x30) >> 4;
+		  pixels[0] = 255 - 85 * val;
+                  break;
+	      case 2 :
+	          *colors++ = val = (*yptr & 0x0c) >> 2;
+		  pixels[2] = 255 - 85 * val;
+	          *colors++ = val = (*mptr & 0x0c) >> 2;
+		  pixels[1] = 255 - 85 * val;
+	          *colors++ = val = (*cptr & 0x0c) >> 2;
+		  pixels[0] = 255 - 85 * val;
+                  break;
+	      case 3 :
+	          *colors++ = val = *yptr & 0x03;
+		  pixels[2] = 255 - 85 * val;
+	          *colors++ = val = *mptr & 0x03;
+		  pixels[1] = 255 - 85 * val;
+	          *colors++ = val = *cptr & 0x03;
+		  pixels[0] = 255 - 85 * val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++, pixels += 3)
+	  {
+	    switch (x & 1)
+	    {
+	      case 0 :
+	          *colors++ = val = (*yptr & 0xf0) >> 4;
+		  pixels[2] = 255 - 17 * val;
+	          *colors++ = val = (*mptr & 0xf0) >> 4;
+		  pixels[1] = 255 - 17 * val;
+	          *colors++ = val = (*cptr & 0xf0) >> 4;
+		  pixels[0] = 255 - 17 * val;
+                  break;
+	      case 1 :
+	          *colors++ = val = *yptr & 0x0f;
+		  pixels[2] = 255 - 17 * val;
+	          *colors++ = val = *mptr & 0x0f;
+		  pixels[1] = 255 - 17 * val;
+	          *colors++ = val = *cptr & 0x0f;
+		  pixels[0] = 255 - 17 * val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+                  break;
+	    }
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --, pixels += 3)
+	  {
+	    *colors++ = val = *yptr++;
+	    pixels[2] = 255 - val;
+
+	    *colors++ = val = *mptr++;
+	    pixels[1] = 255 - val;
+
+	    *colors++ = val = *cptr++;
+	    pixels[0] = 255 - val;
+          }
+          break;
+      case 16 :
+          if (endian_offset)
+	  {
+            for (x = w; x > 0; x --, pixels += 3)
+	    {
+	      *colors++ = *yptr++;
+	      *colors++ = val = *yptr++;
+	      pixels[2] = 255 - val;
+
+	      *colors++ = *mptr++;
+	      *colors++ = val = *mptr++;
+	      pixels[1] = 255 - val;
+
+	      *colors++ = *cptr++;
+	      *colors++ = val = *cptr++;
+	      pixels[0] = 255 - val;
+            }
+          }
+	  else
+	  {
+            for (x = w; x > 0; x --, pixels += 3)
+	    {
+	      *colors++ = val = *yptr++;
+	      pixels[2] = 255 - val;
+	      *colors++ = *yptr++;
+
+	      *colors++ = val = *mptr++;
+	      pixels[1] = 255 - val;
+	      *colors++ = *mptr++;
+
+	      *colors++ = val = *cptr++;
+	      pixels[0] = 255 - val;
+	      *colors++ = *cptr++;
+            }
+          }
+	  break;
+    }
+  }
+}
+
+
+//
+// 'convert_ymck()' - Convert YMCK, GMCK, or GMCS raster data.
+//
+
+static void
+convert_ymck(
+    cups_page_header_t *header,	// I - Raster header */
+    uchar               *line,		// I - Raster line
+    uchar               *colors,	// O - Original pixels
+    uchar               *pixels)	// O - RGB pixels
+{
+  int	x,				// X position in line
+	w,				// Width of line
+	val;				// Pixel value
+  uchar	*cptr,				// Cyan pointer
+	*mptr,				// Magenta pointer
+	*yptr,				// Yellow pointer
+	*kptr,				// Black pointer
+	bit;				// Current bit
+  int	r, g, b, k;			// Current RGB color + K
+
+
+  w = header->cupsWidth;
+
+  if (header->cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    // Chunky
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w; x > 0; x -= 2, pixels += 6)
+	  {
+	    bit       = *line++;
+	    *colors++ = bit >> 4;
+
+            if (bit & 0x10)
+	    {
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      if (bit & 0x80)
+		pixels[2] = 0;
+	      if (bit & 0x40)
+		pixels[1] = 0;
+	      if (bit & 0x20)
+		pixels[0] = 0;
+	    }
+
+	    if (x > 1)
+	    {
+	      *colors++ = bit & 0x0f;
+
+	      if (bit & 0x01)
+	      {
+		pixels[3] = 0;
+		pixels[4] = 0;
+		pixels[5] = 0;
+	      }
+	      else
+	      {
+		if (bit & 0x08)
+	          pixels[5] = 0;
+		if (bit & 0x04)
+	          pixels[4] = 0;
+		if (bit & 0x02)
+	          pixels[3] = 0;
+	      }
+	    }
+          }
+          break;
+      case 2 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    k = 85 * (bit & 0x03);
+	    b = 255 - 85 * ((bit & 0xc0) >> 6) - k;
+	    g = 255 - 85 * ((bit & 0x30) >> 4) - k;
+	    r = 255 - 85 * ((bit & 0x0c) >> 2) - k;
+
+	    if (r < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = bit = *line++;
+
+	    b = 255 - 17 * ((bit & 0xf0) >> 4);
+	    g = 255 - 17 * (bit & 0x0f);
+
+	    *colors++ = bit = *line++;
+
+	    r = 255 - 17 * ((bit & 0xf0) >> 4);
+	    k = 17 * (bit & 0x0f);
+
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    *colors++ = val = *line++;
+	    b         = 255 - val;
+
+	    *colors++ = val = *line++;
+	    g         = 255 - val;
+
+	    *colors++ = val = *line++;
+	    r         = 255 - val;
+
+	    *colors++ = k = *line++;
+
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+	    if (endian_offset)
+	    {
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      b         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      g         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = val = *line++;
+	      r         = 255 - val;
+
+	      *colors++ = *line++;
+	      *colors++ = k = *line++;
+	    }
+	    else
+	    {
+	      *colors++ = val = *line++;
+	      b         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      g         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = val = *line++;
+	      r         = 255 - val;
+	      *colors++ = *line++;
+
+	      *colors++ = k = *line++;
+	      *colors++ = *line++;
+	    }
+
+	    r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b < 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+    }
+  }
+  else
+  {
+    // Banded
+    int bytespercolor = (header->cupsBitsPerColor * header->cupsWidth + 7) / 8;
+
+
+    yptr = line;
+    mptr = line + bytespercolor;
+    cptr = line + 2 * bytespercolor;
+    kptr = line + 3 * bytespercolor;
+
+    switch (header->cupsBitsPerColor)
+    {
+      case 1 :
+          for (x = w, bit = 0x80; x > 0; x --, pixels += 3)
+	  {
+	    if (*yptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*mptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*cptr & bit)
+	      *colors++ = 1;
+	    else
+	      colors ++;
+
+	    if (*kptr & bit)
+	    {
+	      *colors++ = 1;
+
+	      pixels[0] = 0;
+	      pixels[1] = 0;
+	      pixels[2] = 0;
+	    }
+	    else
+	    {
+	      colors ++;
+
+	      if (*cptr & bit)
+		pixels[0] = 0;
+	      if (*mptr & bit)
+		pixels[1] = 0;
+	      if (*yptr & bit)
+		pixels[2] = 0;
+            }
+
+            if (bit > 1)
+	      bit >>= 1;
+	    else
+	    {
+	      bit = 0x80;
+	      cptr ++;
+	      mptr ++;
+	      yptr ++;
+	      kptr ++;
+	    }
+          }
+          break;
+      case 2 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 3)
+	    {
+	      default :
+	      case 0 :
+	          val       = (*kptr & 0xc0) >> 6;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*yptr & 0xc0) >> 6;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0xc0) >> 6;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*cptr & 0xc0) >> 6;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 1 :
+	          val       = (*kptr & 0x30) >> 4;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*yptr & 0x30) >> 4;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x30) >> 4;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*cptr & 0x30) >> 4;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 2 :
+	          val       = (*kptr & 0x0c) >> 2;
+		  k         = 85 * val;
+
+	          *colors++ = val = (*yptr & 0x0c) >> 2;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*mptr & 0x0c) >> 2;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = (*cptr & 0x0c) >> 2;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+                  break;
+	      case 3 :
+	          val       = *kptr & 0x03;
+		  k         = 85 * val;
+
+	          *colors++ = val = *yptr & 0x03;
+		  b         = 255 - 85 * val - k;
+
+	          *colors++ = val = *mptr & 0x03;
+		  g         = 255 - 85 * val - k;
+
+	          *colors++ = val = *cptr & 0x03;
+		  r         = 255 - 85 * val - k;
+
+	          *colors++ = val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 4 :
+          for (x = 0; x < w; x ++)
+	  {
+	    switch (x & 1)
+	    {
+	      default :
+	      case 0 :
+	          val       = (*kptr & 0xf0) >> 4;
+		  k         = 17 * val;
+	          *colors++ = val = (*yptr & 0xf0) >> 4;
+		  b         = 255 - 17 * val - k;
+	          *colors++ = val = (*mptr & 0xf0) >> 4;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = (*cptr & 0xf0) >> 4;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val;
+                  break;
+	      case 1 :
+	          val       = *kptr & 0x0f;
+		  k         = 17 * val;
+	          *colors++ = val = *yptr & 0x0f;
+		  b         = 255 - 17 * val - k;
+	          *colors++ = val = *mptr & 0x0f;
+		  g         = 255 - 17 * val - k;
+	          *colors++ = val = *cptr & 0x0f;
+		  r         = 255 - 17 * val - k;
+	          *colors++ = val;
+
+		  cptr ++;
+		  mptr ++;
+		  yptr ++;
+		  kptr ++;
+                  break;
+	    }
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 8 :
+          for (x = w; x > 0; x --)
+	  {
+	    k         = *kptr++;
+	    *colors++ = val = *yptr++;
+	    b         = 255 - val - k;
+	    *colors++ = val = *mptr++;
+	    g         = 255 - val - k;
+	    *colors++ = val = *cptr++;
+	    r         = 255 - val - k;
+	    *colors++ = k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+          }
+          break;
+      case 16 :
+          for (x = w; x > 0; x --)
+	  {
+            if (endian_offset)
+	    {
+	      *colors++ = *cptr++;
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val;
+
+	      *colors++ = *mptr++;
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val;
+
+	      *colors++ = *yptr++;
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val;
+
+	      *colors++ = *kptr++;
+	      *colors++ = k = *kptr++;
+            }
+	    else
+            {
+	      *colors++ = val = *cptr++;
+	      r         = 255 - val;
+	      *colors++ = *cptr++;
+
+	      *colors++ = val = *mptr++;
+	      g         = 255 - val;
+	      *colors++ = *mptr++;
+
+	      *colors++ = val = *yptr++;
+	      b         = 255 - val;
+	      *colors++ = *yptr++;
+
+	      *colors++ = k = *kptr++;
+	      *colors++ = *kptr++;
+	    }
+
+            r -= k;
+	    g -= k;
+	    b -= k;
+
+	    if (r <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = r;
+
+	    if (g <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = g;
+
+	    if (b <= 0)
+	      *pixels++ = 0;
+	    else
+	      *pixels++ = b;
+	  }
+          break;
+    }
+  }
+}
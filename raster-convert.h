@@ -0,0 +1,94 @@
+//
+// Raster data conversion functions header file.
+//
+// Copyright 2002-2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef RASTER_CONVERT_H
+#  define RASTER_CONVERT_H
+
+
+//
+// Include necessary headers...
+//
+
+#  include "raster.h"
+#  include <string.h>
+#  ifdef __cplusplus
+extern "C" {
+#  endif // __cplusplus
+
+
+//
+// Functions...
+//
+
+extern void	rasterConvertColors(cups_page_header_t *header, unsigned char device_colors[15][3]);
+extern void	rasterConvertLine(cups_page_header_t *header, int y, unsigned char *line, unsigned char *colors, unsigned char *pixels, unsigned char device_colors[15][3]);
+extern double	rasterInkCoverage(cups_page_header_t *header, double total);
+extern void	rasterRecolorLine(cups_page_header_t *header, unsigned char *colors, unsigned char *pixels, unsigned char device_colors[15][3]);
+
+
+//
+// 'rasterChannelValue()' - Get the value of one channel of an original color.
+//
+// Chunked pixels with less than 8 bits per color hold the channels starting
+// with the most significant bits.  16-bit values are in host byte order...
+//
+// This function is inline so the per-pixel loops in RasterView can use it
+// without a call...
+//
+
+static inline unsigned			// O - Channel value
+rasterChannelValue(
+    cups_page_header_t  *header,		// I - Raster header
+    int                 bpc,		// I - Bytes per color
+    const unsigned char *color,		// I - Original color
+    int                 c)		// I - Channel
+{
+  unsigned short	val16;		// 16-bit value
+  unsigned		val;		// Packed value
+  int			i,		// Looping var
+			bits = (int)header->cupsBitsPerColor;
+					// Bits per channel
+
+
+  if (header->cupsColorOrder != CUPS_ORDER_CHUNKED)
+  {
+    // Banded or planar, one value per channel...
+    color += c * bpc / (int)header->cupsNumColors;
+
+    if (bits == 16)
+    {
+      memcpy(&val16, color, sizeof(val16));
+      return (val16);
+    }
+    else
+      return (*color);
+  }
+
+  switch (bits)
+  {
+    case 16 :
+        memcpy(&val16, color + 2 * c, sizeof(val16));
+        return (val16);
+
+    case 8 :
+        return (color[c]);
+
+    default :
+        for (i = 0, val = 0; i < bpc; i ++)
+          val = (val << 8) | color[i];
+
+        return ((val >> ((int)(header->cupsNumColors - 1 - (unsigned)c) * bits)) & ((1U << bits) - 1));
+  }
+}
+
+
+#  ifdef __cplusplus
+}
+#  endif // __cplusplus
+#endif // !RASTER_CONVERT_H
@@ -0,0 +1,540 @@
+//
+// Raster page copying functions for RasterView.
+//
+// Pages are copied as byte ranges of the source file after its file header,
+// so the raster data is never decoded or compressed again.  Only the page
+// counts in the Apple file header and PWG page headers are updated.  Plain files are
+// copied with copy_file_range() on Linux, which lets the kernel (or the file
+// system) move the data without going through user space.  Other systems and
+// gzip'd files fall back on reading and writing the data.
+//
+// Copyright 2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE			// For copy_file_range()
+#endif // __linux__ && !_GNU_SOURCE
+#include "raster-pages.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <io.h>
+typedef int ssize_t;			// Return type of read() and write()
+#else
+#  include <unistd.h>
+#endif // _WIN32
+#ifndef O_BINARY
+#  define O_BINARY	0		// No text mode on POSIX
+#endif // !O_BINARY
+
+
+//
+// Constants...
+//
+
+#define RASTER_PAGES_BUFFER	1048576	// Size of copy buffer
+#define RASTER_PAGES_HEADER	12	// Maximum size of file header
+#define RASTER_PAGES_PAGEHDR	1796	// Size of PWG page header
+#define RASTER_PAGES_COUNT	452	// Offset of TotalPageCount in PWG page header
+
+
+//
+// Local functions...
+//
+
+static int	copy_fd(int dst, int src, z_off_t start, z_off_t length, unsigned char *buffer);
+static int	copy_gz(int dst, gzFile src, z_off_t start, z_off_t length, unsigned char *buffer);
+static int	read_at(gzFile gz, int src, z_off_t start, unsigned char *buffer, size_t length);
+static int	same_file(const char *a, const char *b);
+static int	write_all(int fd, const unsigned char *buffer, size_t bytes);
+
+
+//
+// 'rasterCopyPages()' - Copy pages from one raster file to a new one.
+//
+// The file header (the sync word and, for Apple raster, the page count) is
+// copied first, followed by the byte ranges of each page in order.  Adjacent
+// pages are copied as a single range.  The Apple raster page count and the
+// TotalPageCount of each PWG page header are updated to match the new file.
+// The new file can't be the source file.  On failure `errno` holds the error
+// and the new file is removed if this call created it.
+//
+
+int					// O - 1 on success, 0 on failure
+rasterCopyPages(
+    const char            *dstfile,	// I - New raster file
+    const char            *srcfile,	// I - Source raster file
+    z_off_t               header,	// I - Size of file header in bytes
+    const raster_extent_t *pages,	// I - Byte ranges of pages to copy
+    int                   num_pages)	// I - Number of pages to copy
+{
+  int		i, j;			// Looping vars
+  gzFile	gz;			// Source file
+  int		src = -1,		// Source file descriptor for plain files
+		dst;			// New file
+  unsigned char	fileheader[RASTER_PAGES_HEADER],
+					// File header
+		*buffer;		// Copy buffer
+  z_off_t	start,			// Start of range
+		end;			// End of range
+  int		status = 1,		// Return status
+		error,			// Saved errno
+		created = 1,		// Did we create the new file?
+		pwg = 0;		// Update PWG page headers?
+
+
+  if (header < 4 || header > RASTER_PAGES_HEADER || !pages || num_pages < 1)
+  {
+    errno = EINVAL;
+    return (0);
+  }
+
+  if (same_file(srcfile, dstfile))
+  {
+    errno = EEXIST;
+    return (0);
+  }
+
+  if ((gz = gzopen(srcfile, "rb")) == NULL)
+    return (0);
+
+  if (gzread(gz, fileheader, (unsigned)header) != (int)header)
+  {
+    gzclose(gz);
+    errno = EIO;
+    return (0);
+  }
+
+  if (header == RASTER_PAGES_HEADER && !memcmp(fileheader, "UNIRAST", 8))
+  {
+    // Update the Apple raster page count...
+    fileheader[8]  = (unsigned char)(num_pages >> 24);
+    fileheader[9]  = (unsigned char)(num_pages >> 16);
+    fileheader[10] = (unsigned char)(num_pages >> 8);
+    fileheader[11] = (unsigned char)num_pages;
+  }
+  else if (header == 4 && !memcmp(fileheader, "RaS2", 4))
+  {
+    // PWG raster has the page count in each page header...
+    unsigned char	pageheader[64];	// Start of first page header
+
+    pwg = gzread(gz, pageheader, sizeof(pageheader)) == (int)sizeof(pageheader) && !strcmp((char *)pageheader, "PwgRaster");
+  }
+
+  // Plain files are copied using the file descriptor so the data can be
+  // copied by the kernel...
+  if (gzdirect(gz) && (src = open(srcfile, O_RDONLY | O_BINARY)) >= 0)
+  {
+    gzclose(gz);
+    gz = NULL;
+  }
+
+  if ((buffer = malloc(RASTER_PAGES_BUFFER)) == NULL)
+  {
+    error = errno;
+    if (gz)
+      gzclose(gz);
+    else
+      close(src);
+    errno = error;
+    return (0);
+  }
+
+  if ((dst = open(dstfile, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0666)) < 0 && errno == EEXIST)
+  {
+    created = 0;
+    dst     = open(dstfile, O_WRONLY | O_TRUNC | O_BINARY);
+  }
+
+  if (dst < 0)
+  {
+    error = errno;
+    free(buffer);
+    if (gz)
+      gzclose(gz);
+    else
+      close(src);
+    errno = error;
+    return (0);
+  }
+
+  if (!write_all(dst, fileheader, (size_t)header))
+    status = 0;
+
+  for (i = 0; status && i < num_pages; i = j)
+  {
+    // Merge pages that follow each other in the source file...
+    start = pages[i].start;
+    end   = pages[i].end;
+
+    for (j = i + 1; !pwg && j < num_pages && pages[j].start == end; j ++)
+      end = pages[j].end;
+
+    if (start < header || end < start || (pwg && end - start < RASTER_PAGES_PAGEHDR))
+    {
+      errno  = EINVAL;
+      status = 0;
+      break;
+    }
+
+    if (pwg)
+    {
+      // Copy the page header with the new page count...
+      if (!read_at(gz, src, start, buffer, RASTER_PAGES_PAGEHDR))
+      {
+        status = 0;
+        break;
+      }
+
+      buffer[RASTER_PAGES_COUNT]     = (unsigned char)(num_pages >> 24);
+      buffer[RASTER_PAGES_COUNT + 1] = (unsigned char)(num_pages >> 16);
+      buffer[RASTER_PAGES_COUNT + 2] = (unsigned char)(num_pages >> 8);
+      buffer[RASTER_PAGES_COUNT + 3] = (unsigned char)num_pages;
+
+      if (!write_all(dst, buffer, RASTER_PAGES_PAGEHDR))
+      {
+        status = 0;
+        break;
+      }
+
+      start += RASTER_PAGES_PAGEHDR;
+    }
+
+    if (gz)
+      status = copy_gz(dst, gz, start, end - start, buffer);
+    else
+      status = copy_fd(dst, src, start, end - start, buffer);
+  }
+
+  error = errno;
+
+  if (close(dst) && status)
+  {
+    error  = errno;
+    status = 0;
+  }
+
+  if (!status && created)
+    remove(dstfile);
+
+  free(buffer);
+
+  if (gz)
+    gzclose(gz);
+  else
+    close(src);
+
+  errno = error;
+
+  return (status);
+}
+
+
+//
+// 'rasterPageRanges()' - Parse a list of page ranges.
+//
+// The list contains page numbers and ranges separated by commas, for example
+// "1-3,7,10-".  Each range is stored as a first and last page number, with an
+// open-ended range ending at `INT_MAX`.
+//
+
+int					// O - Number of ranges or -1 on error
+rasterPageRanges(const char *s,		// I - Page list
+                 int        *ranges,	// O - First and last page of each range
+                 int        max_ranges)	// I - Maximum number of ranges
+{
+  int	num_ranges = 0;			// Number of ranges
+  long	first,				// First page in range
+	last;				// Last page in range
+  char	*ptr;				// Pointer into list
+
+
+  if (!s || !*s)
+    return (-1);
+
+  while (*s)
+  {
+    if (num_ranges >= max_ranges)
+      return (-1);
+
+    while (*s == ' ')
+      s ++;
+
+    if (*s == '-')
+    {
+      first = 1;
+    }
+    else
+    {
+      first = strtol(s, &ptr, 10);
+
+      if (ptr == s)
+        return (-1);
+
+      s = ptr;
+    }
+
+    if (*s == '-')
+    {
+      s ++;
+
+      if (isdigit(*s & 255))
+      {
+        last = strtol(s, &ptr, 10);
+        s    = ptr;
+      }
+      else
+        last = INT_MAX;
+    }
+    else
+      last = first;
+
+    while (*s == ' ')
+      s ++;
+
+    if (first < 1 || last < first || first > INT_MAX || last > INT_MAX || (*s && *s != ','))
+      return (-1);
+
+    ranges[2 * num_ranges]     = (int)first;
+    ranges[2 * num_ranges + 1] = (int)last;
+    num_ranges ++;
+
+    if (*s == ',')
+    {
+      s ++;
+
+      if (!*s)
+        return (-1);
+    }
+  }
+
+  return (num_ranges);
+}
+
+
+//
+// 'copy_fd()' - Copy a range of a plain file.
+//
+
+static int				// O - 1 on success, 0 on failure
+copy_fd(int           dst,		// I - New file
+        int           src,		// I - Source file
+        z_off_t       start,		// I - Offset in source file
+        z_off_t       length,		// I - Number of bytes to copy
+        unsigned char *buffer)		// I - Copy buffer
+{
+  ssize_t	bytes;			// Bytes copied
+
+
+#ifdef __linux__
+  // Let the kernel copy the data, falling back on reading and writing it if
+  // the files don't support it...
+  loff_t	offset = (loff_t)start;	// Offset in source file
+
+  while (length > 0)
+  {
+    if ((bytes = copy_file_range(src, &offset, dst, NULL, length > INT_MAX ? INT_MAX : (size_t)length, 0)) > 0)
+    {
+      length -= bytes;
+    }
+    else if (bytes == 0)
+    {
+      // Source file is truncated...
+      errno = EIO;
+      return (0);
+    }
+    else if (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)
+    {
+      break;
+    }
+    else if (errno != EINTR)
+    {
+      return (0);
+    }
+  }
+
+  start = (z_off_t)offset;
+
+  if (length == 0)
+    return (1);
+#endif // __linux__
+
+  if (lseek(src, start, SEEK_SET) < 0)
+    return (0);
+
+  while (length > 0)
+  {
+    if ((bytes = read(src, buffer, length > RASTER_PAGES_BUFFER ? RASTER_PAGES_BUFFER : (size_t)length)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return (0);
+    }
+    else if (bytes == 0)
+    {
+      errno = EIO;
+      return (0);
+    }
+
+    if (!write_all(dst, buffer, (size_t)bytes))
+      return (0);
+
+    length -= bytes;
+  }
+
+  return (1);
+}
+
+
+//
+// 'copy_gz()' - Copy a range of a gzip'd file.
+//
+
+static int				// O - 1 on success, 0 on failure
+copy_gz(int           dst,		// I - New file
+        gzFile        src,		// I - Source file
+        z_off_t       start,		// I - Offset in source data
+        z_off_t       length,		// I - Number of bytes to copy
+        unsigned char *buffer)		// I - Copy buffer
+{
+  int	bytes;				// Bytes read
+
+
+  if (gzseek(src, start, SEEK_SET) != start)
+  {
+    errno = EIO;
+    return (0);
+  }
+
+  while (length > 0)
+  {
+    if ((bytes = gzread(src, buffer, length > RASTER_PAGES_BUFFER ? RASTER_PAGES_BUFFER : (unsigned)length)) <= 0)
+    {
+      errno = EIO;
+      return (0);
+    }
+
+    if (!write_all(dst, buffer, (size_t)bytes))
+      return (0);
+
+    length -= bytes;
+  }
+
+  return (1);
+}
+
+
+//
+// 'read_at()' - Read bytes at an offset in the source file.
+//
+
+static int				// O - 1 on success, 0 on failure
+read_at(gzFile        gz,		// I - Source gzip'd file or `NULL`
+        int           src,		// I - Source plain file
+        z_off_t       start,		// I - Offset in source data
+        unsigned char *buffer,		// I - Buffer
+        size_t        length)		// I - Number of bytes to read
+{
+  ssize_t	bytes;			// Bytes read
+
+
+  if (gz)
+  {
+    if (gzseek(gz, start, SEEK_SET) != start || gzread(gz, buffer, (unsigned)length) != (int)length)
+    {
+      errno = EIO;
+      return (0);
+    }
+
+    return (1);
+  }
+
+  if (lseek(src, start, SEEK_SET) < 0)
+    return (0);
+
+  while (length > 0)
+  {
+    if ((bytes = read(src, buffer, length)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return (0);
+    }
+    else if (bytes == 0)
+    {
+      errno = EIO;
+      return (0);
+    }
+
+    buffer += bytes;
+    length -= (size_t)bytes;
+  }
+
+  return (1);
+}
+
+
+//
+// 'same_file()' - Check whether two filenames refer to the same file.
+//
+
+static int				// O - 1 if the same file, 0 otherwise
+same_file(const char *a,		// I - First filename
+          const char *b)		// I - Second filename
+{
+#ifdef _WIN32
+  char	apath[1024],			// Absolute first filename
+	bpath[1024];			// Absolute second filename
+
+
+  return (_fullpath(apath, a, sizeof(apath)) && _fullpath(bpath, b, sizeof(bpath)) && !_stricmp(apath, bpath));
+
+#else
+  struct stat	ainfo,			// First file information
+		binfo;			// Second file information
+
+
+  return (!stat(a, &ainfo) && !stat(b, &binfo) && ainfo.st_dev == binfo.st_dev && ainfo.st_ino == binfo.st_ino);
+#endif // _WIN32
+}
+
+
+//
+// 'write_all()' - Write a buffer to a file, handling partial writes.
+//
+
+static int				// O - 1 on success, 0 on failure
+write_all(int                 fd,	// I - File
+          const unsigned char *buffer,	// I - Data
+          size_t              bytes)	// I - Number of bytes
+{
+  ssize_t	count;			// Bytes written
+
+
+  while (bytes > 0)
+  {
+    if ((count = write(fd, buffer, bytes)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return (0);
+    }
+
+    buffer += count;
+    bytes  -= (size_t)count;
+  }
+
+  return (1);
+}
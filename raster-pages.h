@@ -0,0 +1,53 @@
+//
+// Raster page copying functions header file.
+//
+// Copyright 2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef RASTER_PAGES_H
+#  define RASTER_PAGES_H
+
+
+//
+// Include necessary headers...
+//
+
+#  include <zlib.h>
+#  ifdef __cplusplus
+extern "C" {
+#  endif // __cplusplus
+
+
+//
+// Constants...
+//
+
+#  define RASTER_MAX_RANGES	100	// Maximum page ranges in a list
+
+
+//
+// Types...
+//
+
+typedef struct raster_extent_s		// Byte range of a page in a file
+{
+  z_off_t		start,		// Offset of page header
+			end;		// Offset after page data
+} raster_extent_t;
+
+
+//
+// Functions...
+//
+
+extern int	rasterCopyPages(const char *dstfile, const char *srcfile, z_off_t header, const raster_extent_t *pages, int num_pages);
+extern int	rasterPageRanges(const char *s, int *ranges, int max_ranges);
+
+
+#  ifdef __cplusplus
+}
+#  endif // __cplusplus
+#endif // !RASTER_PAGES_H
@@ -0,0 +1,254 @@
+//
+// PNG image writing functions for RasterView.
+//
+// Images are 8-bit grayscale or RGB.  Rows are filtered, compressed, and
+// written as they are added, so only the current and previous rows are kept
+// in memory.
+//
+// Copyright 2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-png.h"
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+
+//
+// Constants...
+//
+
+#define RASTER_PNG_BUFFER	65536	// Size of compressed data buffer
+
+
+//
+// Types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+struct raster_png_s			// PNG output file
+{
+  FILE			*fp;		// Output file
+  z_stream		stream;		// Deflate stream for image data
+  size_t		bpl;		// Bytes per row
+  uchar			*row,		// Filtered row with filter type byte
+			*prev;		// Previous row
+  uchar			buffer[RASTER_PNG_BUFFER];
+					// Compressed data
+};
+
+
+//
+// Local functions...
+//
+
+static int	png_write_chunk(FILE *fp, const char *type, const uchar *data, size_t length);
+static void	png_write_uint(uchar *buffer, unsigned val);
+
+
+//
+// 'rasterPNGClose()' - Finish the image data and close a PNG file.
+//
+
+int					// O - 1 on success, 0 on failure
+rasterPNGClose(raster_png_t *png)	// I - PNG file
+{
+  int	status = 1;			// Return status
+  int	zstatus;			// Deflate status
+
+
+  if (!png)
+    return (0);
+
+  png->stream.next_in  = NULL;
+  png->stream.avail_in = 0;
+
+  do
+  {
+    png->stream.next_out  = png->buffer;
+    png->stream.avail_out = sizeof(png->buffer);
+
+    zstatus = deflate(&png->stream, Z_FINISH);
+
+    if (zstatus == Z_STREAM_ERROR || !png_write_chunk(png->fp, "IDAT", png->buffer, sizeof(png->buffer) - png->stream.avail_out))
+    {
+      status = 0;
+      break;
+    }
+  }
+  while (zstatus != Z_STREAM_END);
+
+  deflateEnd(&png->stream);
+
+  if (status && !png_write_chunk(png->fp, "IEND", NULL, 0))
+    status = 0;
+
+  if (fclose(png->fp))
+    status = 0;
+
+  free(png->row);
+  free(png->prev);
+  free(png);
+
+  return (status);
+}
+
+
+//
+// 'rasterPNGCreate()' - Create a PNG file and write the image header.
+//
+// The resolution is stored in a pHYs chunk when non-zero.
+//
+
+raster_png_t *				// O - PNG file or `NULL` on error
+rasterPNGCreate(const char *filename,	// I - Filename
+                unsigned   width,	// I - Width in pixels
+                unsigned   height,	// I - Height in pixels
+                int        bpp,		// I - Bytes per pixel (1 = gray, 3 = RGB)
+                unsigned   xdpi,	// I - Horizontal resolution
+                unsigned   ydpi)	// I - Vertical resolution
+{
+  static const uchar signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+					// PNG file signature
+  raster_png_t	*png;			// PNG file
+  uchar		ihdr[13],		// IHDR chunk data
+		phys[9];		// pHYs chunk data
+  unsigned	xppm = (unsigned)(xdpi / 0.0254 + 0.5),
+		yppm = (unsigned)(ydpi / 0.0254 + 0.5);
+					// Resolution in pixels per meter
+
+
+  if ((png = (raster_png_t *)calloc(1, sizeof(raster_png_t))) == NULL)
+    return (NULL);
+
+  png->bpl  = (size_t)width * (size_t)bpp;
+  png->row  = (uchar *)malloc(png->bpl + 1);
+  png->prev = (uchar *)calloc(1, png->bpl);
+
+  if (!png->row || !png->prev || (png->fp = fopen(filename, "wb")) == NULL)
+  {
+    free(png->row);
+    free(png->prev);
+    free(png);
+    return (NULL);
+  }
+
+  png_write_uint(ihdr, width);
+  png_write_uint(ihdr + 4, height);
+  ihdr[8]  = 8;				// Bit depth
+  ihdr[9]  = bpp == 1 ? 0 : 2;		// Color type (gray or RGB)
+  ihdr[10] = 0;				// Compression method
+  ihdr[11] = 0;				// Filter method
+  ihdr[12] = 0;				// Interlace method
+
+  png_write_uint(phys, xppm);
+  png_write_uint(phys + 4, yppm);
+  phys[8] = 1;				// Units are meters
+
+  if (fwrite(signature, sizeof(signature), 1, png->fp) != 1 || !png_write_chunk(png->fp, "IHDR", ihdr, sizeof(ihdr)) || ((xppm || yppm) && !png_write_chunk(png->fp, "pHYs", phys, sizeof(phys))) || deflateInit(&png->stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+  {
+    fclose(png->fp);
+    free(png->row);
+    free(png->prev);
+    free(png);
+    return (NULL);
+  }
+
+  return (png);
+}
+
+
+//
+// 'rasterPNGWriteRow()' - Compress and write a row of pixels to a PNG file.
+//
+// Rows use the "up" filter, which compresses the large areas of unchanged
+// pixels in a typical page well.  Compressed data is written as IDAT chunks
+// as the buffer fills.
+//
+
+int					// O - 1 on success, 0 on failure
+rasterPNGWriteRow(
+    raster_png_t        *png,		// I - PNG file
+    const unsigned char *pixels)	// I - Row of pixels
+{
+  size_t	i;			// Looping var
+
+
+  png->row[0] = 2;			// Up filter
+
+  for (i = 0; i < png->bpl; i ++)
+    png->row[i + 1] = (uchar)(pixels[i] - png->prev[i]);
+
+  memcpy(png->prev, pixels, png->bpl);
+
+  png->stream.next_in  = png->row;
+  png->stream.avail_in = (uInt)(png->bpl + 1);
+
+  while (png->stream.avail_in > 0)
+  {
+    png->stream.next_out  = png->buffer;
+    png->stream.avail_out = sizeof(png->buffer);
+
+    if (deflate(&png->stream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+      return (0);
+
+    if (!png_write_chunk(png->fp, "IDAT", png->buffer, sizeof(png->buffer) - png->stream.avail_out))
+      return (0);
+  }
+
+  return (1);
+}
+
+
+//
+// 'png_write_chunk()' - Write a chunk to a PNG file.
+//
+
+static int				// O - 1 on success, 0 on failure
+png_write_chunk(FILE        *fp,	// I - PNG file
+                const char  *type,	// I - Chunk type
+                const uchar *data,	// I - Chunk data or `NULL`
+                size_t      length)	// I - Length of chunk data
+{
+  uchar		buffer[4];		// Length or CRC
+  uLong		crc;			// CRC of type and data
+
+
+  if (length == 0 && strcmp(type, "IEND"))
+    return (1);				// Don't write empty IDAT chunks
+
+  crc = crc32(0, (const Bytef *)type, 4);
+  if (length > 0)
+    crc = crc32(crc, data, (uInt)length);
+
+  png_write_uint(buffer, (unsigned)length);
+
+  if (fwrite(buffer, 4, 1, fp) != 1 || fwrite(type, 4, 1, fp) != 1)
+    return (0);
+
+  if (length > 0 && fwrite(data, length, 1, fp) != 1)
+    return (0);
+
+  png_write_uint(buffer, (unsigned)crc);
+
+  return (fwrite(buffer, 4, 1, fp) == 1);
+}
+
+
+//
+// 'png_write_uint()' - Store a 32-bit big-endian value.
+//
+
+static void
+png_write_uint(uchar    *buffer,	// I - Buffer
+               unsigned val)		// I - Value
+{
+  buffer[0] = (uchar)(val >> 24);
+  buffer[1] = (uchar)(val >> 16);
+  buffer[2] = (uchar)(val >> 8);
+  buffer[3] = (uchar)val;
+}
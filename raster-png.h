@@ -0,0 +1,44 @@
+//
+// PNG image writing functions header file.
+//
+// Copyright 2023 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef RASTER_PNG_H
+#  define RASTER_PNG_H
+
+
+//
+// Include necessary headers...
+//
+
+#  include <stdio.h>
+#  ifdef __cplusplus
+extern "C" {
+#  endif // __cplusplus
+
+
+//
+// Types...
+//
+
+typedef struct raster_png_s raster_png_t;
+					// PNG output file
+
+
+//
+// Functions...
+//
+
+extern int		rasterPNGClose(raster_png_t *png);
+extern raster_png_t	*rasterPNGCreate(const char *filename, unsigned width, unsigned height, int bpp, unsigned xdpi, unsigned ydpi);
+extern int		rasterPNGWriteRow(raster_png_t *png, const unsigned char *pixels);
+
+
+#  ifdef __cplusplus
+}
+#  endif // __cplusplus
+#endif // !RASTER_PNG_H
@@ -56,6 +56,8 @@ struct _cups_raster_s			// Raster stream data
 			iocount;	// Number of bytes read/written
 #  endif // DEBUG
   unsigned		apple_page_count;// Apple raster page count
+  unsigned		ink_left,	// First ink column in current row
+			ink_right;	// Last ink column in current row (exclusive)
 };
 
 
@@ -66,7 +68,10 @@ struct _cups_raster_s			// Raster stream data
 extern void		_cupsRasterAddError(const char *f, ...) _CUPS_FORMAT(1,2) _CUPS_PRIVATE;
 extern void		_cupsRasterClearError(void) _CUPS_PRIVATE;
 extern const char	*_cupsRasterColorSpaceString(cups_cspace_t cspace) _CUPS_PRIVATE;
+extern bool		_cupsRasterCopyPage(cups_raster_t *r, cups_raster_t *w) _CUPS_PRIVATE;
 extern cups_raster_t	*_cupsRasterNew(cups_raster_cb_t iocb, void *ctx, cups_raster_mode_t mode) _CUPS_PRIVATE;
+extern unsigned		_cupsRasterScanLines(cups_raster_t *r, unsigned lines, unsigned *bbox, unsigned long long *hash) _CUPS_PRIVATE;
+extern unsigned		_cupsRasterSkipLines(cups_raster_t *r, unsigned lines) _CUPS_PRIVATE;
 
 
 #  ifdef __cplusplus
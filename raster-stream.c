@@ -63,8 +63,14 @@ static const char * const cups_modes[] =
 //
 
 static size_t	cupsCopyString(char *dst, const char *src, size_t dstsize);
+static unsigned char cups_raster_clear(cups_raster_t *r);
+static void	cups_raster_hash(unsigned long long *hash, const unsigned char *p, size_t bytes);
+static void	cups_raster_ink(cups_raster_t *r, const unsigned char *p, size_t bytes, size_t offset, size_t span, unsigned char clear, unsigned *ink);
+static void	cups_raster_ink_box(cups_raster_t *r, unsigned rows, unsigned *bbox);
+static void	cups_raster_ink_row(cups_raster_t *r, const unsigned *ink);
 static ssize_t	cups_raster_io(cups_raster_t *r, unsigned char *buf, size_t bytes);
 static ssize_t	cups_raster_read(cups_raster_t *r, unsigned char *buf, size_t bytes);
+static ssize_t	cups_raster_skip(cups_raster_t *r, size_t bytes);
 static int	cups_raster_update(cups_raster_t *r);
 static ssize_t	cups_raster_write(cups_raster_t *r, const unsigned char *pixels);
 static ssize_t	cups_read_fd(void *ctx, unsigned char *buf, size_t bytes);
@@ -207,6 +213,177 @@ cupsRasterClose(cups_raster_t *r)	// I - Stream to free
 }
 
 
+//
+// '_cupsRasterCopyPage()' - Copy the rest of a page without decoding it.
+//
+// The page header must already be written to the output stream, which must
+// use the same compression and byte order as the input stream.  Compressed
+// lines are copied a record at a time with their line repeat counts and tokens
+// unchanged, except that counts running past the end of the line or page are
+// trimmed.  This must be called on a line boundary.
+//
+
+bool					// O - `true` on success, `false` on failure
+_cupsRasterCopyPage(
+    cups_raster_t *r,			// I - Input raster stream
+    cups_raster_t *w)			// I - Output raster stream
+{
+  unsigned char	*buffer,		// Copy buffer
+		*bufptr,		// Pointer into buffer
+		*bufend,		// End of buffer
+		byte;			// Byte from file
+  unsigned	cupsBytesPerLine,	// cupsBytesPerLine value
+		lines,			// Lines in record
+		count;			// Bytes in token
+  ssize_t	bytes;			// Bytes left in line
+  size_t	length,			// Bytes to copy
+		total;			// Bytes left in page
+  bool		status = true;		// Return status
+
+
+  DEBUG_printf(("_cupsRasterCopyPage(r=%p, w=%p)", (void *)r, (void *)w));
+
+  if (r == NULL || w == NULL || r->mode != CUPS_RASTER_READ || w->mode == CUPS_RASTER_READ || r->compressed != w->compressed || r->swapped != w->swapped || r->bpp != w->bpp || r->count != 0 || w->count != 0 || w->rowheight > 1 || r->header.cupsBytesPerLine == 0 || r->header.cupsBytesPerLine != w->header.cupsBytesPerLine || r->remaining != w->remaining)
+  {
+    _cupsRasterAddError("Unable to copy raster data between different formats.");
+    return (false);
+  }
+
+  if ((buffer = malloc(65536)) == NULL)
+  {
+    _cupsRasterAddError("Unable to allocate memory for raster data: %s", strerror(errno));
+    return (false);
+  }
+
+  bufend           = buffer + 65536;
+  cupsBytesPerLine = r->header.cupsBytesPerLine;
+
+  if (!r->compressed)
+  {
+    // Copy the lines as-is...
+    for (total = (size_t)r->remaining * cupsBytesPerLine; status && total > 0; total -= length)
+    {
+      if ((length = total) > 65536)
+        length = 65536;
+
+      if (cups_raster_io(r, buffer, length) < (ssize_t)length)
+      {
+        _cupsRasterAddError("Unable to read raster data.");
+        status = false;
+      }
+      else if (cups_raster_io(w, buffer, length) < (ssize_t)length)
+      {
+        _cupsRasterAddError("Unable to write raster data: %s", strerror(errno));
+        status = false;
+      }
+    }
+
+    if (status)
+      r->remaining = w->remaining = 0;
+
+    free(buffer);
+
+    return (status);
+  }
+
+  for (bufptr = buffer; status && r->remaining > 0;)
+  {
+    // Copy the line repeat count...
+    if (!cups_raster_read(r, &byte, 1))
+    {
+      _cupsRasterAddError("Unable to read raster data.");
+      status = false;
+      break;
+    }
+
+    if ((lines = (unsigned)byte + 1) > r->remaining)
+    {
+      lines = r->remaining;
+      byte  = (unsigned char)(lines - 1);
+    }
+
+    *bufptr++ = byte;
+
+    // Then the tokens for the line, flushing the buffer as needed so there is
+    // always room for the longest token...
+    for (bytes = (ssize_t)cupsBytesPerLine; status && bytes > 0;)
+    {
+      if ((bufend - bufptr) < (ssize_t)(128 * r->bpp + 1))
+      {
+        if (cups_raster_io(w, buffer, (size_t)(bufptr - buffer)) < (ssize_t)(bufptr - buffer))
+	{
+	  _cupsRasterAddError("Unable to write raster data: %s", strerror(errno));
+	  status = false;
+	  break;
+	}
+
+        bufptr = buffer;
+      }
+
+      if (!cups_raster_read(r, &byte, 1))
+      {
+	_cupsRasterAddError("Unable to read raster data.");
+	status = false;
+      }
+      else if (byte == 128)
+      {
+        // Clear to end of line...
+        *bufptr++ = byte;
+        bytes     = 0;
+      }
+      else
+      {
+        if (byte & 128)
+        {
+	  // Literal pixels...
+	  if ((length = (size_t)(257 - byte) * r->bpp) > (size_t)bytes)
+	  {
+	    length = (size_t)bytes;
+	    byte   = (unsigned char)(257 - length / r->bpp);
+	  }
+
+          count = (unsigned)length;
+	}
+	else
+	{
+	  // Repeated pixel...
+	  if ((length = ((size_t)byte + 1) * r->bpp) > (size_t)bytes)
+	  {
+	    length = (size_t)bytes;
+	    byte   = (unsigned char)(length / r->bpp - 1);
+	  }
+
+          count = r->bpp;
+	}
+
+        *bufptr++ = byte;
+
+        if (cups_raster_read(r, bufptr, count) < (ssize_t)count)
+	{
+	  _cupsRasterAddError("Unable to read raster data.");
+	  status = false;
+	}
+
+        bufptr += count;
+        bytes  -= (ssize_t)length;
+      }
+    }
+
+    r->remaining -= lines;
+    w->remaining -= lines;
+  }
+
+  if (status && bufptr > buffer && cups_raster_io(w, buffer, (size_t)(bufptr - buffer)) < (ssize_t)(bufptr - buffer))
+  {
+    _cupsRasterAddError("Unable to write raster data: %s", strerror(errno));
+    status = false;
+  }
+
+  free(buffer);
+
+  return (status);
+}
+
 #if 0
 //
 // 'cupsRasterInitHeader()' - Initialize a page header for PWG Raster output.
@@ -1074,6 +1251,286 @@ cupsRasterReadPixels(
 }
 
 
+//
+// '_cupsRasterScanLines()' - Skip raster lines, finding the ink bounding box
+//                            and content hash.
+//
+// Compressed lines are parsed but not expanded, except for the last line when
+// it is repeated past the skipped lines.  Clear-to-end-of-line tokens never
+// hold ink and a repeated pixel gives the extent of its whole run, so only the
+// literal bytes are compared with the clear color.  Uncompressed lines are
+// compared from each end until ink is found.  The bounding box is "left, top,
+// right, bottom" in pixels, with the right and bottom edges exclusive; pass a
+// zeroed box to start a new page - it stays empty for a blank page.
+//
+// The hash covers the page geometry and the line repeat counts and tokens of
+// the compressed data (or the lines of uncompressed data), so identical pages
+// from the same writer get the same hash without expanding them.  Pass a
+// zeroed hash to start a new page.  This must be called on a line boundary.
+//
+
+unsigned				// O  - Number of lines skipped
+_cupsRasterScanLines(
+    cups_raster_t *r,			// I  - Raster stream
+    unsigned      lines,		// I  - Number of lines to skip
+    unsigned      *bbox,		// IO - Ink bounding box or `NULL` for none
+    unsigned long long *hash)		// IO - Content hash or `NULL` for none
+{
+  unsigned	skipped,		// Lines skipped
+		cupsBytesPerLine,	// cupsBytesPerLine value
+		count;			// Repetition count
+  ssize_t	bytes;			// Bytes left in line
+  unsigned char	byte,			// Byte from file
+		*temp,			// Pointer into line buffer
+		clear;			// Clear color
+  int		decode;			// Decode this line?
+  unsigned	ink[2];			// First and last ink bits in line
+  unsigned	total;			// Total lines in page
+
+
+  DEBUG_printf(("_cupsRasterScanLines(r=%p, lines=%u, bbox=%p, hash=%p)", (void *)r, lines, (void *)bbox, (void *)hash));
+
+  if (r == NULL || r->mode != CUPS_RASTER_READ || r->header.cupsBytesPerLine == 0)
+    return (0);
+
+  if (lines > r->remaining)
+    lines = r->remaining;
+
+  cupsBytesPerLine = r->header.cupsBytesPerLine;
+  clear            = cups_raster_clear(r);
+
+  if (r->header.cupsColorOrder == CUPS_ORDER_PLANAR)
+    total = r->header.cupsHeight * r->header.cupsNumColors;
+  else
+    total = r->header.cupsHeight;
+
+  if (hash && r->remaining == total && r->count == 0)
+  {
+    // Start of the page, hash the geometry so that the same data with a
+    // different layout doesn't match.  The values are stored little-endian
+    // so the hash is the same on every host...
+    unsigned		values[8];	// Page geometry
+    unsigned char	geometry[32];	// Page geometry bytes
+    int			i;		// Looping var
+
+    values[0] = r->header.cupsWidth;
+    values[1] = r->header.cupsHeight;
+    values[2] = r->header.cupsBitsPerColor;
+    values[3] = r->header.cupsBitsPerPixel;
+    values[4] = r->header.cupsBytesPerLine;
+    values[5] = (unsigned)r->header.cupsColorOrder;
+    values[6] = (unsigned)r->header.cupsColorSpace;
+    values[7] = r->header.cupsNumColors;
+
+    for (i = 0; i < 8; i ++)
+    {
+      geometry[4 * i]     = (unsigned char)values[i];
+      geometry[4 * i + 1] = (unsigned char)(values[i] >> 8);
+      geometry[4 * i + 2] = (unsigned char)(values[i] >> 16);
+      geometry[4 * i + 3] = (unsigned char)(values[i] >> 24);
+    }
+
+    cups_raster_hash(hash, geometry, sizeof(geometry));
+  }
+
+  if (!r->compressed)
+  {
+    unsigned char	*line;		// Uncompressed line
+
+    if (!bbox && !hash)
+    {
+      // Just skip the data...
+      if (cups_raster_skip(r, (size_t)lines * cupsBytesPerLine) < (ssize_t)((size_t)lines * cupsBytesPerLine))
+      {
+	DEBUG_puts("1_cupsRasterScanLines: Read error, returning 0.");
+	return (0);
+      }
+
+      r->remaining -= lines;
+
+      return (lines);
+    }
+
+    // Read each line to find the ink and hash it...
+    if ((line = malloc(cupsBytesPerLine)) == NULL)
+      return (0);
+
+    for (skipped = 0; skipped < lines; skipped ++)
+    {
+      if (cups_raster_io(r, line, cupsBytesPerLine) < (ssize_t)cupsBytesPerLine)
+      {
+	DEBUG_puts("1_cupsRasterScanLines: Read error.");
+	break;
+      }
+
+      if (bbox)
+      {
+	ink[0] = ink[1] = 0;
+
+	cups_raster_ink(r, line, cupsBytesPerLine, 0, cupsBytesPerLine, clear, ink);
+	cups_raster_ink_row(r, ink);
+	cups_raster_ink_box(r, 1, bbox);
+      }
+
+      if (hash)
+        cups_raster_hash(hash, line, cupsBytesPerLine);
+
+      r->remaining --;
+    }
+
+    free(line);
+
+    DEBUG_printf(("1_cupsRasterScanLines: Returning %u", skipped));
+
+    return (skipped);
+  }
+
+  for (skipped = 0; skipped < lines;)
+  {
+    if (r->count == 0)
+    {
+      // Need to read a new row...
+      if (!cups_raster_read(r, &byte, 1))
+      {
+	DEBUG_puts("1_cupsRasterScanLines: Read error, returning 0.");
+	return (skipped);
+      }
+
+      if (hash)
+        cups_raster_hash(hash, &byte, 1);
+
+      r->count = (unsigned)byte + 1;
+      decode   = r->count > (lines - skipped);
+      temp     = r->pixels;
+      bytes    = (ssize_t)cupsBytesPerLine;
+      ink[0]   = ink[1] = 0;
+
+      while (bytes > 0)
+      {
+        // Get a new repeat count...
+        if (!cups_raster_read(r, &byte, 1))
+	{
+	  DEBUG_puts("1_cupsRasterScanLines: Read error, returning 0.");
+	  return (skipped);
+	}
+
+        if (hash)
+          cups_raster_hash(hash, &byte, 1);
+
+        if (byte == 128)
+        {
+          // Clear to end of line...
+          if (decode)
+	    memset(temp, clear, (size_t)bytes);
+
+          temp += bytes;
+          bytes = 0;
+        }
+	else if (byte & 128)
+	{
+	  // Literal pixels...
+	  count = (unsigned)(257 - byte) * r->bpp;
+
+          if (count > (unsigned)bytes)
+	    count = (unsigned)bytes;
+
+          if (((decode || bbox || hash) && !cups_raster_read(r, temp, count)) || (!decode && !bbox && !hash && cups_raster_skip(r, count) < (ssize_t)count))
+	  {
+	    DEBUG_puts("1_cupsRasterScanLines: Read error, returning 0.");
+	    return (skipped);
+	  }
+
+          if (bbox)
+            cups_raster_ink(r, temp, count, (size_t)(temp - r->pixels), count, clear, ink);
+          if (hash)
+            cups_raster_hash(hash, temp, count);
+
+	  temp  += count;
+	  bytes -= (ssize_t)count;
+	}
+	else
+	{
+	  // Repeated pixel...
+          count = ((unsigned)byte + 1) * r->bpp;
+          if (count > (unsigned)bytes)
+	    count = (unsigned)bytes;
+
+          if (count < r->bpp)
+	    break;
+
+	  bytes -= (ssize_t)count;
+
+          if (((decode || bbox || hash) && !cups_raster_read(r, temp, r->bpp)) || (!decode && !bbox && !hash && cups_raster_skip(r, r->bpp) < (ssize_t)r->bpp))
+	  {
+	    DEBUG_puts("1_cupsRasterScanLines: Read error, returning 0.");
+	    return (skipped);
+	  }
+
+          if (bbox)
+            cups_raster_ink(r, temp, r->bpp, (size_t)(temp - r->pixels), count, clear, ink);
+          if (hash)
+            cups_raster_hash(hash, temp, r->bpp);
+
+          if (decode)
+          {
+	    temp  += r->bpp;
+	    count -= r->bpp;
+
+	    while (count > 0)
+	    {
+	      memcpy(temp, temp - r->bpp, r->bpp);
+	      temp  += r->bpp;
+	      count -= r->bpp;
+	    }
+	  }
+	  else
+	    temp += count;
+	}
+      }
+
+      // Swap bytes as needed...
+      if (decode && (r->header.cupsBitsPerColor == 16 || r->header.cupsBitsPerPixel == 12 || r->header.cupsBitsPerPixel == 16) && r->swapped)
+        cups_swap(r->pixels, (size_t)cupsBytesPerLine);
+
+      r->pcurrent = r->pixels;
+
+      if (bbox)
+        cups_raster_ink_row(r, ink);
+    }
+
+    // Skip repeated copies of the current row...
+    if ((count = r->count) > (lines - skipped))
+      count = lines - skipped;
+
+    if (bbox)
+      cups_raster_ink_box(r, count, bbox);
+
+    r->count     -= count;
+    r->remaining -= count;
+    skipped      += count;
+  }
+
+  DEBUG_printf(("1_cupsRasterScanLines: Returning %u", skipped));
+
+  return (skipped);
+}
+
+
+//
+// '_cupsRasterSkipLines()' - Skip raster lines without decoding them.
+//
+// This must be called on a line boundary.
+//
+
+unsigned				// O - Number of lines skipped
+_cupsRasterSkipLines(
+    cups_raster_t *r,			// I - Raster stream
+    unsigned      lines)		// I - Number of lines to skip
+{
+  return (_cupsRasterScanLines(r, lines, NULL, NULL));
+}
+
+
 //
 // '_cupsRasterWriteHeader()' - Write a raster page header.
 //
@@ -1109,7 +1566,10 @@ cupsRasterWriteHeader(
     r->rowheight = r->header.HWResolution[0] / r->header.HWResolution[1];
 
     if (r->header.HWResolution[0] != (r->rowheight * r->header.HWResolution[1]))
+    {
+      _cupsRasterAddError("Unsupported resolution %ux%u for Apple raster.", r->header.HWResolution[0], r->header.HWResolution[1]);
       return (false);
+    }
   }
   else
     r->rowheight = 1;
@@ -1167,7 +1627,13 @@ cupsRasterWriteHeader(
     fh.cupsInteger[6]        = htonl((unsigned)(r->header.cupsImagingBBox[3] * r->header.HWResolution[1] / 72.0));
     fh.cupsInteger[7]        = htonl(0xffffff);
 
-    return (cups_raster_io(r, (unsigned char *)&fh, sizeof(fh)) == sizeof(fh));
+    if (cups_raster_io(r, (unsigned char *)&fh, sizeof(fh)) != sizeof(fh))
+    {
+      _cupsRasterAddError("Unable to write raster page header: %s", strerror(errno));
+      return (false);
+    }
+
+    return (true);
   }
   else if (r->mode == CUPS_RASTER_WRITE_APPLE)
   {
@@ -1193,7 +1659,10 @@ cupsRasterWriteHeader(
       appleheader[7] = (unsigned char)(r->apple_page_count);
 
       if (cups_raster_io(r, appleheader, 8) != 8)
+      {
+        _cupsRasterAddError("Unable to write raster page header: %s", strerror(errno));
         return (false);
+      }
     }
 
     memset(appleheader, 0, sizeof(appleheader));
@@ -1230,11 +1699,21 @@ cupsRasterWriteHeader(
       }
     }
 
-    return (cups_raster_io(r, appleheader, sizeof(appleheader)) == sizeof(appleheader));
+    if (cups_raster_io(r, appleheader, sizeof(appleheader)) != sizeof(appleheader))
+    {
+      _cupsRasterAddError("Unable to write raster page header: %s", strerror(errno));
+      return (false);
+    }
+
+    return (true);
   }
-  else
-    return (cups_raster_io(r, (unsigned char *)&(r->header), sizeof(r->header))
-		== sizeof(r->header));
+  else if (cups_raster_io(r, (unsigned char *)&(r->header), sizeof(r->header)) != sizeof(r->header))
+  {
+    _cupsRasterAddError("Unable to write raster page header: %s", strerror(errno));
+    return (false);
+  }
+
+  return (true);
 }
 
 
@@ -1383,6 +1862,240 @@ cupsRasterWritePixels(
 }
 
 
+//
+// 'cups_raster_clear()' - Return the clear color for the current page.
+//
+
+static unsigned char			// O - Clear color byte
+cups_raster_clear(cups_raster_t *r)	// I - Raster stream
+{
+  switch (r->header.cupsColorSpace)
+  {
+    case CUPS_CSPACE_W :
+    case CUPS_CSPACE_RGB :
+    case CUPS_CSPACE_SW :
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_RGBW :
+    case CUPS_CSPACE_ADOBERGB :
+        return (0xff);
+
+    default :
+        return (0x00);
+  }
+}
+
+
+//
+// 'cups_raster_hash()' - Add raster data to a content hash.
+//
+// This is FNV-1a applied to 64-bit words, with the high bits folded back in
+// after each multiply so that they affect the rest of the hash.  Words are
+// assembled little-endian so the hash is the same on every host...
+//
+
+static void
+cups_raster_hash(
+    unsigned long long  *hash,		// IO - Hash value
+    const unsigned char *p,		// I  - Raster data
+    size_t              bytes)		// I  - Number of bytes
+{
+  unsigned long long	h = *hash,	// Hash value
+			word;		// Word of data
+
+
+  if (!h)
+    h = 0xcbf29ce484222325ULL;
+
+  for (; bytes >= 8; p += 8, bytes -= 8)
+  {
+    word = (unsigned long long)p[0] |
+           ((unsigned long long)p[1] << 8) |
+           ((unsigned long long)p[2] << 16) |
+           ((unsigned long long)p[3] << 24) |
+           ((unsigned long long)p[4] << 32) |
+           ((unsigned long long)p[5] << 40) |
+           ((unsigned long long)p[6] << 48) |
+           ((unsigned long long)p[7] << 56);
+
+    h = (h ^ word) * 0x100000001b3ULL;
+    h ^= h >> 32;
+  }
+
+  for (; bytes > 0; p ++, bytes --)
+    h = (h ^ *p) * 0x100000001b3ULL;
+
+  *hash = h;
+}
+
+
+//
+// 'cups_raster_ink()' - Add the ink in raster data to the current line.
+//
+// The data is either literal pixels or a single pixel that is repeated to
+// cover "span" bytes.  Ink is tracked in bits from the start of the line - or
+// the start of the band for banded data, since all bands share the same
+// pixel columns.
+//
+
+static void
+cups_raster_ink(
+    cups_raster_t       *r,		// I  - Raster stream
+    const unsigned char *p,		// I  - Raster data
+    size_t              bytes,		// I  - Number of bytes
+    size_t              offset,		// I  - Offset of data in line
+    size_t              span,		// I  - Number of bytes in line covered by data
+    unsigned char       clear,		// I  - Clear color
+    unsigned            *ink)		// IO - First and last (exclusive) ink bits in line
+{
+  size_t	first,			// First ink byte
+		last,			// Last ink byte
+		band;			// Bytes per band
+  unsigned	lo,			// First ink bit
+		hi;			// Last ink bit (exclusive)
+  unsigned char	bits;			// Ink bits in byte
+
+
+  if (r->header.cupsColorOrder == CUPS_ORDER_BANDED && r->header.cupsNumColors > 1)
+    band = r->header.cupsBytesPerLine / r->header.cupsNumColors;
+  else
+    band = r->header.cupsBytesPerLine;
+
+  if (bytes == span && offset / band != (offset + bytes - 1) / band)
+  {
+    // Check literal pixels in each band separately...
+    size_t count = band - offset % band;	// Bytes in this band
+
+    cups_raster_ink(r, p, count, offset, count, clear, ink);
+    cups_raster_ink(r, p + count, bytes - count, offset + count, bytes - count, clear, ink);
+    return;
+  }
+
+  for (first = 0; first < bytes && p[first] == clear; first ++);
+
+  if (first >= bytes)
+    return;
+
+  for (last = bytes - 1; p[last] == clear; last --);
+
+  if ((offset + first) / band == (offset + last + span - bytes) / band)
+  {
+    // Find the first and last ink bits in the first and last ink bytes...
+    lo = (unsigned)((offset + first) % band) * 8;
+    hi = (unsigned)((offset + last + span - bytes) % band) * 8 + 8;
+
+    for (bits = p[first] ^ clear; !(bits & 0x80); bits <<= 1)
+      lo ++;
+
+    for (bits = p[last] ^ clear; !(bits & 1); bits >>= 1)
+      hi --;
+  }
+  else
+  {
+    // Repeated pixels run from one band into the next...
+    lo = 0;
+    hi = (unsigned)band * 8;
+  }
+
+  if (ink[1] == 0 || lo < ink[0])
+    ink[0] = lo;
+  if (hi > ink[1])
+    ink[1] = hi;
+}
+
+
+//
+// 'cups_raster_ink_box()' - Add the ink of the current line to a bounding box.
+//
+
+static void
+cups_raster_ink_box(
+    cups_raster_t *r,			// I  - Raster stream
+    unsigned      rows,			// I  - Number of copies of the current line
+    unsigned      *bbox)		// IO - Ink bounding box
+{
+  unsigned	height = r->header.cupsHeight,
+					// Lines per plane
+		total,			// Total lines in page
+		top,			// First line with ink
+		bottom;			// Last line with ink (exclusive)
+
+
+  if (r->ink_right == 0 || rows == 0 || height == 0)
+    return;
+
+  if (r->header.cupsColorOrder == CUPS_ORDER_PLANAR && r->header.cupsNumColors > 1)
+    total = height * r->header.cupsNumColors;
+  else
+    total = height;
+
+  top    = (total - r->remaining) % height;
+  bottom = top + rows;
+
+  if (bottom > height)
+  {
+    // Repeated line continues into the next plane...
+    top    = 0;
+    bottom = height;
+  }
+
+  if (bbox[2] == 0)
+  {
+    bbox[0] = r->ink_left;
+    bbox[1] = top;
+    bbox[2] = r->ink_right;
+    bbox[3] = bottom;
+    return;
+  }
+
+  if (r->ink_left < bbox[0])
+    bbox[0] = r->ink_left;
+  if (top < bbox[1])
+    bbox[1] = top;
+  if (r->ink_right > bbox[2])
+    bbox[2] = r->ink_right;
+  if (bottom > bbox[3])
+    bbox[3] = bottom;
+}
+
+
+//
+// 'cups_raster_ink_row()' - Save the ink columns of the current line.
+//
+
+static void
+cups_raster_ink_row(
+    cups_raster_t  *r,			// I - Raster stream
+    const unsigned *ink)		// I - First and last (exclusive) ink bits in line
+{
+  unsigned	bits;			// Bits per pixel in a line or band
+
+
+  if (r->header.cupsColorOrder == CUPS_ORDER_CHUNKED)
+    bits = r->header.cupsBitsPerPixel;
+  else
+    bits = r->header.cupsBitsPerColor;
+
+  r->ink_left  = 0;
+  r->ink_right = 0;
+
+  if (ink[1] == 0 || bits == 0)
+    return;
+
+  r->ink_left  = ink[0] / bits;
+  r->ink_right = (ink[1] + bits - 1) / bits;
+
+  if (r->ink_right > r->header.cupsWidth)
+    r->ink_right = r->header.cupsWidth;
+
+  if (r->ink_left >= r->ink_right)
+  {
+    // Only the padding at the end of the line has ink...
+    r->ink_left  = 0;
+    r->ink_right = 0;
+  }
+}
+
+
 //
 // 'cups_raster_io()' - Read/write bytes from a context, handling interruptions.
 //
@@ -1551,6 +2264,43 @@ cups_raster_read(cups_raster_t *r,	// I - Raster stream
 }
 
 
+//
+// 'cups_raster_skip()' - Skip bytes in the raster stream.
+//
+
+static ssize_t				// O - Number of bytes skipped
+cups_raster_skip(cups_raster_t *r,	// I - Raster stream
+                 size_t        bytes)	// I - Number of bytes to skip
+{
+  ssize_t	count,			// Number of bytes read
+		total = 0;		// Total bytes skipped
+  unsigned char	temp[65536];		// Temporary buffer
+
+
+  if (r->compressed && r->bufptr < r->bufend)
+  {
+    // Skip what is already buffered...
+    if ((total = r->bufend - r->bufptr) > (ssize_t)bytes)
+      total = (ssize_t)bytes;
+
+    r->bufptr += total;
+  }
+
+  while (total < (ssize_t)bytes)
+  {
+    if ((count = (ssize_t)bytes - total) > (ssize_t)sizeof(temp))
+      count = (ssize_t)sizeof(temp);
+
+    if (cups_raster_read(r, temp, (size_t)count) < count)
+      break;
+
+    total += count;
+  }
+
+  return (total);
+}
+
+
 //
 // 'cups_raster_update()' - Update the raster header and row count for the
 //                          current page.
@@ -1637,6 +2387,7 @@ cups_raster_update(cups_raster_t *r)	// I - Raster stream
 
       default :
           // Unknown color space
+          _cupsRasterAddError("Unsupported color space %d.", (int)r->header.cupsColorSpace);
           return (0);
     }
   }
@@ -1664,6 +2415,8 @@ cups_raster_update(cups_raster_t *r)	// I - Raster stream
 
     if ((r->pixels = calloc(r->header.cupsBytesPerLine, 1)) == NULL)
     {
+      _cupsRasterAddError("Unable to allocate memory for raster line: %s", strerror(errno));
+
       r->pcurrent = NULL;
       r->pend     = NULL;
       r->count    = 0;
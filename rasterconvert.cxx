@@ -0,0 +1,593 @@
+//
+// Program to convert raster files between the CUPS, PWG, and Apple formats.
+//
+// Usage:
+//
+//   ./rasterconvert --format FORMAT FILENAME OUTPUT
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-private.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+//
+// Constants...
+//
+
+#define RC_PIPE_ROWS	64		// Rows buffered between threads
+
+
+//
+// Local types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+typedef enum rc_format_e		// Raster formats
+{
+  RC_FORMAT_V1,				// CUPS raster version 1
+  RC_FORMAT_V2,				// CUPS raster version 2 (compressed)
+  RC_FORMAT_V3,				// CUPS raster version 3 (uncompressed)
+  RC_FORMAT_PWG,			// PWG raster
+  RC_FORMAT_APPLE			// Apple raster
+} rc_format_t;
+
+typedef struct rc_output_s		// Output file
+{
+  FILE			*fp;		// File
+  bool			v1_sync,	// Write the version 1 sync word next?
+			v1_header;	// Write a version 1 page header next?
+} rc_output_t;
+
+typedef struct rc_pipe_s		// Rows passed from the reading thread
+{
+  cups_raster_t		*ras;		// Input raster stream
+  unsigned		bpl,		// Bytes per line
+			lines;		// Lines in page
+  uchar			*rows;		// Ring of rows
+  unsigned		num_read,	// Number of rows read
+			num_written;	// Number of rows written
+  bool			read_error,	// Unable to read a row?
+			cancel;		// Stop reading?
+  std::mutex		lock;		// Lock for counts
+  std::condition_variable cond;		// Signaled when counts change
+} rc_pipe_t;
+
+
+//
+// Local globals...
+//
+
+static const char * const rc_formats[] =// Format names
+{
+  "v1",
+  "v2",
+  "v3",
+  "pwg",
+  "apple"
+};
+
+
+//
+// Local functions...
+//
+
+static const char *convert_header(rc_format_t from, rc_format_t to, cups_page_header_t *h);
+static rc_format_t input_format(cups_raster_t *ras, cups_page_header_t *h);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static void	read_cb(rc_pipe_t *pipe);
+static void	usage(FILE *out);
+static ssize_t	write_cb(rc_output_t *out, unsigned char *buffer, size_t length);
+static int	write_rows(cups_raster_t *ras, cups_raster_t *outras, cups_page_header_t *h, uchar *rows);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  const char	*filename = NULL,	// Raster file
+		*output = NULL,		// Output file
+		*message;		// Error message
+  int		format = -1;		// Output format (rc_format_t)
+  rc_format_t	from;			// Input format of page
+  gzFile	fp;			// Input file
+  cups_raster_t	*ras,			// Input raster stream
+		*outras;		// Output raster stream
+  rc_output_t	out;			// Output file
+  cups_raster_mode_t mode;		// Output raster mode
+  cups_page_header_t h;			// Page header
+  int		page = 0;		// Current page
+  bool		status = true;		// Conversion status
+  uchar		*rows = NULL;		// Ring of rows for reading thread
+  size_t	alloc_rows = 0;		// Bytes allocated for rows
+
+
+  // Parse command-line
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--format"))
+    {
+      i ++;
+
+      if (i < argc)
+      {
+        for (format = RC_FORMAT_V1; format <= RC_FORMAT_APPLE; format ++)
+        {
+          if (!strcmp(argv[i], rc_formats[format]))
+            break;
+        }
+      }
+
+      if (i >= argc || format > RC_FORMAT_APPLE)
+      {
+        fputs("rasterconvert: Expected 'v1', 'v2', 'v3', 'pwg', or 'apple' after '--format'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+    }
+    else if (argv[i][0] == '-' && argv[i][1])
+    {
+      fprintf(stderr, "rasterconvert: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+    else if (!filename)
+    {
+      filename = argv[i];
+    }
+    else if (!output)
+    {
+      output = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "rasterconvert: Unexpected argument '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+  }
+
+  if (!output || format < 0)
+  {
+    usage(stderr);
+    return (1);
+  }
+
+  // Open the input and output files...
+  if (!strcmp(filename, "-"))
+    fp = gzdopen(0, "r");
+  else
+    fp = gzopen(filename, "r");
+
+  if (!fp)
+  {
+    fprintf(stderr, "rasterconvert: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (1);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rasterconvert: Unable to read '%s': %s\n", filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (1);
+  }
+
+  if (!strcmp(output, "-"))
+    out.fp = stdout;
+  else
+    out.fp = fopen(output, "wb");
+
+  if (!out.fp)
+  {
+    fprintf(stderr, "rasterconvert: Unable to create '%s': %s\n", output, strerror(errno));
+    cupsRasterClose(ras);
+    gzclose(fp);
+    return (1);
+  }
+
+  // The raster stream code doesn't write version 1 files, so write version 3
+  // and let the output callback swap in the version 1 sync word and headers...
+  out.v1_sync   = format == RC_FORMAT_V1;
+  out.v1_header = false;
+
+  switch (format)
+  {
+    case RC_FORMAT_V1 :
+    case RC_FORMAT_V3 :
+        mode = CUPS_RASTER_WRITE;
+        break;
+    case RC_FORMAT_V2 :
+        mode = CUPS_RASTER_WRITE_COMPRESSED;
+        break;
+    case RC_FORMAT_PWG :
+        mode = CUPS_RASTER_WRITE_PWG;
+        break;
+    default :
+        mode = CUPS_RASTER_WRITE_APPLE;
+        break;
+  }
+
+  if ((outras = cupsRasterOpenIO((cups_raster_cb_t)write_cb, &out, mode)) == NULL)
+  {
+    fprintf(stderr, "rasterconvert: Unable to write '%s': %s\n", output, cupsRasterErrorString());
+    status = false;
+  }
+
+  // Convert each page...
+  while (status && cupsRasterReadHeader(ras, &h))
+  {
+    page ++;
+    from = input_format(ras, &h);
+
+    if ((message = convert_header(from, (rc_format_t)format, &h)) != NULL)
+    {
+      fprintf(stderr, "rasterconvert: Page %d of '%s' %s.\n", page, filename, message);
+      status = false;
+      break;
+    }
+
+    out.v1_header = format == RC_FORMAT_V1;
+
+    if (!cupsRasterWriteHeader(outras, &h))
+    {
+      fprintf(stderr, "rasterconvert: Unable to write page %d to '%s': %s\n", page, output, cupsRasterErrorString());
+      status = false;
+      break;
+    }
+
+    out.v1_header = false;
+
+    if ((from == format || ((from == RC_FORMAT_V1 || from == RC_FORMAT_V3) && (format == RC_FORMAT_V1 || format == RC_FORMAT_V3))) && ras->swapped == outras->swapped && outras->rowheight == 1)
+    {
+      // Same encoding, copy the lines without decoding them...
+      if (!_cupsRasterCopyPage(ras, outras))
+      {
+	fprintf(stderr, "rasterconvert: Unable to convert page %d of '%s': %s\n", page, filename, cupsRasterErrorString());
+	status = false;
+      }
+    }
+    else
+    {
+      // Decode the rows in another thread while this one encodes them...
+      size_t bytes = (size_t)RC_PIPE_ROWS * h.cupsBytesPerLine;
+					// Size of row ring
+
+      if (bytes > alloc_rows)
+      {
+        uchar *temp;			// New rows
+
+        if ((temp = (uchar *)realloc(rows, bytes)) == NULL)
+        {
+          fprintf(stderr, "rasterconvert: Unable to allocate memory for page %d.\n", page);
+          status = false;
+          break;
+        }
+
+        rows       = temp;
+        alloc_rows = bytes;
+      }
+
+      switch (write_rows(ras, outras, &h, rows))
+      {
+        case 0 :
+	    fprintf(stderr, "rasterconvert: Unable to write page %d to '%s': %s\n", page, output, strerror(errno));
+	    status = false;
+	    break;
+        case -1 :
+	    fprintf(stderr, "rasterconvert: Page %d of '%s' is truncated.\n", page, filename);
+	    status = false;
+	    break;
+      }
+    }
+  }
+
+  if (status && page == 0)
+  {
+    fprintf(stderr, "rasterconvert: No pages in '%s'.\n", filename);
+    status = false;
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+  cupsRasterClose(outras);
+  free(rows);
+
+  if (out.fp != stdout)
+  {
+    if (fclose(out.fp) && status)
+    {
+      fprintf(stderr, "rasterconvert: Unable to write '%s': %s\n", output, strerror(errno));
+      status = false;
+    }
+
+    if (!status)
+      remove(output);
+  }
+  else if (fflush(stdout) && status)
+  {
+    fprintf(stderr, "rasterconvert: Unable to write to stdout: %s\n", strerror(errno));
+    status = false;
+  }
+
+  return (status ? 0 : 1);
+}
+
+
+//
+// 'convert_header()' - Update a page header for the output format.
+//
+// PWG and Apple raster only support chunked pixels in some color spaces.  CUPS
+// raster pages use the integer fields for driver data, so they are reset to
+// the PWG defaults.  Pages that are already in the output format are copied
+// as-is.
+//
+
+static const char *			// O  - Error message or `NULL` if OK
+convert_header(rc_format_t        from,	// I  - Input format
+               rc_format_t        to,	// I  - Output format
+               cups_page_header_t *h)	// IO - Page header
+{
+  if (from == to || (to != RC_FORMAT_PWG && to != RC_FORMAT_APPLE))
+    return (NULL);
+
+  if (h->cupsColorOrder != CUPS_ORDER_CHUNKED)
+    return ("has banded or planar pixels, which need chunked pixels for PWG and Apple raster");
+
+  if (to == RC_FORMAT_PWG)
+  {
+    if (h->cupsColorSpace != CUPS_CSPACE_RGB && h->cupsColorSpace != CUPS_CSPACE_K && h->cupsColorSpace != CUPS_CSPACE_CMYK && h->cupsColorSpace != CUPS_CSPACE_SW && h->cupsColorSpace != CUPS_CSPACE_SRGB && h->cupsColorSpace != CUPS_CSPACE_ADOBERGB && (h->cupsColorSpace < CUPS_CSPACE_DEVICE1 || h->cupsColorSpace > CUPS_CSPACE_DEVICEF))
+      return ("uses a color space that PWG raster doesn't support");
+
+    if (h->cupsBitsPerColor != 8 && h->cupsBitsPerColor != 16 && (h->cupsBitsPerColor != 1 || (h->cupsColorSpace != CUPS_CSPACE_K && h->cupsColorSpace != CUPS_CSPACE_SW)))
+      return ("uses a bit depth that PWG raster doesn't support");
+  }
+  else
+  {
+    if (h->cupsColorSpace != CUPS_CSPACE_SW && h->cupsColorSpace != CUPS_CSPACE_SRGB && h->cupsColorSpace != CUPS_CSPACE_CIELab && h->cupsColorSpace != CUPS_CSPACE_ADOBERGB && h->cupsColorSpace != CUPS_CSPACE_W && h->cupsColorSpace != CUPS_CSPACE_RGB && h->cupsColorSpace != CUPS_CSPACE_CMYK)
+      return ("uses a color space that Apple raster doesn't support");
+
+    if (h->cupsBitsPerColor != 8 && h->cupsBitsPerColor != 16)
+      return ("uses a bit depth that Apple raster doesn't support");
+
+    if (h->HWResolution[1] == 0 || (h->HWResolution[0] % h->HWResolution[1]) != 0)
+      return ("uses a resolution that Apple raster doesn't support");
+  }
+
+  if (from != RC_FORMAT_PWG && from != RC_FORMAT_APPLE)
+  {
+    // Page count and transforms are unknown...
+    memset(h->cupsInteger, 0, sizeof(h->cupsInteger));
+
+    h->cupsInteger[CUPS_RASTER_PWG_CrossFeedTransform] = 1;
+    h->cupsInteger[CUPS_RASTER_PWG_FeedTransform]      = 1;
+    h->cupsInteger[CUPS_RASTER_PWG_AlternatePrimary]   = 0xffffff;
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'input_format()' - Get the format of the current input page.
+//
+
+static rc_format_t			// O - Format
+input_format(cups_raster_t      *ras,	// I - Input raster stream
+             cups_page_header_t *h)	// I - Page header
+{
+  switch (ras->sync)
+  {
+    case CUPS_RASTER_SYNCv1 :
+    case CUPS_RASTER_REVSYNCv1 :
+        return (RC_FORMAT_V1);
+
+    case CUPS_RASTER_SYNCv2 :
+    case CUPS_RASTER_REVSYNCv2 :
+        return (strcmp(h->MediaClass, "PwgRaster") ? RC_FORMAT_V2 : RC_FORMAT_PWG);
+
+    case CUPS_RASTER_SYNCapple :
+    case CUPS_RASTER_REVSYNCapple :
+        return (RC_FORMAT_APPLE);
+
+    default :
+        return (RC_FORMAT_V3);
+  }
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'read_cb()' - Read the rows of a page into the ring.
+//
+
+static void
+read_cb(rc_pipe_t *pipe)		// I - Rows being passed
+{
+  unsigned	y;			// Current row
+
+
+  for (y = 0; y < pipe->lines; y ++)
+  {
+    {
+      // Wait for room in the ring...
+      std::unique_lock<std::mutex> lock(pipe->lock);
+
+      pipe->cond.wait(lock, [pipe, y] { return (pipe->cancel || y < pipe->num_written + RC_PIPE_ROWS); });
+
+      if (pipe->cancel)
+        return;
+    }
+
+    if (!cupsRasterReadPixels(pipe->ras, pipe->rows + (size_t)(y % RC_PIPE_ROWS) * pipe->bpl, pipe->bpl))
+    {
+      std::lock_guard<std::mutex> lock(pipe->lock);
+
+      pipe->read_error = true;
+      pipe->cond.notify_all();
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pipe->lock);
+
+      pipe->num_read = y + 1;
+      pipe->cond.notify_all();
+    }
+  }
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rasterconvert --format FORMAT FILENAME OUTPUT\n", out);
+  fputs("Options:\n", out);
+  fputs("  --format FORMAT  Write 'v1', 'v2', or 'v3' CUPS, 'pwg', or 'apple' raster.\n", out);
+  fputs("  --help           Show program usage.\n", out);
+  fputs("Use '-' for FILENAME or OUTPUT to read stdin or write stdout.\n", out);
+}
+
+
+//
+// 'write_cb()' - Write data to the output file.
+//
+// Version 1 files are written as version 3 with a different sync word and the
+// shorter version 1 page header.
+//
+
+static ssize_t				// O - Bytes written or -1 on error
+write_cb(rc_output_t   *out,		// I - Output file
+         unsigned char *buffer,		// I - Buffer
+         size_t        length)		// I - Bytes to write
+{
+  if (out->v1_sync && length == sizeof(unsigned))
+  {
+    unsigned sync = CUPS_RASTER_SYNCv1;	// Version 1 sync word
+
+    out->v1_sync = false;
+
+    return (fwrite(&sync, sizeof(sync), 1, out->fp) == 1 ? (ssize_t)length : -1);
+  }
+  else if (out->v1_header && length == sizeof(cups_page_header_t))
+  {
+    out->v1_header = false;
+
+    return (fwrite(buffer, offsetof(cups_page_header_t, cupsNumColors), 1, out->fp) == 1 ? (ssize_t)length : -1);
+  }
+
+  return (fwrite(buffer, 1, length, out->fp) == length ? (ssize_t)length : -1);
+}
+
+
+//
+// 'write_rows()' - Decode and encode the rows of a page.
+//
+// A reading thread decodes up to RC_PIPE_ROWS rows ahead into the ring while
+// this thread compresses and writes them, so memory use only depends on the
+// width of the page.  The rows are written as they were read since all of the
+// formats use the same pixel packing.
+//
+
+static int				// O - 1 on success, 0 on write error, -1 on read error
+write_rows(cups_raster_t      *ras,	// I - Input raster stream
+           cups_raster_t      *outras,	// I - Output raster stream
+           cups_page_header_t *h,	// I - Page header
+           uchar              *rows)	// I - Ring of rows
+{
+  rc_pipe_t	pipe;			// Rows being passed
+  std::thread	reader;			// Reading thread
+  unsigned	y;			// Current row
+  int		status = 1;		// Return status
+
+
+  pipe.ras         = ras;
+  pipe.bpl         = h->cupsBytesPerLine;
+  pipe.lines       = ras->remaining;
+  pipe.rows        = rows;
+  pipe.num_read    = 0;
+  pipe.num_written = 0;
+  pipe.read_error  = false;
+  pipe.cancel      = false;
+
+  reader = std::thread(read_cb, &pipe);
+
+  for (y = 0; y < pipe.lines; y ++)
+  {
+    {
+      // Wait for the row to be read...
+      std::unique_lock<std::mutex> lock(pipe.lock);
+
+      pipe.cond.wait(lock, [&pipe, y] { return (pipe.read_error || y < pipe.num_read); });
+
+      if (y >= pipe.num_read)
+      {
+        status = -1;
+        break;
+      }
+    }
+
+    if (!cupsRasterWritePixels(outras, rows + (size_t)(y % RC_PIPE_ROWS) * pipe.bpl, pipe.bpl))
+    {
+      status = 0;
+      break;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pipe.lock);
+
+      pipe.num_written = y + 1;
+      pipe.cond.notify_all();
+    }
+  }
+
+  if (status != 1)
+  {
+    std::lock_guard<std::mutex> lock(pipe.lock);
+
+    pipe.cancel = true;
+    pipe.cond.notify_all();
+  }
+
+  reader.join();
+
+  return (status);
+}
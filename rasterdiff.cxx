@@ -0,0 +1,735 @@
+//
+// Program to compare two raster files.
+//
+// Usage:
+//
+//   ./rasterdiff [OPTIONS] FILENAME1 FILENAME2
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-private.h"
+#include "raster-convert.h"
+#include "raster-png.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include <atomic>
+#include <thread>
+
+
+//
+// Constants...
+//
+
+#define RD_MAX_THREADS	16		// Maximum comparison threads
+
+
+//
+// Page comparison results...
+//
+
+enum
+{
+  RD_SAME,				// Pages are identical
+  RD_DIFFERENT,				// Pixels or header fields differ
+  RD_LAYOUT,				// Page sizes or formats differ
+  RD_ERROR				// Unable to read page
+};
+
+
+//
+// Local types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+typedef struct rd_field_s		// Page header field
+{
+  const char		*name;		// Name of field
+  size_t		offset,		// Offset in header
+			size;		// Size of field
+  int			layout;		// Does the field change the pixel layout?
+} rd_field_t;
+
+typedef struct rd_page_s		// Comparison of one page
+{
+  int			status;		// RD_SAME, RD_DIFFERENT, RD_LAYOUT, or RD_ERROR
+  char			fields[1024];	// Names of header fields that differ
+  unsigned		rows,		// Number of rows that differ
+			x1, y1,		// Top-left corner of changed region
+			x2, y2;		// Bottom-right corner of changed region
+  int			num_channels;	// Number of channels
+  unsigned		max_delta[15];	// Maximum difference of each channel
+} rd_page_t;
+
+typedef struct rd_job_s			// Comparison job shared by all threads
+{
+  const char		*filenames[2],	// Raster files
+			*prefix;	// Difference image prefix or `NULL`
+  z_off_t		*pages[2];	// Offset of each page header
+  int			num_pages[2];	// Number of pages
+  rd_page_t		*results;	// Results for each page
+  std::atomic<int>	next_page;	// Next page to compare
+} rd_job_t;
+
+
+//
+// Local globals...
+//
+
+#define RD_FIELD(f,l) { #f, offsetof(cups_page_header_t, f), sizeof(((cups_page_header_t *)0)->f), l }
+
+static const rd_field_t	rd_fields[] =
+{
+  RD_FIELD(MediaClass, 0),
+  RD_FIELD(MediaColor, 0),
+  RD_FIELD(MediaType, 0),
+  RD_FIELD(OutputType, 0),
+  RD_FIELD(AdvanceDistance, 0),
+  RD_FIELD(AdvanceMedia, 0),
+  RD_FIELD(Collate, 0),
+  RD_FIELD(CutMedia, 0),
+  RD_FIELD(Duplex, 0),
+  RD_FIELD(HWResolution, 0),
+  RD_FIELD(ImagingBoundingBox, 0),
+  RD_FIELD(InsertSheet, 0),
+  RD_FIELD(Jog, 0),
+  RD_FIELD(LeadingEdge, 0),
+  RD_FIELD(Margins, 0),
+  RD_FIELD(ManualFeed, 0),
+  RD_FIELD(MediaPosition, 0),
+  RD_FIELD(MediaWeight, 0),
+  RD_FIELD(MirrorPrint, 0),
+  RD_FIELD(NegativePrint, 0),
+  RD_FIELD(NumCopies, 0),
+  RD_FIELD(Orientation, 0),
+  RD_FIELD(OutputFaceUp, 0),
+  RD_FIELD(PageSize, 0),
+  RD_FIELD(Separations, 0),
+  RD_FIELD(TraySwitch, 0),
+  RD_FIELD(Tumble, 0),
+  RD_FIELD(cupsWidth, 1),
+  RD_FIELD(cupsHeight, 1),
+  RD_FIELD(cupsMediaType, 0),
+  RD_FIELD(cupsBitsPerColor, 1),
+  RD_FIELD(cupsBitsPerPixel, 1),
+  RD_FIELD(cupsBytesPerLine, 1),
+  RD_FIELD(cupsColorOrder, 1),
+  RD_FIELD(cupsColorSpace, 1),
+  RD_FIELD(cupsCompression, 0),
+  RD_FIELD(cupsRowCount, 0),
+  RD_FIELD(cupsRowFeed, 0),
+  RD_FIELD(cupsRowStep, 0),
+  RD_FIELD(cupsNumColors, 1),
+  RD_FIELD(cupsBorderlessScalingFactor, 0),
+  RD_FIELD(cupsPageSize, 0),
+  RD_FIELD(cupsImagingBBox, 0),
+  RD_FIELD(cupsInteger, 0),
+  RD_FIELD(cupsReal, 0),
+  RD_FIELD(cupsString, 0),
+  RD_FIELD(cupsMarkerType, 0),
+  RD_FIELD(cupsRenderingIntent, 0),
+  RD_FIELD(cupsPageSizeName, 0)
+};
+
+
+//
+// Local functions...
+//
+
+static int	compare_headers(cups_page_header_t *a, cups_page_header_t *b, rd_page_t *result);
+static void	compare_page(rd_job_t *job, cups_raster_t *ras[2], int page);
+static int	index_file(const char *filename, z_off_t **pages);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static z_off_t	raster_offset(cups_raster_t *ras, gzFile fp);
+static void	thread_cb(rd_job_t *job);
+static void	usage(FILE *out);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i, c;			// Looping vars
+  rd_job_t	job;			// Comparison job
+  int		num_files = 0,		// Number of files
+		num_pages,		// Number of pages to compare
+		num_threads = 0,	// Number of threads
+		differ = 0,		// Number of pages that differ
+		mismatch = 0,		// Do the page counts differ?
+		errors = 0;		// Number of pages that couldn't be read
+  rd_page_t	*result;		// Current page result
+  std::thread	threads[RD_MAX_THREADS];
+					// Comparison threads
+
+
+  // Parse command-line
+  memset(job.filenames, 0, sizeof(job.filenames));
+  memset(job.pages, 0, sizeof(job.pages));
+  job.prefix    = NULL;
+  job.results   = NULL;
+  job.next_page = 0;
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--diff"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("rasterdiff: Expected output prefix after '--diff'.\n", stderr);
+        usage(stderr);
+        return (2);
+      }
+
+      job.prefix = argv[i];
+    }
+    else if (!strcmp(argv[i], "--threads"))
+    {
+      i ++;
+      if (i >= argc || (num_threads = atoi(argv[i])) < 1)
+      {
+        fputs("rasterdiff: Expected number of threads after '--threads'.\n", stderr);
+        usage(stderr);
+        return (2);
+      }
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "rasterdiff: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (2);
+    }
+    else if (num_files < 2)
+      job.filenames[num_files ++] = argv[i];
+    else
+    {
+      usage(stderr);
+      return (2);
+    }
+  }
+
+  if (num_files != 2)
+  {
+    usage(stderr);
+    return (2);
+  }
+
+  // Find the start of each page...
+  for (i = 0; i < 2; i ++)
+  {
+    if ((job.num_pages[i] = index_file(job.filenames[i], job.pages + i)) < 0)
+      return (2);
+  }
+
+  if (job.num_pages[0] != job.num_pages[1])
+  {
+    printf("'%s' has %d pages, '%s' has %d pages.\n", job.filenames[0], job.num_pages[0], job.filenames[1], job.num_pages[1]);
+    mismatch = 1;
+  }
+
+  if ((num_pages = job.num_pages[0]) > job.num_pages[1])
+    num_pages = job.num_pages[1];
+
+  // Compare pages in parallel, each thread using its own pair of streams...
+  job.results = new rd_page_t[num_pages > 0 ? num_pages : 1];
+
+  if (num_threads == 0)
+    num_threads = (int)std::thread::hardware_concurrency();
+  if (num_threads > num_pages)
+    num_threads = num_pages;
+  if (num_threads > RD_MAX_THREADS)
+    num_threads = RD_MAX_THREADS;
+
+  for (i = 0; i < num_threads; i ++)
+    threads[i] = std::thread(thread_cb, &job);
+
+  for (i = 0; i < num_threads; i ++)
+    threads[i].join();
+
+  // Report the differences in page order...
+  for (i = 0, result = job.results; i < num_pages; i ++, result ++)
+  {
+    if (result->status == RD_SAME)
+      continue;
+
+    if (result->status == RD_ERROR)
+    {
+      errors ++;
+      continue;
+    }
+
+    differ ++;
+
+    printf("Page %d:", i + 1);
+
+    if (result->fields[0])
+      printf(" header differs (%s)", result->fields);
+
+    if (result->status == RD_LAYOUT)
+    {
+      puts(", pixels not compared");
+      continue;
+    }
+
+    if (result->rows > 0)
+    {
+      printf("%s %u rows differ in [%u,%u]-[%u,%u], max delta", result->fields[0] ? "," : "", result->rows, result->x1, result->y1, result->x2, result->y2);
+
+      for (c = 0; c < result->num_channels; c ++)
+        printf("%s%u", c ? "," : " ", result->max_delta[c]);
+    }
+
+    putchar('\n');
+  }
+
+  if (differ)
+    printf("%d of %d pages differ.\n", differ, num_pages);
+
+  delete[] job.results;
+  delete[] job.pages[0];
+  delete[] job.pages[1];
+
+  return (errors ? 2 : (differ || mismatch) ? 1 : 0);
+}
+
+
+//
+// 'compare_headers()' - Compare two page headers.
+//
+// The names of the fields that differ are added to the page result.
+//
+
+static int				// O - 1 if the pixels can be compared, 0 otherwise
+compare_headers(cups_page_header_t *a,	// I - First header
+                cups_page_header_t *b,	// I - Second header
+                rd_page_t          *result)
+					// I - Page result
+{
+  size_t	i;			// Looping var
+  int		layout = 0;		// Does the pixel layout differ?
+  size_t	len = 0;		// Length of field names
+
+
+  if (!memcmp(a, b, sizeof(cups_page_header_t)))
+    return (1);
+
+  for (i = 0; i < sizeof(rd_fields) / sizeof(rd_fields[0]); i ++)
+  {
+    if (memcmp((char *)a + rd_fields[i].offset, (char *)b + rd_fields[i].offset, rd_fields[i].size))
+    {
+      snprintf(result->fields + len, sizeof(result->fields) - len, "%s%s", len ? ", " : "", rd_fields[i].name);
+      len += strlen(result->fields + len);
+
+      if (rd_fields[i].layout)
+        layout = 1;
+    }
+  }
+
+  if (len > 0)
+    result->status = layout ? RD_LAYOUT : RD_DIFFERENT;
+
+  return (!layout);
+}
+
+
+//
+// 'compare_page()' - Compare one page of the two files.
+//
+// Rows are read from both files in lockstep.  Identical rows are skipped
+// after a single memcmp() of the raw data, only rows that differ are
+// converted to find the changed pixels and channel differences.  When a
+// difference image is requested every row is converted so that unchanged
+// pixels can be drawn as a faded copy of the first file.
+//
+
+static void
+compare_page(rd_job_t      *job,	// I - Comparison job
+             cups_raster_t *ras[2],	// I - Raster streams
+             int           page)	// I - Page index
+{
+  rd_page_t		*result = job->results + page;
+					// Page result
+  cups_page_header_t	header[2];	// Page headers
+  uchar			device_colors[15][3];
+					// RGB values for each device color
+  int			i,		// Looping var
+			c,		// Channel
+			bpc,		// Bytes per color
+			bpp,		// Bytes per pixel
+			same;		// Row is identical?
+  unsigned		x, y,		// Position in page
+			a, b,		// Channel values
+			delta,		// Channel difference
+			pixel_delta,	// Maximum difference of pixel
+			maxval,		// Maximum channel value
+			bpl;		// Bytes per line
+  uchar			*lines[2],	// Raster lines
+			*colors[2],	// Original pixels
+			*pixels,	// Converted pixels of first file
+			*output = NULL,	// Difference image pixels
+			*cptr[2],	// Pointers into colors
+			*pptr,		// Pointer into pixels
+			*optr;		// Pointer into output
+  char			filename[1024];	// Difference image filename
+  raster_png_t		*png = NULL;	// Difference image
+
+
+  memset(result, 0, sizeof(rd_page_t));
+
+  for (i = 0; i < 2; i ++)
+  {
+    if (!cupsRasterReadHeader(ras[i], header + i))
+    {
+      fprintf(stderr, "rasterdiff: Unable to read page %d of '%s': %s\n", page + 1, job->filenames[i], cupsRasterErrorString());
+      result->status = RD_ERROR;
+      return;
+    }
+  }
+
+  if (!compare_headers(header, header + 1, result))
+    return;
+
+  if (header[0].cupsWidth == 0 || header[0].cupsWidth > 1000000 || header[0].cupsHeight == 0 || header[0].cupsHeight > 1000000 || header[0].cupsNumColors < 1 || header[0].cupsNumColors > 15)
+  {
+    fprintf(stderr, "rasterdiff: Page %d of '%s' dimensions are out of range (%ux%u).\n", page + 1, job->filenames[0], header[0].cupsWidth, header[0].cupsHeight);
+    result->status = RD_ERROR;
+    return;
+  }
+
+  if (header[0].cupsColorOrder == CUPS_ORDER_PLANAR && header[0].cupsNumColors > 1)
+  {
+    // Each plane is a separate set of lines, which can't be compared as pixels...
+    fprintf(stderr, "rasterdiff: Page %d of '%s' uses planar color order, which is not supported.\n", page + 1, job->filenames[0]);
+    result->status = RD_ERROR;
+    return;
+  }
+
+  // Allocate buffers for one row of each file...
+  bpl    = header[0].cupsBytesPerLine;
+  bpp    = header[0].cupsNumColors == 1 ? 1 : 3;
+  bpc    = (int)(header[0].cupsBitsPerPixel + 7) / 8;
+  maxval = (1U << header[0].cupsBitsPerColor) - 1;
+
+  if (header[0].cupsColorOrder != CUPS_ORDER_CHUNKED)
+    bpc *= (int)header[0].cupsNumColors;
+
+  result->num_channels = (int)header[0].cupsNumColors;
+  result->x1           = header[0].cupsWidth;
+  result->y1           = header[0].cupsHeight;
+
+  for (i = 0; i < 2; i ++)
+  {
+    lines[i]  = new uchar[bpl];
+    colors[i] = new uchar[(size_t)header[0].cupsWidth * (size_t)bpc];
+  }
+
+  pixels = new uchar[(size_t)header[0].cupsWidth * (size_t)bpp];
+
+  rasterConvertColors(header, device_colors);
+
+  if (job->prefix)
+  {
+    snprintf(filename, sizeof(filename), "%s-%d.png", job->prefix, page + 1);
+
+    if ((png = rasterPNGCreate(filename, header[0].cupsWidth, header[0].cupsHeight, 3, header[0].HWResolution[0], header[0].HWResolution[1])) == NULL)
+      fprintf(stderr, "rasterdiff: Unable to create '%s': %s\n", filename, strerror(errno));
+    else
+      output = new uchar[(size_t)header[0].cupsWidth * 3];
+  }
+
+  // Compare the rows...
+  for (y = 0; y < header[0].cupsHeight; y ++)
+  {
+    if (!cupsRasterReadPixels(ras[0], lines[0], bpl) || !cupsRasterReadPixels(ras[1], lines[1], bpl))
+    {
+      fprintf(stderr, "rasterdiff: Unable to read page %d: %s\n", page + 1, cupsRasterErrorString());
+      result->status = RD_ERROR;
+      break;
+    }
+
+    if ((same = !memcmp(lines[0], lines[1], bpl)) != 0 && !png)
+      continue;
+
+    // The second file's pixels aren't used, so convert both lines into the
+    // same pixel buffer, first file last.  Some conversions only store the
+    // marked pixels, so clear the buffers first...
+    memset(colors[0], 0, (size_t)header[0].cupsWidth * (size_t)bpc);
+    memset(pixels, 255, (size_t)header[0].cupsWidth * (size_t)bpp);
+
+    if (!same)
+    {
+      memset(colors[1], 0, (size_t)header[0].cupsWidth * (size_t)bpc);
+      rasterConvertLine(header, (int)y, lines[1], colors[1], pixels, device_colors);
+      memset(pixels, 255, (size_t)header[0].cupsWidth * (size_t)bpp);
+
+      result->status = RD_DIFFERENT;
+      result->rows ++;
+
+      if (y < result->y1)
+        result->y1 = y;
+      result->y2 = y;
+    }
+
+    rasterConvertLine(header, (int)y, lines[0], colors[0], pixels, device_colors);
+
+    // Find the pixels that differ...
+
+    for (x = 0, cptr[0] = colors[0], cptr[1] = colors[1], pptr = pixels, optr = output; x < header[0].cupsWidth; x ++, cptr[0] += bpc, cptr[1] += bpc, pptr += bpp)
+    {
+      pixel_delta = 0;
+
+      if (!same && memcmp(cptr[0], cptr[1], (size_t)bpc))
+      {
+        if (x < result->x1)
+          result->x1 = x;
+        if (x > result->x2)
+          result->x2 = x;
+
+        for (c = 0; c < result->num_channels; c ++)
+        {
+          a     = rasterChannelValue(header, bpc, cptr[0], c);
+          b     = rasterChannelValue(header, bpc, cptr[1], c);
+          delta = a > b ? a - b : b - a;
+
+          if (delta > result->max_delta[c])
+            result->max_delta[c] = delta;
+          if (delta > pixel_delta)
+            pixel_delta = delta;
+        }
+      }
+
+      if (optr)
+      {
+        if (pixel_delta)
+        {
+          // Changed pixels are red, darker for larger differences...
+          *optr++ = 255;
+          *optr++ = (uchar)(160 - 160 * pixel_delta / maxval);
+          *optr++ = (uchar)(160 - 160 * pixel_delta / maxval);
+        }
+        else
+        {
+          // Unchanged pixels are a faded copy of the first file...
+          *optr++ = (uchar)(192 + pptr[0] / 4);
+          *optr++ = (uchar)(192 + pptr[bpp == 1 ? 0 : 1] / 4);
+          *optr++ = (uchar)(192 + pptr[bpp == 1 ? 0 : 2] / 4);
+        }
+      }
+    }
+
+    if (png && !rasterPNGWriteRow(png, output))
+    {
+      fprintf(stderr, "rasterdiff: Unable to write '%s': %s\n", filename, strerror(errno));
+      rasterPNGClose(png);
+      remove(filename);
+      png = NULL;
+    }
+  }
+
+  // Only keep difference images for pages that differ...
+  if (png)
+  {
+    if (!rasterPNGClose(png))
+      fprintf(stderr, "rasterdiff: Unable to write '%s': %s\n", filename, strerror(errno));
+
+    if (result->status == RD_SAME || result->status == RD_ERROR)
+      remove(filename);
+  }
+
+  for (i = 0; i < 2; i ++)
+  {
+    delete[] lines[i];
+    delete[] colors[i];
+  }
+
+  delete[] pixels;
+  delete[] output;
+}
+
+
+//
+// 'index_file()' - Find the offset of each page header in a raster file.
+//
+// The page data is skipped without decoding it.
+//
+
+static int				// O - Number of pages or -1 on error
+index_file(const char *filename,	// I - Raster file
+           z_off_t    **pages)		// O - Offset of each page header
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		lines;		// Number of lines in page
+  z_off_t		offset,		// Offset of page header
+			*temp;		// New page array
+  int			num_pages = 0,	// Number of pages
+			alloc_pages = 0;// Number of pages allocated
+
+
+  if ((fp = gzopen(filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rasterdiff: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (-1);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rasterdiff: Unable to read '%s': %s\n", filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (-1);
+  }
+
+  for (offset = raster_offset(ras, fp); cupsRasterReadHeader(ras, &header); offset = raster_offset(ras, fp))
+  {
+    if (num_pages >= alloc_pages)
+    {
+      temp = new z_off_t[alloc_pages + 100];
+
+      if (*pages)
+      {
+        memcpy(temp, *pages, (size_t)alloc_pages * sizeof(z_off_t));
+        delete[] *pages;
+      }
+
+      *pages      = temp;
+      alloc_pages += 100;
+    }
+
+    (*pages)[num_pages ++] = offset;
+
+    lines = header.cupsHeight;
+
+    if (header.cupsColorOrder == CUPS_ORDER_PLANAR && header.cupsNumColors > 1)
+      lines *= header.cupsNumColors;
+
+    if (_cupsRasterSkipLines(ras, lines) != lines)
+    {
+      // Compare the truncated page so its differences are still reported...
+      fprintf(stderr, "rasterdiff: Page %d of '%s' is truncated.\n", num_pages, filename);
+      break;
+    }
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+
+  return (num_pages);
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'raster_offset()' - Get the file offset of the next raster data.
+//
+
+static z_off_t				// O - Offset in file
+raster_offset(cups_raster_t *ras,	// I - Raster stream
+              gzFile        fp)		// I - File
+{
+  return (gztell(fp) - (ras->compressed ? ras->bufend - ras->bufptr : 0));
+}
+
+
+//
+// 'thread_cb()' - Compare pages until there are none left.
+//
+
+static void
+thread_cb(rd_job_t *job)		// I - Comparison job
+{
+  int			i;		// Looping var
+  gzFile		fp[2] = { NULL, NULL };
+					// Files
+  cups_raster_t		*ras[2] = { NULL, NULL };
+					// Raster streams
+  int			page,		// Current page
+			num_pages,	// Number of pages to compare
+			status = 1;	// Are the files open?
+
+
+  if ((num_pages = job->num_pages[0]) > job->num_pages[1])
+    num_pages = job->num_pages[1];
+
+  for (i = 0; i < 2; i ++)
+  {
+    if ((fp[i] = gzopen(job->filenames[i], "r")) == NULL || (ras[i] = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp[i], CUPS_RASTER_READ)) == NULL)
+    {
+      fprintf(stderr, "rasterdiff: Unable to open '%s': %s\n", job->filenames[i], strerror(errno));
+      status = 0;
+      break;
+    }
+  }
+
+  while ((page = job->next_page ++) < num_pages)
+  {
+    if (!status)
+    {
+      job->results[page].status = RD_ERROR;
+      continue;
+    }
+
+    // Position both streams at the page header...
+    for (i = 0; i < 2; i ++)
+    {
+      gzseek(fp[i], job->pages[i][page], SEEK_SET);
+
+      ras[i]->bufptr = ras[i]->buffer;
+      ras[i]->bufend = ras[i]->buffer;
+    }
+
+    compare_page(job, ras, page);
+  }
+
+  for (i = 0; i < 2; i ++)
+  {
+    if (ras[i])
+      cupsRasterClose(ras[i]);
+    if (fp[i])
+      gzclose(fp[i]);
+  }
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rasterdiff [OPTIONS] FILENAME1 FILENAME2\n", out);
+  fputs("Options:\n", out);
+  fputs("  --diff PREFIX    Write difference images to PREFIX-N.png.\n", out);
+  fputs("  --help           Show program usage.\n", out);
+  fputs("  --threads COUNT  Compare COUNT pages at a time.\n", out);
+}
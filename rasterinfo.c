@@ -0,0 +1,412 @@
+//
+// Program to show information about raster files.
+//
+// Usage:
+//
+//   ./rasterinfo [--bbox] [--blank] [--brief] [--hash] FILENAME [... FILENAME]
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include "raster-private.h"
+
+
+//
+// Local functions...
+//
+
+static void	print_header(cups_page_header_t *header);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static z_off_t	raster_offset(cups_raster_t *ras, gzFile fp);
+static int	show_file(const char *filename, int brief, int check, int bbox, int hash);
+static void	usage(FILE *out);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  int		bbox = 0,		// Show ink bounding boxes?
+		brief = 0,		// Show one line per page?
+		check = 0,		// Check for blank pages?
+		files = 0,		// Number of files shown
+		hash = 0,		// Show page hashes?
+		status = 0;		// Exit status
+
+
+  // Parse command-line
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--bbox"))
+    {
+      bbox = 1;
+    }
+    else if (!strcmp(argv[i], "--blank"))
+    {
+      check = 1;
+    }
+    else if (!strcmp(argv[i], "--brief"))
+    {
+      brief = 1;
+    }
+    else if (!strcmp(argv[i], "--hash"))
+    {
+      hash = 1;
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "rasterinfo: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+    else
+    {
+      if (!show_file(argv[i], brief, check, bbox, hash))
+        status = 1;
+
+      files ++;
+    }
+  }
+
+  if (!files)
+  {
+    usage(stderr);
+    return (1);
+  }
+
+  return (status);
+}
+
+
+//
+// 'print_header()' - Show the attributes in a page header.
+//
+
+static void
+print_header(
+    cups_page_header_t *header)		// I - Page header
+{
+  int		i;			// Looping var
+
+
+  if (!strcmp(header->MediaClass, "PwgRaster"))
+  {
+    puts("    PWG Raster Page Attributes:");
+
+    printf("      MediaColor = \"%s\"\n", header->MediaColor);
+    printf("      MediaType = \"%s\"\n", header->MediaType);
+    printf("      PrintContentOptimize = \"%s\"\n", header->OutputType);
+    printf("      CutMedia = %d\n", header->CutMedia);
+    printf("      Duplex = %d\n", header->Duplex);
+    printf("      HWResolution = [ %d %d ]\n", header->HWResolution[0], header->HWResolution[1]);
+    printf("      InsertSheet = %d\n", header->InsertSheet);
+    printf("      Jog = %d\n", header->Jog);
+    printf("      LeadingEdge = %d\n", header->LeadingEdge);
+    printf("      MediaPosition = %d\n", header->MediaPosition);
+    printf("      MediaWeightMetric = %d\n", header->MediaWeight);
+    printf("      NumCopies = %d\n", header->NumCopies);
+    printf("      Orientation = %d\n", header->Orientation);
+    printf("      PageSize = [ %d %d ]\n", header->PageSize[0], header->PageSize[1]);
+    printf("      Tumble = %d\n", header->Tumble);
+    printf("      Width = %d\n", header->cupsWidth);
+    printf("      Height = %d\n", header->cupsHeight);
+    printf("      BitsPerColor = %d\n", header->cupsBitsPerColor);
+    printf("      BitsPerPixel = %d\n", header->cupsBitsPerPixel);
+    printf("      BytesPerLine = %d\n", header->cupsBytesPerLine);
+    printf("      ColorOrder = %s\n", header->cupsColorOrder == CUPS_ORDER_CHUNKED ? "CHUNKED" : header->cupsColorOrder == CUPS_ORDER_BANDED ? "BANDED" : header->cupsColorOrder == CUPS_ORDER_PLANAR ? "PLANAR" : "UNKNOWN");
+    printf("      ColorSpace = %s\n", _cupsRasterColorSpaceString(header->cupsColorSpace));
+    printf("      NumColors = %d\n", header->cupsNumColors);
+    printf("      TotalPageCount = %u\n", header->cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
+    printf("      CrossFeedTransform = %d\n", header->cupsInteger[CUPS_RASTER_PWG_CrossFeedTransform]);
+    printf("      FeedTransform = %d\n", header->cupsInteger[CUPS_RASTER_PWG_FeedTransform]);
+    printf("      ImageBoxLeft = %u\n", header->cupsInteger[CUPS_RASTER_PWG_ImageBoxLeft]);
+    printf("      ImageBoxTop = %u\n", header->cupsInteger[CUPS_RASTER_PWG_ImageBoxTop]);
+    printf("      ImageBoxRight = %u\n", header->cupsInteger[CUPS_RASTER_PWG_ImageBoxRight]);
+    printf("      ImageBoxBottom = %u\n", header->cupsInteger[CUPS_RASTER_PWG_ImageBoxBottom]);
+    printf("      AlternatePrimary = %06x (%u, %u, %u)\n", header->cupsInteger[CUPS_RASTER_PWG_AlternatePrimary], (header->cupsInteger[CUPS_RASTER_PWG_AlternatePrimary] >> 16) & 255, (header->cupsInteger[CUPS_RASTER_PWG_AlternatePrimary] >> 8) & 255, header->cupsInteger[CUPS_RASTER_PWG_AlternatePrimary] & 255);
+    printf("      PrintQuality = %u\n", header->cupsInteger[CUPS_RASTER_PWG_PrintQuality]);
+    printf("      VendorIdentifier = %u\n", header->cupsInteger[CUPS_RASTER_PWG_VendorIdentifier]);
+    printf("      VendorLength = %u\n", header->cupsInteger[CUPS_RASTER_PWG_VendorLength]);
+
+    unsigned char	*data = (unsigned char *)header->cupsReal;
+    unsigned		dataidx, datalen = header->cupsInteger[15];
+
+    fputs("      VendorData =", stdout);
+
+    for (dataidx = 0; dataidx < datalen; dataidx ++)
+    {
+      if ((dataidx & 7) == 0)
+	fputs("\n         ", stdout);
+
+      printf(" %02X", *data++);
+    }
+
+    putchar('\n');
+
+    printf("      RenderingIntent = \"%s\"\n", header->cupsRenderingIntent);
+    printf("      PageSizeName = \"%s\"\n", header->cupsPageSizeName);
+  }
+  else
+  {
+    puts("    CUPS Raster Page Attributes:");
+
+    printf("      MediaClass = \"%s\"\n", header->MediaClass);
+    printf("      MediaColor = \"%s\"\n", header->MediaColor);
+    printf("      MediaType = \"%s\"\n", header->MediaType);
+    printf("      OutputType = \"%s\"\n", header->OutputType);
+    printf("      AdvanceDistance = %d\n", header->AdvanceDistance);
+    printf("      AdvanceMedia = %d\n", header->AdvanceMedia);
+    printf("      Collate = %d\n", header->Collate);
+    printf("      CutMedia = %d\n", header->CutMedia);
+    printf("      Duplex = %d\n", header->Duplex);
+    printf("      HWResolution = [ %d %d ]\n", header->HWResolution[0], header->HWResolution[1]);
+    printf("      ImagingBoundingBox = [ %d %d %d %d ]\n", header->ImagingBoundingBox[0], header->ImagingBoundingBox[1], header->ImagingBoundingBox[2], header->ImagingBoundingBox[3]);
+    printf("      InsertSheet = %d\n", header->InsertSheet);
+    printf("      Jog = %d\n", header->Jog);
+    printf("      LeadingEdge = %d\n", header->LeadingEdge);
+    printf("      Margins = [ %d %d ]\n", header->Margins[0], header->Margins[1]);
+    printf("      ManualFeed = %d\n", header->ManualFeed);
+    printf("      MediaPosition = %d\n", header->MediaPosition);
+    printf("      MediaWeight = %d\n", header->MediaWeight);
+    printf("      MirrorPrint = %d\n", header->MirrorPrint);
+    printf("      NegativePrint = %d\n", header->NegativePrint);
+    printf("      NumCopies = %d\n", header->NumCopies);
+    printf("      Orientation = %d\n", header->Orientation);
+    printf("      OutputFaceUp = %d\n", header->OutputFaceUp);
+    printf("      PageSize = [ %d %d ]\n", header->PageSize[0], header->PageSize[1]);
+    printf("      Separations = %d\n", header->Separations);
+    printf("      TraySwitch = %d\n", header->TraySwitch);
+    printf("      Tumble = %d\n", header->Tumble);
+    printf("      cupsWidth = %d\n", header->cupsWidth);
+    printf("      cupsHeight = %d\n", header->cupsHeight);
+    printf("      cupsMediaType = %d\n", header->cupsMediaType);
+    printf("      cupsBitsPerColor = %d\n", header->cupsBitsPerColor);
+    printf("      cupsBitsPerPixel = %d\n", header->cupsBitsPerPixel);
+    printf("      cupsBytesPerLine = %d\n", header->cupsBytesPerLine);
+    printf("      cupsColorOrder = %s\n", header->cupsColorOrder == CUPS_ORDER_CHUNKED ? "CHUNKED" : header->cupsColorOrder == CUPS_ORDER_BANDED ? "BANDED" : header->cupsColorOrder == CUPS_ORDER_PLANAR ? "PLANAR" : "UNKNOWN");
+    printf("      cupsColorSpace = %s\n", _cupsRasterColorSpaceString(header->cupsColorSpace));
+    printf("      cupsCompression = %d\n", header->cupsCompression);
+    printf("      cupsRowCount = %d\n", header->cupsRowCount);
+    printf("      cupsRowFeed = %d\n", header->cupsRowFeed);
+    printf("      cupsRowStep = %d\n", header->cupsRowStep);
+    printf("      cupsNumColors = %d\n", header->cupsNumColors);
+    printf("      cupsBorderlessScalingFactor = %f\n", header->cupsBorderlessScalingFactor);
+    printf("      cupsPageSize = [ %f %f ]\n", header->cupsPageSize[0], header->cupsPageSize[1]);
+    printf("      cupsImagingBBox = [ %f %f %f %f ]\n", header->cupsImagingBBox[0], header->cupsImagingBBox[1], header->cupsImagingBBox[2], header->cupsImagingBBox[3]);
+
+    for (i = 0; i < 16; i ++)
+    {
+      printf("      cupsInteger%d = %u\n", i + 1, header->cupsInteger[i]);
+    }
+
+    for (i = 0; i < 16; i ++)
+    {
+      printf("      cupsReal%d = %f\n", i + 1, header->cupsReal[i]);
+    }
+
+    for (i = 0; i < 16; i ++)
+    {
+      printf("      cupsString%d = \"%s\"\n", i + 1, header->cupsString[i]);
+    }
+
+    printf("      cupsMarkerType = \"%s\"\n", header->cupsMarkerType);
+    printf("      cupsRenderingIntent = \"%s\"\n", header->cupsRenderingIntent);
+    printf("      cupsPageSizeName = \"%s\"\n", header->cupsPageSizeName);
+  }
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'raster_offset()' - Return the current offset in the raster stream.
+//
+
+static z_off_t				// O - Offset
+raster_offset(cups_raster_t *ras,	// I - Raster stream
+              gzFile        fp)		// I - File
+{
+  return (gztell(fp) - (ras->compressed ? ras->bufend - ras->bufptr : 0));
+}
+
+
+//
+// 'show_file()' - Show information about each page in a raster file.
+//
+// The page data is skipped without decoding it, so this runs at about the
+// speed of reading the file.  Blank pages, ink bounding boxes, and page hashes
+// are found from the compressed data as it is skipped...
+//
+
+static int				// O - 1 on success, 0 on failure
+show_file(const char *filename,		// I - File to show
+          int        brief,		// I - Show one line per page?
+          int        check,		// I - Check for blank pages?
+          int        bbox,		// I - Show ink bounding boxes?
+          int        hash)		// I - Show page hashes?
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		page = 0,	// Current page
+			lines,		// Lines in page data
+			ink[4],		// Ink bounding box
+			same,		// Earlier page with the same hash
+			alloc_hashes = 0;// Number of hashes allocated
+  unsigned long long	*hashes = NULL,	// Hash of each page
+			*temp;		// New hashes
+  z_off_t		start,		// Start of page header
+			data,		// Start of page data
+			end;		// End of page data
+  double		ratio;		// Compression ratio
+  int			status = 1;	// Return status
+
+
+  if ((fp = gzopen(filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rasterinfo: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (0);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rasterinfo: Unable to read '%s': %s\n", filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (0);
+  }
+
+  printf("%s:\n", filename);
+
+  for (start = raster_offset(ras, fp); cupsRasterReadHeader(ras, &header); start = end)
+  {
+    page ++;
+    data  = raster_offset(ras, fp);
+    lines = header.cupsHeight;
+
+    if (header.cupsColorOrder == CUPS_ORDER_PLANAR && header.cupsNumColors > 1)
+      lines *= header.cupsNumColors;
+
+    memset(ink, 0, sizeof(ink));
+
+    if (hash && page > alloc_hashes)
+    {
+      if ((temp = realloc(hashes, (alloc_hashes + 100) * sizeof(unsigned long long))) == NULL)
+      {
+        fprintf(stderr, "rasterinfo: Unable to allocate memory for page hashes.\n");
+        status = 0;
+        break;
+      }
+
+      hashes       = temp;
+      alloc_hashes += 100;
+    }
+
+    if (hash)
+      hashes[page - 1] = 0;
+
+    if (_cupsRasterScanLines(ras, lines, check || bbox ? ink : NULL, hash ? hashes + page - 1 : NULL) != lines)
+    {
+      fprintf(stderr, "rasterinfo: Page %u of '%s' is truncated.\n", page, filename);
+      status = 0;
+      break;
+    }
+
+    end = raster_offset(ras, fp);
+
+    // Look for an earlier page with the same contents...
+    for (same = 0; hash && same < page - 1; same ++)
+    {
+      if (hashes[same] == hashes[page - 1])
+        break;
+    }
+
+    if (end > data)
+      ratio = (double)header.cupsBytesPerLine * lines / (double)(end - data);
+    else
+      ratio = 0.0;
+
+    if (brief)
+    {
+      printf("  Page %u: %ux%u %s %u-bit, header %ld, data %ld, %ld bytes, %.1f:1", page, header.cupsWidth, header.cupsHeight, _cupsRasterColorSpaceString(header.cupsColorSpace), header.cupsBitsPerPixel, (long)start, (long)data, (long)(end - data), ratio);
+      if (check && !ink[2])
+        fputs(", blank", stdout);
+      if (bbox && ink[2])
+        printf(", ink [ %u %u %u %u ]", ink[0], ink[1], ink[2], ink[3]);
+      if (hash)
+        printf(", hash %016llx", hashes[page - 1]);
+      if (hash && same < page - 1)
+        printf(", same as page %u", same + 1);
+      putchar('\n');
+    }
+    else
+    {
+      printf("  Page %u:\n", page);
+      printf("    HeaderOffset = %ld\n", (long)start);
+      printf("    DataOffset = %ld\n", (long)data);
+      printf("    DataBytes = %ld\n", (long)(end - data));
+      printf("    CompressionRatio = %.2f\n", ratio);
+      if (check)
+        printf("    Blank = %s\n", ink[2] ? "false" : "true");
+      if (bbox)
+        printf("    InkBoundingBox = [ %u %u %u %u ]\n", ink[0], ink[1], ink[2], ink[3]);
+      if (hash)
+        printf("    Hash = %016llx\n", hashes[page - 1]);
+      if (hash && same < page - 1)
+        printf("    SameAsPage = %u\n", same + 1);
+      print_header(&header);
+    }
+  }
+
+  free(hashes);
+  cupsRasterClose(ras);
+  gzclose(fp);
+
+  return (status);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rasterinfo [OPTIONS] FILENAME [... FILENAME]\n", out);
+  fputs("Options:\n", out);
+  fputs("  --bbox     Show the ink bounding box of each page.\n", out);
+  fputs("  --blank    Check for blank pages.\n", out);
+  fputs("  --brief    Show one line per page.\n", out);
+  fputs("  --hash     Show a hash of each page's compressed data and any earlier\n", out);
+  fputs("             page that is the same.\n", out);
+  fputs("  --help     Show program usage.\n", out);
+}
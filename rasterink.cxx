@@ -0,0 +1,794 @@
+//
+// Program to estimate the ink coverage of each page in raster files.
+//
+// Usage:
+//
+//   ./rasterink [OPTIONS] FILENAME [... FILENAME]
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-private.h"
+#include "raster-convert.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include <atomic>
+#include <thread>
+
+
+//
+// Constants...
+//
+
+#define RI_MAX_THREADS	16		// Maximum counting threads
+
+
+//
+// Local types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+typedef struct ri_page_s		// Coverage of one page
+{
+  int			status;		// 1 if counted, 0 on error
+  unsigned		width,		// Width in pixels
+			height,		// Height in pixels
+			bits;		// Bits per color
+  cups_cspace_t		cspace;		// Color space
+  int			num_channels;	// Number of channels
+  double		coverage[15];	// Coverage of each channel in percent
+} ri_page_t;
+
+typedef struct ri_job_s			// Counting job shared by all threads
+{
+  const char		*filename;	// Raster file
+  z_off_t		*pages;		// Offset of each page header
+  int			num_pages;	// Number of pages
+  ri_page_t		*results;	// Results for each page
+  std::atomic<int>	next_page;	// Next page to count
+} ri_job_t;
+
+
+//
+// Local functions...
+//
+
+static void	count_bytes(const uchar *p, size_t bytes, int period, uchar lastmask, unsigned long long *counts);
+static int	count_page(ri_job_t *job, cups_raster_t *ras, int page);
+static int	index_file(const char *filename, z_off_t **pages);
+static void	packed_table(int bpp, int bits, int nc, int period, unsigned *table);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static z_off_t	raster_offset(cups_raster_t *ras, gzFile fp);
+static void	sum_values(const uchar *p, size_t bytes, int size, int nc, unsigned long long *sums);
+static void	thread_cb(ri_job_t *job);
+static void	usage(FILE *out);
+static void	write_json_string(const char *s);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i, j, c;		// Looping vars
+  ri_job_t	job;			// Counting job
+  int		json = 0,		// Write JSON instead of CSV?
+		num_files = 0,		// Number of files
+		count = 0,		// Number of pages written
+		num_threads = 0,	// Number of threads
+		threads_used,		// Number of threads for this file
+		status = 0;		// Exit status
+  ri_page_t	*result;		// Current page result
+  double	total;			// Total coverage
+  std::thread	threads[RI_MAX_THREADS];
+					// Counting threads
+
+
+  // Parse command-line
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--csv"))
+    {
+      json = 0;
+    }
+    else if (!strcmp(argv[i], "--json"))
+    {
+      json = 1;
+    }
+    else if (!strcmp(argv[i], "--threads"))
+    {
+      i ++;
+      if (i >= argc || (num_threads = atoi(argv[i])) < 1)
+      {
+        fputs("rasterink: Expected number of threads after '--threads'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "rasterink: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+    else
+      num_files ++;
+  }
+
+  if (!num_files)
+  {
+    usage(stderr);
+    return (1);
+  }
+
+  // Count the pages of each file...
+  if (json)
+    puts("[");
+  else
+    puts("filename,page,width,height,colorspace,bits,total,coverage1,coverage2,coverage3,coverage4,coverage5,coverage6,coverage7,coverage8,coverage9,coverage10,coverage11,coverage12,coverage13,coverage14,coverage15");
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--threads"))
+    {
+      i ++;
+      continue;
+    }
+    else if (argv[i][0] == '-')
+      continue;
+
+    job.filename  = argv[i];
+    job.pages     = NULL;
+    job.next_page = 0;
+
+    if ((job.num_pages = index_file(job.filename, &job.pages)) < 0)
+    {
+      status = 1;
+      continue;
+    }
+
+    // Count pages in parallel, each thread using its own raster stream...
+    job.results = new ri_page_t[job.num_pages > 0 ? job.num_pages : 1];
+
+    if ((threads_used = num_threads) == 0)
+      threads_used = (int)std::thread::hardware_concurrency();
+    if (threads_used > job.num_pages)
+      threads_used = job.num_pages;
+    if (threads_used > RI_MAX_THREADS)
+      threads_used = RI_MAX_THREADS;
+
+    for (j = 0; j < threads_used; j ++)
+      threads[j] = std::thread(thread_cb, &job);
+
+    for (j = 0; j < threads_used; j ++)
+      threads[j].join();
+
+    // Report the coverage in page order...
+    for (j = 0, result = job.results; j < job.num_pages; j ++, result ++)
+    {
+      if (!result->status)
+      {
+        status = 1;
+        continue;
+      }
+
+      for (c = 0, total = 0.0; c < result->num_channels; c ++)
+        total += result->coverage[c];
+
+      if (json)
+      {
+        printf("%s  {\"filename\": ", count ? ",\n" : "");
+        write_json_string(job.filename);
+        printf(", \"page\": %d, \"width\": %u, \"height\": %u, \"colorspace\": \"%s\", \"bits\": %u, \"total\": %.3f, \"coverage\": [", j + 1, result->width, result->height, _cupsRasterColorSpaceString(result->cspace), result->bits, total);
+
+        for (c = 0; c < result->num_channels; c ++)
+          printf("%s%.3f", c ? ", " : "", result->coverage[c]);
+
+        fputs("]}", stdout);
+      }
+      else
+      {
+        if (strpbrk(job.filename, ",\"\n"))
+        {
+          // Quote filenames with special characters...
+          const char *ptr;		// Pointer into filename
+
+          putchar('\"');
+          for (ptr = job.filename; *ptr; ptr ++)
+          {
+            if (*ptr == '\"')
+              putchar('\"');
+            putchar(*ptr);
+          }
+          putchar('\"');
+        }
+        else
+          fputs(job.filename, stdout);
+
+        printf(",%d,%u,%u,%s,%u,%.3f", j + 1, result->width, result->height, _cupsRasterColorSpaceString(result->cspace), result->bits, total);
+
+        for (c = 0; c < 15; c ++)
+        {
+          if (c < result->num_channels)
+            printf(",%.3f", result->coverage[c]);
+          else
+            putchar(',');
+        }
+
+        putchar('\n');
+      }
+
+      count ++;
+    }
+
+    delete[] job.results;
+    delete[] job.pages;
+  }
+
+  if (json)
+    puts(count ? "\n]" : "]");
+
+  return (status);
+}
+
+
+//
+// 'count_bytes()' - Count the byte values in packed raster data.
+//
+// Each byte is counted by its value and position in a repeating group of
+// `period` bytes, which is enough to find the channel sums with a lookup
+// table later.  The padding bits at the end of the last byte are ignored...
+//
+
+static void
+count_bytes(const uchar        *p,	// I - Raster data
+            size_t             bytes,	// I - Number of bytes
+            int                period,	// I - Bytes in each group of pixels
+            uchar              lastmask,// I - Bits of last byte to count
+            unsigned long long *counts)	// IO - Counts for each position and value
+{
+  size_t	i;			// Looping var
+  int		j;			// Position in group
+
+
+  if (bytes == 0)
+    return;
+
+  bytes --;
+  counts[(int)(bytes % (size_t)period) * 256 + (p[bytes] & lastmask)] ++;
+
+  if (period == 1)
+  {
+    for (i = 0; i < bytes; i ++)
+      counts[p[i]] ++;
+  }
+  else
+  {
+    for (i = 0, j = 0; i < bytes; i ++)
+    {
+      counts[j * 256 + p[i]] ++;
+
+      if (++ j >= period)
+        j = 0;
+    }
+  }
+}
+
+
+//
+// 'count_page()' - Count the ink coverage of one page.
+//
+// Pixels are summed straight from the raster data without converting them.
+// 8- and 16-bit values are summed eight bytes at a time, and packed 1-, 2-,
+// and 4-bit values are counted by byte and summed with a lookup table...
+//
+
+static int				// O - 1 on success, 0 on failure
+count_page(ri_job_t      *job,		// I - Counting job
+           cups_raster_t *ras,		// I - Raster stream
+           int           page)		// I - Page index
+{
+  cups_page_header_t	header;		// Page header
+  ri_page_t		*result = job->results + page;
+					// Result for this page
+  int			c, j, b,	// Looping vars
+			nc,		// Number of channels
+			bpp,		// Bits per pixel in the packed data
+			period,		// Bytes in each group of pixels
+			ncounts;	// Number of count arrays
+  uchar			lastmask;	// Bits of last byte in each line
+  unsigned		y,		// Current line
+			lines,		// Number of lines
+			bytes,		// Bytes per channel in each line
+			*table = NULL;	// Channel values for each byte
+  unsigned long long	sums[15],	// Sum of each channel
+			*counts = NULL;	// Number of each byte value
+  uchar			*line;		// Raster line
+
+
+  memset(result, 0, sizeof(ri_page_t));
+  memset(sums, 0, sizeof(sums));
+
+  if (!cupsRasterReadHeader(ras, &header))
+  {
+    fprintf(stderr, "rasterink: Unable to read page %d of '%s': %s\n", page + 1, job->filename, cupsRasterErrorString());
+    return (0);
+  }
+
+  nc = (int)header.cupsNumColors;
+
+  if (nc < 1 || nc > 15 || header.cupsBytesPerLine == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 2 && header.cupsBitsPerColor != 4 && header.cupsBitsPerColor != 8 && header.cupsBitsPerColor != 16))
+  {
+    fprintf(stderr, "rasterink: Page %d of '%s' has an unsupported format.\n", page + 1, job->filename);
+    return (0);
+  }
+
+  result->width        = header.cupsWidth;
+  result->height       = header.cupsHeight;
+  result->bits         = header.cupsBitsPerColor;
+  result->cspace       = header.cupsColorSpace;
+  result->num_channels = nc;
+
+  if (header.cupsColorOrder == CUPS_ORDER_CHUNKED)
+  {
+    bpp   = (int)header.cupsBitsPerPixel;
+    lines = header.cupsHeight;
+    bytes = header.cupsBytesPerLine;
+  }
+  else
+  {
+    bpp   = (int)header.cupsBitsPerColor;
+    lines = header.cupsColorOrder == CUPS_ORDER_PLANAR ? header.cupsHeight * (unsigned)nc : header.cupsHeight;
+    bytes = header.cupsColorOrder == CUPS_ORDER_BANDED ? header.cupsBytesPerLine / (unsigned)nc : header.cupsBytesPerLine;
+  }
+
+  if ((header.cupsWidth * (unsigned)bpp) & 7)
+    lastmask = (uchar)(0xff << (8 - ((header.cupsWidth * (unsigned)bpp) & 7)));
+  else
+    lastmask = 0xff;
+
+  if (header.cupsBitsPerColor < 8)
+  {
+    // Packed values are counted by byte, separately for each position in a
+    // group of pixels that fills whole bytes or, for banded and planar data,
+    // for each channel...
+    if (header.cupsColorOrder == CUPS_ORDER_CHUNKED)
+    {
+      for (period = 1; (period * 8) % bpp; period ++);
+
+      ncounts = period;
+      table   = new unsigned[(size_t)period * 256 * (size_t)nc];
+
+      packed_table(bpp, (int)header.cupsBitsPerColor, nc, period, table);
+    }
+    else
+    {
+      period  = 1;
+      ncounts = nc;
+      table   = new unsigned[256];
+
+      packed_table(bpp, bpp, 1, 1, table);
+    }
+
+    counts = new unsigned long long[(size_t)ncounts * 256];
+    memset(counts, 0, (size_t)ncounts * 256 * sizeof(unsigned long long));
+  }
+  else
+    period = ncounts = 0;
+
+  line = new uchar[header.cupsBytesPerLine];
+
+  for (y = 0; y < lines; y ++)
+  {
+    if (!cupsRasterReadPixels(ras, line, header.cupsBytesPerLine))
+    {
+      fprintf(stderr, "rasterink: Unable to read page %d of '%s': %s\n", page + 1, job->filename, cupsRasterErrorString());
+      break;
+    }
+
+    switch (header.cupsColorOrder)
+    {
+      case CUPS_ORDER_CHUNKED :
+          if (counts)
+            count_bytes(line, bytes, period, lastmask, counts);
+          else
+            sum_values(line, bytes, (int)header.cupsBitsPerColor / 8, nc, sums);
+          break;
+
+      case CUPS_ORDER_BANDED :
+          for (c = 0; c < nc; c ++)
+          {
+            if (counts)
+              count_bytes(line + c * bytes, bytes, 1, lastmask, counts + c * 256);
+            else
+              sum_values(line + c * bytes, bytes, (int)header.cupsBitsPerColor / 8, 1, sums + c);
+          }
+          break;
+
+      default :
+          c = (int)(y / header.cupsHeight);
+
+          if (counts)
+            count_bytes(line, bytes, 1, lastmask, counts + c * 256);
+          else
+            sum_values(line, bytes, (int)header.cupsBitsPerColor / 8, 1, sums + c);
+          break;
+    }
+  }
+
+  delete[] line;
+
+  if (counts)
+  {
+    // Add up the channel values of the counted bytes...
+    for (j = 0; j < ncounts; j ++)
+    {
+      for (b = 0; b < 256; b ++)
+      {
+        if (!counts[j * 256 + b])
+          continue;
+
+        if (header.cupsColorOrder == CUPS_ORDER_CHUNKED)
+        {
+          for (c = 0; c < nc; c ++)
+            sums[c] += counts[j * 256 + b] * table[(j * 256 + b) * nc + c];
+        }
+        else
+          sums[j] += counts[j * 256 + b] * table[b];
+      }
+    }
+
+    delete[] counts;
+    delete[] table;
+  }
+
+  if (y < lines)
+    return (0);
+
+  // Convert the sums to percentages...
+  for (c = 0; c < nc; c ++)
+    result->coverage[c] = rasterInkCoverage(&header, (double)sums[c]);
+
+  result->status = 1;
+
+  return (1);
+}
+
+
+//
+// 'index_file()' - Find the offset of each page header in a raster file.
+//
+// The page data is skipped without decoding it.
+//
+
+static int				// O - Number of pages or -1 on error
+index_file(const char *filename,	// I - Raster file
+           z_off_t    **pages)		// O - Offset of each page header
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  z_off_t		offset,		// Offset of page header
+			*temp;		// New page array
+  unsigned		lines;		// Lines in page
+  int			num_pages = 0,	// Number of pages
+			alloc_pages = 0;// Number of pages allocated
+
+
+  if ((fp = gzopen(filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rasterink: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (-1);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rasterink: Unable to read '%s': %s\n", filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (-1);
+  }
+
+  for (offset = raster_offset(ras, fp); cupsRasterReadHeader(ras, &header); offset = raster_offset(ras, fp))
+  {
+    if (num_pages >= alloc_pages)
+    {
+      temp = new z_off_t[alloc_pages + 100];
+
+      if (*pages)
+      {
+        memcpy(temp, *pages, (size_t)alloc_pages * sizeof(z_off_t));
+        delete[] *pages;
+      }
+
+      *pages      = temp;
+      alloc_pages += 100;
+    }
+
+    (*pages)[num_pages ++] = offset;
+
+    if (header.cupsColorOrder == CUPS_ORDER_PLANAR)
+      lines = header.cupsHeight * header.cupsNumColors;
+    else
+      lines = header.cupsHeight;
+
+    if (_cupsRasterSkipLines(ras, lines) != lines)
+    {
+      // Count the truncated page so the error is reported for it...
+      fprintf(stderr, "rasterink: Page %d of '%s' is truncated.\n", num_pages, filename);
+      break;
+    }
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+
+  return (num_pages);
+}
+
+
+//
+// 'packed_table()' - Make a table of the channel values in each byte of packed
+//                    raster data.
+//
+// Channels never span bytes since they are 1, 2, or 4 bits, so the channel
+// sums of a group of pixels are the sums of the table entries of its bytes.
+// Within a pixel the first channel is in the most significant bits...
+//
+
+static void
+packed_table(int      bpp,		// I - Bits per pixel
+             int      bits,		// I - Bits per channel
+             int      nc,		// I - Number of channels
+             int      period,		// I - Bytes in each group of pixels
+             unsigned *table)		// O - Channel values for each position and byte
+{
+  int		j, b, c,		// Looping vars
+		bit,			// Bit in group
+		pixel,			// Pixel in group
+		shift;			// Bits from end of pixel
+
+
+  memset(table, 0, (size_t)period * 256 * (size_t)nc * sizeof(unsigned));
+
+  for (j = 0; j < period; j ++)
+  {
+    for (b = 0; b < 256; b ++)
+    {
+      // Find the pixel and channel of each set of bits in the byte...
+      for (bit = j * 8; bit < (j + 1) * 8; bit += bits)
+      {
+        pixel = bit / bpp;
+        shift = (pixel + 1) * bpp - bit - bits;
+
+        if (shift >= nc * bits)
+          continue;			// Padding bits
+
+        c = nc - 1 - shift / bits;
+
+        table[(j * 256 + b) * nc + c] += (unsigned)(b >> (8 - bits - (bit - j * 8))) & ((1U << bits) - 1);
+      }
+    }
+  }
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'raster_offset()' - Get the file offset of the next raster data.
+//
+
+static z_off_t				// O - Offset in file
+raster_offset(cups_raster_t *ras,	// I - Raster stream
+              gzFile        fp)		// I - File
+{
+  return (gztell(fp) - (ras->compressed ? ras->bufend - ras->bufptr : 0));
+}
+
+
+//
+// 'sum_values()' - Sum the 8- or 16-bit channel values in raster data.
+//
+// The values are summed eight bytes at a time by adding alternate values to
+// separate lanes of 64-bit accumulators, which are added to the channel sums
+// before they can overflow.  A group of channels fills a whole number of
+// 64-bit words, so each lane always holds the same channel...
+//
+
+static void
+sum_values(const uchar        *p,	// I - Raster data
+           size_t             bytes,	// I - Number of bytes
+           int                size,	// I - Bytes per value (1 or 2)
+           int                nc,	// I - Number of channels
+           unsigned long long *sums)	// IO - Sum of each channel
+{
+  int			i, w, k,	// Looping vars
+			per,		// Values per word
+			nwords,		// Words in each group of channels
+			limit,		// Groups before accumulators overflow
+			groups,		// Groups in this pass
+			lanebits,	// Bits per lane
+			element,	// Value in even lane
+			oelement;	// Value in odd lane
+  uint64_t		word,		// Current word
+			mask,		// Mask for even values
+			lanemask,	// Mask for one lane
+			even[15],	// Accumulators for even values
+			odd[15];	// Accumulators for odd values
+  size_t		gbytes,		// Bytes in each group of channels
+			x;		// Value in tail
+
+
+  per      = 8 / size;
+  lanebits = 16 * size;
+  mask     = size == 1 ? 0x00ff00ff00ff00ffULL : 0x0000ffff0000ffffULL;
+  lanemask = size == 1 ? 0xffffULL : 0xffffffffULL;
+  limit    = size == 1 ? 256 : 65536;
+
+  for (nwords = 1; (nwords * per) % nc; nwords ++);
+
+  gbytes = (size_t)nwords * 8;
+
+  while (bytes >= gbytes)
+  {
+    memset(even, 0, sizeof(even));
+    memset(odd, 0, sizeof(odd));
+
+    for (groups = 0; groups < limit && bytes >= gbytes; groups ++, p += gbytes, bytes -= gbytes)
+    {
+      for (w = 0; w < nwords; w ++)
+      {
+        memcpy(&word, p + 8 * w, sizeof(word));
+
+        even[w] += word & mask;
+        odd[w]  += (word >> (8 * size)) & mask;
+      }
+    }
+
+    // Add the lanes to the channel sums...
+    for (w = 0; w < nwords; w ++)
+    {
+      for (k = 0; k < per / 2; k ++)
+      {
+        // The low-order value of a word is the last one in memory on
+        // big-endian hosts, so the even lanes hold the later value...
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        element = w * per + per - 1 - 2 * k;
+        oelement = element - 1;
+#else
+        element = w * per + 2 * k;
+        oelement = element + 1;
+#endif // __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+
+        sums[element % nc]  += (even[w] >> (k * lanebits)) & lanemask;
+        sums[oelement % nc] += (odd[w] >> (k * lanebits)) & lanemask;
+      }
+    }
+  }
+
+  // Add any remaining values one at a time...
+  for (x = 0, i = 0; x < bytes; x += (size_t)size)
+  {
+    if (size == 1)
+      sums[i] += p[x];
+    else
+    {
+      unsigned short val16;		// 16-bit value
+
+      memcpy(&val16, p + x, sizeof(val16));
+      sums[i] += val16;
+    }
+
+    if (++ i >= nc)
+      i = 0;
+  }
+}
+
+
+//
+// 'thread_cb()' - Count pages until there are none left.
+//
+
+static void
+thread_cb(ri_job_t *job)		// I - Counting job
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  int			page;		// Current page
+
+
+  if ((fp = gzopen(job->filename, "r")) == NULL || (ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rasterink: Unable to open '%s': %s\n", job->filename, strerror(errno));
+
+    if (fp)
+      gzclose(fp);
+
+    while ((page = job->next_page ++) < job->num_pages)
+      job->results[page].status = 0;
+    return;
+  }
+
+  while ((page = job->next_page ++) < job->num_pages)
+  {
+    // Position the stream at the page header...
+    gzseek(fp, job->pages[page], SEEK_SET);
+
+    ras->bufptr = ras->buffer;
+    ras->bufend = ras->buffer;
+
+    count_page(job, ras, page);
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rasterink [OPTIONS] FILENAME [... FILENAME]\n", out);
+  fputs("Options:\n", out);
+  fputs("  --csv            Write CSV (default).\n", out);
+  fputs("  --help           Show program usage.\n", out);
+  fputs("  --json           Write JSON.\n", out);
+  fputs("  --threads COUNT  Count COUNT pages at a time.\n", out);
+}
+
+
+//
+// 'write_json_string()' - Write a quoted JSON string.
+//
+
+static void
+write_json_string(const char *s)	// I - String
+{
+  putchar('\"');
+
+  for (; *s; s ++)
+  {
+    if (*s == '\"' || *s == '\\')
+    {
+      putchar('\\');
+      putchar(*s);
+    }
+    else if ((*s & 255) < ' ')
+      printf("\\u%04x", *s);
+    else
+      putchar(*s);
+  }
+
+  putchar('\"');
+}
@@ -0,0 +1,353 @@
+//
+// Program to copy pages from raster files without decoding them.
+//
+// Usage:
+//
+//   ./rastersplit [--count PAGES] [--pages LIST] FILENAME OUTPUT
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include "raster-private.h"
+#include "raster-pages.h"
+
+
+//
+// Local functions...
+//
+
+static int	index_file(const char *filename, int max_page, z_off_t *header, raster_extent_t **pages);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static z_off_t	raster_offset(cups_raster_t *ras, gzFile fp);
+static void	usage(FILE *out);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i,			// Looping var
+		page;			// Current page
+  const char	*filename = NULL,	// Raster file
+		*output = NULL,		// Output file or prefix
+		*list = "1-",		// Pages to copy
+		*ext;			// Output file extension
+  int		count = 0;		// Pages per output file (0 = all)
+  int		ranges[2 * RASTER_MAX_RANGES],
+					// Page ranges
+		num_ranges,		// Number of page ranges
+		max_page,		// Last page needed
+		num_pages,		// Number of pages in file
+		num_copy = 0,		// Number of pages to copy
+		alloc_copy = 0;		// Number of pages allocated
+  z_off_t	header;			// Size of file header
+  raster_extent_t *pages = NULL,	// Byte ranges of pages in file
+		*copy = NULL,		// Byte ranges of pages to copy
+		*temp;			// New pages
+  char		name[1024];		// Output filename
+
+
+  // Parse command-line
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--count"))
+    {
+      i ++;
+
+      if (i >= argc || (count = atoi(argv[i])) < 1)
+      {
+        fputs("rastersplit: Expected page count after '--count'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "--pages"))
+    {
+      i ++;
+
+      if (i >= argc)
+      {
+        fputs("rastersplit: Expected page list after '--pages'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+
+      list = argv[i];
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "rastersplit: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+    else if (!filename)
+    {
+      filename = argv[i];
+    }
+    else if (!output)
+    {
+      output = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "rastersplit: Unexpected argument '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+  }
+
+  if (!output)
+  {
+    usage(stderr);
+    return (1);
+  }
+
+  if ((num_ranges = rasterPageRanges(list, ranges, RASTER_MAX_RANGES)) < 0)
+  {
+    fprintf(stderr, "rastersplit: Bad page list '%s'.\n", list);
+    return (1);
+  }
+
+  // Find the pages, stopping after the last one that is needed...
+  for (i = 0, max_page = 0; i < num_ranges; i ++)
+  {
+    if (ranges[2 * i + 1] > max_page)
+      max_page = ranges[2 * i + 1];
+  }
+
+  if ((num_pages = index_file(filename, max_page, &header, &pages)) < 0)
+    return (1);
+
+  // Make the list of pages to copy, in the order given...
+  for (i = 0; i < num_ranges; i ++)
+  {
+    if (ranges[2 * i] > num_pages)
+    {
+      fprintf(stderr, "rastersplit: Page %d is out of range, '%s' has %d pages.\n", ranges[2 * i], filename, num_pages);
+      free(pages);
+      free(copy);
+      return (1);
+    }
+
+    for (page = ranges[2 * i]; page <= ranges[2 * i + 1] && page <= num_pages; page ++)
+    {
+      if (num_copy >= alloc_copy)
+      {
+        if ((temp = realloc(copy, (size_t)(alloc_copy + 1024) * sizeof(raster_extent_t))) == NULL)
+        {
+          fputs("rastersplit: Unable to allocate memory for pages.\n", stderr);
+          free(pages);
+          free(copy);
+          return (1);
+        }
+
+        copy       = temp;
+        alloc_copy += 1024;
+      }
+
+      copy[num_copy ++] = pages[page - 1];
+    }
+  }
+
+  // Copy the pages...
+  if (count == 0)
+  {
+    if (!rasterCopyPages(output, filename, header, copy, num_copy))
+    {
+      fprintf(stderr, "rastersplit: Unable to write '%s': %s\n", output, strerror(errno));
+      free(pages);
+      free(copy);
+      return (1);
+    }
+  }
+  else
+  {
+    // Name each file using the extension of the source file, without any
+    // ".gz" since the pages are written uncompressed...
+    const char	*base,			// Filename without directory
+		*ptr;			// Pointer into filename
+    size_t	extlen;			// Length of extension
+
+    if ((base = strrchr(filename, '/')) != NULL)
+      base ++;
+    else
+      base = filename;
+
+    extlen = strlen(base);
+
+    if (extlen > 3 && !strcmp(base + extlen - 3, ".gz"))
+      extlen -= 3;
+
+    for (ptr = base + extlen; ptr > base && ptr[-1] != '.'; ptr --);
+
+    if (ptr > (base + 1))
+    {
+      ext    = ptr - 1;
+      extlen = (size_t)(base + extlen - ext);
+    }
+    else
+    {
+      ext    = ".ras";
+      extlen = 4;
+    }
+
+    for (i = 0; i < num_copy; i += count)
+    {
+      snprintf(name, sizeof(name), "%s-%d%.*s", output, i / count + 1, (int)extlen, ext);
+
+      if (!rasterCopyPages(name, filename, header, copy + i, num_copy - i < count ? num_copy - i : count))
+      {
+        fprintf(stderr, "rastersplit: Unable to write '%s': %s\n", name, strerror(errno));
+        free(pages);
+        free(copy);
+        return (1);
+      }
+    }
+  }
+
+  free(pages);
+  free(copy);
+
+  return (0);
+}
+
+
+//
+// 'index_file()' - Find the byte ranges of the pages in a raster file.
+//
+// The page data is skipped without decoding it...
+//
+
+static int				// O - Number of pages or -1 on error
+index_file(const char      *filename,	// I - Raster file
+           int             max_page,	// I - Last page needed
+           z_off_t         *header,	// O - Size of file header
+           raster_extent_t **pages)	// O - Byte ranges of pages
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	h;		// Page header
+  int			num_pages = 0,	// Number of pages
+			alloc_pages = 0;// Number of pages allocated
+  unsigned		lines;		// Lines in page data
+  z_off_t		start;		// Start of page
+  raster_extent_t	*temp;		// New pages
+
+
+  *pages = NULL;
+
+  if ((fp = gzopen(filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rastersplit: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (-1);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rastersplit: Unable to read '%s': %s\n", filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (-1);
+  }
+
+  *header = raster_offset(ras, fp);
+
+  for (start = *header; num_pages < max_page && cupsRasterReadHeader(ras, &h); start = (*pages)[num_pages - 1].end)
+  {
+    if (num_pages >= alloc_pages)
+    {
+      if ((temp = realloc(*pages, (size_t)(alloc_pages + 1024) * sizeof(raster_extent_t))) == NULL)
+      {
+        fputs("rastersplit: Unable to allocate memory for pages.\n", stderr);
+        num_pages = -1;
+        break;
+      }
+
+      *pages      = temp;
+      alloc_pages += 1024;
+    }
+
+    lines = h.cupsHeight;
+
+    if (h.cupsColorOrder == CUPS_ORDER_PLANAR && h.cupsNumColors > 1)
+      lines *= h.cupsNumColors;
+
+    if (_cupsRasterSkipLines(ras, lines) != lines)
+    {
+      fprintf(stderr, "rastersplit: Page %d of '%s' is truncated.\n", num_pages + 1, filename);
+      num_pages = -1;
+      break;
+    }
+
+    (*pages)[num_pages].start = start;
+    (*pages)[num_pages].end   = raster_offset(ras, fp);
+    num_pages ++;
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+
+  if (num_pages < 0)
+  {
+    free(*pages);
+    *pages = NULL;
+  }
+
+  return (num_pages);
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'raster_offset()' - Return the current offset in the raster stream.
+//
+
+static z_off_t				// O - Offset
+raster_offset(cups_raster_t *ras,	// I - Raster stream
+              gzFile        fp)		// I - File
+{
+  return (gztell(fp) - (ras->compressed ? ras->bufend - ras->bufptr : 0));
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rastersplit [OPTIONS] FILENAME OUTPUT\n", out);
+  fputs("Options:\n", out);
+  fputs("  --count PAGES  Write PAGES pages to each file named OUTPUT-N.ext.\n", out);
+  fputs("  --help         Show program usage.\n", out);
+  fputs("  --pages LIST   Copy the listed pages, for example \"1-3,7,10-\".\n", out);
+}
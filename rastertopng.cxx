@@ -0,0 +1,557 @@
+//
+// Program to convert raster files to PNG images.
+//
+// Usage:
+//
+//   ./rastertopng [OPTIONS] FILENAME
+//
+// Copyright © 2023 by Michael R Sweet
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-private.h"
+#include "raster-convert.h"
+#include "raster-png.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <zlib.h>
+#include <atomic>
+#include <thread>
+
+
+//
+// Constants...
+//
+
+#define RTP_MAX_THREADS	16		// Maximum conversion threads
+
+
+//
+// Local types...
+//
+
+typedef unsigned char uchar;		// Unsigned 8-bit value
+
+typedef struct rtp_job_s		// Conversion job shared by all threads
+{
+  const char		*filename,	// Raster file
+			*prefix;	// Output filename prefix
+  z_off_t		*pages;		// Offset of each page header
+  int			num_pages;	// Number of pages
+  float			scale;		// Output scale (0 = fit max_size)
+  int			max_size;	// Maximum width or height (0 = none)
+  std::atomic<int>	next_page,	// Next page to convert
+			errors;		// Number of pages that failed
+} rtp_job_t;
+
+
+//
+// Local functions...
+//
+
+static int	index_file(rtp_job_t *job);
+static ssize_t	raster_cb(gzFile ctx, unsigned char *buffer, size_t length);
+static z_off_t	raster_offset(cups_raster_t *ras, gzFile fp);
+static void	thread_cb(rtp_job_t *job);
+static void	usage(FILE *out);
+static int	write_page(rtp_job_t *job, cups_raster_t *ras, int page);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  rtp_job_t	job;			// Conversion job
+  char		prefix[1024],		// Default output prefix
+		*ptr;			// Pointer into prefix
+  int		num_threads = 0;	// Number of threads
+  std::thread	threads[RTP_MAX_THREADS];
+					// Conversion threads
+
+
+  // Parse command-line
+  job.filename  = NULL;
+  job.prefix    = NULL;
+  job.pages     = NULL;
+  job.num_pages = 0;
+  job.scale     = 1.0f;
+  job.max_size  = 0;
+  job.next_page = 0;
+  job.errors    = 0;
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      usage(stdout);
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--max-size"))
+    {
+      i ++;
+      if (i >= argc || (job.max_size = atoi(argv[i])) < 1)
+      {
+        fputs("rastertopng: Expected maximum size in pixels after '--max-size'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+
+      job.scale = 0.0f;
+    }
+    else if (!strcmp(argv[i], "--scale"))
+    {
+      i ++;
+      if (i >= argc || (job.scale = (float)atof(argv[i])) <= 0.0f || job.scale > 1.0f)
+      {
+        fputs("rastertopng: Expected scale from 0.0 to 1.0 after '--scale'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+
+      job.max_size = 0;
+    }
+    else if (!strcmp(argv[i], "--threads"))
+    {
+      i ++;
+      if (i >= argc || (num_threads = atoi(argv[i])) < 1)
+      {
+        fputs("rastertopng: Expected number of threads after '--threads'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "-o"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("rastertopng: Expected output prefix after '-o'.\n", stderr);
+        usage(stderr);
+        return (1);
+      }
+
+      job.prefix = argv[i];
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "rastertopng: Unknown option '%s'.\n", argv[i]);
+      usage(stderr);
+      return (1);
+    }
+    else if (job.filename)
+    {
+      fputs("rastertopng: Only one raster file can be converted at a time.\n", stderr);
+      usage(stderr);
+      return (1);
+    }
+    else
+      job.filename = argv[i];
+  }
+
+  if (!job.filename)
+  {
+    usage(stderr);
+    return (1);
+  }
+
+  if (!job.prefix)
+  {
+    // Default to the raster filename without its extension...
+    strncpy(prefix, job.filename, sizeof(prefix) - 1);
+    prefix[sizeof(prefix) - 1] = '\0';
+
+    if ((ptr = strrchr(prefix, '.')) != NULL && !strchr(ptr, '/'))
+      *ptr = '\0';
+
+    job.prefix = prefix;
+  }
+
+  // Find the start of each page...
+  if (!index_file(&job))
+    return (1);
+
+  // Convert pages in parallel, each thread using its own raster stream...
+  if (num_threads == 0)
+    num_threads = (int)std::thread::hardware_concurrency();
+  if (num_threads > job.num_pages)
+    num_threads = job.num_pages;
+  if (num_threads > RTP_MAX_THREADS)
+    num_threads = RTP_MAX_THREADS;
+  if (num_threads < 1)
+    num_threads = 1;
+
+  for (i = 0; i < num_threads; i ++)
+    threads[i] = std::thread(thread_cb, &job);
+
+  for (i = 0; i < num_threads; i ++)
+    threads[i].join();
+
+  delete[] job.pages;
+
+  return (job.errors > 0);
+}
+
+
+//
+// 'index_file()' - Find the offset of each page header in a raster file.
+//
+// The page data is skipped without decoding it.
+//
+
+static int				// O - 1 on success, 0 on failure
+index_file(rtp_job_t *job)		// I - Conversion job
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		lines;		// Number of lines in page
+  z_off_t		offset,		// Offset of page header
+			*temp;		// New page array
+  int			alloc_pages = 0;// Number of pages allocated
+  int			status = 1;	// Return status
+
+
+  if ((fp = gzopen(job->filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rastertopng: Unable to open '%s': %s\n", job->filename, strerror(errno));
+    return (0);
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rastertopng: Unable to read '%s': %s\n", job->filename, cupsRasterErrorString());
+    gzclose(fp);
+    return (0);
+  }
+
+  for (offset = raster_offset(ras, fp); cupsRasterReadHeader(ras, &header); offset = raster_offset(ras, fp))
+  {
+    if (job->num_pages >= alloc_pages)
+    {
+      temp = new z_off_t[alloc_pages + 100];
+
+      if (job->pages)
+      {
+        memcpy(temp, job->pages, (size_t)alloc_pages * sizeof(z_off_t));
+        delete[] job->pages;
+      }
+
+      job->pages  = temp;
+      alloc_pages += 100;
+    }
+
+    job->pages[job->num_pages ++] = offset;
+
+    lines = header.cupsHeight;
+
+    if (header.cupsColorOrder == CUPS_ORDER_PLANAR && header.cupsNumColors > 1)
+      lines *= header.cupsNumColors;
+
+    if (_cupsRasterSkipLines(ras, lines) != lines)
+    {
+      fprintf(stderr, "rastertopng: Page %d of '%s' is truncated.\n", job->num_pages, job->filename);
+      job->num_pages --;
+      status = 0;
+      break;
+    }
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+
+  if (job->num_pages == 0)
+  {
+    fprintf(stderr, "rastertopng: No pages in '%s'.\n", job->filename);
+    status = 0;
+  }
+
+  return (status);
+}
+
+
+//
+// 'raster_cb()' - Read data from a gzFile.
+//
+
+static ssize_t				// O - Bytes read or -1 on error
+raster_cb(gzFile        ctx,		// I - File pointer
+          unsigned char *buffer,	// I - Buffer
+          size_t        length)		// I - Bytes to read
+{
+  return ((ssize_t)gzread(ctx, buffer, (unsigned)length));
+}
+
+
+//
+// 'raster_offset()' - Get the file offset of the next raster data.
+//
+
+static z_off_t				// O - Offset in file
+raster_offset(cups_raster_t *ras,	// I - Raster stream
+              gzFile        fp)		// I - File
+{
+  return (gztell(fp) - (ras->compressed ? ras->bufend - ras->bufptr : 0));
+}
+
+
+//
+// 'thread_cb()' - Convert pages until there are none left.
+//
+
+static void
+thread_cb(rtp_job_t *job)		// I - Conversion job
+{
+  gzFile		fp;		// File
+  cups_raster_t		*ras;		// Raster stream
+  int			page;		// Current page
+
+
+  if ((fp = gzopen(job->filename, "r")) == NULL)
+  {
+    fprintf(stderr, "rastertopng: Unable to open '%s': %s\n", job->filename, strerror(errno));
+    job->errors ++;
+    return;
+  }
+
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)raster_cb, fp, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "rastertopng: Unable to read '%s': %s\n", job->filename, cupsRasterErrorString());
+    gzclose(fp);
+    job->errors ++;
+    return;
+  }
+
+  while ((page = job->next_page ++) < job->num_pages)
+  {
+    // Position the stream at the page header...
+    gzseek(fp, job->pages[page], SEEK_SET);
+
+    ras->bufptr = ras->buffer;
+    ras->bufend = ras->buffer;
+
+    if (!write_page(job, ras, page))
+      job->errors ++;
+  }
+
+  cupsRasterClose(ras);
+  gzclose(fp);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ./rastertopng [OPTIONS] FILENAME\n", out);
+  fputs("Options:\n", out);
+  fputs("  --help             Show program usage.\n", out);
+  fputs("  --max-size PIXELS  Scale pages to fit in PIXELS by PIXELS.\n", out);
+  fputs("  --scale FACTOR     Scale pages by FACTOR (0.0 to 1.0).\n", out);
+  fputs("  --threads COUNT    Convert COUNT pages at a time.\n", out);
+  fputs("  -o PREFIX          Write pages to PREFIX-N.png.\n", out);
+}
+
+
+//
+// 'write_page()' - Convert one page to a PNG file.
+//
+// Rows are converted and written as they are read.  When scaling, each output
+// pixel is the average of the source pixels it covers, accumulated over the
+// source rows for each output row.
+//
+
+static int				// O - 1 on success, 0 on failure
+write_page(rtp_job_t     *job,		// I - Conversion job
+           cups_raster_t *ras,		// I - Raster stream
+           int           page)		// I - Page index
+{
+  cups_page_header_t	header;		// Page header
+  uchar			device_colors[15][3];
+					// RGB values for each device color
+  int			bpc,		// Bytes per color
+			bpp;		// Bytes per pixel
+  unsigned		width,		// Output width
+			height,		// Output height
+			x, y,		// Source position
+			sx,		// Start of output column
+			ox, oy,		// Output position
+			rows;		// Source rows in output row
+  int			c;		// Channel
+  float			scale;		// Output scale
+  uchar			*line,		// Raster line
+			*colors,	// Original pixels
+			*pixels,	// Converted pixels
+			*output;	// Scaled pixels
+  unsigned		*xmap = NULL;	// First source column for each output column
+  unsigned long long	*sums = NULL;	// Sums of source pixels
+  char			filename[1024];	// Output filename
+  raster_png_t		*png;		// PNG file
+  int			status = 1;	// Return status
+
+
+  if (!cupsRasterReadHeader(ras, &header))
+  {
+    fprintf(stderr, "rastertopng: Unable to read page %d of '%s': %s\n", page + 1, job->filename, cupsRasterErrorString());
+    return (0);
+  }
+
+  if (header.cupsWidth == 0 || header.cupsWidth > 1000000 || header.cupsHeight == 0 || header.cupsHeight > 1000000)
+  {
+    fprintf(stderr, "rastertopng: Page %d of '%s' dimensions are out of range (%ux%u).\n", page + 1, job->filename, header.cupsWidth, header.cupsHeight);
+    return (0);
+  }
+
+  if (header.cupsColorOrder == CUPS_ORDER_PLANAR && header.cupsNumColors > 1)
+  {
+    // Each plane is a separate set of lines, which can't be converted row by row...
+    fprintf(stderr, "rastertopng: Page %d of '%s' uses planar color order, which is not supported.\n", page + 1, job->filename);
+    return (0);
+  }
+
+  // Figure out the output size...
+  if (job->max_size > 0)
+  {
+    if (header.cupsWidth > header.cupsHeight)
+      scale = (float)job->max_size / (float)header.cupsWidth;
+    else
+      scale = (float)job->max_size / (float)header.cupsHeight;
+
+    if (scale > 1.0f)
+      scale = 1.0f;
+  }
+  else
+    scale = job->scale;
+
+  if ((width = (unsigned)(header.cupsWidth * scale + 0.5f)) < 1)
+    width = 1;
+  else if (width > header.cupsWidth)
+    width = header.cupsWidth;
+
+  if ((height = (unsigned)(header.cupsHeight * scale + 0.5f)) < 1)
+    height = 1;
+  else if (height > header.cupsHeight)
+    height = header.cupsHeight;
+
+  // Allocate buffers for one row...
+  bpp = header.cupsNumColors == 1 ? 1 : 3;
+  bpc = (int)(header.cupsBitsPerPixel + 7) / 8;
+
+  if (header.cupsColorOrder != CUPS_ORDER_CHUNKED)
+    bpc *= (int)header.cupsNumColors;
+
+  line   = new uchar[header.cupsBytesPerLine];
+  colors = new uchar[(size_t)header.cupsWidth * (size_t)bpc];
+  pixels = new uchar[(size_t)header.cupsWidth * (size_t)bpp];
+  output = new uchar[(size_t)width * (size_t)bpp];
+
+  if (width < header.cupsWidth || height < header.cupsHeight)
+  {
+    xmap = new unsigned[width + 1];
+    sums = new unsigned long long[(size_t)width * (size_t)bpp];
+
+    for (ox = 0; ox <= width; ox ++)
+      xmap[ox] = (unsigned)((unsigned long long)ox * header.cupsWidth / width);
+
+    memset(sums, 0, (size_t)width * (size_t)bpp * sizeof(unsigned long long));
+  }
+
+  rasterConvertColors(&header, device_colors);
+
+  snprintf(filename, sizeof(filename), "%s-%d.png", job->prefix, page + 1);
+
+  if ((png = rasterPNGCreate(filename, width, height, bpp, (unsigned)(header.HWResolution[0] * scale + 0.5f), (unsigned)(header.HWResolution[1] * scale + 0.5f))) == NULL)
+  {
+    fprintf(stderr, "rastertopng: Unable to create '%s': %s\n", filename, strerror(errno));
+    status = 0;
+    goto done;
+  }
+
+  // Convert and write the rows...
+  for (y = 0, oy = 0, rows = 0; y < header.cupsHeight; y ++)
+  {
+    if (!cupsRasterReadPixels(ras, line, header.cupsBytesPerLine))
+    {
+      fprintf(stderr, "rastertopng: Unable to read page %d of '%s': %s\n", page + 1, job->filename, cupsRasterErrorString());
+      status = 0;
+      break;
+    }
+
+    memset(pixels, 255, (size_t)header.cupsWidth * (size_t)bpp);
+    rasterConvertLine(&header, (int)y, line, colors, pixels, device_colors);
+
+    if (!sums)
+    {
+      if (!rasterPNGWriteRow(png, pixels))
+      {
+        status = 0;
+        break;
+      }
+
+      continue;
+    }
+
+    // Add the source pixels covered by each output column...
+    for (ox = 0; ox < width; ox ++)
+    {
+      for (sx = xmap[ox], x = sx; x < xmap[ox + 1]; x ++)
+      {
+        for (c = 0; c < bpp; c ++)
+          sums[ox * bpp + c] += pixels[x * bpp + c];
+      }
+    }
+
+    rows ++;
+
+    if ((unsigned long long)(y + 1) * height >= (unsigned long long)(oy + 1) * header.cupsHeight)
+    {
+      // Last source row for this output row, write the averages...
+      for (ox = 0; ox < width; ox ++)
+      {
+        unsigned long long area = (unsigned long long)(xmap[ox + 1] - xmap[ox]) * rows;
+					// Source pixels per output pixel
+
+        for (c = 0; c < bpp; c ++)
+          output[ox * bpp + c] = (uchar)((sums[ox * bpp + c] + area / 2) / area);
+      }
+
+      if (!rasterPNGWriteRow(png, output))
+      {
+        status = 0;
+        break;
+      }
+
+      memset(sums, 0, (size_t)width * (size_t)bpp * sizeof(unsigned long long));
+      oy ++;
+      rows = 0;
+    }
+  }
+
+  if (!rasterPNGClose(png) && status)
+  {
+    fprintf(stderr, "rastertopng: Unable to write '%s': %s\n", filename, strerror(errno));
+    status = 0;
+  }
+
+  done:
+
+  delete[] line;
+  delete[] colors;
+  delete[] pixels;
+  delete[] output;
+  delete[] xmap;
+  delete[] sums;
+
+  return (status);
+}
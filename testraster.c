@@ -4,6 +4,7 @@
 // Usage:
 //
 //   ./testraster [--pwg] [--urf] [WIDTH] [HEIGHT] >FILENAME
+//   ./testraster --test
 //
 // Copyright © 2023 by Michael R Sweet
 //
@@ -12,15 +13,37 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <string.h>
-#include "raster.h"
+#include "raster-private.h"
+#include "raster-pages.h"
+
+
+//
+// Local types...
+//
+
+typedef struct test_buffer_s		// Memory buffer for raster data
+{
+  unsigned char	*data;			// Data
+  size_t	length,			// Length of data
+		alloc,			// Allocated size
+		pos;			// Read position
+} test_buffer_t;
 
 
 //
 // Local functions...
 //
 
+static ssize_t	read_cb(test_buffer_t *tb, unsigned char *buffer, size_t length);
+static int	test_bbox(cups_cspace_t cspace);
+static int	test_copy(void);
+static int	test_ranges(void);
+static int	test_skip(void);
 static void	usage(FILE *out);
+static ssize_t	write_cb(test_buffer_t *tb, unsigned char *buffer, size_t length);
 static void	write_page(cups_raster_t *ras, unsigned width, unsigned height, cups_cspace_t cspace, unsigned bpp);
 
 
@@ -52,6 +75,21 @@ main(int  argc,				// I - Number of command-line arguments
     {
       mode = CUPS_RASTER_WRITE_PWG;
     }
+    else if (!strcmp(argv[i], "--test"))
+    {
+      // Run the unit tests for the raster functions...
+      int	status = 1;		// Test status
+
+      status &= test_bbox(CUPS_CSPACE_W);
+      status &= test_bbox(CUPS_CSPACE_K);
+      status &= test_skip();
+      status &= test_copy();
+      status &= test_ranges();
+
+      puts(status ? "All tests passed." : "Some tests failed.");
+
+      return (!status);
+    }
     else if (!strcmp(argv[i], "--urf"))
     {
       mode = CUPS_RASTER_WRITE_APPLE;
@@ -104,6 +142,361 @@ main(int  argc,				// I - Number of command-line arguments
 }
 
 
+//
+// 'read_cb()' - Read raster data from a memory buffer.
+//
+
+static ssize_t				// O - Bytes read
+read_cb(test_buffer_t *tb,		// I - Memory buffer
+        unsigned char *buffer,		// I - Buffer
+        size_t        length)		// I - Bytes to read
+{
+  if (length > tb->length - tb->pos)
+    length = tb->length - tb->pos;
+
+  memcpy(buffer, tb->data + tb->pos, length);
+  tb->pos += length;
+
+  return ((ssize_t)length);
+}
+
+
+//
+// 'test_bbox()' - Test blank page detection and ink bounding boxes.
+//
+// Three 32x8 8-bit pages are scanned: a blank page and a page with ink at
+// (5,3)-(9,3) from the compressed writer, then a hand-coded page with two ink
+// pixels at (5,0)-(6,0) between repeated clear pixels and a clear-to-end-of-
+// line token, followed by lines that are only a clear-to-end-of-line token.
+//
+
+static int				// O - 1 on success, 0 on failure
+test_bbox(cups_cspace_t cspace)		// I - Color space (W or K)
+{
+  test_buffer_t		tb;		// Memory buffer
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		y,		// Current line
+			bbox[4];	// Ink bounding box
+  unsigned char		line[32],	// Line
+			clear,		// Clear color
+			ink;		// Ink color
+  int			page,		// Current page
+			status = 1;	// Test status
+  static const unsigned	expected[3][4] =// Expected bounding boxes
+  {
+    { 0, 0, 0, 0 },
+    { 5, 3, 10, 4 },
+    { 5, 0, 7, 1 }
+  };
+
+
+  printf("Testing blank pages and bounding boxes (%s): ", cspace == CUPS_CSPACE_W ? "W" : "K");
+
+  clear = cspace == CUPS_CSPACE_W ? 0xff : 0x00;
+  ink   = cspace == CUPS_CSPACE_W ? 0x00 : 0xff;
+
+  // Write the pages...
+  memset(&tb, 0, sizeof(tb));
+  memset(&header, 0, sizeof(header));
+  header.cupsWidth        = 32;
+  header.cupsHeight       = 8;
+  header.cupsColorSpace   = cspace;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsBitsPerPixel = 8;
+  header.cupsBitsPerColor = 8;
+  header.cupsNumColors    = 1;
+  header.cupsBytesPerLine = 32;
+
+  ras = cupsRasterOpenIO((cups_raster_cb_t)write_cb, &tb, CUPS_RASTER_WRITE_COMPRESSED);
+
+  for (page = 0; page < 2; page ++)
+  {
+    cupsRasterWriteHeader(ras, &header);
+
+    for (y = 0; y < 8; y ++)
+    {
+      memset(line, clear, sizeof(line));
+      if (page == 1 && y == 3)
+        memset(line + 5, ink, 5);
+
+      cupsRasterWritePixels(ras, line, sizeof(line));
+    }
+  }
+
+  cupsRasterWriteHeader(ras, &header);
+  cupsRasterClose(ras);
+
+  // Then the hand-coded lines, 5 clear pixels, 2 ink pixels, and clear to the
+  // end of the line, then 7 lines of clear to the end of the line...
+  line[0]  = 0;
+  line[1]  = 4;
+  line[2]  = clear;
+  line[3]  = 255;
+  line[4]  = ink;
+  line[5]  = ink;
+  line[6]  = 128;
+  line[7]  = 6;
+  line[8]  = 128;
+
+  write_cb(&tb, line, 9);
+
+  // Scan the pages...
+  ras = cupsRasterOpenIO((cups_raster_cb_t)read_cb, &tb, CUPS_RASTER_READ);
+
+  for (page = 0; page < 3; page ++)
+  {
+    memset(bbox, 0, sizeof(bbox));
+
+    if (!cupsRasterReadHeader(ras, &header))
+    {
+      printf("FAIL (unable to read page %d)\n", page + 1);
+      status = 0;
+      break;
+    }
+    else if (_cupsRasterScanLines(ras, header.cupsHeight, bbox, NULL) != header.cupsHeight)
+    {
+      printf("FAIL (unable to scan page %d)\n", page + 1);
+      status = 0;
+      break;
+    }
+    else if (memcmp(bbox, expected[page], sizeof(bbox)))
+    {
+      printf("FAIL (page %d bounding box is [%u %u %u %u], expected [%u %u %u %u])\n", page + 1, bbox[0], bbox[1], bbox[2], bbox[3], expected[page][0], expected[page][1], expected[page][2], expected[page][3]);
+      status = 0;
+      break;
+    }
+  }
+
+  if (status && cupsRasterReadHeader(ras, &header))
+  {
+    puts("FAIL (extra page)");
+    status = 0;
+  }
+
+  if (status)
+    puts("PASS");
+
+  cupsRasterClose(ras);
+  free(tb.data);
+
+  return (status);
+}
+
+
+//
+// 'test_copy()' - Test copying pages without decoding them.
+//
+
+static int				// O - 1 on success, 0 on failure
+test_copy(void)
+{
+  test_buffer_t		src,		// Original pages
+			dst;		// Copied pages
+  cups_raster_t		*ras,		// Input raster stream
+			*out;		// Output raster stream
+  cups_page_header_t	header,		// Original page header
+			cheader;	// Copied page header
+  unsigned		y;		// Current line
+  unsigned char		*line = NULL,	// Original line
+			*cline = NULL;	// Copied line
+  int			pages = 0,	// Number of pages
+			status = 1;	// Test status
+
+
+  printf("Testing copying pages: ");
+
+  memset(&src, 0, sizeof(src));
+  memset(&dst, 0, sizeof(dst));
+
+  // Write some test pages...
+  ras = cupsRasterOpenIO((cups_raster_cb_t)write_cb, &src, CUPS_RASTER_WRITE_COMPRESSED);
+  write_page(ras, 85, 110, CUPS_CSPACE_W, 8);
+  write_page(ras, 85, 110, CUPS_CSPACE_RGB, 24);
+  write_page(ras, 85, 110, CUPS_CSPACE_K, 1);
+  cupsRasterClose(ras);
+
+  // Copy them...
+  ras = cupsRasterOpenIO((cups_raster_cb_t)read_cb, &src, CUPS_RASTER_READ);
+  out = cupsRasterOpenIO((cups_raster_cb_t)write_cb, &dst, CUPS_RASTER_WRITE_COMPRESSED);
+
+  while (status && cupsRasterReadHeader(ras, &header))
+  {
+    if (!cupsRasterWriteHeader(out, &header) || !_cupsRasterCopyPage(ras, out))
+    {
+      printf("FAIL (unable to copy page %d: %s)\n", pages + 1, cupsRasterErrorString());
+      status = 0;
+    }
+
+    pages ++;
+  }
+
+  cupsRasterClose(ras);
+  cupsRasterClose(out);
+
+  if (status && pages != 3)
+  {
+    printf("FAIL (copied %d pages, expected 3)\n", pages);
+    status = 0;
+  }
+
+  // Compare the copied pixels with the originals...
+  src.pos = 0;
+  ras     = cupsRasterOpenIO((cups_raster_cb_t)read_cb, &src, CUPS_RASTER_READ);
+  out     = cupsRasterOpenIO((cups_raster_cb_t)read_cb, &dst, CUPS_RASTER_READ);
+  pages   = 0;
+
+  while (status && cupsRasterReadHeader(ras, &header))
+  {
+    pages ++;
+
+    if (!cupsRasterReadHeader(out, &cheader) || memcmp(&header, &cheader, sizeof(header)))
+    {
+      printf("FAIL (page %d header differs)\n", pages);
+      status = 0;
+      break;
+    }
+
+    line  = malloc(header.cupsBytesPerLine);
+    cline = malloc(header.cupsBytesPerLine);
+
+    for (y = 0; y < header.cupsHeight; y ++)
+    {
+      if (!cupsRasterReadPixels(ras, line, header.cupsBytesPerLine) || !cupsRasterReadPixels(out, cline, header.cupsBytesPerLine) || memcmp(line, cline, header.cupsBytesPerLine))
+      {
+        printf("FAIL (page %d line %u differs)\n", pages, y);
+        status = 0;
+        break;
+      }
+    }
+
+    free(line);
+    free(cline);
+  }
+
+  if (status && cupsRasterReadHeader(out, &cheader))
+  {
+    puts("FAIL (extra page)");
+    status = 0;
+  }
+
+  if (status)
+    puts("PASS");
+
+  cupsRasterClose(ras);
+  cupsRasterClose(out);
+  free(src.data);
+  free(dst.data);
+
+  return (status);
+}
+
+
+//
+// 'test_ranges()' - Test parsing page lists.
+//
+
+static int				// O - 1 on success, 0 on failure
+test_ranges(void)
+{
+  int		i,			// Looping var
+		ranges[2 * RASTER_MAX_RANGES],
+					// Page ranges
+		num_ranges,		// Number of ranges
+		status = 1;		// Test status
+  static const char * const bad[] =	// Malformed page lists
+  {
+    "",
+    "3-1",
+    "1,",
+    "0"
+  };
+  static const int expected[6] =	// Ranges for "1-3,5,7-"
+  {
+    1, 3, 5, 5, 7, INT_MAX
+  };
+
+
+  printf("Testing page lists: ");
+
+  if ((num_ranges = rasterPageRanges("1-3,5,7-", ranges, RASTER_MAX_RANGES)) != 3 || memcmp(ranges, expected, sizeof(expected)))
+  {
+    printf("FAIL (\"1-3,5,7-\" returned %d ranges)\n", num_ranges);
+    status = 0;
+  }
+
+  for (i = 0; i < (int)(sizeof(bad) / sizeof(bad[0])); i ++)
+  {
+    if ((num_ranges = rasterPageRanges(bad[i], ranges, RASTER_MAX_RANGES)) != -1)
+    {
+      printf("FAIL (\"%s\" returned %d ranges, expected an error)\n", bad[i], num_ranges);
+      status = 0;
+    }
+  }
+
+  if (status)
+    puts("PASS");
+
+  return (status);
+}
+
+
+//
+// 'test_skip()' - Test skipping the lines of a page.
+//
+
+static int				// O - 1 on success, 0 on failure
+test_skip(void)
+{
+  test_buffer_t		tb;		// Memory buffer
+  cups_raster_t		*ras;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  unsigned		lines;		// Lines skipped
+  int			status = 1;	// Test status
+
+
+  printf("Testing skipping to the next page: ");
+
+  memset(&tb, 0, sizeof(tb));
+
+  ras = cupsRasterOpenIO((cups_raster_cb_t)write_cb, &tb, CUPS_RASTER_WRITE_COMPRESSED);
+  write_page(ras, 85, 110, CUPS_CSPACE_RGB, 24);
+  write_page(ras, 64, 48, CUPS_CSPACE_K, 1);
+  cupsRasterClose(ras);
+
+  ras = cupsRasterOpenIO((cups_raster_cb_t)read_cb, &tb, CUPS_RASTER_READ);
+
+  // Skipping past the end of the page only skips the lines in the page...
+  if (!cupsRasterReadHeader(ras, &header) || (lines = _cupsRasterSkipLines(ras, header.cupsHeight + 10)) != 110)
+  {
+    puts("FAIL (unable to skip page 1)");
+    status = 0;
+  }
+  else if (!cupsRasterReadHeader(ras, &header) || header.cupsWidth != 64 || header.cupsHeight != 48)
+  {
+    puts("FAIL (unable to read page 2 header)");
+    status = 0;
+  }
+  else if ((lines = _cupsRasterSkipLines(ras, 20)) != 20 || (lines = _cupsRasterSkipLines(ras, 100)) != 28)
+  {
+    printf("FAIL (skipped %u lines of page 2)\n", lines);
+    status = 0;
+  }
+  else if (cupsRasterReadHeader(ras, &header))
+  {
+    puts("FAIL (extra page)");
+    status = 0;
+  }
+  else
+    puts("PASS");
+
+  cupsRasterClose(ras);
+  free(tb.data);
+
+  return (status);
+}
+
+
 //
 // 'usage()' - Show program usage.
 //
@@ -115,10 +508,39 @@ usage(FILE *out)			// I - Output file
   fputs("Options:\n", out);
   fputs("  --help     Show program usage.\n", out);
   fputs("  --pwg      Output PWG raster instead of CUPS raster.\n", out);
+  fputs("  --test     Run the unit tests.\n", out);
   fputs("  --urf      Output Apple raster instead of CUPS raster.\n", out);
 }
 
 
+//
+// 'write_cb()' - Write raster data to a memory buffer.
+//
+
+static ssize_t				// O - Bytes written or -1 on error
+write_cb(test_buffer_t *tb,		// I - Memory buffer
+         unsigned char *buffer,		// I - Buffer
+         size_t        length)		// I - Bytes to write
+{
+  unsigned char	*temp;			// New buffer
+
+
+  if (tb->length + length > tb->alloc)
+  {
+    if ((temp = realloc(tb->data, tb->length + length + 65536)) == NULL)
+      return (-1);
+
+    tb->data  = temp;
+    tb->alloc = tb->length + length + 65536;
+  }
+
+  memcpy(tb->data + tb->length, buffer, length);
+  tb->length += length;
+
+  return ((ssize_t)length);
+}
+
+
 //
 // 'write_page()' - Write a single page.
 //